@@ -84,6 +84,659 @@ GetIpv6SupportInformationBlock (
   return EFI_SUCCESS;
 }
 
+/** Gets latency profile information block
+
+  @param[in]   This                  Current EFI_ADAPTER_INFORMATION_PROTOCOL instance.
+  @param[out]  InformationBlock      Latency profile information block.
+  @param[out]  InformationBlockSize  Latency profile information block size.
+
+  @retval      EFI_SUCCESS           Information block returned successfully
+  @retval      EFI_UNSUPPORTED       MAC has no timestamping unit
+  @retval      EFI_OUT_OF_RESOURCES  Not enough resources to store latency profile
+**/
+STATIC
+EFI_STATUS
+GetLatencyProfileInformationBlock (
+  IN  EFI_ADAPTER_INFORMATION_PROTOCOL *This,
+  OUT VOID **                           InformationBlock,
+  OUT UINTN *                           InformationBlockSize
+  )
+{
+  INTELGBE_ADAPTER_INFO_LATENCY_PROFILE *Buffer;
+  UNDI_PRIVATE_DATA *                    UndiPrivateData;
+  GIG_DRIVER_DATA *                      GigAdapter;
+
+  UndiPrivateData = UNDI_PRIVATE_DATA_FROM_AIP (This);
+  GigAdapter = &UndiPrivateData->NicInfo;
+
+  if (!GigAdapter->Hw.mac.tstamp) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Buffer = AllocatePool (sizeof (INTELGBE_ADAPTER_INFO_LATENCY_PROFILE));
+
+  if (Buffer == NULL) {
+    DEBUGPRINT (ADAPTERINFO, ("AllocatePool failed\n"));
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Buffer->Enabled        = GigAdapter->rx_queue[0].tstamp;
+  Buffer->WireToReceive  = GigAdapter->WireToReceive;
+  Buffer->TransmitToWire = GigAdapter->TransmitToWire;
+  if (Buffer->WireToReceive.Count == 0) {
+    Buffer->WireToReceive.MinNs = 0;
+  }
+  if (Buffer->TransmitToWire.Count == 0) {
+    Buffer->TransmitToWire.MinNs = 0;
+  }
+
+  *InformationBlock = Buffer;
+  *InformationBlockSize = sizeof (INTELGBE_ADAPTER_INFO_LATENCY_PROFILE);
+
+  return EFI_SUCCESS;
+}
+
+/** Starts or stops latency profiling
+
+  Only the Enabled field of the block is used. Enabling clears the profile.
+
+  @param[in]   This                  Current EFI_ADAPTER_INFORMATION_PROTOCOL instance.
+  @param[in]   InformationBlock      Latency profile information block.
+  @param[in]   InformationBlockSize  Latency profile information block size.
+
+  @retval      EFI_SUCCESS             Profiling state changed
+  @retval      EFI_INVALID_PARAMETER   InformationBlockSize is too small
+  @retval      EFI_UNSUPPORTED         MAC has no timestamping unit
+  @retval      EFI_DEVICE_ERROR        System time counter failed to start
+**/
+STATIC
+EFI_STATUS
+SetLatencyProfileInformationBlock (
+  IN EFI_ADAPTER_INFORMATION_PROTOCOL *This,
+  IN VOID *                            InformationBlock,
+  IN UINTN                             InformationBlockSize
+  )
+{
+  INTELGBE_ADAPTER_INFO_LATENCY_PROFILE *Profile;
+  UNDI_PRIVATE_DATA *                    UndiPrivateData;
+
+  if (InformationBlockSize < sizeof (INTELGBE_ADAPTER_INFO_LATENCY_PROFILE)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  UndiPrivateData = UNDI_PRIVATE_DATA_FROM_AIP (This);
+  Profile = (INTELGBE_ADAPTER_INFO_LATENCY_PROFILE *) InformationBlock;
+
+  return IntelgbeSetTimestamping (&UndiPrivateData->NicInfo, Profile->Enabled);
+}
+
+/** Gets link profile information block
+
+  @param[in]   This                  Current EFI_ADAPTER_INFORMATION_PROTOCOL instance.
+  @param[out]  InformationBlock      Link profile information block.
+  @param[out]  InformationBlockSize  Link profile information block size.
+
+  @retval      EFI_SUCCESS           Information block returned successfully
+  @retval      EFI_OUT_OF_RESOURCES  Not enough resources to store link profile
+**/
+STATIC
+EFI_STATUS
+GetLinkProfileInformationBlock (
+  IN  EFI_ADAPTER_INFORMATION_PROTOCOL *This,
+  OUT VOID **                           InformationBlock,
+  OUT UINTN *                           InformationBlockSize
+  )
+{
+  INTELGBE_ADAPTER_INFO_LINK_PROFILE *Buffer;
+  UNDI_PRIVATE_DATA *                 UndiPrivateData;
+
+  Buffer = AllocatePool (sizeof (INTELGBE_ADAPTER_INFO_LINK_PROFILE));
+
+  if (Buffer == NULL) {
+    DEBUGPRINT (ADAPTERINFO, ("AllocatePool failed\n"));
+    return EFI_OUT_OF_RESOURCES;
+  }
+  UndiPrivateData = UNDI_PRIVATE_DATA_FROM_AIP (This);
+
+  Buffer->Profile   = UndiPrivateData->NicInfo.Hw.mac.link_profile;
+  Buffer->EeeActive = UndiPrivateData->NicInfo.Hw.mac.eee_active;
+
+  *InformationBlock = Buffer;
+  *InformationBlockSize = sizeof (INTELGBE_ADAPTER_INFO_LINK_PROFILE);
+
+  return EFI_SUCCESS;
+}
+
+/** Sets link profile
+
+  @param[in]   This                  Current EFI_ADAPTER_INFORMATION_PROTOCOL instance.
+  @param[in]   InformationBlock      Link profile information block.
+  @param[in]   InformationBlockSize  Link profile information block size.
+
+  @retval      EFI_SUCCESS             Profile applied
+  @retval      EFI_INVALID_PARAMETER   Block is too small or profile is unknown
+  @retval      EFI_UNSUPPORTED         MAC has no EEE support
+  @retval      EFI_DEVICE_ERROR        PHY could not be reconfigured
+**/
+STATIC
+EFI_STATUS
+SetLinkProfileInformationBlock (
+  IN EFI_ADAPTER_INFORMATION_PROTOCOL *This,
+  IN VOID *                            InformationBlock,
+  IN UINTN                             InformationBlockSize
+  )
+{
+  INTELGBE_ADAPTER_INFO_LINK_PROFILE *Profile;
+  UNDI_PRIVATE_DATA *                 UndiPrivateData;
+
+  if (InformationBlockSize < sizeof (INTELGBE_ADAPTER_INFO_LINK_PROFILE)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  UndiPrivateData = UNDI_PRIVATE_DATA_FROM_AIP (This);
+  Profile = (INTELGBE_ADAPTER_INFO_LINK_PROFILE *) InformationBlock;
+
+  return IntelgbeSetLinkProfile (&UndiPrivateData->NicInfo, Profile->Profile);
+}
+
+/** Gets flow control information block
+
+  @param[in]   This                  Current EFI_ADAPTER_INFORMATION_PROTOCOL instance.
+  @param[out]  InformationBlock      Flow control information block.
+  @param[out]  InformationBlockSize  Flow control information block size.
+
+  @retval      EFI_SUCCESS           Information block returned successfully
+  @retval      EFI_OUT_OF_RESOURCES  Not enough resources to store flow control info
+**/
+STATIC
+EFI_STATUS
+GetFlowControlInformationBlock (
+  IN  EFI_ADAPTER_INFORMATION_PROTOCOL *This,
+  OUT VOID **                           InformationBlock,
+  OUT UINTN *                           InformationBlockSize
+  )
+{
+  INTELGBE_ADAPTER_INFO_FLOW_CONTROL *Buffer;
+  UNDI_PRIVATE_DATA *                 UndiPrivateData;
+  GIG_DRIVER_DATA *                   GigAdapter;
+
+  Buffer = AllocatePool (sizeof (INTELGBE_ADAPTER_INFO_FLOW_CONTROL));
+
+  if (Buffer == NULL) {
+    DEBUGPRINT (ADAPTERINFO, ("AllocatePool failed\n"));
+    return EFI_OUT_OF_RESOURCES;
+  }
+  UndiPrivateData = UNDI_PRIVATE_DATA_FROM_AIP (This);
+  GigAdapter = &UndiPrivateData->NicInfo;
+
+  IntelgbeUpdateRxFifoDrops (GigAdapter);
+
+  Buffer->Requested = 0;
+  Buffer->Active    = 0;
+  if ((GigAdapter->Hw.mac.fc_requested & INTELGBE_FC_RX) != 0) {
+    Buffer->Requested |= INTELGBE_ADAPTER_INFO_FC_RX;
+  }
+  if ((GigAdapter->Hw.mac.fc_requested & INTELGBE_FC_TX) != 0) {
+    Buffer->Requested |= INTELGBE_ADAPTER_INFO_FC_TX;
+  }
+  if ((GigAdapter->Hw.mac.fc_active & INTELGBE_FC_RX) != 0) {
+    Buffer->Active |= INTELGBE_ADAPTER_INFO_FC_RX;
+  }
+  if ((GigAdapter->Hw.mac.fc_active & INTELGBE_FC_TX) != 0) {
+    Buffer->Active |= INTELGBE_ADAPTER_INFO_FC_TX;
+  }
+  Buffer->RxFifoOverflows = GigAdapter->RxFifoOverflows;
+  Buffer->RxFifoMissed    = GigAdapter->RxFifoMissed;
+
+  *InformationBlock = Buffer;
+  *InformationBlockSize = sizeof (INTELGBE_ADAPTER_INFO_FLOW_CONTROL);
+
+  return EFI_SUCCESS;
+}
+
+/** Sets requested flow control
+
+  @param[in]   This                  Current EFI_ADAPTER_INFORMATION_PROTOCOL instance.
+  @param[in]   InformationBlock      Flow control information block.
+  @param[in]   InformationBlockSize  Flow control information block size.
+
+  @retval      EFI_SUCCESS             Flow control applied
+  @retval      EFI_INVALID_PARAMETER   Block is too small or unknown bits set
+  @retval      EFI_DEVICE_ERROR        PHY could not be reconfigured
+**/
+STATIC
+EFI_STATUS
+SetFlowControlInformationBlock (
+  IN EFI_ADAPTER_INFORMATION_PROTOCOL *This,
+  IN VOID *                            InformationBlock,
+  IN UINTN                             InformationBlockSize
+  )
+{
+  INTELGBE_ADAPTER_INFO_FLOW_CONTROL *FlowControl;
+  UNDI_PRIVATE_DATA *                 UndiPrivateData;
+
+  if (InformationBlockSize < sizeof (INTELGBE_ADAPTER_INFO_FLOW_CONTROL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  UndiPrivateData = UNDI_PRIVATE_DATA_FROM_AIP (This);
+  FlowControl = (INTELGBE_ADAPTER_INFO_FLOW_CONTROL *) InformationBlock;
+
+  return IntelgbeSetFlowControl (&UndiPrivateData->NicInfo, FlowControl->Requested);
+}
+
+/** Gets TX scheduling information block
+
+  @param[in]   This                  Current EFI_ADAPTER_INFORMATION_PROTOCOL instance.
+  @param[out]  InformationBlock      TX scheduling information block.
+  @param[out]  InformationBlockSize  TX scheduling information block size.
+
+  @retval      EFI_SUCCESS           Information block returned successfully
+  @retval      EFI_OUT_OF_RESOURCES  Not enough resources to store TX scheduling info
+**/
+STATIC
+EFI_STATUS
+GetTxSchedulingInformationBlock (
+  IN  EFI_ADAPTER_INFORMATION_PROTOCOL *This,
+  OUT VOID **                           InformationBlock,
+  OUT UINTN *                           InformationBlockSize
+  )
+{
+  INTELGBE_ADAPTER_INFO_TX_SCHEDULING *Buffer;
+  UNDI_PRIVATE_DATA *                  UndiPrivateData;
+  GIG_DRIVER_DATA *                    GigAdapter;
+  UINT32                               i;
+
+  Buffer = AllocateZeroPool (sizeof (INTELGBE_ADAPTER_INFO_TX_SCHEDULING));
+
+  if (Buffer == NULL) {
+    DEBUGPRINT (ADAPTERINFO, ("AllocateZeroPool failed\n"));
+    return EFI_OUT_OF_RESOURCES;
+  }
+  UndiPrivateData = UNDI_PRIVATE_DATA_FROM_AIP (This);
+  GigAdapter = &UndiPrivateData->NicInfo;
+
+  switch (GigAdapter->Hw.mac.tx_sched) {
+  case MTL_OPR_MD_SCHALG_WRR:
+    Buffer->Algorithm = INTELGBE_ADAPTER_INFO_TX_SCHED_WRR;
+    break;
+  case MTL_OPR_MD_SCHALG_DWRR:
+    Buffer->Algorithm = INTELGBE_ADAPTER_INFO_TX_SCHED_DWRR;
+    break;
+  default:
+    Buffer->Algorithm = INTELGBE_ADAPTER_INFO_TX_SCHED_SP;
+    break;
+  }
+  Buffer->QueueCount = GigAdapter->txqnum;
+  for (i = 0; i < GigAdapter->txqnum; i++) {
+    Buffer->Weight[i] = GigAdapter->Hw.mac.txq_weight[i];
+  }
+
+  *InformationBlock = Buffer;
+  *InformationBlockSize = sizeof (INTELGBE_ADAPTER_INFO_TX_SCHEDULING);
+
+  return EFI_SUCCESS;
+}
+
+/** Sets TX scheduling algorithm and queue weights
+
+  @param[in]   This                  Current EFI_ADAPTER_INFORMATION_PROTOCOL instance.
+  @param[in]   InformationBlock      TX scheduling information block.
+  @param[in]   InformationBlockSize  TX scheduling information block size.
+
+  @retval      EFI_SUCCESS             Scheduling applied
+  @retval      EFI_INVALID_PARAMETER   Block is too small, unknown algorithm or zero weight
+  @retval      EFI_DEVICE_ERROR        MTL could not be reconfigured
+**/
+STATIC
+EFI_STATUS
+SetTxSchedulingInformationBlock (
+  IN EFI_ADAPTER_INFORMATION_PROTOCOL *This,
+  IN VOID *                            InformationBlock,
+  IN UINTN                             InformationBlockSize
+  )
+{
+  INTELGBE_ADAPTER_INFO_TX_SCHEDULING *TxScheduling;
+  UNDI_PRIVATE_DATA *                  UndiPrivateData;
+
+  if (InformationBlockSize < sizeof (INTELGBE_ADAPTER_INFO_TX_SCHEDULING)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  UndiPrivateData = UNDI_PRIVATE_DATA_FROM_AIP (This);
+  TxScheduling = (INTELGBE_ADAPTER_INFO_TX_SCHEDULING *) InformationBlock;
+
+  return IntelgbeSetTxScheduling (
+           &UndiPrivateData->NicInfo,
+           TxScheduling->Algorithm,
+           TxScheduling->Weight
+           );
+}
+
+/** Gets DMA profile information block
+
+  @param[in]   This                  Current EFI_ADAPTER_INFORMATION_PROTOCOL instance.
+  @param[out]  InformationBlock      DMA profile information block.
+  @param[out]  InformationBlockSize  DMA profile information block size.
+
+  @retval      EFI_SUCCESS           Information block returned successfully
+  @retval      EFI_OUT_OF_RESOURCES  Not enough resources to store DMA profile info
+**/
+STATIC
+EFI_STATUS
+GetDmaProfileInformationBlock (
+  IN  EFI_ADAPTER_INFORMATION_PROTOCOL *This,
+  OUT VOID **                           InformationBlock,
+  OUT UINTN *                           InformationBlockSize
+  )
+{
+  INTELGBE_ADAPTER_INFO_DMA_PROFILE *Buffer;
+  UNDI_PRIVATE_DATA *                UndiPrivateData;
+  struct intelgbe_dma_cfg *          Cfg;
+
+  Buffer = AllocateZeroPool (sizeof (INTELGBE_ADAPTER_INFO_DMA_PROFILE));
+
+  if (Buffer == NULL) {
+    DEBUGPRINT (ADAPTERINFO, ("AllocateZeroPool failed\n"));
+    return EFI_OUT_OF_RESOURCES;
+  }
+  UndiPrivateData = UNDI_PRIVATE_DATA_FROM_AIP (This);
+  Cfg = &UndiPrivateData->NicInfo.Hw.mac.dma_cfg;
+
+  Buffer->Profile        = UndiPrivateData->NicInfo.Hw.mac.dma_profile;
+  Buffer->BurstLengths   = Cfg->blen / DMA_SYSBUS_MD_BLEN4;
+  Buffer->ReadRequests   = Cfg->rd_osr + 1;
+  Buffer->WriteRequests  = Cfg->wr_osr + 1;
+  Buffer->BurstBeats     = Cfg->pbl;
+  Buffer->BurstBeatsX8   = Cfg->pblx8;
+  Buffer->AddressAligned = Cfg->aal;
+  Buffer->FixedBurst     = Cfg->fb;
+
+  *InformationBlock = Buffer;
+  *InformationBlockSize = sizeof (INTELGBE_ADAPTER_INFO_DMA_PROFILE);
+
+  return EFI_SUCCESS;
+}
+
+/** Sets DMA profile
+
+  @param[in]   This                  Current EFI_ADAPTER_INFORMATION_PROTOCOL instance.
+  @param[in]   InformationBlock      DMA profile information block.
+  @param[in]   InformationBlockSize  DMA profile information block size.
+
+  @retval      EFI_SUCCESS             Profile applied
+  @retval      EFI_INVALID_PARAMETER   Block is too small, unknown profile or bad custom settings
+  @retval      EFI_NOT_READY           Frames are still in the TX rings
+**/
+STATIC
+EFI_STATUS
+SetDmaProfileInformationBlock (
+  IN EFI_ADAPTER_INFORMATION_PROTOCOL *This,
+  IN VOID *                            InformationBlock,
+  IN UINTN                             InformationBlockSize
+  )
+{
+  INTELGBE_ADAPTER_INFO_DMA_PROFILE *DmaProfile;
+  UNDI_PRIVATE_DATA *                UndiPrivateData;
+  struct intelgbe_dma_cfg            Cfg;
+
+  if (InformationBlockSize < sizeof (INTELGBE_ADAPTER_INFO_DMA_PROFILE)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  UndiPrivateData = UNDI_PRIVATE_DATA_FROM_AIP (This);
+  DmaProfile = (INTELGBE_ADAPTER_INFO_DMA_PROFILE *) InformationBlock;
+
+  // Requests in flight are programmed minus one, zero wraps and is rejected.
+  Cfg.blen   = DmaProfile->BurstLengths * DMA_SYSBUS_MD_BLEN4;
+  Cfg.rd_osr = DmaProfile->ReadRequests - 1;
+  Cfg.wr_osr = DmaProfile->WriteRequests - 1;
+  Cfg.pbl    = DmaProfile->BurstBeats;
+  Cfg.pblx8  = DmaProfile->BurstBeatsX8;
+  Cfg.aal    = DmaProfile->AddressAligned;
+  Cfg.fb     = DmaProfile->FixedBurst;
+
+  return IntelgbeSetDmaProfile (
+           &UndiPrivateData->NicInfo,
+           DmaProfile->Profile,
+           &Cfg
+           );
+}
+
+/** Gets OS handoff information block
+
+  @param[in]   This                  Current EFI_ADAPTER_INFORMATION_PROTOCOL instance.
+  @param[out]  InformationBlock      OS handoff information block.
+  @param[out]  InformationBlockSize  OS handoff information block size.
+
+  @retval      EFI_SUCCESS           Information block returned successfully
+  @retval      EFI_OUT_OF_RESOURCES  Not enough resources to store OS handoff info
+**/
+STATIC
+EFI_STATUS
+GetOsHandoffInformationBlock (
+  IN  EFI_ADAPTER_INFORMATION_PROTOCOL *This,
+  OUT VOID **                           InformationBlock,
+  OUT UINTN *                           InformationBlockSize
+  )
+{
+  INTELGBE_ADAPTER_INFO_OS_HANDOFF *Buffer;
+  UNDI_PRIVATE_DATA *               UndiPrivateData;
+
+  Buffer = AllocatePool (sizeof (INTELGBE_ADAPTER_INFO_OS_HANDOFF));
+
+  if (Buffer == NULL) {
+    DEBUGPRINT (ADAPTERINFO, ("AllocatePool failed\n"));
+    return EFI_OUT_OF_RESOURCES;
+  }
+  UndiPrivateData = UNDI_PRIVATE_DATA_FROM_AIP (This);
+
+  Buffer->Enable = UndiPrivateData->NicInfo.OsHandoff;
+
+  *InformationBlock = Buffer;
+  *InformationBlockSize = sizeof (INTELGBE_ADAPTER_INFO_OS_HANDOFF);
+
+  return EFI_SUCCESS;
+}
+
+/** Sets OS handoff
+
+  @param[in]   This                  Current EFI_ADAPTER_INFORMATION_PROTOCOL instance.
+  @param[in]   InformationBlock      OS handoff information block.
+  @param[in]   InformationBlockSize  OS handoff information block size.
+
+  @retval      EFI_SUCCESS             Setting recorded
+  @retval      EFI_INVALID_PARAMETER   Block is too small
+  @retval      EFI_OUT_OF_RESOURCES    Could not allocate the configuration table
+**/
+STATIC
+EFI_STATUS
+SetOsHandoffInformationBlock (
+  IN EFI_ADAPTER_INFORMATION_PROTOCOL *This,
+  IN VOID *                            InformationBlock,
+  IN UINTN                             InformationBlockSize
+  )
+{
+  INTELGBE_ADAPTER_INFO_OS_HANDOFF *OsHandoff;
+  UNDI_PRIVATE_DATA *               UndiPrivateData;
+
+  if (InformationBlockSize < sizeof (INTELGBE_ADAPTER_INFO_OS_HANDOFF)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  UndiPrivateData = UNDI_PRIVATE_DATA_FROM_AIP (This);
+  OsHandoff = (INTELGBE_ADAPTER_INFO_OS_HANDOFF *) InformationBlock;
+
+  return IntelgbeSetOsHandoff (&UndiPrivateData->NicInfo, OsHandoff->Enable);
+}
+
+/** Gets trace information block, the header followed by the trace records
+
+  @param[in]   This                  Current EFI_ADAPTER_INFORMATION_PROTOCOL instance.
+  @param[out]  InformationBlock      Trace information block.
+  @param[out]  InformationBlockSize  Trace information block size.
+
+  @retval      EFI_SUCCESS           Information block returned successfully
+  @retval      EFI_OUT_OF_RESOURCES  Not enough resources to store the trace
+**/
+STATIC
+EFI_STATUS
+GetTraceInformationBlock (
+  IN  EFI_ADAPTER_INFORMATION_PROTOCOL *This,
+  OUT VOID **                           InformationBlock,
+  OUT UINTN *                           InformationBlockSize
+  )
+{
+  INTELGBE_ADAPTER_INFO_TRACE *Buffer;
+  UNDI_PRIVATE_DATA *          UndiPrivateData;
+  GIG_DRIVER_DATA *            GigAdapter;
+  UINT32                       Count;
+
+  UndiPrivateData = UNDI_PRIVATE_DATA_FROM_AIP (This);
+  GigAdapter = &UndiPrivateData->NicInfo;
+
+  Count = (UINT32) MIN (GigAdapter->TraceWritten, INTELGBE_TRACE_RECORDS);
+  Buffer = AllocateZeroPool (sizeof (INTELGBE_ADAPTER_INFO_TRACE) +
+                             Count * sizeof (INTELGBE_TRACE_RECORD));
+
+  if (Buffer == NULL) {
+    DEBUGPRINT (ADAPTERINFO, ("AllocateZeroPool failed\n"));
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Buffer->Mask    = GigAdapter->TraceMask;
+  Buffer->TscHz   = GigAdapter->TraceTscHz;
+  Buffer->Written = IntelgbeTraceCopy (GigAdapter,
+                      (INTELGBE_TRACE_RECORD *) (Buffer + 1), Count);
+  Buffer->RecordCount = (UINT32) MIN (Count, Buffer->Written);
+
+  *InformationBlock = Buffer;
+  *InformationBlockSize = sizeof (INTELGBE_ADAPTER_INFO_TRACE) +
+                          Buffer->RecordCount * sizeof (INTELGBE_TRACE_RECORD);
+
+  return EFI_SUCCESS;
+}
+
+/** Sets the traced event classes, a non-zero mask restarts the trace
+
+  @param[in]   This                  Current EFI_ADAPTER_INFORMATION_PROTOCOL instance.
+  @param[in]   InformationBlock      Trace information block.
+  @param[in]   InformationBlockSize  Trace information block size.
+
+  @retval      EFI_SUCCESS             Trace mask applied
+  @retval      EFI_INVALID_PARAMETER   Block is too small or unknown class set
+  @retval      EFI_OUT_OF_RESOURCES    Could not allocate the trace ring
+**/
+STATIC
+EFI_STATUS
+SetTraceInformationBlock (
+  IN EFI_ADAPTER_INFORMATION_PROTOCOL *This,
+  IN VOID *                            InformationBlock,
+  IN UINTN                             InformationBlockSize
+  )
+{
+  INTELGBE_ADAPTER_INFO_TRACE *Trace;
+  UNDI_PRIVATE_DATA *          UndiPrivateData;
+
+  if (InformationBlockSize < sizeof (INTELGBE_ADAPTER_INFO_TRACE)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  UndiPrivateData = UNDI_PRIVATE_DATA_FROM_AIP (This);
+  Trace = (INTELGBE_ADAPTER_INFO_TRACE *) InformationBlock;
+
+  return IntelgbeSetTrace (&UndiPrivateData->NicInfo, Trace->Mask);
+}
+
+/** Gets capture information block, the header followed by the captured frames
+
+  @param[in]   This                  Current EFI_ADAPTER_INFORMATION_PROTOCOL instance.
+  @param[out]  InformationBlock      Capture information block.
+  @param[out]  InformationBlockSize  Capture information block size.
+
+  @retval      EFI_SUCCESS           Information block returned successfully
+  @retval      EFI_OUT_OF_RESOURCES  Not enough resources to store the frames
+**/
+STATIC
+EFI_STATUS
+GetCaptureInformationBlock (
+  IN  EFI_ADAPTER_INFORMATION_PROTOCOL *This,
+  OUT VOID **                           InformationBlock,
+  OUT UINTN *                           InformationBlockSize
+  )
+{
+  INTELGBE_ADAPTER_INFO_CAPTURE *Buffer;
+  INTELGBE_CAPTURE               State;
+  UNDI_PRIVATE_DATA *            UndiPrivateData;
+  GIG_DRIVER_DATA *              GigAdapter;
+  UINTN                          Size;
+
+  UndiPrivateData = UNDI_PRIVATE_DATA_FROM_AIP (This);
+  GigAdapter = &UndiPrivateData->NicInfo;
+
+  Size = 0;
+  if (GigAdapter->Capture != NULL) {
+    Size = (UINTN) MIN (GigAdapter->Capture->Captured, GigAdapter->Capture->Slots) *
+           GigAdapter->Capture->SlotSize;
+  }
+  Buffer = AllocateZeroPool (sizeof (INTELGBE_ADAPTER_INFO_CAPTURE) + Size);
+
+  if (Buffer == NULL) {
+    DEBUGPRINT (ADAPTERINFO, ("AllocateZeroPool failed\n"));
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Buffer->RecordCount = IntelgbeCaptureCopy (GigAdapter, &State,
+                          (UINT8 *) (Buffer + 1), &Size);
+  Buffer->Directions  = GigAdapter->CaptureDirections;
+  Buffer->Flags       = State.Flags;
+  Buffer->SnapLen     = State.SnapLen;
+  Buffer->RingSize    = State.Slots * State.SlotSize;
+  Buffer->EtherType   = State.EtherType;
+  Buffer->Captured    = State.Captured;
+  Buffer->Dropped     = State.Dropped;
+  Buffer->Truncated   = State.Truncated;
+  Buffer->StartTsc    = State.StartTsc;
+  Buffer->TscHz       = GigAdapter->TraceTscHz;
+  CopyMem (&Buffer->StartTime, &State.StartTime, sizeof (EFI_TIME));
+
+  *InformationBlock = Buffer;
+  *InformationBlockSize = sizeof (INTELGBE_ADAPTER_INFO_CAPTURE) + Size;
+
+  return EFI_SUCCESS;
+}
+
+/** Arms or stops the packet capture, arming discards the frames captured so far
+
+  @param[in]   This                  Current EFI_ADAPTER_INFORMATION_PROTOCOL instance.
+  @param[in]   InformationBlock      Capture information block.
+  @param[in]   InformationBlockSize  Capture information block size.
+
+  @retval      EFI_SUCCESS             Capture armed or stopped
+  @retval      EFI_INVALID_PARAMETER   Block is too small or settings are invalid
+  @retval      EFI_OUT_OF_RESOURCES    Could not allocate the capture ring
+**/
+STATIC
+EFI_STATUS
+SetCaptureInformationBlock (
+  IN EFI_ADAPTER_INFORMATION_PROTOCOL *This,
+  IN VOID *                            InformationBlock,
+  IN UINTN                             InformationBlockSize
+  )
+{
+  INTELGBE_ADAPTER_INFO_CAPTURE *Capture;
+  UNDI_PRIVATE_DATA *            UndiPrivateData;
+
+  if (InformationBlockSize < sizeof (INTELGBE_ADAPTER_INFO_CAPTURE)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  UndiPrivateData = UNDI_PRIVATE_DATA_FROM_AIP (This);
+  Capture = (INTELGBE_ADAPTER_INFO_CAPTURE *) InformationBlock;
+
+  return IntelgbeSetCapture (&UndiPrivateData->NicInfo, Capture->Directions,
+           Capture->Flags, Capture->SnapLen, Capture->EtherType, Capture->RingSize);
+}
 
 /** Returns the current state information for the adapter
 
@@ -323,6 +976,14 @@ InitAdapterInformationProtocol (
 
   EFI_GUID MediaStateGuid      = EFI_ADAPTER_INFO_MEDIA_STATE_GUID;
   EFI_GUID Ipv6SupportInfoGuid = EFI_ADAPTER_INFO_UNDI_IPV6_SUPPORT_GUID;
+  EFI_GUID LatencyProfileGuid  = INTELGBE_ADAPTER_INFO_LATENCY_PROFILE_GUID;
+  EFI_GUID LinkProfileGuid     = INTELGBE_ADAPTER_INFO_LINK_PROFILE_GUID;
+  EFI_GUID FlowControlGuid     = INTELGBE_ADAPTER_INFO_FLOW_CONTROL_GUID;
+  EFI_GUID TxSchedulingGuid    = INTELGBE_ADAPTER_INFO_TX_SCHEDULING_GUID;
+  EFI_GUID OsHandoffGuid       = INTELGBE_ADAPTER_INFO_OS_HANDOFF_GUID;
+  EFI_GUID TraceGuid           = INTELGBE_ADAPTER_INFO_TRACE_GUID;
+  EFI_GUID DmaProfileGuid      = INTELGBE_ADAPTER_INFO_DMA_PROFILE_GUID;
+  EFI_GUID CaptureGuid         = INTELGBE_ADAPTER_INFO_CAPTURE_GUID;
 
   DEBUGPRINT (ADAPTERINFO, ("%a, %d\n", __FUNCTION__, __LINE__));
 
@@ -342,6 +1003,62 @@ InitAdapterInformationProtocol (
   InformationType.SetInformationBlock = NULL;
   AddSupportedInformationType (&InformationType);
 
+  SetMem (&InformationType,
+    sizeof (EFI_ADAPTER_INFORMATION_TYPE_DESCRIPTOR), 0);
+  CopyMem (&InformationType.Guid, &LatencyProfileGuid, sizeof (EFI_GUID));
+  InformationType.GetInformationBlock = GetLatencyProfileInformationBlock;
+  InformationType.SetInformationBlock = SetLatencyProfileInformationBlock;
+  AddSupportedInformationType (&InformationType);
+
+  SetMem (&InformationType,
+    sizeof (EFI_ADAPTER_INFORMATION_TYPE_DESCRIPTOR), 0);
+  CopyMem (&InformationType.Guid, &LinkProfileGuid, sizeof (EFI_GUID));
+  InformationType.GetInformationBlock = GetLinkProfileInformationBlock;
+  InformationType.SetInformationBlock = SetLinkProfileInformationBlock;
+  AddSupportedInformationType (&InformationType);
+
+  SetMem (&InformationType,
+    sizeof (EFI_ADAPTER_INFORMATION_TYPE_DESCRIPTOR), 0);
+  CopyMem (&InformationType.Guid, &FlowControlGuid, sizeof (EFI_GUID));
+  InformationType.GetInformationBlock = GetFlowControlInformationBlock;
+  InformationType.SetInformationBlock = SetFlowControlInformationBlock;
+  AddSupportedInformationType (&InformationType);
+
+  SetMem (&InformationType,
+    sizeof (EFI_ADAPTER_INFORMATION_TYPE_DESCRIPTOR), 0);
+  CopyMem (&InformationType.Guid, &TxSchedulingGuid, sizeof (EFI_GUID));
+  InformationType.GetInformationBlock = GetTxSchedulingInformationBlock;
+  InformationType.SetInformationBlock = SetTxSchedulingInformationBlock;
+  AddSupportedInformationType (&InformationType);
+
+  SetMem (&InformationType,
+    sizeof (EFI_ADAPTER_INFORMATION_TYPE_DESCRIPTOR), 0);
+  CopyMem (&InformationType.Guid, &OsHandoffGuid, sizeof (EFI_GUID));
+  InformationType.GetInformationBlock = GetOsHandoffInformationBlock;
+  InformationType.SetInformationBlock = SetOsHandoffInformationBlock;
+  AddSupportedInformationType (&InformationType);
+
+  SetMem (&InformationType,
+    sizeof (EFI_ADAPTER_INFORMATION_TYPE_DESCRIPTOR), 0);
+  CopyMem (&InformationType.Guid, &TraceGuid, sizeof (EFI_GUID));
+  InformationType.GetInformationBlock = GetTraceInformationBlock;
+  InformationType.SetInformationBlock = SetTraceInformationBlock;
+  AddSupportedInformationType (&InformationType);
+
+  SetMem (&InformationType,
+    sizeof (EFI_ADAPTER_INFORMATION_TYPE_DESCRIPTOR), 0);
+  CopyMem (&InformationType.Guid, &DmaProfileGuid, sizeof (EFI_GUID));
+  InformationType.GetInformationBlock = GetDmaProfileInformationBlock;
+  InformationType.SetInformationBlock = SetDmaProfileInformationBlock;
+  AddSupportedInformationType (&InformationType);
+
+  SetMem (&InformationType,
+    sizeof (EFI_ADAPTER_INFORMATION_TYPE_DESCRIPTOR), 0);
+  CopyMem (&InformationType.Guid, &CaptureGuid, sizeof (EFI_GUID));
+  InformationType.GetInformationBlock = GetCaptureInformationBlock;
+  InformationType.SetInformationBlock = SetCaptureInformationBlock;
+  AddSupportedInformationType (&InformationType);
+
 
   Status = gBS->InstallProtocolInterface (
                   &UndiPrivateData->DeviceHandle,
@@ -38,6 +38,130 @@ typedef struct {
 
 #define MAX_SUPPORTED_INFORMATION_TYPE 20
 
+/* Latency profile built from the MAC IEEE 1588 timestamps */
+#define INTELGBE_ADAPTER_INFO_LATENCY_PROFILE_GUID \
+  { 0x5d70403f, 0x352b, 0x4a4b, { 0xa2, 0x30, 0xeb, 0x48, 0x78, 0x2c, 0xa6, 0xe3 }}
+
+typedef struct {
+  UINT64  Count;
+  UINT64  MinNs;
+  UINT64  MaxNs;
+  UINT64  TotalNs;
+} INTELGBE_LATENCY_STATS;
+
+typedef struct {
+  BOOLEAN                 Enabled;        // Set TRUE to start a new profile, FALSE to stop
+  INTELGBE_LATENCY_STATS  WireToReceive;  // RX timestamp to IntelgbeReceive
+  INTELGBE_LATENCY_STATS  TransmitToWire; // IntelgbeTransmit to TX timestamp
+} INTELGBE_ADAPTER_INFO_LATENCY_PROFILE;
+
+/* Link profile, selects whether EEE/LPI is used */
+#define INTELGBE_ADAPTER_INFO_LINK_PROFILE_GUID \
+  { 0xfbe858a1, 0x1c3e, 0x4ed1, { 0x9e, 0xf5, 0xb7, 0xd1, 0xef, 0x81, 0xf1, 0xe8 }}
+
+#define INTELGBE_ADAPTER_INFO_LINK_PROFILE_LOW_LATENCY  0
+#define INTELGBE_ADAPTER_INFO_LINK_PROFILE_POWER_SAVE   1
+
+typedef struct {
+  UINT32   Profile;    // INTELGBE_ADAPTER_INFO_LINK_PROFILE_*
+  BOOLEAN  EeeActive;  // LPI is in use on the current link, ignored by Set
+} INTELGBE_ADAPTER_INFO_LINK_PROFILE;
+
+/* IEEE 802.3x flow control and RX FIFO drop counters */
+#define INTELGBE_ADAPTER_INFO_FLOW_CONTROL_GUID \
+  { 0xcaadd4bf, 0x848e, 0x48c0, { 0xb0, 0xe2, 0x1a, 0x85, 0x06, 0x00, 0x29, 0xb2 }}
+
+#define INTELGBE_ADAPTER_INFO_FC_RX  BIT0  // Honour received pause frames
+#define INTELGBE_ADAPTER_INFO_FC_TX  BIT1  // Send pause frames when the RX FIFO fills
+
+typedef struct {
+  UINT32  Requested;        // INTELGBE_ADAPTER_INFO_FC_* advertised, the only field used by Set
+  UINT32  Active;           // INTELGBE_ADAPTER_INFO_FC_* resolved for the current link
+  UINT64  RxFifoOverflows;  // Frames dropped because the MTL RX FIFO was full
+  UINT64  RxFifoMissed;     // Frames dropped because no RX descriptor was free
+} INTELGBE_ADAPTER_INFO_FLOW_CONTROL;
+
+/* MTL scheduling between the bulk and control TX queues */
+#define INTELGBE_ADAPTER_INFO_TX_SCHEDULING_GUID \
+  { 0xeed9320d, 0x0114, 0x4eee, { 0x92, 0x28, 0x18, 0x18, 0x0c, 0x65, 0xd4, 0xd1 }}
+
+#define INTELGBE_ADAPTER_INFO_TX_SCHED_SP    0  // Strict priority, higher queue first
+#define INTELGBE_ADAPTER_INFO_TX_SCHED_WRR   1  // Weighted round robin, weight in frames
+#define INTELGBE_ADAPTER_INFO_TX_SCHED_DWRR  2  // Deficit weighted round robin, weight in MTU quanta
+
+#define INTELGBE_ADAPTER_INFO_TX_MAX_QUEUES  8
+
+typedef struct {
+  UINT32  Algorithm;   // INTELGBE_ADAPTER_INFO_TX_SCHED_*
+  UINT32  QueueCount;  // TX queues in use, ignored by Set
+  UINT32  Weight[INTELGBE_ADAPTER_INFO_TX_MAX_QUEUES];  // Per queue, first QueueCount used
+} INTELGBE_ADAPTER_INFO_TX_SCHEDULING;
+
+/* AXI burst, outstanding request and DMA burst length settings */
+#define INTELGBE_ADAPTER_INFO_DMA_PROFILE_GUID \
+  { 0xcc111efe, 0x84d8, 0x4ada, { 0x9c, 0x9c, 0x86, 0xc7, 0x4c, 0xf3, 0x3b, 0x67 }}
+
+#define INTELGBE_ADAPTER_INFO_DMA_PROFILE_DEFAULT      0  // 4/8/16 beat bursts, one request in flight
+#define INTELGBE_ADAPTER_INFO_DMA_PROFILE_BALANCED     1  // As default with two reads and writes in flight
+#define INTELGBE_ADAPTER_INFO_DMA_PROFILE_THROUGHPUT   2  // Aligned bursts up to 32 beats, four in flight
+#define INTELGBE_ADAPTER_INFO_DMA_PROFILE_LOW_LATENCY  3  // Short bursts that do not hold the bus
+#define INTELGBE_ADAPTER_INFO_DMA_PROFILE_CUSTOM       4  // Settings taken from the fields below
+
+#define INTELGBE_ADAPTER_INFO_DMA_BLEN_4   BIT0
+#define INTELGBE_ADAPTER_INFO_DMA_BLEN_8   BIT1
+#define INTELGBE_ADAPTER_INFO_DMA_BLEN_16  BIT2
+#define INTELGBE_ADAPTER_INFO_DMA_BLEN_32  BIT3
+
+typedef struct {
+  UINT32   Profile;         // INTELGBE_ADAPTER_INFO_DMA_PROFILE_*, the only field used by Set unless custom
+  UINT32   BurstLengths;    // INTELGBE_ADAPTER_INFO_DMA_BLEN_* the AXI master may use
+  UINT32   ReadRequests;    // Outstanding AXI reads, 1 to 8
+  UINT32   WriteRequests;   // Outstanding AXI writes, 1 to 8
+  UINT32   BurstBeats;      // TX and RX DMA burst length, 1, 2, 4, 8, 16 or 32
+  BOOLEAN  BurstBeatsX8;    // BurstBeats counts units of 8 beats
+  BOOLEAN  AddressAligned;  // Address-aligned beats
+  BOOLEAN  FixedBurst;      // Fixed length bursts only
+} INTELGBE_ADAPTER_INFO_DMA_PROFILE;
+
+/* Leave the link up at ExitBootServices and describe it in the OS handoff table */
+#define INTELGBE_ADAPTER_INFO_OS_HANDOFF_GUID \
+  { 0x5d680bc8, 0x1543, 0x4f62, { 0xb2, 0x82, 0x5b, 0xab, 0x00, 0x35, 0x21, 0x3c }}
+
+typedef struct {
+  BOOLEAN  Enable;
+} INTELGBE_ADAPTER_INFO_OS_HANDOFF;
+
+/* Binary datapath trace, records and events are described in Trace.h */
+#define INTELGBE_ADAPTER_INFO_TRACE_GUID \
+  { 0x4c1e6bbb, 0x84d0, 0x472a, { 0x8f, 0xd5, 0xc9, 0x17, 0xe2, 0xb5, 0x4c, 0xec }}
+
+typedef struct {
+  UINT32  Mask;         // Bit per INTELGBE_TRACE_CLASS_*, the only field used by Set
+  UINT32  RecordCount;  // INTELGBE_TRACE_RECORD entries following, oldest first
+  UINT64  Written;      // Records written since the trace was started
+  UINT64  TscHz;        // Time stamp counter frequency, 0 when unknown
+} INTELGBE_ADAPTER_INFO_TRACE;
+
+/* In-memory packet capture, records and settings are described in Capture.h */
+#define INTELGBE_ADAPTER_INFO_CAPTURE_GUID \
+  { 0x834066c1, 0x485e, 0x4c35, { 0x98, 0xf5, 0xdf, 0x15, 0xce, 0x23, 0x14, 0x3c }}
+
+typedef struct {
+  UINT32    Directions;   // INTELGBE_CAPTURE_TX/RX, 0 stops the capture and keeps the frames
+  UINT32    Flags;        // INTELGBE_CAPTURE_FLAG_*
+  UINT32    SnapLen;      // Bytes kept per frame, 0 for the default
+  UINT32    RingSize;     // Ring size in bytes, 0 for the default
+  UINT16    EtherType;    // Only frames of this EtherType, 0 for all
+  UINT16    Reserved;
+  UINT32    RecordCount;  // Records following, oldest first, each INTELGBE_CAPTURE_RECORD_SIZE bytes
+  UINT64    Captured;     // Frames recorded since the capture was armed
+  UINT64    Dropped;      // Frames not recorded because the ring was full
+  UINT64    Truncated;    // Frames recorded shorter than they were
+  UINT64    StartTsc;     // Time stamp counter when the capture was armed
+  UINT64    TscHz;        // Time stamp counter frequency, 0 when unknown
+  EFI_TIME  StartTime;    // Wall clock at StartTsc, zero when unknown
+} INTELGBE_ADAPTER_INFO_CAPTURE;
+
 /** Adds supported Information Type Descriptor to the list.
   Call before protocol installation.
 
@@ -0,0 +1,1593 @@
+/** @file
+  Network datapath benchmark for Simple Network Protocol instances.
+
+  Runs TX blast, RX sink, ping-pong and mixed frame size scenarios on one SNP
+  handle and reports frame rate, throughput, latency percentiles and the
+  driver's statistics over the run. The checksum and memcopy scenarios measure
+  the DxeNetLib Internet checksum and the driver's frame copy without an
+  interface. Timing uses the CPU time stamp counter
+  calibrated against Stall(), so the tool runs unchanged on hardware and under
+  the emulator.
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "UndiBench.h"
+
+STATIC EFI_GUID mFlowControlGuid = INTELGBE_ADAPTER_INFO_FLOW_CONTROL_GUID;
+STATIC EFI_GUID mTraceGuid       = INTELGBE_ADAPTER_INFO_TRACE_GUID;
+
+STATIC CONST SHELL_PARAM_ITEM mParamList[] = {
+  {L"-l",       TypeFlag},
+  {L"-i",       TypeValue},
+  {L"-m",       TypeValue},
+  {L"-n",       TypeValue},
+  {L"-s",       TypeValue},
+  {L"-batch",   TypeValue},
+  {L"-t",       TypeValue},
+  {L"-d",       TypeValue},
+  {L"-promisc", TypeFlag},
+  {L"-trace",   TypeValue},
+  {L"-?",       TypeFlag},
+  {NULL,        TypeMax}
+};
+
+STATIC CONST CHAR16 *mScenarioNames[] = {
+  L"tx",
+  L"rx",
+  L"pingpong",
+  L"mixed",
+  L"reflect",
+  L"mnp",
+  L"checksum",
+  L"memcopy"
+};
+
+/* Block sizes of the checksum scenario: minimum frame, IPv4 minimum MTU, MTU, page, jumbo */
+STATIC CONST UINT32 mChecksumSizes[] = {
+  64, 576, 1500, 4096, BENCH_CSUM_MAX_LEN
+};
+
+/* Frame sizes of the memcopy scenario: minimum frame, MTU, either side of the
+   non-temporal threshold, jumbo */
+STATIC CONST UINT32 mMemCopySizes[] = {
+  64, 1500, INTELGBE_COPY_STREAM_MIN - 1, INTELGBE_COPY_STREAM_MIN, BENCH_COPY_MAX_LEN
+};
+
+/* Source and destination offsets from a 64-byte boundary, aligned then misaligned */
+STATIC CONST UINT32 mMemCopyOffsets[][2] = {
+  {0, 0}, {1, 3}
+};
+
+/* Simple IMIX: 7 x 60, 4 x 590, 1 x 1514 bytes, interleaved */
+STATIC CONST UINT16 mImix[] = {
+  60, 590, 60, 60, 590, 60, 1514, 60, 590, 60, 590, 60
+};
+
+/** Prints the command line help.
+**/
+STATIC
+VOID
+BenchUsage (
+  VOID
+  )
+{
+  Print (L"UndiBench [-l] [-i index] [-m tx|rx|pingpong|mixed|reflect|mnp|checksum|memcopy] [-n frames]\n");
+  Print (L"          [-s size] [-batch count] [-t seconds] [-d mac] [-promisc]\n");
+  Print (L"  -l        List SNP handles\n");
+  Print (L"  -i        SNP handle to use, from -l (default 0)\n");
+  Print (L"  -m        Scenario (default tx). reflect echoes pingpong frames back, mnp leaves\n");
+  Print (L"            the interface to MNP and reports its receive path, checksum measures\n");
+  Print (L"            NetblockChecksum against the former 16-bit loop, memcopy measures the\n");
+  Print (L"            driver's frame copy against a UINTN loop\n");
+  Print (L"  -n        Frames to send for tx, mixed and pingpong (default %d)\n", BENCH_DEFAULT_FRAMES);
+  Print (L"  -s        Frame size without FCS, %d-%d (default %d)\n",
+    BENCH_MIN_FRAME_LEN, BENCH_MAX_FRAME_LEN, BENCH_DEFAULT_SIZE);
+  Print (L"  -batch    Frames queued before completions are reaped, 1-%d (default %d)\n",
+    BENCH_MAX_BATCH, BENCH_DEFAULT_BATCH);
+  Print (L"  -t        Run time of rx, reflect and mnp in seconds (default %d)\n", BENCH_DEFAULT_SECONDS);
+  Print (L"  -d        Destination MAC address (default broadcast)\n");
+  Print (L"  -promisc  Receive in promiscuous mode\n");
+  Print (L"  -trace    Trace the driver datapath during the run and save the records to a file\n");
+}
+
+/** Parses a MAC address written as six hex bytes separated by ':' or '-'.
+
+   @param[in]   String   Address to parse
+   @param[out]  Mac      Parsed address
+
+   @retval   TRUE    Address parsed
+   @retval   FALSE   String is not a MAC address
+**/
+STATIC
+BOOLEAN
+BenchParseMac (
+  IN  CONST CHAR16    *String,
+  OUT EFI_MAC_ADDRESS *Mac
+  )
+{
+  UINTN  Byte;
+  UINTN  Digit;
+  CHAR16 Char;
+  UINT8  Value;
+
+  ZeroMem (Mac, sizeof (EFI_MAC_ADDRESS));
+  for (Byte = 0; Byte < ETHER_ADDR_LEN; Byte++) {
+    Value = 0;
+    for (Digit = 0; Digit < 2; Digit++) {
+      Char = *String++;
+      if ((Char >= L'0') && (Char <= L'9')) {
+        Value = (UINT8) ((Value << 4) | (Char - L'0'));
+      } else if ((Char >= L'a') && (Char <= L'f')) {
+        Value = (UINT8) ((Value << 4) | (Char - L'a' + 10));
+      } else if ((Char >= L'A') && (Char <= L'F')) {
+        Value = (UINT8) ((Value << 4) | (Char - L'A' + 10));
+      } else {
+        return FALSE;
+      }
+    }
+    Mac->Addr[Byte] = Value;
+    if (Byte < ETHER_ADDR_LEN - 1) {
+      if ((*String != L':') && (*String != L'-')) {
+        return FALSE;
+      }
+      String++;
+    }
+  }
+  return (*String == L'\0');
+}
+
+/** Measures the time stamp counter frequency.
+
+   @return   Ticks per second
+**/
+STATIC
+UINT64
+BenchCalibrateTsc (
+  VOID
+  )
+{
+  UINT64 Start;
+
+  Start = AsmReadTsc ();
+  gBS->Stall (BENCH_CALIBRATE_US);
+  return MultU64x32 (AsmReadTsc () - Start, 1000000 / BENCH_CALIBRATE_US);
+}
+
+/** Converts time stamp counter ticks to nanoseconds.
+
+   @param[in]   Ctx     Benchmark context
+   @param[in]   Ticks   Interval in ticks
+
+   @return   Interval in nanoseconds
+**/
+STATIC
+UINT64
+BenchTicksToNs (
+  IN BENCH_CONTEXT *Ctx,
+  IN UINT64        Ticks
+  )
+{
+  return DivU64x64Remainder (MultU64x32 (Ticks, 1000), DivU64x32 (Ctx->TscHz, 1000000), NULL);
+}
+
+/** Orders latency samples for PerformQuickSort.
+
+   @param[in]   Buffer1   First sample
+   @param[in]   Buffer2   Second sample
+
+   @return   <0, 0 or >0 as Buffer1 is below, equal to or above Buffer2
+**/
+STATIC
+INTN
+EFIAPI
+BenchCompareUint64 (
+  IN CONST VOID *Buffer1,
+  IN CONST VOID *Buffer2
+  )
+{
+  UINT64 A;
+  UINT64 B;
+
+  A = *(CONST UINT64 *) Buffer1;
+  B = *(CONST UINT64 *) Buffer2;
+  return (A < B) ? -1 : ((A > B) ? 1 : 0);
+}
+
+/** Fills a transmit buffer with a benchmark frame.
+
+   @param[in]   Ctx        Benchmark context
+   @param[out]  Frame      Buffer of at least BENCH_MAX_FRAME_LEN bytes
+   @param[in]   Sequence   Sequence number carried by the frame
+**/
+STATIC
+VOID
+BenchBuildFrame (
+  IN  BENCH_CONTEXT *Ctx,
+  OUT UINT8         *Frame,
+  IN  UINT32        Sequence
+  )
+{
+  BENCH_FRAME_HEADER *Header;
+
+  Header = (BENCH_FRAME_HEADER *) Frame;
+  CopyMem (Header->DestAddr, &Ctx->DestAddr, ETHER_ADDR_LEN);
+  CopyMem (Header->SrcAddr, &Ctx->Snp->Mode->CurrentAddress, ETHER_ADDR_LEN);
+  Header->Type     = SwapBytes16 (BENCH_ETHER_TYPE);
+  Header->Magic    = BENCH_MAGIC;
+  Header->Sequence = Sequence;
+  Header->TxTsc    = 0;
+}
+
+/** Returns transmit buffers completed by the driver to the free pool.
+
+   @param[in]   Ctx   Benchmark context
+
+   @return   Number of buffers reclaimed
+**/
+STATIC
+UINTN
+BenchReclaimTx (
+  IN BENCH_CONTEXT *Ctx
+  )
+{
+  VOID       *TxBuf;
+  UINTN      Reclaimed;
+  UINTN      i;
+  EFI_STATUS Status;
+
+  Reclaimed = 0;
+  for (;;) {
+    TxBuf  = NULL;
+    Status = Ctx->Snp->GetStatus (Ctx->Snp, NULL, &TxBuf);
+    if (EFI_ERROR (Status) || (TxBuf == NULL)) {
+      break;
+    }
+    for (i = 0; i < Ctx->Batch; i++) {
+      if (Ctx->TxBusy[i] && (Ctx->TxPool[i] == TxBuf)) {
+        Ctx->TxBusy[i] = FALSE;
+        Reclaimed++;
+        break;
+      }
+    }
+  }
+  return Reclaimed;
+}
+
+/** Waits until the driver has returned every transmit buffer.
+
+   @param[in]   Ctx   Benchmark context
+
+   @retval   TRUE    All buffers are back
+   @retval   FALSE   Buffers still owned by the driver after one second
+**/
+STATIC
+BOOLEAN
+BenchDrainTx (
+  IN BENCH_CONTEXT *Ctx
+  )
+{
+  UINT64 Deadline;
+  UINTN  i;
+
+  Deadline = AsmReadTsc () + Ctx->TscHz;
+  do {
+    BenchReclaimTx (Ctx);
+    for (i = 0; i < Ctx->Batch; i++) {
+      if (Ctx->TxBusy[i]) {
+        break;
+      }
+    }
+    if (i == Ctx->Batch) {
+      return TRUE;
+    }
+  } while (AsmReadTsc () < Deadline);
+
+  return FALSE;
+}
+
+/** Sends Ctx->Frames frames as fast as the driver takes them.
+
+   Up to Ctx->Batch frames are queued before completions are reaped.
+
+   @param[in]   Ctx      Benchmark context
+   @param[out]  Result   Frames and bytes sent
+
+   @retval   EFI_SUCCESS   All frames were queued
+   @retval   EFI_TIMEOUT   No frame was queued or completed for BENCH_TX_STALL_US
+   @retval   other         Transmit failed
+**/
+STATIC
+EFI_STATUS
+BenchTxBlast (
+  IN  BENCH_CONTEXT *Ctx,
+  OUT BENCH_RESULT  *Result
+  )
+{
+  EFI_STATUS Status;
+  UINT32     Sent;
+  UINT32     LastSent;
+  UINTN      Len;
+  UINTN      i;
+  UINT64     Start;
+  UINT64     Now;
+  UINT64     StallTicks;
+  UINT64     Deadline;
+
+  Status     = EFI_SUCCESS;
+  Sent       = 0;
+  StallTicks = DivU64x32 (MultU64x32 (Ctx->TscHz, BENCH_TX_STALL_US / 1000), 1000);
+  Start      = AsmReadTsc ();
+  Deadline   = Start + StallTicks;
+  while (Sent < Ctx->Frames) {
+    LastSent = Sent;
+    for (i = 0; (i < Ctx->Batch) && (Sent < Ctx->Frames); i++) {
+      if (Ctx->TxBusy[i]) {
+        continue;
+      }
+      if (Ctx->Scenario == BenchScenarioMixed) {
+        Len = mImix[Sent % ARRAY_SIZE (mImix)];
+      } else {
+        Len = Ctx->FrameLen;
+      }
+      ((BENCH_FRAME_HEADER *) Ctx->TxPool[i])->Sequence = Sent;
+
+      Status = Ctx->Snp->Transmit (Ctx->Snp, 0, Len, Ctx->TxPool[i], NULL, NULL, NULL);
+      if (Status == EFI_NOT_READY) {
+        break;
+      }
+      if (EFI_ERROR (Status)) {
+        Result->Errors++;
+        goto Exit;
+      }
+      Ctx->TxBusy[i] = TRUE;
+      Result->Bytes += Len;
+      Sent++;
+    }
+    Now = AsmReadTsc ();
+    if ((BenchReclaimTx (Ctx) > 0) || (Sent != LastSent)) {
+      Deadline = Now + StallTicks;
+    } else if (Now >= Deadline) {
+      // The driver neither takes new frames nor completes queued ones
+      Result->Errors++;
+      Status = EFI_TIMEOUT;
+      goto Exit;
+    }
+  }
+  Status = EFI_SUCCESS;
+
+Exit:
+  BenchDrainTx (Ctx);
+  Result->Ticks  = AsmReadTsc () - Start;
+  Result->Frames = Sent;
+  return Status;
+}
+
+/** Counts frames received for Ctx->Seconds.
+
+   @param[in]   Ctx      Benchmark context
+   @param[out]  Result   Frames and bytes received
+**/
+STATIC
+VOID
+BenchRxSink (
+  IN  BENCH_CONTEXT *Ctx,
+  OUT BENCH_RESULT  *Result
+  )
+{
+  EFI_STATUS Status;
+  UINTN      Len;
+  UINT64     Start;
+  UINT64     Deadline;
+
+  Start    = AsmReadTsc ();
+  Deadline = Start + MultU64x32 (Ctx->TscHz, Ctx->Seconds);
+  while (AsmReadTsc () < Deadline) {
+    Len    = BENCH_MAX_FRAME_LEN;
+    Status = Ctx->Snp->Receive (Ctx->Snp, NULL, &Len, Ctx->RxBuffer, NULL, NULL, NULL);
+    if (Status == EFI_NOT_READY) {
+      continue;
+    }
+    if (EFI_ERROR (Status)) {
+      Result->Errors++;
+      continue;
+    }
+    Result->Frames++;
+    Result->Bytes += Len;
+  }
+  Result->Ticks = AsmReadTsc () - Start;
+}
+
+/** Leaves the interface to MNP for Ctx->Seconds.
+
+   Runs at the caller's TPL so the MNP poll timer keeps receiving, the frames
+   it took are read from the MNP counters afterwards.
+
+   @param[in]   Ctx      Benchmark context
+   @param[out]  Result   Run time
+**/
+STATIC
+VOID
+BenchMnp (
+  IN  BENCH_CONTEXT *Ctx,
+  OUT BENCH_RESULT  *Result
+  )
+{
+  UINT64 Start;
+  UINT64 Deadline;
+
+  Start    = AsmReadTsc ();
+  Deadline = Start + MultU64x32 (Ctx->TscHz, Ctx->Seconds);
+  while (AsmReadTsc () < Deadline) {
+    gBS->Stall (1000);
+  }
+  Result->Ticks = AsmReadTsc () - Start;
+}
+
+/** Checks that a received frame is a benchmark frame.
+
+   @param[in]   Frame   Received frame
+   @param[in]   Len     Length of the frame
+
+   @return   Benchmark header, NULL for any other frame
+**/
+STATIC
+BENCH_FRAME_HEADER *
+BenchMatchFrame (
+  IN UINT8 *Frame,
+  IN UINTN Len
+  )
+{
+  BENCH_FRAME_HEADER *Header;
+
+  Header = (BENCH_FRAME_HEADER *) Frame;
+  if ((Len < sizeof (BENCH_FRAME_HEADER))
+    || (Header->Type != SwapBytes16 (BENCH_ETHER_TYPE))
+    || (Header->Magic != BENCH_MAGIC))
+  {
+    return NULL;
+  }
+  return Header;
+}
+
+/** Sends Ctx->Frames requests one at a time and times the replies from a
+   peer running the reflect scenario.
+
+   @param[in]   Ctx      Benchmark context
+   @param[out]  Result   Replies received and their round trip times
+
+   @retval   EFI_SUCCESS            Run completed
+   @retval   EFI_OUT_OF_RESOURCES   No room for the latency samples
+   @retval   other                  Transmit failed
+**/
+STATIC
+EFI_STATUS
+BenchPingPong (
+  IN  BENCH_CONTEXT *Ctx,
+  OUT BENCH_RESULT  *Result
+  )
+{
+  BENCH_FRAME_HEADER *Request;
+  BENCH_FRAME_HEADER *Reply;
+  EFI_STATUS         Status;
+  UINT32             Sequence;
+  UINTN              Len;
+  UINT64             Start;
+  UINT64             Now;
+  UINT64             Deadline;
+
+  Result->Latency = AllocatePool (sizeof (UINT64) * Ctx->Frames);
+  if (Result->Latency == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Request = (BENCH_FRAME_HEADER *) Ctx->TxPool[0];
+  Start   = AsmReadTsc ();
+  for (Sequence = 0; Sequence < Ctx->Frames; Sequence++) {
+    if (!BenchDrainTx (Ctx)) {
+      Status = EFI_TIMEOUT;
+      goto Exit;
+    }
+    Request->Sequence = Sequence;
+    Request->TxTsc    = AsmReadTsc ();
+    Status = Ctx->Snp->Transmit (Ctx->Snp, 0, Ctx->FrameLen, Request, NULL, NULL, NULL);
+    if (EFI_ERROR (Status)) {
+      Result->Errors++;
+      goto Exit;
+    }
+    Ctx->TxBusy[0] = TRUE;
+
+    Deadline = Request->TxTsc + DivU64x32 (MultU64x32 (Ctx->TscHz, BENCH_PING_TIMEOUT_US / 1000), 1000);
+    do {
+      Len    = BENCH_MAX_FRAME_LEN;
+      Status = Ctx->Snp->Receive (Ctx->Snp, NULL, &Len, Ctx->RxBuffer, NULL, NULL, NULL);
+      Now    = AsmReadTsc ();
+      if (Status != EFI_SUCCESS) {
+        continue;
+      }
+      Reply = BenchMatchFrame (Ctx->RxBuffer, Len);
+      if ((Reply != NULL)
+        && (Reply->Sequence == Sequence))
+      {
+        Result->Latency[Result->LatencyCount++] = Now - Reply->TxTsc;
+        Result->Frames++;
+        Result->Bytes += Len;
+        break;
+      }
+    } while (Now < Deadline);
+  }
+  Status = EFI_SUCCESS;
+
+Exit:
+  BenchDrainTx (Ctx);
+  Result->Ticks = AsmReadTsc () - Start;
+  return Status;
+}
+
+/** Echoes benchmark frames back to their sender for Ctx->Seconds.
+
+   @param[in]   Ctx      Benchmark context
+   @param[out]  Result   Frames reflected
+**/
+STATIC
+VOID
+BenchReflect (
+  IN  BENCH_CONTEXT *Ctx,
+  OUT BENCH_RESULT  *Result
+  )
+{
+  BENCH_FRAME_HEADER *Header;
+  EFI_STATUS         Status;
+  UINTN              Len;
+  UINTN              i;
+  UINT64             Start;
+  UINT64             Deadline;
+
+  Start    = AsmReadTsc ();
+  Deadline = Start + MultU64x32 (Ctx->TscHz, Ctx->Seconds);
+  while (AsmReadTsc () < Deadline) {
+    Len    = BENCH_MAX_FRAME_LEN;
+    Status = Ctx->Snp->Receive (Ctx->Snp, NULL, &Len, Ctx->RxBuffer, NULL, NULL, NULL);
+    if (Status != EFI_SUCCESS) {
+      continue;
+    }
+    Header = BenchMatchFrame (Ctx->RxBuffer, Len);
+    if (Header == NULL) {
+      continue;
+    }
+
+    BenchReclaimTx (Ctx);
+    for (i = 0; (i < Ctx->Batch) && Ctx->TxBusy[i]; i++) {
+    }
+    if (i == Ctx->Batch) {
+      Result->Errors++;
+      continue;
+    }
+
+    CopyMem (Header->DestAddr, Header->SrcAddr, ETHER_ADDR_LEN);
+    CopyMem (Header->SrcAddr, &Ctx->Snp->Mode->CurrentAddress, ETHER_ADDR_LEN);
+    CopyMem (Ctx->TxPool[i], Ctx->RxBuffer, Len);
+    Status = Ctx->Snp->Transmit (Ctx->Snp, 0, Len, Ctx->TxPool[i], NULL, NULL, NULL);
+    if (EFI_ERROR (Status)) {
+      Result->Errors++;
+      continue;
+    }
+    Ctx->TxBusy[i] = TRUE;
+    Result->Frames++;
+    Result->Bytes += Len;
+  }
+  BenchDrainTx (Ctx);
+  Result->Ticks = AsmReadTsc () - Start;
+}
+
+/** Internet checksum as NetblockChecksum computed it before the 64-bit and
+   SIMD kernels, the reference for the checksum scenario.
+
+   @param[in]   Bulk   Data
+   @param[in]   Len    Length of the data
+
+   @return   The checksum
+**/
+STATIC
+UINT16
+BenchChecksumReference (
+  IN UINT8  *Bulk,
+  IN UINT32 Len
+  )
+{
+  UINT32 Sum;
+
+  Sum = 0;
+  if ((Len % 2) != 0) {
+    Sum += Bulk[Len - 1];
+  }
+  while (Len > 1) {
+    Sum  += *(UINT16 *) Bulk;
+    Bulk += 2;
+    Len  -= 2;
+  }
+  while ((Sum >> 16) != 0) {
+    Sum = (Sum & 0xFFFF) + (Sum >> 16);
+  }
+  return (UINT16) Sum;
+}
+
+/** Free function of the net buffers wrapping the checksum buffer, which the
+   scenario frees itself.
+
+   @param[in]   Arg   Unused
+**/
+STATIC
+VOID
+EFIAPI
+BenchChecksumExtFree (
+  IN VOID *Arg
+  )
+{
+}
+
+/** Compares NetblockChecksum with the reference for every length and
+   alignment, and NetbufChecksum over blocks split at odd and even offsets.
+
+   @param[in]   Buffer    At least BENCH_CSUM_MAX_LEN + 8 bytes of data
+   @param[out]  Checked   Checksums compared
+
+   @return   Checksums that differ from the reference
+**/
+STATIC
+UINT32
+BenchChecksumVerify (
+  IN  UINT8  *Buffer,
+  OUT UINT32 *Checked
+  )
+{
+  NET_FRAGMENT Frag[3];
+  NET_BUF      *Nbuf;
+  UINT32       Errors;
+  UINT32       Offset;
+  UINT32       Len;
+  UINT32       i;
+  UINT32       j;
+
+  Errors   = 0;
+  *Checked = 0;
+
+  for (Offset = 0; Offset < 8; Offset++) {
+    for (Len = 0; Len <= BENCH_CSUM_MAX_LEN; Len++) {
+      if (NetblockChecksum (Buffer + Offset, Len) != BenchChecksumReference (Buffer + Offset, Len)) {
+        Errors++;
+      }
+      (*Checked)++;
+    }
+  }
+
+  // Three blocks of a jumbo frame, the first two 1-130 bytes long.
+  for (i = 1; i <= 130; i++) {
+    for (j = 1; j <= 130; j++) {
+      Frag[0].Bulk = Buffer + 1;
+      Frag[0].Len  = i;
+      Frag[1].Bulk = Buffer + 1 + i;
+      Frag[1].Len  = j;
+      Frag[2].Bulk = Buffer + 1 + i + j;
+      Frag[2].Len  = BENCH_CSUM_MAX_LEN - i - j;
+      Nbuf = NetbufFromExt (Frag, 3, 0, 0, BenchChecksumExtFree, NULL);
+      if (Nbuf == NULL) {
+        return Errors + 1;
+      }
+      if (NetbufChecksum (Nbuf) != BenchChecksumReference (Buffer + 1, BENCH_CSUM_MAX_LEN)) {
+        Errors++;
+      }
+      (*Checked)++;
+      NetbufFree (Nbuf);
+    }
+  }
+
+  return Errors;
+}
+
+/** Converts the time taken to process a number of bytes to MB/s.
+
+   @param[in]   Ctx     Benchmark context
+   @param[in]   Bytes   Bytes summed or copied
+   @param[in]   Ticks   Time stamp counter ticks taken
+
+   @return   Throughput in MB/s
+**/
+STATIC
+UINT64
+BenchRate (
+  IN BENCH_CONTEXT *Ctx,
+  IN UINT64        Bytes,
+  IN UINT64        Ticks
+  )
+{
+  UINT64 Us;
+
+  Us = DivU64x64Remainder (Ticks, DivU64x32 (Ctx->TscHz, 1000000), NULL);
+  if (Us == 0) {
+    return 0;
+  }
+  return DivU64x64Remainder (Bytes, Us, NULL);
+}
+
+/** Measures NetblockChecksum against the reference on MTU and jumbo sized
+   blocks, aligned and at an odd address, after checking that both agree.
+
+   @param[in]   Ctx   Benchmark context
+
+   @retval   EFI_SUCCESS            Results printed
+   @retval   EFI_OUT_OF_RESOURCES   No memory for the data
+   @retval   EFI_CRC_ERROR          NetblockChecksum differs from the reference
+**/
+STATIC
+EFI_STATUS
+BenchChecksum (
+  IN BENCH_CONTEXT *Ctx
+  )
+{
+  UINT8  *Buffer;
+  UINT32 Seed;
+  UINT32 Checked;
+  UINT32 Errors;
+  UINT32 Iterations;
+  UINT32 Size;
+  UINT32 Offset;
+  UINT32 i;
+  UINT32 k;
+  UINT64 Start;
+  UINT64 RefTicks;
+  UINT64 NewTicks;
+  volatile UINT16 Sink;  // keeps the timed loops from being optimized away
+
+  Buffer = AllocatePool (BENCH_CSUM_MAX_LEN + 8);
+  if (Buffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  // Fixed pseudo-random data, the same on every run.
+  Seed = 1;
+  for (i = 0; i < BENCH_CSUM_MAX_LEN + 8; i++) {
+    Seed      = Seed * 1103515245 + 12345;
+    Buffer[i] = (UINT8) (Seed >> 16);
+  }
+
+  Errors = BenchChecksumVerify (Buffer, &Checked);
+  Print (L"checksum: %d of %d checksums differ from the reference\n", Errors, Checked);
+  if (Errors != 0) {
+    FreePool (Buffer);
+    return EFI_CRC_ERROR;
+  }
+
+  Print (L"  %5s %6s %14s %14s\n", L"size", L"offset", L"reference MB/s", L"MB/s");
+  Sink = 0;
+  for (i = 0; i < ARRAY_SIZE (mChecksumSizes); i++) {
+    Size       = mChecksumSizes[i];
+    Iterations = BENCH_CSUM_VOLUME / Size;
+    for (Offset = 0; Offset < 2; Offset++) {
+      Start = AsmReadTsc ();
+      for (k = 0; k < Iterations; k++) {
+        Sink += BenchChecksumReference (Buffer + Offset, Size);
+      }
+      RefTicks = AsmReadTsc () - Start;
+
+      Start = AsmReadTsc ();
+      for (k = 0; k < Iterations; k++) {
+        Sink += NetblockChecksum (Buffer + Offset, Size);
+      }
+      NewTicks = AsmReadTsc () - Start;
+
+      Print (L"  %5d %6d %14ld %14ld\n", Size, Offset,
+        BenchRate (Ctx, MultU64x32 (Iterations, Size), RefTicks),
+        BenchRate (Ctx, MultU64x32 (Iterations, Size), NewTicks));
+    }
+  }
+
+  FreePool (Buffer);
+  return EFI_SUCCESS;
+}
+
+/** Frame copy as IntelgbeMemCopy did it before the vector kernels, the
+   reference for the memcopy scenario.
+
+   @param[out]  Dest     Destination
+   @param[in]   Source   Source, not overlapping Dest
+   @param[in]   Count    Bytes to copy
+**/
+STATIC
+VOID
+BenchMemCopyReference (
+  OUT UINT8 *Dest,
+  IN  UINT8 *Source,
+  IN  UINT32 Count
+  )
+{
+  UINTN *DestPtr;
+  UINTN *SourcePtr;
+  UINTN i;
+
+  DestPtr   = (UINTN *) Dest;
+  SourcePtr = (UINTN *) Source;
+  for (i = Count / sizeof (UINTN); i > 0; i--) {
+    *DestPtr++ = *SourcePtr++;
+  }
+  Dest   = (UINT8 *) DestPtr;
+  Source = (UINT8 *) SourcePtr;
+  for (i = Count % sizeof (UINTN); i > 0; i--) {
+    *Dest++ = *Source++;
+  }
+}
+
+/** Checks IntelgbeMemCopy for every length up to BENCH_COPY_MAX_LEN at
+   source and destination offsets 0-3, including the bytes around the copy.
+
+   @param[in]   Source    At least BENCH_COPY_MAX_LEN + 64 bytes of data
+   @param[in]   Dest      At least BENCH_COPY_MAX_LEN + 64 bytes
+   @param[out]  Checked   Copies compared
+
+   @return   Copies that differ from the source or touch bytes outside the copy
+**/
+STATIC
+UINT32
+BenchMemCopyVerify (
+  IN  UINT8  *Source,
+  IN  UINT8  *Dest,
+  OUT UINT32 *Checked
+  )
+{
+  UINT32 Errors;
+  UINT32 SrcOffset;
+  UINT32 DstOffset;
+  UINT32 Len;
+
+  Errors   = 0;
+  *Checked = 0;
+
+  for (SrcOffset = 0; SrcOffset < 4; SrcOffset++) {
+    for (DstOffset = 0; DstOffset < 4; DstOffset++) {
+      for (Len = 0; Len <= BENCH_COPY_MAX_LEN; Len++) {
+        SetMem (Dest, Len + 32, 0xA5);
+        IntelgbeMemCopy (Dest + 16 + DstOffset, Source + 16 + SrcOffset, Len);
+        if ((CompareMem (Dest + 16 + DstOffset, Source + 16 + SrcOffset, Len) != 0)
+          || (Dest[15 + DstOffset] != 0xA5)
+          || (Dest[16 + DstOffset + Len] != 0xA5))
+        {
+          Errors++;
+        }
+        (*Checked)++;
+      }
+    }
+  }
+
+  return Errors;
+}
+
+/** Measures IntelgbeMemCopy against the reference on minimum, MTU and jumbo
+   frames and either side of the non-temporal threshold, aligned and
+   misaligned, after checking its copies.
+
+   @param[in]   Ctx   Benchmark context
+
+   @retval   EFI_SUCCESS            Results printed
+   @retval   EFI_OUT_OF_RESOURCES   No memory for the buffers
+   @retval   EFI_COMPROMISED_DATA   IntelgbeMemCopy copied wrongly
+**/
+STATIC
+EFI_STATUS
+BenchMemCopy (
+  IN BENCH_CONTEXT *Ctx
+  )
+{
+  UINT8  *SourcePool;
+  UINT8  *DestPool;
+  UINT8  *Source;
+  UINT8  *Dest;
+  UINT32 Seed;
+  UINT32 Checked;
+  UINT32 Errors;
+  UINT32 Iterations;
+  UINT32 Size;
+  UINT32 i;
+  UINT32 j;
+  UINT32 k;
+  UINT64 Start;
+  UINT64 RefTicks;
+  UINT64 NewTicks;
+
+  SourcePool = AllocatePool (BENCH_COPY_MAX_LEN + 128);
+  DestPool   = AllocatePool (BENCH_COPY_MAX_LEN + 128);
+  if ((SourcePool == NULL) || (DestPool == NULL)) {
+    if (SourcePool != NULL) {
+      FreePool (SourcePool);
+    }
+    if (DestPool != NULL) {
+      FreePool (DestPool);
+    }
+    return EFI_OUT_OF_RESOURCES;
+  }
+  Source = ALIGN_POINTER (SourcePool, 64);
+  Dest   = ALIGN_POINTER (DestPool, 64);
+
+  // Fixed pseudo-random data, the same on every run.
+  Seed = 1;
+  for (i = 0; i < BENCH_COPY_MAX_LEN + 64; i++) {
+    Seed      = Seed * 1103515245 + 12345;
+    Source[i] = (UINT8) (Seed >> 16);
+  }
+
+  Errors = BenchMemCopyVerify (Source, Dest, &Checked);
+  Print (L"memcopy: %d of %d copies differ from the source\n", Errors, Checked);
+  if (Errors != 0) {
+    FreePool (SourcePool);
+    FreePool (DestPool);
+    return EFI_COMPROMISED_DATA;
+  }
+
+  Print (L"  %5s %6s %6s %6s %14s %14s\n", L"size", L"source", L"dest", L"stream", L"reference MB/s", L"MB/s");
+  for (i = 0; i < ARRAY_SIZE (mMemCopySizes); i++) {
+    Size       = mMemCopySizes[i];
+    Iterations = BENCH_COPY_VOLUME / Size;
+    for (j = 0; j < ARRAY_SIZE (mMemCopyOffsets); j++) {
+      Start = AsmReadTsc ();
+      for (k = 0; k < Iterations; k++) {
+        BenchMemCopyReference (Dest + mMemCopyOffsets[j][1], Source + mMemCopyOffsets[j][0], Size);
+      }
+      RefTicks = AsmReadTsc () - Start;
+
+      Start = AsmReadTsc ();
+      for (k = 0; k < Iterations; k++) {
+        IntelgbeMemCopy (Dest + mMemCopyOffsets[j][1], Source + mMemCopyOffsets[j][0], Size);
+      }
+      NewTicks = AsmReadTsc () - Start;
+
+      Print (L"  %5d %6d %6d %6s %14ld %14ld\n", Size, mMemCopyOffsets[j][0], mMemCopyOffsets[j][1],
+        (Size >= INTELGBE_COPY_STREAM_MIN) ? L"yes" : L"no",
+        BenchRate (Ctx, MultU64x32 (Iterations, Size), RefTicks),
+        BenchRate (Ctx, MultU64x32 (Iterations, Size), NewTicks));
+    }
+  }
+
+  FreePool (SourcePool);
+  FreePool (DestPool);
+  return EFI_SUCCESS;
+}
+
+/** Reads the driver counters that are reported as deltas over a run.
+
+   @param[in]   Ctx         Benchmark context
+   @param[out]  Telemetry   Counters, each group flagged when available
+**/
+STATIC
+VOID
+BenchSampleTelemetry (
+  IN  BENCH_CONTEXT   *Ctx,
+  OUT BENCH_TELEMETRY *Telemetry
+  )
+{
+  INTELGBE_ADAPTER_INFO_FLOW_CONTROL *FlowControl;
+  UINTN                              Size;
+  EFI_STATUS                         Status;
+
+  ZeroMem (Telemetry, sizeof (BENCH_TELEMETRY));
+
+  Size   = sizeof (EFI_NETWORK_STATISTICS);
+  Status = Ctx->Snp->Statistics (Ctx->Snp, FALSE, &Size, &Telemetry->Statistics);
+  Telemetry->HaveStatistics = !EFI_ERROR (Status);
+
+  if (Ctx->Aip != NULL) {
+    Status = Ctx->Aip->GetInformation (Ctx->Aip, &mFlowControlGuid, (VOID **) &FlowControl, &Size);
+    if (!EFI_ERROR (Status)) {
+      if (Size >= sizeof (INTELGBE_ADAPTER_INFO_FLOW_CONTROL)) {
+        CopyMem (&Telemetry->FlowControl, FlowControl, sizeof (INTELGBE_ADAPTER_INFO_FLOW_CONTROL));
+        Telemetry->HaveFlowControl = TRUE;
+      }
+      FreePool (FlowControl);
+    }
+  }
+
+  if (Ctx->Mnp != NULL) {
+    Telemetry->HaveMnp = !EFI_ERROR (Ctx->Mnp->GetPollInfo (Ctx->Mnp, &Telemetry->Mnp));
+  }
+}
+
+/** Prints one statistics counter as a delta, skipping unsupported counters.
+
+   @param[in]   Name     Counter name
+   @param[in]   Before   Value before the run
+   @param[in]   After    Value after the run
+**/
+STATIC
+VOID
+BenchPrintDelta (
+  IN CONST CHAR16 *Name,
+  IN UINT64       Before,
+  IN UINT64       After
+  )
+{
+  if ((Before == MAX_UINT64) || (After == MAX_UINT64)) {
+    return;
+  }
+  Print (L"  %-20s %ld\n", Name, After - Before);
+}
+
+/** Prints the MNP receive path counters over a run.
+
+   @param[in]   Before   MNP counters before the run
+   @param[in]   After    MNP counters after the run
+**/
+STATIC
+VOID
+BenchReportMnp (
+  IN EDKII_MNP_POLL_INFO *Before,
+  IN EDKII_MNP_POLL_INFO *After
+  )
+{
+  UINT64 Polls;
+  UINT64 Time;
+  UINT64 Frames;
+  UINT64 Wraps;
+  UINT64 Allocations;
+
+  Polls       = After->Polls - Before->Polls;
+  Time        = After->PolledTime - Before->PolledTime;
+  Frames      = After->Frames - Before->Frames;
+  Wraps       = After->RxWraps - Before->RxWraps;
+  Allocations = After->RxWrapAllocations - Before->RxWrapAllocations;
+
+  Print (L"MNP receive path:\n");
+  Print (L"  %-20s %ld\n", L"Polls", Polls);
+  if (Time != 0) {
+    Print (L"  %-20s %ld\n", L"PollsPerSecond", DivU64x64Remainder (MultU64x32 (Polls, 10000000), Time, NULL));
+  }
+  Print (L"  %-20s %ld\n", L"Frames", Frames);
+  if (Polls != 0) {
+    Print (L"  %-20s %ld.%02ld\n", L"FramesPerPoll",
+      DivU64x64Remainder (Frames, Polls, NULL),
+      ModU64x32 (DivU64x64Remainder (MultU64x32 (Frames, 100), Polls, NULL), 100));
+  }
+  Print (L"  %-20s %ld\n", L"BudgetHits", After->BudgetHits - Before->BudgetHits);
+  Print (L"  %-20s %ld\n", L"RxWraps", Wraps);
+  Print (L"  %-20s %ld\n", L"RxWrapAllocations", Allocations);
+  if (Wraps != 0) {
+    Print (L"  %-20s %ld.%03ld\n", L"AllocationsPerWrap",
+      DivU64x64Remainder (Allocations, Wraps, NULL),
+      ModU64x32 (DivU64x64Remainder (MultU64x32 (Allocations, 1000), Wraps, NULL), 1000));
+  }
+}
+
+/** Prints the results of a run.
+
+   @param[in]   Ctx      Benchmark context
+   @param[in]   Result   Counters collected by the run
+   @param[in]   Before   Driver counters before the run
+   @param[in]   After    Driver counters after the run
+**/
+STATIC
+VOID
+BenchReport (
+  IN BENCH_CONTEXT   *Ctx,
+  IN BENCH_RESULT    *Result,
+  IN BENCH_TELEMETRY *Before,
+  IN BENCH_TELEMETRY *After
+  )
+{
+  UINT64 Us;
+  UINT64 Kbps;
+  UINTN  Count;
+
+  Us   = DivU64x64Remainder (Result->Ticks, DivU64x32 (Ctx->TscHz, 1000000), NULL);
+  Kbps = 0;
+  if (Us != 0) {
+    Kbps = DivU64x64Remainder (MultU64x32 (Result->Bytes, 8000), Us, NULL);
+  }
+
+  Print (L"%s: %ld frames, %ld bytes, %ld errors in %ld.%06ld s\n",
+    mScenarioNames[Ctx->Scenario], Result->Frames, Result->Bytes, Result->Errors,
+    DivU64x32 (Us, 1000000), ModU64x32 (Us, 1000000));
+  if (Us != 0) {
+    Print (L"  %ld pps, %ld.%03ld Mb/s\n",
+      DivU64x64Remainder (MultU64x32 (Result->Frames, 1000000), Us, NULL),
+      DivU64x32 (Kbps, 1000), ModU64x32 (Kbps, 1000));
+  }
+
+  Count = Result->LatencyCount;
+  if (Count != 0) {
+    PerformQuickSort (Result->Latency, Count, sizeof (UINT64), BenchCompareUint64);
+    Print (L"  round trip ns: min %ld p50 %ld p90 %ld p99 %ld p99.9 %ld max %ld (%d lost)\n",
+      BenchTicksToNs (Ctx, Result->Latency[0]),
+      BenchTicksToNs (Ctx, Result->Latency[Count / 2]),
+      BenchTicksToNs (Ctx, Result->Latency[(Count * 90) / 100]),
+      BenchTicksToNs (Ctx, Result->Latency[(Count * 99) / 100]),
+      BenchTicksToNs (Ctx, Result->Latency[(Count * 999) / 1000]),
+      BenchTicksToNs (Ctx, Result->Latency[Count - 1]),
+      Ctx->Frames - Count);
+  }
+
+  if (Before->HaveStatistics && After->HaveStatistics) {
+    Print (L"Driver statistics:\n");
+    BenchPrintDelta (L"RxTotalFrames", Before->Statistics.RxTotalFrames, After->Statistics.RxTotalFrames);
+    BenchPrintDelta (L"RxDroppedFrames", Before->Statistics.RxDroppedFrames, After->Statistics.RxDroppedFrames);
+    BenchPrintDelta (L"RxCrcErrorFrames", Before->Statistics.RxCrcErrorFrames, After->Statistics.RxCrcErrorFrames);
+    BenchPrintDelta (L"TxTotalFrames", Before->Statistics.TxTotalFrames, After->Statistics.TxTotalFrames);
+    BenchPrintDelta (L"TxDroppedFrames", Before->Statistics.TxDroppedFrames, After->Statistics.TxDroppedFrames);
+  }
+  if (Before->HaveFlowControl && After->HaveFlowControl) {
+    Print (L"Driver telemetry:\n");
+    BenchPrintDelta (L"RxFifoOverflows", Before->FlowControl.RxFifoOverflows, After->FlowControl.RxFifoOverflows);
+    BenchPrintDelta (L"RxFifoMissed", Before->FlowControl.RxFifoMissed, After->FlowControl.RxFifoMissed);
+  }
+  if (Before->HaveMnp && After->HaveMnp) {
+    BenchReportMnp (&Before->Mnp, &After->Mnp);
+  }
+}
+
+/** Lists SNP handles with their index for -i.
+
+   @param[in]   Handles   SNP handles
+   @param[in]   Count     Number of handles
+**/
+STATIC
+VOID
+BenchListHandles (
+  IN EFI_HANDLE *Handles,
+  IN UINTN      Count
+  )
+{
+  EFI_SIMPLE_NETWORK_PROTOCOL *Snp;
+  EFI_MAC_ADDRESS             *Mac;
+  UINTN                       i;
+
+  for (i = 0; i < Count; i++) {
+    if (EFI_ERROR (gBS->HandleProtocol (Handles[i], &gEfiSimpleNetworkProtocolGuid, (VOID **) &Snp))) {
+      continue;
+    }
+    Mac = &Snp->Mode->CurrentAddress;
+    Print (L"%d: %02x:%02x:%02x:%02x:%02x:%02x state %d media %a\n", i,
+      Mac->Addr[0], Mac->Addr[1], Mac->Addr[2], Mac->Addr[3], Mac->Addr[4], Mac->Addr[5],
+      Snp->Mode->State,
+      Snp->Mode->MediaPresent ? "present" : "absent");
+  }
+}
+
+/** Brings the SNP instance to the initialized state and sets the receive
+   filters for the run.
+
+   @param[in]   Ctx   Benchmark context
+
+   @retval   EFI_SUCCESS   Interface ready
+   @retval   other         Start, Initialize or ReceiveFilters failed
+**/
+STATIC
+EFI_STATUS
+BenchPrepareSnp (
+  IN BENCH_CONTEXT *Ctx
+  )
+{
+  EFI_SIMPLE_NETWORK_PROTOCOL *Snp;
+  EFI_STATUS                  Status;
+  UINT32                      Enable;
+
+  Snp = Ctx->Snp;
+  if (Snp->Mode->State == EfiSimpleNetworkStopped) {
+    Status = Snp->Start (Snp);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+  if (Snp->Mode->State == EfiSimpleNetworkStarted) {
+    Status = Snp->Initialize (Snp, 0, 0);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  Enable = EFI_SIMPLE_NETWORK_RECEIVE_UNICAST | EFI_SIMPLE_NETWORK_RECEIVE_BROADCAST;
+  if (Ctx->Promiscuous) {
+    Enable |= EFI_SIMPLE_NETWORK_RECEIVE_PROMISCUOUS;
+  }
+  Enable &= Snp->Mode->ReceiveFilterMask;
+  return Snp->ReceiveFilters (Snp, Enable, 0, FALSE, 0, NULL);
+}
+
+/** Parses the command line into the benchmark context.
+
+   @param[in]   Package   Parsed command line
+   @param[out]  Ctx       Benchmark context
+   @param[out]  Index     SNP handle index
+
+   @retval   TRUE    Options valid
+   @retval   FALSE   Invalid option, message printed
+**/
+STATIC
+BOOLEAN
+BenchParseOptions (
+  IN  LIST_ENTRY    *Package,
+  OUT BENCH_CONTEXT *Ctx,
+  OUT UINTN         *Index
+  )
+{
+  CONST CHAR16 *Value;
+  UINTN        i;
+
+  Ctx->Scenario = BenchScenarioTxBlast;
+  Ctx->Frames   = BENCH_DEFAULT_FRAMES;
+  Ctx->FrameLen = BENCH_DEFAULT_SIZE;
+  Ctx->Batch    = BENCH_DEFAULT_BATCH;
+  Ctx->Seconds  = BENCH_DEFAULT_SECONDS;
+  SetMem (&Ctx->DestAddr, ETHER_ADDR_LEN, 0xFF);
+  *Index = 0;
+
+  Value = ShellCommandLineGetValue (Package, L"-i");
+  if (Value != NULL) {
+    *Index = ShellStrToUintn (Value);
+  }
+
+  Value = ShellCommandLineGetValue (Package, L"-m");
+  if (Value != NULL) {
+    for (i = 0; i < ARRAY_SIZE (mScenarioNames); i++) {
+      if (StrCmp (Value, mScenarioNames[i]) == 0) {
+        break;
+      }
+    }
+    if (i == ARRAY_SIZE (mScenarioNames)) {
+      Print (L"Unknown scenario %s\n", Value);
+      return FALSE;
+    }
+    Ctx->Scenario = (BENCH_SCENARIO) i;
+  }
+
+  Value = ShellCommandLineGetValue (Package, L"-n");
+  if (Value != NULL) {
+    Ctx->Frames = (UINT32) ShellStrToUintn (Value);
+  }
+
+  Value = ShellCommandLineGetValue (Package, L"-s");
+  if (Value != NULL) {
+    Ctx->FrameLen = (UINT32) ShellStrToUintn (Value);
+  }
+  if ((Ctx->FrameLen < BENCH_MIN_FRAME_LEN)
+    || (Ctx->FrameLen > BENCH_MAX_FRAME_LEN))
+  {
+    Print (L"Frame size must be %d-%d\n", BENCH_MIN_FRAME_LEN, BENCH_MAX_FRAME_LEN);
+    return FALSE;
+  }
+
+  Value = ShellCommandLineGetValue (Package, L"-batch");
+  if (Value != NULL) {
+    Ctx->Batch = (UINT32) ShellStrToUintn (Value);
+  }
+  if ((Ctx->Batch == 0)
+    || (Ctx->Batch > BENCH_MAX_BATCH))
+  {
+    Print (L"Batch must be 1-%d\n", BENCH_MAX_BATCH);
+    return FALSE;
+  }
+
+  Value = ShellCommandLineGetValue (Package, L"-t");
+  if (Value != NULL) {
+    Ctx->Seconds = (UINT32) ShellStrToUintn (Value);
+  }
+
+  Value = ShellCommandLineGetValue (Package, L"-d");
+  if ((Value != NULL)
+    && !BenchParseMac (Value, &Ctx->DestAddr))
+  {
+    Print (L"Invalid MAC address %s\n", Value);
+    return FALSE;
+  }
+
+  Ctx->Promiscuous = ShellCommandLineGetFlag (Package, L"-promisc");
+  Ctx->TraceFile   = ShellCommandLineGetValue (Package, L"-trace");
+  return TRUE;
+}
+
+/** Starts or stops the driver's binary datapath trace.
+
+   @param[in]   Ctx    Benchmark context
+   @param[in]   Mask   Bit per INTELGBE_TRACE_CLASS_*, 0 to stop
+
+   @retval   EFI_SUCCESS     Trace mask applied
+   @retval   EFI_UNSUPPORTED Driver does not publish the trace
+**/
+STATIC
+EFI_STATUS
+BenchSetTrace (
+  IN BENCH_CONTEXT *Ctx,
+  IN UINT32        Mask
+  )
+{
+  INTELGBE_ADAPTER_INFO_TRACE Trace;
+
+  if (Ctx->Aip == NULL) {
+    return EFI_UNSUPPORTED;
+  }
+
+  ZeroMem (&Trace, sizeof (Trace));
+  Trace.Mask = Mask;
+  return Ctx->Aip->SetInformation (Ctx->Aip, &mTraceGuid, &Trace, sizeof (Trace));
+}
+
+/** Writes the driver's trace, header and records as returned by the driver,
+   to the file given with -trace for offline decoding.
+
+   @param[in]   Ctx   Benchmark context
+
+   @retval   EFI_SUCCESS   Trace saved
+   @retval   other         Trace could not be read or written
+**/
+STATIC
+EFI_STATUS
+BenchSaveTrace (
+  IN BENCH_CONTEXT *Ctx
+  )
+{
+  INTELGBE_ADAPTER_INFO_TRACE *Trace;
+  SHELL_FILE_HANDLE           File;
+  UINTN                       Size;
+  EFI_STATUS                  Status;
+
+  Status = Ctx->Aip->GetInformation (Ctx->Aip, &mTraceGuid, (VOID **) &Trace, &Size);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  // Start from an empty file so a shorter trace leaves no stale records behind.
+  ShellDeleteFileByName (Ctx->TraceFile);
+  Status = ShellOpenFileByName (Ctx->TraceFile, &File,
+             EFI_FILE_MODE_CREATE | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_READ, 0);
+  if (!EFI_ERROR (Status)) {
+    Status = ShellWriteFile (File, &Size, Trace);
+    ShellCloseFile (&File);
+  }
+  if (!EFI_ERROR (Status)) {
+    Print (L"Trace: %d of %ld records saved to %s\n", Trace->RecordCount,
+      Trace->Written, Ctx->TraceFile);
+  }
+
+  FreePool (Trace);
+  return Status;
+}
+
+/** Runs the selected scenario with the MNP poll timer held off.
+
+   @param[in]   Ctx   Benchmark context
+
+   @retval   EFI_SUCCESS   Scenario ran, results printed
+   @retval   other         Scenario failed
+**/
+STATIC
+EFI_STATUS
+BenchRun (
+  IN BENCH_CONTEXT *Ctx
+  )
+{
+  BENCH_RESULT    Result;
+  BENCH_TELEMETRY Before;
+  BENCH_TELEMETRY After;
+  EFI_STATUS      Status;
+  EFI_TPL         OldTpl;
+  UINTN           i;
+
+  ZeroMem (&Result, sizeof (Result));
+  for (i = 0; i < Ctx->Batch; i++) {
+    BenchBuildFrame (Ctx, Ctx->TxPool[i], 0);
+  }
+
+  BenchSampleTelemetry (Ctx, &Before);
+
+  if (Ctx->TraceFile != NULL) {
+    Status = BenchSetTrace (Ctx, (1U << (INTELGBE_TRACE_CLASS_CMD + 1)) - 1);
+    if (EFI_ERROR (Status)) {
+      Print (L"Driver trace not available: %r\n", Status);
+      Ctx->TraceFile = NULL;
+    }
+  }
+
+  // MNP polls the interface from a TPL_CALLBACK timer and would take our frames,
+  // unless it is MNP being measured.
+  OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+  if (Ctx->Scenario == BenchScenarioMnp) {
+    gBS->RestoreTPL (OldTpl);
+  }
+  switch (Ctx->Scenario) {
+  case BenchScenarioMnp:
+    BenchMnp (Ctx, &Result);
+    Status = EFI_SUCCESS;
+    break;
+  case BenchScenarioRxSink:
+    BenchRxSink (Ctx, &Result);
+    Status = EFI_SUCCESS;
+    break;
+  case BenchScenarioPingPong:
+    Status = BenchPingPong (Ctx, &Result);
+    break;
+  case BenchScenarioReflect:
+    BenchReflect (Ctx, &Result);
+    Status = EFI_SUCCESS;
+    break;
+  default:
+    Status = BenchTxBlast (Ctx, &Result);
+    break;
+  }
+  if (Ctx->Scenario != BenchScenarioMnp) {
+    gBS->RestoreTPL (OldTpl);
+  }
+
+  if (Ctx->TraceFile != NULL) {
+    BenchSetTrace (Ctx, 0);
+    if (EFI_ERROR (BenchSaveTrace (Ctx))) {
+      Print (L"Could not save trace to %s\n", Ctx->TraceFile);
+    }
+  }
+
+  BenchSampleTelemetry (Ctx, &After);
+
+  if (EFI_ERROR (Status)) {
+    Print (L"Run stopped: %r\n", Status);
+  }
+  BenchReport (Ctx, &Result, &Before, &After);
+
+  if (Result.Latency != NULL) {
+    FreePool (Result.Latency);
+  }
+  return Status;
+}
+
+/** Application entry point.
+
+   @param[in]   Argc   Number of command line arguments
+   @param[in]   Argv   Command line arguments
+
+   @retval   SHELL_SUCCESS            Benchmark ran
+   @retval   SHELL_INVALID_PARAMETER  Invalid command line
+   @retval   SHELL_NOT_FOUND          No SNP instance with the given index
+   @retval   SHELL_DEVICE_ERROR       Interface could not be used
+   @retval   SHELL_ABORTED            Checksum differs from the reference
+**/
+INTN
+EFIAPI
+ShellAppMain (
+  IN UINTN  Argc,
+  IN CHAR16 **Argv
+  )
+{
+  BENCH_CONTEXT *Ctx;
+  LIST_ENTRY    *Package;
+  CHAR16        *ProblemParam;
+  EFI_HANDLE    *Handles;
+  UINTN         HandleCount;
+  UINTN         Index;
+  UINTN         i;
+  EFI_STATUS    Status;
+  INTN          Ret;
+
+  Package = NULL;
+  Handles = NULL;
+  Ctx     = NULL;
+
+  Status = ShellCommandLineParse (mParamList, &Package, &ProblemParam, TRUE);
+  if (EFI_ERROR (Status)) {
+    if (ProblemParam != NULL) {
+      Print (L"Unknown option %s\n", ProblemParam);
+      FreePool (ProblemParam);
+    }
+    BenchUsage ();
+    return SHELL_INVALID_PARAMETER;
+  }
+  if (ShellCommandLineGetFlag (Package, L"-?")) {
+    BenchUsage ();
+    Ret = SHELL_SUCCESS;
+    goto Exit;
+  }
+
+  Ctx = AllocateZeroPool (sizeof (BENCH_CONTEXT));
+  if (Ctx == NULL) {
+    Ret = SHELL_OUT_OF_RESOURCES;
+    goto Exit;
+  }
+  if (!BenchParseOptions (Package, Ctx, &Index)) {
+    Ret = SHELL_INVALID_PARAMETER;
+    goto Exit;
+  }
+
+  // The checksum and memcopy scenarios measure code alone, no interface needed.
+  if ((Ctx->Scenario == BenchScenarioChecksum) || (Ctx->Scenario == BenchScenarioMemCopy)) {
+    Ctx->TscHz = BenchCalibrateTsc ();
+    if (Ctx->Scenario == BenchScenarioChecksum) {
+      Status = BenchChecksum (Ctx);
+    } else {
+      Status = BenchMemCopy (Ctx);
+    }
+    Ret = EFI_ERROR (Status) ? SHELL_ABORTED : SHELL_SUCCESS;
+    goto Exit;
+  }
+
+  Status = gBS->LocateHandleBuffer (ByProtocol, &gEfiSimpleNetworkProtocolGuid,
+                  NULL, &HandleCount, &Handles);
+  if (EFI_ERROR (Status)) {
+    Print (L"No network interfaces found\n");
+    Ret = SHELL_NOT_FOUND;
+    goto Exit;
+  }
+  if (ShellCommandLineGetFlag (Package, L"-l")) {
+    BenchListHandles (Handles, HandleCount);
+    Ret = SHELL_SUCCESS;
+    goto Exit;
+  }
+
+  if (Index >= HandleCount) {
+    Print (L"Interface %d not found, %d available\n", Index, HandleCount);
+    Ret = SHELL_NOT_FOUND;
+    goto Exit;
+  }
+
+  Ctx->Handle = Handles[Index];
+  gBS->HandleProtocol (Ctx->Handle, &gEfiSimpleNetworkProtocolGuid, (VOID **) &Ctx->Snp);
+  if (EFI_ERROR (gBS->HandleProtocol (Ctx->Handle, &gEfiAdapterInformationProtocolGuid,
+                       (VOID **) &Ctx->Aip)))
+  {
+    Ctx->Aip = NULL;
+  }
+  if (EFI_ERROR (gBS->HandleProtocol (Ctx->Handle, &gEdkiiMnpPollInfoProtocolGuid,
+                       (VOID **) &Ctx->Mnp)))
+  {
+    Ctx->Mnp = NULL;
+  }
+  if ((Ctx->Scenario == BenchScenarioMnp) && (Ctx->Mnp == NULL)) {
+    Print (L"Interface %d is not managed by MNP\n", Index);
+    Ret = SHELL_NOT_FOUND;
+    goto Exit;
+  }
+
+  // Ping-pong keeps a single request in flight.
+  if (Ctx->Scenario == BenchScenarioPingPong) {
+    Ctx->Batch = 1;
+  }
+  for (i = 0; i < Ctx->Batch; i++) {
+    Ctx->TxPool[i] = AllocateZeroPool (BENCH_MAX_FRAME_LEN);
+    if (Ctx->TxPool[i] == NULL) {
+      Ret = SHELL_OUT_OF_RESOURCES;
+      goto Exit;
+    }
+  }
+  Ctx->RxBuffer = AllocateZeroPool (BENCH_MAX_FRAME_LEN);
+  if (Ctx->RxBuffer == NULL) {
+    Ret = SHELL_OUT_OF_RESOURCES;
+    goto Exit;
+  }
+
+  // MNP configured the interface, leave its receive filters alone.
+  Status = EFI_SUCCESS;
+  if (Ctx->Scenario != BenchScenarioMnp) {
+    Status = BenchPrepareSnp (Ctx);
+  }
+  if (EFI_ERROR (Status)) {
+    Print (L"Interface %d not usable: %r\n", Index, Status);
+    Ret = SHELL_DEVICE_ERROR;
+    goto Exit;
+  }
+
+  Ctx->TscHz = BenchCalibrateTsc ();
+  Status = BenchRun (Ctx);
+  Ret = EFI_ERROR (Status) ? SHELL_DEVICE_ERROR : SHELL_SUCCESS;
+
+Exit:
+  if (Ctx != NULL) {
+    // Buffers the driver never returned must stay allocated.
+    for (i = 0; i < BENCH_MAX_BATCH; i++) {
+      if ((Ctx->TxPool[i] != NULL) && !Ctx->TxBusy[i]) {
+        FreePool (Ctx->TxPool[i]);
+      }
+    }
+    if (Ctx->RxBuffer != NULL) {
+      FreePool (Ctx->RxBuffer);
+    }
+    FreePool (Ctx);
+  }
+  if (Handles != NULL) {
+    FreePool (Handles);
+  }
+  ShellCommandLineFreeVarList (Package);
+  return Ret;
+}
@@ -0,0 +1,128 @@
+/** @file
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef UNDI_BENCH_H_
+#define UNDI_BENCH_H_
+
+#include <Uefi.h>
+
+#include <Protocol/SimpleNetwork.h>
+#include <Protocol/AdapterInformation.h>
+#include <Protocol/MnpPollInfo.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+#include <Library/ShellLib.h>
+#include <Library/SortLib.h>
+#include <Library/NetLib.h>
+
+/* Telemetry types published by the UNDI driver through the Adapter Information Protocol */
+#include "../../AdapterInformation.h"
+#include "../../Trace.h"
+/* The driver's frame copy, built into the memcopy scenario */
+#include "../../MemCopy.h"
+
+/* Benchmark frames use the IEEE local experimental EtherType */
+#define BENCH_ETHER_TYPE        0x88B5
+#define BENCH_MAGIC             SIGNATURE_32 ('U', 'B', 'N', 'C')
+
+/* Frame sizes without FCS */
+#define BENCH_MIN_FRAME_LEN     60
+#define BENCH_MAX_FRAME_LEN     1514
+
+/* Defaults for the command line options */
+#define BENCH_DEFAULT_FRAMES    100000
+#define BENCH_DEFAULT_SIZE      BENCH_MAX_FRAME_LEN
+#define BENCH_DEFAULT_BATCH     32
+#define BENCH_DEFAULT_SECONDS   10
+#define BENCH_MAX_BATCH         256
+
+/* Time a ping-pong request waits for its reply before it counts as lost */
+#define BENCH_PING_TIMEOUT_US   100000
+
+/* Time the transmit scenarios wait without queuing or completing a frame */
+#define BENCH_TX_STALL_US       1000000
+
+/* Checksum scenario: largest block summed, and bytes summed per measurement */
+#define BENCH_CSUM_MAX_LEN      9000
+#define BENCH_CSUM_VOLUME       SIZE_256MB
+
+/* Memcopy scenario: largest frame copied, and bytes copied per measurement */
+#define BENCH_COPY_MAX_LEN      9000
+#define BENCH_COPY_VOLUME       SIZE_256MB
+
+/* Stall used to measure the time stamp counter frequency */
+#define BENCH_CALIBRATE_US      100000
+
+#define ETHER_ADDR_LEN          6
+
+#pragma pack(1)
+typedef struct {
+  UINT8   DestAddr[ETHER_ADDR_LEN];
+  UINT8   SrcAddr[ETHER_ADDR_LEN];
+  UINT16  Type;
+  UINT32  Magic;
+  UINT32  Sequence;
+  UINT64  TxTsc;     // Sender's time stamp counter, echoed back by the reflector
+} BENCH_FRAME_HEADER;
+#pragma pack()
+
+typedef enum {
+  BenchScenarioTxBlast,
+  BenchScenarioRxSink,
+  BenchScenarioPingPong,
+  BenchScenarioMixed,
+  BenchScenarioReflect,
+  BenchScenarioMnp,
+  BenchScenarioChecksum,
+  BenchScenarioMemCopy
+} BENCH_SCENARIO;
+
+typedef struct {
+  EFI_HANDLE                        Handle;
+  EFI_SIMPLE_NETWORK_PROTOCOL       *Snp;
+  EFI_ADAPTER_INFORMATION_PROTOCOL  *Aip;  // NULL when the driver does not publish telemetry
+  EDKII_MNP_POLL_INFO_PROTOCOL      *Mnp;  // NULL when MNP does not manage the interface
+  BENCH_SCENARIO                    Scenario;
+  UINT32                            Frames;
+  UINT32                            FrameLen;
+  UINT32                            Batch;
+  UINT32                            Seconds;
+  BOOLEAN                           Promiscuous;
+  CONST CHAR16                      *TraceFile;  // driver trace saved here after the run, NULL for none
+  EFI_MAC_ADDRESS                   DestAddr;
+  UINT64                            TscHz;
+
+  UINT8                             *TxPool[BENCH_MAX_BATCH];
+  BOOLEAN                           TxBusy[BENCH_MAX_BATCH];  // handed to Transmit, not yet back from GetStatus
+  UINT8                             *RxBuffer;
+} BENCH_CONTEXT;
+
+/* Counters collected by one run */
+typedef struct {
+  UINT64  Frames;
+  UINT64  Bytes;
+  UINT64  Errors;
+  UINT64  Ticks;
+  UINT64  *Latency;      // ping-pong round trip times in ticks
+  UINTN   LatencyCount;
+} BENCH_RESULT;
+
+/* Driver telemetry sampled before and after a run */
+typedef struct {
+  BOOLEAN                             HaveStatistics;
+  EFI_NETWORK_STATISTICS              Statistics;
+  BOOLEAN                             HaveFlowControl;
+  INTELGBE_ADAPTER_INFO_FLOW_CONTROL  FlowControl;
+  BOOLEAN                             HaveMnp;
+  EDKII_MNP_POLL_INFO                 Mnp;
+} BENCH_TELEMETRY;
+
+#endif /* UNDI_BENCH_H_ */
@@ -0,0 +1,503 @@
+/** @file
+  Packet capture front end for the UNDI driver.
+
+  Arms the capture ring the driver keeps in memory, stops it and writes the
+  captured frames to a pcap file that Wireshark or tcpdump read directly.
+  The driver timestamps frames with the CPU time stamp counter, converted
+  here to wall clock time from the moment the capture was armed.
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "UndiCapture.h"
+
+STATIC EFI_GUID mCaptureGuid = INTELGBE_ADAPTER_INFO_CAPTURE_GUID;
+
+STATIC CONST SHELL_PARAM_ITEM mParamList[] = {
+  {L"-l",       TypeFlag},
+  {L"-i",       TypeValue},
+  {L"-start",   TypeFlag},
+  {L"-stop",    TypeFlag},
+  {L"-w",       TypeValue},
+  {L"-dir",     TypeValue},
+  {L"-snap",    TypeValue},
+  {L"-type",    TypeValue},
+  {L"-size",    TypeValue},
+  {L"-first",   TypeFlag},
+  {L"-?",       TypeFlag},
+  {NULL,        TypeMax}
+};
+
+/** Prints the command line help.
+**/
+STATIC
+VOID
+CaptureUsage (
+  VOID
+  )
+{
+  Print (L"UndiCapture [-l] [-i index] [-start [-dir rx|tx|both] [-snap bytes] [-type ethertype]\n");
+  Print (L"            [-size KB] [-first]] [-stop] [-w file]\n");
+  Print (L"  -l        List SNP handles\n");
+  Print (L"  -i        SNP handle to use, from -l (default 0)\n");
+  Print (L"  -start    Arm the capture, discarding the frames captured so far\n");
+  Print (L"  -dir      Directions to capture (default both)\n");
+  Print (L"  -snap     Bytes kept per frame, 1-%d (default %d)\n",
+    INTELGBE_CAPTURE_MAX_SNAPLEN, INTELGBE_CAPTURE_DEFAULT_SNAPLEN);
+  Print (L"  -type     Only capture this EtherType, e.g. 0x0800 (default all)\n");
+  Print (L"  -size     Capture ring size in KB (default %d)\n",
+    INTELGBE_CAPTURE_DEFAULT_RING_SIZE / SIZE_1KB);
+  Print (L"  -first    Keep the first frames once the ring is full instead of the newest\n");
+  Print (L"  -stop     Stop capturing, the frames are kept\n");
+  Print (L"  -w        Write the captured frames to a pcap file\n");
+  Print (L"Without -start, -stop or -w the capture state is printed.\n");
+}
+
+/** Lists SNP handles with their index for -i.
+
+   @param[in]   Handles   SNP handles
+   @param[in]   Count     Number of handles
+**/
+STATIC
+VOID
+CaptureListHandles (
+  IN EFI_HANDLE *Handles,
+  IN UINTN      Count
+  )
+{
+  EFI_SIMPLE_NETWORK_PROTOCOL      *Snp;
+  EFI_ADAPTER_INFORMATION_PROTOCOL *Aip;
+  EFI_MAC_ADDRESS                  *Mac;
+  UINTN                            i;
+
+  for (i = 0; i < Count; i++) {
+    if (EFI_ERROR (gBS->HandleProtocol (Handles[i], &gEfiSimpleNetworkProtocolGuid, (VOID **) &Snp))) {
+      continue;
+    }
+    Mac = &Snp->Mode->CurrentAddress;
+    Print (L"%d: %02x:%02x:%02x:%02x:%02x:%02x capture %a\n", i,
+      Mac->Addr[0], Mac->Addr[1], Mac->Addr[2], Mac->Addr[3], Mac->Addr[4], Mac->Addr[5],
+      EFI_ERROR (gBS->HandleProtocol (Handles[i], &gEfiAdapterInformationProtocolGuid, (VOID **) &Aip)) ?
+        "unsupported" : "supported");
+  }
+}
+
+/** Converts an EFI_TIME to seconds since the Unix epoch, in UTC.
+
+   @param[in]   Time   Time to convert
+
+   @return   Seconds since 1970-01-01, 0 when the time is not set
+**/
+STATIC
+UINT64
+CaptureEpochSeconds (
+  IN CONST EFI_TIME *Time
+  )
+{
+  INTN    Year;
+  INTN    Month;
+  INTN    Era;
+  INTN    YearOfEra;
+  INTN    DayOfYear;
+  INTN    Days;
+  UINT64  Seconds;
+
+  if (Time->Year < 1970) {
+    return 0;
+  }
+
+  // Days from civil, March based so the leap day ends the year.
+  Year  = Time->Year - ((Time->Month <= 2) ? 1 : 0);
+  Month = Time->Month;
+  Era   = Year / 400;
+  YearOfEra = Year - Era * 400;
+  DayOfYear = (153 * (Month + ((Month > 2) ? -3 : 9)) + 2) / 5 + Time->Day - 1;
+  Days  = Era * 146097 + YearOfEra * 365 + YearOfEra / 4 - YearOfEra / 100 + DayOfYear - 719468;
+
+  Seconds = MultU64x32 ((UINT64) Days, SECONDS_PER_DAY) +
+            Time->Hour * 3600 + Time->Minute * 60 + Time->Second;
+
+  // Local time is UTC minus TimeZone minutes.
+  if (Time->TimeZone != EFI_UNSPECIFIED_TIMEZONE) {
+    Seconds += (INT64) Time->TimeZone * 60;
+  }
+
+  return Seconds;
+}
+
+/** Reads the capture state and frames from the driver.
+
+   @param[in]   Aip       Adapter Information Protocol of the interface
+   @param[out]  Capture   Returns the header followed by the records, free with FreePool
+   @param[out]  Size      Returns the size of Capture
+
+   @retval   EFI_SUCCESS   Capture read
+   @retval   other         The driver does not support capturing
+**/
+STATIC
+EFI_STATUS
+CaptureRead (
+  IN  EFI_ADAPTER_INFORMATION_PROTOCOL *Aip,
+  OUT INTELGBE_ADAPTER_INFO_CAPTURE    **Capture,
+  OUT UINTN                            *Size
+  )
+{
+  return Aip->GetInformation (Aip, &mCaptureGuid, (VOID **) Capture, Size);
+}
+
+/** Prints the capture settings and counters.
+
+   @param[in]   Aip   Adapter Information Protocol of the interface
+
+   @retval   EFI_SUCCESS   State printed
+   @retval   other         The driver does not support capturing
+**/
+STATIC
+EFI_STATUS
+CapturePrintState (
+  IN EFI_ADAPTER_INFORMATION_PROTOCOL *Aip
+  )
+{
+  INTELGBE_ADAPTER_INFO_CAPTURE *Capture;
+  UINTN                         Size;
+  EFI_STATUS                    Status;
+
+  Status = CaptureRead (Aip, &Capture, &Size);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Print (L"Capture:    %a%a%a\n",
+    (Capture->Directions == 0) ? "stopped" : "armed",
+    ((Capture->Directions & INTELGBE_CAPTURE_RX) != 0) ? " rx" : "",
+    ((Capture->Directions & INTELGBE_CAPTURE_TX) != 0) ? " tx" : "");
+  if (Capture->RingSize != 0) {
+    Print (L"Ring:       %d KB, snap length %d, %a\n", Capture->RingSize / SIZE_1KB,
+      Capture->SnapLen,
+      ((Capture->Flags & INTELGBE_CAPTURE_FLAG_STOP_WHEN_FULL) != 0) ? "keep first" : "keep newest");
+    if (Capture->EtherType != 0) {
+      Print (L"EtherType:  0x%04x\n", Capture->EtherType);
+    }
+    Print (L"Records:    %d\n", Capture->RecordCount);
+    Print (L"Captured:   %ld\n", Capture->Captured);
+    Print (L"Overwritten:%ld\n", Capture->Captured - Capture->RecordCount);
+    Print (L"Dropped:    %ld\n", Capture->Dropped);
+    Print (L"Truncated:  %ld\n", Capture->Truncated);
+  }
+
+  FreePool (Capture);
+  return EFI_SUCCESS;
+}
+
+/** Writes the captured frames to a pcap file.
+
+   @param[in]   Aip        Adapter Information Protocol of the interface
+   @param[in]   FileName   File to write, replaced when it exists
+
+   @retval   EFI_SUCCESS   File written
+   @retval   other         Capture could not be read or the file written
+**/
+STATIC
+EFI_STATUS
+CaptureSavePcap (
+  IN EFI_ADAPTER_INFORMATION_PROTOCOL *Aip,
+  IN CONST CHAR16                     *FileName
+  )
+{
+  INTELGBE_ADAPTER_INFO_CAPTURE *Capture;
+  INTELGBE_CAPTURE_RECORD       *Record;
+  PCAP_FILE_HEADER              *FileHeader;
+  PCAP_RECORD_HEADER            *PcapRecord;
+  SHELL_FILE_HANDLE             File;
+  UINT8                         *Records;
+  UINT8                         *Pcap;
+  UINT8                         *Out;
+  UINT64                        Epoch;
+  UINT64                        Ticks;
+  UINT64                        Remainder;
+  UINTN                         Size;
+  UINT32                        i;
+  EFI_STATUS                    Status;
+
+  Status = CaptureRead (Aip, &Capture, &Size);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  // Every pcap record header is no larger than the driver's record header.
+  Pcap = AllocatePool (sizeof (PCAP_FILE_HEADER) + Size);
+  if (Pcap == NULL) {
+    FreePool (Capture);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  FileHeader = (PCAP_FILE_HEADER *) Pcap;
+  FileHeader->Magic        = PCAP_MAGIC;
+  FileHeader->VersionMajor = PCAP_VERSION_MAJOR;
+  FileHeader->VersionMinor = PCAP_VERSION_MINOR;
+  FileHeader->ThisZone     = 0;
+  FileHeader->SigFigs      = 0;
+  FileHeader->SnapLen      = Capture->SnapLen;
+  FileHeader->LinkType     = PCAP_LINKTYPE_ETHERNET;
+  Out = (UINT8 *) (FileHeader + 1);
+
+  Epoch   = CaptureEpochSeconds (&Capture->StartTime);
+  Records = (UINT8 *) (Capture + 1);
+  for (i = 0; i < Capture->RecordCount; i++) {
+    Record = (INTELGBE_CAPTURE_RECORD *) Records;
+    Records += INTELGBE_CAPTURE_RECORD_SIZE (Record->CaptureLen);
+
+    PcapRecord = (PCAP_RECORD_HEADER *) Out;
+    Ticks = Record->Tsc - Capture->StartTsc;
+    if (Capture->TscHz != 0) {
+      PcapRecord->Seconds      = (UINT32) (Epoch + DivU64x64Remainder (Ticks, Capture->TscHz, &Remainder));
+      PcapRecord->Microseconds = (UINT32) DivU64x64Remainder (MultU64x32 (Remainder, 1000000),
+                                            Capture->TscHz, NULL);
+    } else {
+      PcapRecord->Seconds      = (UINT32) Epoch;
+      PcapRecord->Microseconds = 0;
+    }
+    PcapRecord->CaptureLen = Record->CaptureLen;
+    PcapRecord->FrameLen   = Record->FrameLen;
+    CopyMem (PcapRecord + 1, Record + 1, Record->CaptureLen);
+    Out = (UINT8 *) (PcapRecord + 1) + Record->CaptureLen;
+  }
+  Size = Out - Pcap;
+
+  // Start from an empty file so a shorter capture leaves no stale frames behind.
+  ShellDeleteFileByName (FileName);
+  Status = ShellOpenFileByName (FileName, &File,
+             EFI_FILE_MODE_CREATE | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_READ, 0);
+  if (!EFI_ERROR (Status)) {
+    Status = ShellWriteFile (File, &Size, Pcap);
+    ShellCloseFile (&File);
+  }
+  if (!EFI_ERROR (Status)) {
+    Print (L"Capture: %d frames saved to %s, %ld overwritten, %ld dropped, %ld truncated\n",
+      Capture->RecordCount, FileName, Capture->Captured - Capture->RecordCount,
+      Capture->Dropped, Capture->Truncated);
+  }
+
+  FreePool (Pcap);
+  FreePool (Capture);
+  return Status;
+}
+
+/** Arms the capture with the settings given on the command line.
+
+   @param[in]   Aip       Adapter Information Protocol of the interface
+   @param[in]   Package   Parsed command line
+
+   @retval   EFI_SUCCESS             Capture armed
+   @retval   EFI_INVALID_PARAMETER   Invalid option, message printed
+   @retval   other                   The driver refused the settings
+**/
+STATIC
+EFI_STATUS
+CaptureStart (
+  IN EFI_ADAPTER_INFORMATION_PROTOCOL *Aip,
+  IN LIST_ENTRY                       *Package
+  )
+{
+  INTELGBE_ADAPTER_INFO_CAPTURE Capture;
+  CONST CHAR16                  *Value;
+
+  ZeroMem (&Capture, sizeof (Capture));
+  Capture.Directions = INTELGBE_CAPTURE_TX | INTELGBE_CAPTURE_RX;
+
+  Value = ShellCommandLineGetValue (Package, L"-dir");
+  if (Value != NULL) {
+    if (StrCmp (Value, L"rx") == 0) {
+      Capture.Directions = INTELGBE_CAPTURE_RX;
+    } else if (StrCmp (Value, L"tx") == 0) {
+      Capture.Directions = INTELGBE_CAPTURE_TX;
+    } else if (StrCmp (Value, L"both") != 0) {
+      Print (L"Unknown direction %s\n", Value);
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+
+  Value = ShellCommandLineGetValue (Package, L"-snap");
+  if (Value != NULL) {
+    Capture.SnapLen = (UINT32) ShellStrToUintn (Value);
+    if ((Capture.SnapLen == 0)
+      || (Capture.SnapLen > INTELGBE_CAPTURE_MAX_SNAPLEN))
+    {
+      Print (L"Snap length must be 1-%d\n", INTELGBE_CAPTURE_MAX_SNAPLEN);
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+
+  Value = ShellCommandLineGetValue (Package, L"-type");
+  if (Value != NULL) {
+    Capture.EtherType = (UINT16) ShellStrToUintn (Value);
+  }
+
+  Value = ShellCommandLineGetValue (Package, L"-size");
+  if (Value != NULL) {
+    Capture.RingSize = (UINT32) ShellStrToUintn (Value) * SIZE_1KB;
+    if ((Capture.RingSize == 0)
+      || (Capture.RingSize > INTELGBE_CAPTURE_MAX_RING_SIZE))
+    {
+      Print (L"Ring size must be 1-%d KB\n", INTELGBE_CAPTURE_MAX_RING_SIZE / SIZE_1KB);
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+
+  if (ShellCommandLineGetFlag (Package, L"-first")) {
+    Capture.Flags = INTELGBE_CAPTURE_FLAG_STOP_WHEN_FULL;
+  }
+
+  return Aip->SetInformation (Aip, &mCaptureGuid, &Capture, sizeof (Capture));
+}
+
+/** Stops the capture, keeping the captured frames.
+
+   @param[in]   Aip   Adapter Information Protocol of the interface
+
+   @retval   EFI_SUCCESS   Capture stopped
+   @retval   other         The driver does not support capturing
+**/
+STATIC
+EFI_STATUS
+CaptureStop (
+  IN EFI_ADAPTER_INFORMATION_PROTOCOL *Aip
+  )
+{
+  INTELGBE_ADAPTER_INFO_CAPTURE Capture;
+
+  ZeroMem (&Capture, sizeof (Capture));
+  return Aip->SetInformation (Aip, &mCaptureGuid, &Capture, sizeof (Capture));
+}
+
+/** UEFI application entry point.
+
+   @param[in]   Argc   Number of command line arguments
+   @param[in]   Argv   Command line arguments
+
+   @retval   SHELL_SUCCESS            Command completed
+   @retval   SHELL_INVALID_PARAMETER  Invalid command line
+   @retval   SHELL_NOT_FOUND          No SNP instance with the given index
+   @retval   SHELL_UNSUPPORTED        Interface does not support capturing
+   @retval   SHELL_DEVICE_ERROR       Capture could not be controlled or saved
+**/
+INTN
+EFIAPI
+ShellAppMain (
+  IN UINTN  Argc,
+  IN CHAR16 **Argv
+  )
+{
+  EFI_ADAPTER_INFORMATION_PROTOCOL *Aip;
+  LIST_ENTRY                       *Package;
+  CHAR16                           *ProblemParam;
+  EFI_HANDLE                       *Handles;
+  CONST CHAR16                     *FileName;
+  UINTN                            HandleCount;
+  UINTN                            Index;
+  CONST CHAR16                     *Value;
+  EFI_STATUS                       Status;
+  INTN                             Ret;
+
+  Package = NULL;
+  Handles = NULL;
+
+  Status = ShellCommandLineParse (mParamList, &Package, &ProblemParam, TRUE);
+  if (EFI_ERROR (Status)) {
+    if (ProblemParam != NULL) {
+      Print (L"Unknown option %s\n", ProblemParam);
+      FreePool (ProblemParam);
+    }
+    CaptureUsage ();
+    return SHELL_INVALID_PARAMETER;
+  }
+  if (ShellCommandLineGetFlag (Package, L"-?")) {
+    CaptureUsage ();
+    Ret = SHELL_SUCCESS;
+    goto Exit;
+  }
+
+  Status = gBS->LocateHandleBuffer (ByProtocol, &gEfiSimpleNetworkProtocolGuid,
+                  NULL, &HandleCount, &Handles);
+  if (EFI_ERROR (Status)) {
+    Print (L"No network interfaces found\n");
+    Ret = SHELL_NOT_FOUND;
+    goto Exit;
+  }
+  if (ShellCommandLineGetFlag (Package, L"-l")) {
+    CaptureListHandles (Handles, HandleCount);
+    Ret = SHELL_SUCCESS;
+    goto Exit;
+  }
+
+  Index = 0;
+  Value = ShellCommandLineGetValue (Package, L"-i");
+  if (Value != NULL) {
+    Index = ShellStrToUintn (Value);
+  }
+  if (Index >= HandleCount) {
+    Print (L"Interface %d not found, %d available\n", Index, HandleCount);
+    Ret = SHELL_NOT_FOUND;
+    goto Exit;
+  }
+  if (EFI_ERROR (gBS->HandleProtocol (Handles[Index], &gEfiAdapterInformationProtocolGuid,
+                       (VOID **) &Aip)))
+  {
+    Print (L"Interface %d does not support capturing\n", Index);
+    Ret = SHELL_UNSUPPORTED;
+    goto Exit;
+  }
+
+  Ret = SHELL_SUCCESS;
+  FileName = ShellCommandLineGetValue (Package, L"-w");
+
+  // Stop before saving so the file holds what was captured up to this command.
+  if (ShellCommandLineGetFlag (Package, L"-stop")) {
+    Status = CaptureStop (Aip);
+    if (EFI_ERROR (Status)) {
+      Print (L"Could not stop the capture: %r\n", Status);
+      Ret = SHELL_DEVICE_ERROR;
+      goto Exit;
+    }
+  }
+
+  if (FileName != NULL) {
+    Status = CaptureSavePcap (Aip, FileName);
+    if (EFI_ERROR (Status)) {
+      Print (L"Could not save the capture to %s: %r\n", FileName, Status);
+      Ret = SHELL_DEVICE_ERROR;
+      goto Exit;
+    }
+  }
+
+  if (ShellCommandLineGetFlag (Package, L"-start")) {
+    Status = CaptureStart (Aip, Package);
+    if (EFI_ERROR (Status)) {
+      if (Status != EFI_INVALID_PARAMETER) {
+        Print (L"Could not arm the capture: %r\n", Status);
+      }
+      Ret = (Status == EFI_INVALID_PARAMETER) ? SHELL_INVALID_PARAMETER : SHELL_DEVICE_ERROR;
+      goto Exit;
+    }
+  }
+
+  if (!ShellCommandLineGetFlag (Package, L"-stop")
+    && !ShellCommandLineGetFlag (Package, L"-start")
+    && (FileName == NULL))
+  {
+    Status = CapturePrintState (Aip);
+    if (EFI_ERROR (Status)) {
+      Print (L"Interface %d does not support capturing: %r\n", Index, Status);
+      Ret = SHELL_UNSUPPORTED;
+    }
+  }
+
+Exit:
+  if (Handles != NULL) {
+    FreePool (Handles);
+  }
+  ShellCommandLineFreeVarList (Package);
+  return Ret;
+}
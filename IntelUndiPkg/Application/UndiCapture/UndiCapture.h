@@ -0,0 +1,54 @@
+/** @file
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef UNDI_CAPTURE_H_
+#define UNDI_CAPTURE_H_
+
+#include <Uefi.h>
+
+#include <Protocol/SimpleNetwork.h>
+#include <Protocol/AdapterInformation.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+#include <Library/ShellLib.h>
+
+/* Capture types published by the UNDI driver through the Adapter Information Protocol */
+#include "../../AdapterInformation.h"
+#include "../../Capture.h"
+
+/* Classic pcap file format with microsecond timestamps */
+#define PCAP_MAGIC              0xA1B2C3D4
+#define PCAP_VERSION_MAJOR      2
+#define PCAP_VERSION_MINOR      4
+#define PCAP_LINKTYPE_ETHERNET  1
+
+#define SECONDS_PER_DAY         86400
+
+#pragma pack(1)
+typedef struct {
+  UINT32  Magic;
+  UINT16  VersionMajor;
+  UINT16  VersionMinor;
+  INT32   ThisZone;   // Always 0, timestamps are UTC
+  UINT32  SigFigs;
+  UINT32  SnapLen;
+  UINT32  LinkType;
+} PCAP_FILE_HEADER;
+
+typedef struct {
+  UINT32  Seconds;
+  UINT32  Microseconds;
+  UINT32  CaptureLen;
+  UINT32  FrameLen;
+} PCAP_RECORD_HEADER;
+#pragma pack()
+
+#endif /* UNDI_CAPTURE_H_ */
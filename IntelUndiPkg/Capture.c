@@ -0,0 +1,306 @@
+/** @file
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Library/UefiRuntimeServicesTableLib.h>
+
+#include "Intelgbe.h"
+#include "Capture.h"
+
+/* Tag protocol identifier of an 802.1Q header */
+#define CAPTURE_ETHERTYPE_VLAN  0x8100
+
+/** Takes the slot for a frame passing the capture filter.
+
+   @param[in]   Capture      Armed capture
+   @param[in]   Direction    INTELGBE_CAPTURE_TX or INTELGBE_CAPTURE_RX
+   @param[in]   Header       Start of the frame, its media header
+   @param[in]   HeaderLen    Bytes readable at Header
+   @param[in]   FrameLen     Length of the whole frame
+
+   @return   Record to fill in, NULL when the frame is filtered out or dropped
+**/
+STATIC
+INTELGBE_CAPTURE_RECORD *
+IntelgbeCaptureReserve (
+  INTELGBE_CAPTURE *Capture,
+  UINT8             Direction,
+  UINT8            *Header,
+  UINT32            HeaderLen,
+  UINT32            FrameLen
+  )
+{
+  INTELGBE_CAPTURE_RECORD *Record;
+  UINT16                   Type;
+
+  if (Capture->EtherType != 0) {
+    if (HeaderLen < PXE_MAC_HEADER_LEN_ETHER) {
+      return NULL;
+    }
+    Type = (UINT16) ((Header[12] << 8) | Header[13]);
+    if ((Type == CAPTURE_ETHERTYPE_VLAN) && (HeaderLen >= PXE_MAC_HEADER_LEN_ETHER + 4)) {
+      Type = (UINT16) ((Header[16] << 8) | Header[17]);
+    }
+    if (Type != Capture->EtherType) {
+      return NULL;
+    }
+  }
+
+  if ((Capture->Captured >= Capture->Slots) &&
+      ((Capture->Flags & INTELGBE_CAPTURE_FLAG_STOP_WHEN_FULL) != 0))
+  {
+    Capture->Dropped++;
+    return NULL;
+  }
+
+  Record = (INTELGBE_CAPTURE_RECORD *) (Capture->Ring + Capture->Next * Capture->SlotSize);
+  Capture->Next++;
+  if (Capture->Next == Capture->Slots) {
+    Capture->Next = 0;
+  }
+  Capture->Captured++;
+
+  Record->Tsc        = INTELGBE_TRACE_TIMESTAMP ();
+  Record->FrameLen   = (UINT16) FrameLen;
+  Record->CaptureLen = (UINT16) MIN (FrameLen, Capture->SnapLen);
+  Record->Direction  = Direction;
+  if (Record->CaptureLen < FrameLen) {
+    Capture->Truncated++;
+  }
+
+  return Record;
+}
+
+/** Records a frame in the capture ring.
+
+   Only called through INTELGBE_CAPTURE_FRAME once the direction was found
+   armed.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+   @param[in]   Direction    INTELGBE_CAPTURE_TX or INTELGBE_CAPTURE_RX
+   @param[in]   Frame        Frame, starting with the media header
+   @param[in]   FrameLen     Length of the frame
+**/
+VOID
+IntelgbeCaptureFrame (
+  GIG_DRIVER_DATA *GigAdapter,
+  UINT8            Direction,
+  UINT8           *Frame,
+  UINT32           FrameLen
+  )
+{
+  INTELGBE_CAPTURE_RECORD *Record;
+
+  Record = IntelgbeCaptureReserve (GigAdapter->Capture, Direction, Frame,
+             FrameLen, FrameLen);
+  if (Record != NULL) {
+    IntelgbeMemCopy ((UINT8 *) (Record + 1), Frame, Record->CaptureLen);
+  }
+}
+
+/** Records a fragmented transmit frame in the capture ring.
+
+   Only called through INTELGBE_CAPTURE_FRAGMENTS once transmit capture was
+   found armed. The media header is expected in the first fragment.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+   @param[in]   TxFrags      Fragment list of the frame
+**/
+VOID
+IntelgbeCaptureFragments (
+  GIG_DRIVER_DATA            *GigAdapter,
+  PXE_CPB_TRANSMIT_FRAGMENTS *TxFrags
+  )
+{
+  INTELGBE_CAPTURE_RECORD *Record;
+  UINT8                   *Dest;
+  UINT32                   Left;
+  UINT32                   Len;
+  UINT32                   i;
+
+  Record = IntelgbeCaptureReserve (GigAdapter->Capture, INTELGBE_CAPTURE_TX,
+             (UINT8 *) (UINTN) TxFrags->FragDesc[0].FragAddr,
+             TxFrags->FragDesc[0].FragLen,
+             TxFrags->FrameLen + TxFrags->MediaheaderLen);
+  if (Record == NULL) {
+    return;
+  }
+
+  Dest = (UINT8 *) (Record + 1);
+  Left = Record->CaptureLen;
+  for (i = 0; (i < TxFrags->FragCnt) && (Left != 0); i++) {
+    Len = MIN (TxFrags->FragDesc[i].FragLen, Left);
+    IntelgbeMemCopy (Dest, (UINT8 *) (UINTN) TxFrags->FragDesc[i].FragAddr, Len);
+    Dest += Len;
+    Left -= Len;
+  }
+
+  // The fragments were shorter than the frame claimed, keep what was there.
+  Record->CaptureLen -= (UINT16) Left;
+}
+
+/** Arms or stops the packet capture.
+
+   Arming allocates a new ring and restarts the capture, stopping keeps the
+   ring and its frames so they can still be read out.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+   @param[in]   Directions   INTELGBE_CAPTURE_TX and/or INTELGBE_CAPTURE_RX, 0 to stop
+   @param[in]   Flags        INTELGBE_CAPTURE_FLAG_*
+   @param[in]   SnapLen      Bytes kept per frame, 0 for the default
+   @param[in]   EtherType    Only capture frames of this EtherType, 0 for all
+   @param[in]   RingSize     Ring size in bytes, 0 for the default
+
+   @retval   EFI_SUCCESS             Capture armed or stopped
+   @retval   EFI_INVALID_PARAMETER   Unknown direction or flag, or sizes out of range
+   @retval   EFI_OUT_OF_RESOURCES    Could not allocate the ring
+**/
+EFI_STATUS
+IntelgbeSetCapture (
+  GIG_DRIVER_DATA *GigAdapter,
+  UINT32           Directions,
+  UINT32           Flags,
+  UINT32           SnapLen,
+  UINT16           EtherType,
+  UINT32           RingSize
+  )
+{
+  INTELGBE_CAPTURE *Capture;
+  INTELGBE_CAPTURE *Old;
+  EFI_TPL           OldTpl;
+  UINT32            SlotSize;
+
+  if (((Directions & ~(INTELGBE_CAPTURE_TX | INTELGBE_CAPTURE_RX)) != 0) ||
+      ((Flags & ~INTELGBE_CAPTURE_FLAG_STOP_WHEN_FULL) != 0))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (Directions == 0) {
+    GigAdapter->CaptureDirections = 0;
+    return EFI_SUCCESS;
+  }
+
+  if (SnapLen == 0) {
+    SnapLen = INTELGBE_CAPTURE_DEFAULT_SNAPLEN;
+  }
+  if (RingSize == 0) {
+    RingSize = INTELGBE_CAPTURE_DEFAULT_RING_SIZE;
+  }
+  SlotSize = INTELGBE_CAPTURE_RECORD_SIZE (SnapLen);
+  if ((SnapLen > INTELGBE_CAPTURE_MAX_SNAPLEN) ||
+      (RingSize > INTELGBE_CAPTURE_MAX_RING_SIZE) ||
+      (RingSize < SlotSize))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Capture = AllocateZeroPool (sizeof (INTELGBE_CAPTURE));
+  if (Capture == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  Capture->Ring = AllocatePool (RingSize);
+  if (Capture->Ring == NULL) {
+    FreePool (Capture);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Capture->SlotSize  = SlotSize;
+  Capture->Slots     = RingSize / SlotSize;
+  Capture->SnapLen   = SnapLen;
+  Capture->Flags     = Flags;
+  Capture->EtherType = EtherType;
+  if (EFI_ERROR (gRT->GetTime (&Capture->StartTime, NULL))) {
+    ZeroMem (&Capture->StartTime, sizeof (EFI_TIME));
+  }
+  IntelgbeCalibrateTsc (GigAdapter);
+
+  // The datapath runs at TPL_CALLBACK, keep it off the ring while we swap.
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  Old = GigAdapter->Capture;
+  Capture->StartTsc = INTELGBE_TRACE_TIMESTAMP ();
+  GigAdapter->Capture = Capture;
+  GigAdapter->CaptureDirections = (UINT8) Directions;
+  gBS->RestoreTPL (OldTpl);
+
+  IntelgbeFreeCapture (Old);
+
+  return EFI_SUCCESS;
+}
+
+/** Copies the captured frames out of the ring, oldest first.
+
+   @param[in]      GigAdapter   Pointer to the driver structure
+   @param[out]     State        Returns the capture settings and counters, Ring is NULL
+   @param[out]     Buffer       Buffer for the records, each INTELGBE_CAPTURE_RECORD_SIZE bytes
+   @param[in,out]  BufferSize   On entry the size of Buffer, on exit the bytes written
+
+   @return   Records written to Buffer
+**/
+UINT32
+IntelgbeCaptureCopy (
+  GIG_DRIVER_DATA  *GigAdapter,
+  INTELGBE_CAPTURE *State,
+  UINT8            *Buffer,
+  UINTN            *BufferSize
+  )
+{
+  INTELGBE_CAPTURE        *Capture;
+  INTELGBE_CAPTURE_RECORD *Record;
+  EFI_TPL                  OldTpl;
+  UINTN                    Used;
+  UINT32                   Size;
+  UINT32                   Count;
+  UINT32                   Slot;
+  UINT32                   i;
+
+  ZeroMem (State, sizeof (INTELGBE_CAPTURE));
+  Used  = 0;
+  Count = 0;
+
+  OldTpl  = gBS->RaiseTPL (TPL_NOTIFY);
+  Capture = GigAdapter->Capture;
+  if (Capture != NULL) {
+    CopyMem (State, Capture, sizeof (INTELGBE_CAPTURE));
+    State->Ring = NULL;
+
+    Count = (UINT32) MIN (Capture->Captured, Capture->Slots);
+    Slot  = (Capture->Captured > Capture->Slots) ? Capture->Next : 0;
+    for (i = 0; i < Count; i++) {
+      Record = (INTELGBE_CAPTURE_RECORD *) (Capture->Ring + Slot * Capture->SlotSize);
+      Size   = INTELGBE_CAPTURE_RECORD_SIZE (Record->CaptureLen);
+      if (Used + Size > *BufferSize) {
+        break;
+      }
+      CopyMem (Buffer + Used, Record, sizeof (INTELGBE_CAPTURE_RECORD) + Record->CaptureLen);
+      Used += Size;
+      Slot++;
+      if (Slot == Capture->Slots) {
+        Slot = 0;
+      }
+    }
+    Count = i;
+  }
+  gBS->RestoreTPL (OldTpl);
+
+  *BufferSize = Used;
+  return Count;
+}
+
+/** Releases a capture and its ring.
+
+   @param[in]   Capture   Capture to free, may be NULL
+**/
+VOID
+IntelgbeFreeCapture (
+  INTELGBE_CAPTURE *Capture
+  )
+{
+  if (Capture != NULL) {
+    FreePool (Capture->Ring);
+    FreePool (Capture);
+  }
+}
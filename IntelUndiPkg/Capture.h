@@ -0,0 +1,98 @@
+/** @file
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef CAPTURE_H_
+#define CAPTURE_H_
+
+/* Capture of the frames passing through IntelgbeTransmit and IntelgbeReceive.
+
+   Frames are copied, up to the snap length, into a ring allocated when the
+   capture is armed. A disarmed capture costs a test per frame and an armed
+   one a record header and a copy of at most the snap length. The datapath
+   never waits on the ring: it overwrites its oldest frames, or with
+   INTELGBE_CAPTURE_FLAG_STOP_WHEN_FULL keeps the first ones and counts the
+   rest as dropped. The frames are read out through the
+   INTELGBE_ADAPTER_INFO_CAPTURE Adapter Information type and written as a
+   pcap file by the UndiCapture shell application. */
+
+/* Directions, selected when the capture is armed */
+#define INTELGBE_CAPTURE_TX                 BIT0
+#define INTELGBE_CAPTURE_RX                 BIT1
+
+/* Keep the first frames once the ring is full instead of the newest */
+#define INTELGBE_CAPTURE_FLAG_STOP_WHEN_FULL  BIT0
+
+/* Bytes kept per frame, the largest is a VLAN tagged frame without FCS */
+#define INTELGBE_CAPTURE_DEFAULT_SNAPLEN    128
+#define INTELGBE_CAPTURE_MAX_SNAPLEN        1518
+
+/* Ring sizes in bytes */
+#define INTELGBE_CAPTURE_DEFAULT_RING_SIZE  SIZE_1MB
+#define INTELGBE_CAPTURE_MAX_RING_SIZE      SIZE_64MB
+
+#pragma pack(1)
+typedef struct {
+  UINT64  Tsc;         // Time stamp counter when the driver handled the frame
+  UINT16  FrameLen;    // Length of the frame, FCS excluded
+  UINT16  CaptureLen;  // Bytes of the frame following this header
+  UINT8   Direction;   // INTELGBE_CAPTURE_TX or INTELGBE_CAPTURE_RX
+  UINT8   Reserved[3];
+} INTELGBE_CAPTURE_RECORD;
+#pragma pack()
+
+/* Records are read out back to back, each padded to this alignment */
+#define INTELGBE_CAPTURE_RECORD_SIZE(CaptureLen) \
+  ALIGN_VALUE (sizeof (INTELGBE_CAPTURE_RECORD) + (CaptureLen), 8)
+
+/* Ring and counters of an armed capture */
+typedef struct {
+  UINT8     *Ring;       // Slots fixed size records
+  UINT32    SlotSize;
+  UINT32    Slots;
+  UINT32    Next;        // Slot written next, the oldest once the ring wrapped
+  UINT32    SnapLen;
+  UINT32    Flags;       // INTELGBE_CAPTURE_FLAG_*
+  UINT16    EtherType;   // Only frames of this EtherType, 0 for all
+  UINT64    Captured;    // Frames recorded since the capture was armed
+  UINT64    Dropped;     // Matching frames not recorded because the ring was full
+  UINT64    Truncated;   // Frames recorded shorter than they were
+  UINT64    StartTsc;
+  EFI_TIME  StartTime;   // Wall clock at StartTsc
+} INTELGBE_CAPTURE;
+
+#ifndef INTELGBE_NO_CAPTURE
+/** Records a frame when the capture is armed for its direction.
+
+   @param[in]   Adapter     GIG_DRIVER_DATA pointer
+   @param[in]   Direction   INTELGBE_CAPTURE_TX or INTELGBE_CAPTURE_RX
+   @param[in]   Frame       Frame, starting with the media header
+   @param[in]   FrameLen    Length of the frame
+**/
+#define INTELGBE_CAPTURE_FRAME(Adapter, Direction, Frame, FrameLen) \
+  do { \
+    if (((Adapter)->CaptureDirections & (Direction)) != 0) { \
+      IntelgbeCaptureFrame ((Adapter), (Direction), (Frame), (FrameLen)); \
+    } \
+  } while (FALSE)
+
+/** Records a fragmented frame when the capture is armed for transmit.
+
+   @param[in]   Adapter     GIG_DRIVER_DATA pointer
+   @param[in]   Frags       PXE_CPB_TRANSMIT_FRAGMENTS of the frame
+**/
+#define INTELGBE_CAPTURE_FRAGMENTS(Adapter, Frags) \
+  do { \
+    if (((Adapter)->CaptureDirections & INTELGBE_CAPTURE_TX) != 0) { \
+      IntelgbeCaptureFragments ((Adapter), (Frags)); \
+    } \
+  } while (FALSE)
+#else
+#define INTELGBE_CAPTURE_FRAME(Adapter, Direction, Frame, FrameLen)
+#define INTELGBE_CAPTURE_FRAGMENTS(Adapter, Frags)
+#endif /* INTELGBE_NO_CAPTURE */
+
+#endif /* CAPTURE_H_ */
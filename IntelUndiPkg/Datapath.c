@@ -0,0 +1,297 @@
+/** @file
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+#include <Protocol/SimpleNetwork.h>
+#include "Intelgbe.h"
+#include "Datapath.h"
+
+/* Global variables */
+
+EFI_GUID gEdkiiNicDatapathProtocolGuid = EDKII_NIC_DATAPATH_PROTOCOL_GUID;
+
+/** Checks the adapter can take a datapath call.
+
+   The protocol instance belongs to one adapter, so the interface number,
+   opcode and CPB/DB checks of IntelgbeUndiApiEntry have nothing to check.
+   What remains is the adapter state, which can change at any time.
+
+   @param[in]   GigAdapter   Pointer to the driver data
+
+   @retval   EFI_SUCCESS        Adapter is initialized and idle
+   @retval   EFI_NOT_STARTED    Adapter is not initialized
+   @retval   EFI_NOT_READY      Another command is in progress
+   @retval   EFI_DEVICE_ERROR   ExitBootServices stopped the adapter
+**/
+STATIC
+EFI_STATUS
+DatapathCheckState (
+  IN GIG_DRIVER_DATA *GigAdapter
+  )
+{
+  if (GigAdapter->ExitBootServicesTriggered) {
+    return EFI_DEVICE_ERROR;
+  }
+  if (GigAdapter->State != PXE_STATFLAGS_GET_STATE_INITIALIZED) {
+    return EFI_NOT_STARTED;
+  }
+  if (GigAdapter->DriverBusy) {
+    return EFI_NOT_READY;
+  }
+  return EFI_SUCCESS;
+}
+
+/** Places one whole frame on the transmit queue
+
+   @param[in]   This        Current EDKII_NIC_DATAPATH_PROTOCOL instance
+   @param[in]   FrameAddr   Address of the frame, media header included
+   @param[in]   FrameLen    Length of the frame
+
+   @retval      EFI_SUCCESS        Frame queued
+   @retval      EFI_NOT_READY      Transmit queue full or adapter busy
+   @retval      EFI_NOT_STARTED    Adapter is not initialized
+   @retval      EFI_DEVICE_ERROR   Frame could not be queued
+**/
+EFI_STATUS
+EFIAPI
+UndiDatapathTransmit (
+  IN EDKII_NIC_DATAPATH_PROTOCOL *This,
+  IN UINT64                      FrameAddr,
+  IN UINT32                      FrameLen
+  )
+{
+  UNDI_PRIVATE_DATA *UndiPrivateData;
+  GIG_DRIVER_DATA   *GigAdapter;
+  PXE_CPB_TRANSMIT  Cpb;
+  EFI_STATUS        Status;
+
+  UndiPrivateData = UNDI_PRIVATE_DATA_FROM_DATAPATH (This);
+  GigAdapter = &UndiPrivateData->NicInfo;
+
+  Status = DatapathCheckState (GigAdapter);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Cpb.FrameAddr      = FrameAddr;
+  Cpb.DataLen        = FrameLen;
+  Cpb.MediaheaderLen = 0;
+  Cpb.reserved       = 0;
+
+  switch (IntelgbeTransmit (GigAdapter, (UINT64) (UINTN) &Cpb, PXE_OPFLAGS_TRANSMIT_WHOLE)) {
+  case PXE_STATCODE_SUCCESS:
+    return EFI_SUCCESS;
+  case PXE_STATCODE_QUEUE_FULL:
+  case PXE_STATCODE_BUFFER_FULL:
+  case PXE_STATCODE_BUSY:
+    return EFI_NOT_READY;
+  default:
+    return EFI_DEVICE_ERROR;
+  }
+}
+
+/** Copies the next received frame into the caller's buffer
+
+   @param[in]   This         Current EDKII_NIC_DATAPATH_PROTOCOL instance
+   @param[in]   BufferAddr   Address of the receive buffer
+   @param[in]   BufferLen    Length of the receive buffer
+   @param[out]  Db           Frame length, header length, addresses and type
+
+   @retval      EFI_SUCCESS        Frame received
+   @retval      EFI_NOT_READY      No frame waiting or adapter busy
+   @retval      EFI_NOT_STARTED    Adapter is not initialized
+   @retval      EFI_DEVICE_ERROR   Adapter is stopped
+**/
+EFI_STATUS
+EFIAPI
+UndiDatapathReceive (
+  IN  EDKII_NIC_DATAPATH_PROTOCOL *This,
+  IN  UINT64                      BufferAddr,
+  IN  UINT32                      BufferLen,
+  OUT PXE_DB_RECEIVE              *Db
+  )
+{
+  UNDI_PRIVATE_DATA *UndiPrivateData;
+  GIG_DRIVER_DATA   *GigAdapter;
+  PXE_CPB_RECEIVE   Cpb;
+  EFI_STATUS        Status;
+
+  UndiPrivateData = UNDI_PRIVATE_DATA_FROM_DATAPATH (This);
+  GigAdapter = &UndiPrivateData->NicInfo;
+
+  Status = DatapathCheckState (GigAdapter);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+  if (!GigAdapter->ReceiveStarted) {
+    return EFI_NOT_STARTED;
+  }
+
+  Cpb.BufferAddr = BufferAddr;
+  Cpb.BufferLen  = BufferLen;
+  Cpb.reserved   = 0;
+
+  if (IntelgbeReceive (GigAdapter, (UINT64) (UINTN) &Cpb, (UINT64) (UINTN) Db)
+      != PXE_STATCODE_SUCCESS)
+  {
+    return EFI_NOT_READY;
+  }
+  return EFI_SUCCESS;
+}
+
+/** Returns the addresses of frames whose transmission completed
+
+   @param[in]       This      Current EDKII_NIC_DATAPATH_PROTOCOL instance
+   @param[out]      Buffers   Frame addresses
+   @param[in,out]   Count     Size of Buffers on entry, addresses written on exit
+
+   @retval      EFI_SUCCESS        *Count addresses written
+   @retval      EFI_NOT_STARTED    Adapter is not initialized
+   @retval      EFI_NOT_READY      Adapter busy
+   @retval      EFI_DEVICE_ERROR   Adapter is stopped
+**/
+EFI_STATUS
+EFIAPI
+UndiDatapathReclaimTx (
+  IN     EDKII_NIC_DATAPATH_PROTOCOL *This,
+  OUT    UINT64                      *Buffers,
+  IN OUT UINT32                      *Count
+  )
+{
+  UNDI_PRIVATE_DATA *UndiPrivateData;
+  GIG_DRIVER_DATA   *GigAdapter;
+  EFI_STATUS        Status;
+
+  UndiPrivateData = UNDI_PRIVATE_DATA_FROM_DATAPATH (This);
+  GigAdapter = &UndiPrivateData->NicInfo;
+
+  Status = DatapathCheckState (GigAdapter);
+  if (EFI_ERROR (Status)) {
+    *Count = 0;
+    return Status;
+  }
+
+  *Count = IntelgbeFreeTxBuffers (GigAdapter, (UINT16) MIN (*Count, MAX_UINT16), Buffers);
+  return EFI_SUCCESS;
+}
+
+/** Reads and clears the interrupt status, optionally reads the link state
+
+   @param[in]   This              Current EDKII_NIC_DATAPATH_PROTOCOL instance
+   @param[out]  InterruptStatus   EFI_SIMPLE_NETWORK_*_INTERRUPT bits, optional
+   @param[out]  MediaPresent      Link state, optional
+
+   @retval      EFI_SUCCESS        Status read
+   @retval      EFI_NOT_STARTED    Adapter is not initialized
+   @retval      EFI_NOT_READY      Adapter busy
+   @retval      EFI_DEVICE_ERROR   Adapter is stopped
+**/
+EFI_STATUS
+EFIAPI
+UndiDatapathPollStatus (
+  IN  EDKII_NIC_DATAPATH_PROTOCOL *This,
+  OUT UINT32                      *InterruptStatus  OPTIONAL,
+  OUT BOOLEAN                     *MediaPresent     OPTIONAL
+  )
+{
+  UNDI_PRIVATE_DATA *UndiPrivateData;
+  GIG_DRIVER_DATA   *GigAdapter;
+  UINT16            StatFlags;
+  EFI_STATUS        Status;
+
+  UndiPrivateData = UNDI_PRIVATE_DATA_FROM_DATAPATH (This);
+  GigAdapter = &UndiPrivateData->NicInfo;
+
+  Status = DatapathCheckState (GigAdapter);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (InterruptStatus != NULL) {
+    *InterruptStatus = 0;
+    StatFlags = IntelgbeGetInterruptStatus (GigAdapter);
+    if ((StatFlags & PXE_STATFLAGS_GET_STATUS_RECEIVE) != 0) {
+      *InterruptStatus |= EFI_SIMPLE_NETWORK_RECEIVE_INTERRUPT;
+    }
+    if ((StatFlags & PXE_STATFLAGS_GET_STATUS_TRANSMIT) != 0) {
+      *InterruptStatus |= EFI_SIMPLE_NETWORK_TRANSMIT_INTERRUPT;
+    }
+  }
+
+  if (MediaPresent != NULL) {
+    *MediaPresent = IsLinkUp (GigAdapter);
+    if (!*MediaPresent) {
+      INTELGBE_TRACE (GigAdapter, INTELGBE_TRACE_LINK_DOWN, 0, 0, 0, 0);
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/** Initializes and installs NIC Datapath Protocol on adapter
+
+   @param[in]   UndiPrivateData   Driver private data structure
+
+   @retval    EFI_SUCCESS   Protocol installed successfully
+   @retval    !EFI_SUCCESS  Failed to install and initialize protocol
+**/
+EFI_STATUS
+InitDatapathProtocol (
+  IN UNDI_PRIVATE_DATA *UndiPrivateData
+  )
+{
+  EFI_STATUS                  Status;
+  EDKII_NIC_DATAPATH_PROTOCOL *Datapath;
+
+  Datapath = &UndiPrivateData->Datapath;
+
+  Datapath->Revision   = EDKII_NIC_DATAPATH_PROTOCOL_REVISION;
+  Datapath->Transmit   = UndiDatapathTransmit;
+  Datapath->Receive    = UndiDatapathReceive;
+  Datapath->ReclaimTx  = UndiDatapathReclaimTx;
+  Datapath->PollStatus = UndiDatapathPollStatus;
+
+  Status = gBS->InstallProtocolInterface (
+                  &UndiPrivateData->DeviceHandle,
+                  &gEdkiiNicDatapathProtocolGuid,
+                  EFI_NATIVE_INTERFACE,
+                  Datapath
+                );
+  if (EFI_ERROR (Status)) {
+    DEBUGPRINT (CRITICAL,
+      ("InstallProtocolInterface returned %r\n", Status));
+  }
+
+  return Status;
+}
+
+/** Uninstalls NIC Datapath Protocol
+
+   @param[in]   UndiPrivateData   Driver private data structure
+
+   @retval     EFI_SUCCESS    Protocol uninstalled successfully
+   @retval     !EFI_SUCCESS   Failed to uninstall protocol
+**/
+EFI_STATUS
+UninstallDatapathProtocol (
+  IN UNDI_PRIVATE_DATA *UndiPrivateData
+  )
+{
+  EFI_STATUS Status;
+
+  Status = gBS->UninstallProtocolInterface (
+                  UndiPrivateData->DeviceHandle,
+                  &gEdkiiNicDatapathProtocolGuid,
+                  &UndiPrivateData->Datapath
+                );
+  if (EFI_ERROR (Status)) {
+    DEBUGPRINT (CRITICAL,
+      ("UnInstallProtocolInterface returned %r\n", Status));
+  }
+
+  return Status;
+}
@@ -0,0 +1,39 @@
+/** @file
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef DATAPATH_H_
+#define DATAPATH_H_
+
+#include <Protocol/NicDatapath.h>
+
+typedef struct UNDI_PRIVATE_DATA_S UNDI_PRIVATE_DATA;
+
+/** Initializes and installs NIC Datapath Protocol on adapter
+
+   @param[in]   UndiPrivateData   Driver private data structure
+
+   @retval    EFI_SUCCESS   Protocol installed successfully
+   @retval    !EFI_SUCCESS  Failed to install and initialize protocol
+**/
+EFI_STATUS
+InitDatapathProtocol (
+  IN UNDI_PRIVATE_DATA *UndiPrivateData
+  );
+
+/** Uninstalls NIC Datapath Protocol
+
+   @param[in]   UndiPrivateData   Driver private data structure
+
+   @retval     EFI_SUCCESS    Protocol uninstalled successfully
+   @retval     !EFI_SUCCESS   Failed to uninstall protocol
+**/
+EFI_STATUS
+UninstallDatapathProtocol (
+  IN UNDI_PRIVATE_DATA *UndiPrivateData
+  );
+
+#endif /* DATAPATH_H_ */
@@ -659,6 +659,8 @@ IntelgbeUndiGetInitInfo (
   )
 {
   PXE_DB_GET_INIT_INFO *DbPtr;
+  struct intelgbe_hw   *Hw;
+  UINTN                Speeds;
 
   DEBUGPRINT (CRITICAL, ("IntelgbeUndiGetInitInfo\n"));
   DEBUGWAIT (DECODE);
@@ -668,10 +670,22 @@ IntelgbeUndiGetInitInfo (
   DbPtr->MemoryRequired = 0;
   DbPtr->FrameDataLen   = PXE_MAX_TXRX_UNIT_ETHER;
 
-  DbPtr->LinkSpeeds[0]  = 10;
-  DbPtr->LinkSpeeds[1]  = 100;
-  DbPtr->LinkSpeeds[2]  = 0;
-  DbPtr->LinkSpeeds[3]  = 0;
+  // Report what the PHY can do, the SERDES follows the negotiated speed.
+  Hw = &GigAdapter->Hw;
+  ZeroMem (DbPtr->LinkSpeeds, sizeof (DbPtr->LinkSpeeds));
+  Speeds = 0;
+  if ((Hw->phy.support & (PHY_SUPPORT_10_HALF | PHY_SUPPORT_10_FULL)) != 0) {
+    DbPtr->LinkSpeeds[Speeds++] = 10;
+  }
+  if ((Hw->phy.support & (PHY_SUPPORT_100_HALF | PHY_SUPPORT_100_FULL)) != 0) {
+    DbPtr->LinkSpeeds[Speeds++] = 100;
+  }
+  if ((Hw->phy.support & (PHY_SUPPORT_1000_HALF | PHY_SUPPORT_1000_FULL)) != 0) {
+    DbPtr->LinkSpeeds[Speeds++] = 1000;
+  }
+  if ((Hw->phy.support & PHY_SUPPORT_2500_FULL) != 0) {
+    DbPtr->LinkSpeeds[Speeds++] = 2500;
+  }
 
   DbPtr->NvCount        = MAX_EEPROM_LEN;
   DbPtr->NvWidth        = 4;
@@ -688,7 +702,10 @@ IntelgbeUndiGetInitInfo (
   DbPtr->IFtype         = PXE_IFTYPE_ETHERNET;
   DbPtr->SupportedDuplexModes         = PXE_DUPLEX_ENABLE_FULL_SUPPORTED |
   PXE_DUPLEX_FORCE_FULL_SUPPORTED;
-  DbPtr->SupportedLoopBackModes       = 0;
+  DbPtr->SupportedLoopBackModes       = PXE_LOOPBACK_INTERNAL_SUPPORTED;
+  if (Hw->phy.ops.set_loopback != NULL) {
+    DbPtr->SupportedLoopBackModes |= PXE_LOOPBACK_EXTERNAL_SUPPORTED;
+  }
 
   CdbPtr->StatFlags |= (PXE_STATFLAGS_CABLE_DETECT_SUPPORTED |
                         PXE_STATFLAGS_GET_STATUS_NO_MEDIA_SUPPORTED);
@@ -980,6 +997,7 @@ IntelgbeUndiStnAddr (
         GigAdapter->Hw.mac.perm_addr,
         PXE_HWADDR_LEN_ETHER
       );
+      intelgbe_write_mac_addr_generic (&GigAdapter->Hw);
     }
   }
 
@@ -997,6 +1015,9 @@ IntelgbeUndiStnAddr (
       DEBUGPRINT (DECODE, ("%2x ", CpbPtr->StationAddr[i]));
     }
 
+    // Program the perfect filter so RX filter status matches the new address
+    intelgbe_write_mac_addr_generic (&GigAdapter->Hw);
+
   }
 
   if (CdbPtr->DBaddr != (UINT64) 0) {
@@ -1161,14 +1182,10 @@ IntelgbeUndiStatus (
   )
 {
   PXE_DB_GET_STATUS *       DbPtr;
-  UINT32                    IntStatus;
   UINT16                    NumEntries;
 
-  DEBUGPRINT (DECODE, ("IntelgbeUndiStatus\n"));
-
   if (GigAdapter->DriverBusy) {
-    DEBUGPRINT (DECODE,
-      ("ERROR: IntelgbeUndiStatus called when driver busy\n"));
+    INTELGBE_TRACE (GigAdapter, INTELGBE_TRACE_CMD_BUSY, CdbPtr->OpCode, 0, 0, 0);
     CdbPtr->StatFlags = PXE_STATFLAGS_COMMAND_FAILED;
     CdbPtr->StatCode = PXE_STATCODE_BUSY;
     return;
@@ -1181,7 +1198,8 @@ IntelgbeUndiStatus (
   if (CdbPtr->DBsize < (sizeof (UINT64) * 2)) {
     CdbPtr->StatFlags = PXE_STATFLAGS_COMMAND_FAILED;
     CdbPtr->StatCode = PXE_STATCODE_INVALID_CDB;
-    DEBUGPRINT (CRITICAL, ("Invalid CDB\n"));
+    INTELGBE_TRACE (GigAdapter, INTELGBE_TRACE_CMD_BAD_CDB, CdbPtr->OpCode,
+      CdbPtr->StatCode, CdbPtr->StatFlags, 0);
     if ((CdbPtr->OpFlags & PXE_OPFLAGS_GET_TRANSMITTED_BUFFERS) != 0) {
       CdbPtr->StatFlags |= PXE_STATFLAGS_GET_STATUS_NO_TXBUFS_WRITTEN;
     }
@@ -1195,8 +1213,6 @@ IntelgbeUndiStatus (
     // of completed transmit buffers.
     NumEntries = (UINT16)
     ((CdbPtr->DBsize - sizeof (UINT64)) / sizeof (UINT64));
-    DEBUGPRINT (DECODE, ("CdbPtr->DBsize = %d\n", CdbPtr->DBsize));
-    DEBUGPRINT (DECODE, ("NumEntries in DbPtr = %d\n", NumEntries));
 
     // On return NumEntries will be the number of TX buffers written into the DB
     NumEntries =
@@ -1208,52 +1224,23 @@ IntelgbeUndiStatus (
     // The receive buffer size and reserved fields take up the first 64 bits of the DB
     // The completed transmit buffers take up the rest
     CdbPtr->DBsize = (UINT16) (sizeof (UINT64) + NumEntries * sizeof (UINT64));
-    DEBUGPRINT (DECODE, ("Return DBsize = %d\n", CdbPtr->DBsize));
   }
 
   if ((CdbPtr->OpFlags & PXE_OPFLAGS_GET_INTERRUPT_STATUS) != 0) {
-    u32 i, j;
-    j = MAX(GigAdapter->txqnum, GigAdapter->rxqnum);
-    for (i = 0; i < j; i++) {
-      struct intelgbe_rx_queue *rx_queue = &GigAdapter->rx_queue[i];
-      IntStatus = INTELGBE_READ_REG(&GigAdapter->Hw, DMA_INTR_STATUS_CH(i));
-      if (IntStatus & BIT(15)) {
-        if (IntStatus & BIT(0)) {
-          DEBUGPRINT(DECODE, ("Transmit Interrupt\n"));
-          CdbPtr->StatFlags |= PXE_STATFLAGS_GET_STATUS_TRANSMIT;
-          INTELGBE_WRITE_REG(&GigAdapter->Hw, DMA_INTR_STATUS_CH(i), BIT(0));
-        }
-      }
-      else if (IntStatus & BIT(14)) {
-        DEBUGPRINT(CRITICAL, ("Abnormal Interrupt %x\n", IntStatus));
-        INTELGBE_WRITE_REG(&GigAdapter->Hw, DMA_INTR_STATUS_CH(i), IntStatus);
-      }
-      IntStatus = INTELGBE_READ_REG(&GigAdapter->Hw,
-                                    DMA_INTR_STATUS_CH(rx_queue->chan));
-      if (IntStatus & BIT(15)) {
-        if (IntStatus & BIT(6)) {
-          DEBUGPRINT(DECODE, ("Receive Interrupt\n"));
-          INTELGBE_WRITE_REG(&GigAdapter->Hw, DMA_INTR_STATUS_CH(rx_queue->chan),
-                             BIT(6));
-          CdbPtr->StatFlags |= PXE_STATFLAGS_GET_STATUS_RECEIVE;
-        }
-      } else if (IntStatus & BIT(14)) {
-        DEBUGPRINT(CRITICAL, ("Abnormal Interrupt %x\n", IntStatus));
-        INTELGBE_WRITE_REG(&GigAdapter->Hw, DMA_INTR_STATUS_CH(rx_queue->chan),
-                           IntStatus);
-      }
-    }
+    CdbPtr->StatFlags |= IntelgbeGetInterruptStatus (GigAdapter);
   }
   // Return current media status
   if ((CdbPtr->OpFlags & PXE_OPFLAGS_GET_MEDIA_STATUS) != 0) {
     if (!IsLinkUp (GigAdapter)) {
       CdbPtr->StatFlags |= PXE_STATFLAGS_GET_STATUS_NO_MEDIA;
-      DEBUGPRINT (DECODE, ("Media disconnected\n"));
+      INTELGBE_TRACE (GigAdapter, INTELGBE_TRACE_LINK_DOWN, 0, 0, 0, 0);
     }
   }
 
   CdbPtr->StatFlags |= PXE_STATFLAGS_COMMAND_COMPLETE;
   CdbPtr->StatCode = PXE_STATCODE_SUCCESS;
+  INTELGBE_TRACE (GigAdapter, INTELGBE_TRACE_STATUS, CdbPtr->OpFlags,
+    (CdbPtr->DBsize - sizeof (UINT64)) / sizeof (UINT64), CdbPtr->StatFlags, 0);
 
   return;
 }
@@ -1280,8 +1267,6 @@ IntelgbeUndiFillHeader (
   ETHER_HEADER *                  MacHeader;
   UINTN                           i;
 
-  DEBUGPRINT (DECODE, ("IntelgbeUndiFillHeader\n"));
-
   if (CdbPtr->CPBsize == PXE_CPBSIZE_NOT_USED) {
     CdbPtr->StatFlags = PXE_STATFLAGS_COMMAND_FAILED;
     CdbPtr->StatCode = PXE_STATCODE_INVALID_CDB;
@@ -1305,14 +1290,10 @@ IntelgbeUndiFillHeader (
     // We don't swap the protocol bytes.
     MacHeader->Type = Cpbf->Protocol;
 
-    DEBUGPRINT (DECODE, ("MacHeader->SrcAddr = "));
     for (i = 0; i < PXE_HWADDR_LEN_ETHER; i++) {
       MacHeader->DestAddr[i] = Cpbf->DestAddr[i];
       MacHeader->SrcAddr[i] = Cpbf->SrcAddr[i];
-      DEBUGPRINT (DECODE, ("%x ", MacHeader->SrcAddr[i]));
     }
-
-    DEBUGPRINT (DECODE, ("\n"));
   } else {
     Cpb       = (PXE_CPB_FILL_HEADER *) (UINTN) CdbPtr->CPBaddr;
     MacHeader = (ETHER_HEADER *) (UINTN) Cpb->MediaHeader;
@@ -1320,14 +1301,10 @@ IntelgbeUndiFillHeader (
     // We don't swap the protocol bytes.
     MacHeader->Type = Cpb->Protocol;
 
-    DEBUGPRINT (DECODE, ("MacHeader->SrcAddr = "));
     for (i = 0; i < PXE_HWADDR_LEN_ETHER; i++) {
       MacHeader->DestAddr[i] = Cpb->DestAddr[i];
       MacHeader->SrcAddr[i] = Cpb->SrcAddr[i];
-      DEBUGPRINT (DECODE, ("%x ", MacHeader->SrcAddr[i]));
     }
-
-    DEBUGPRINT (DECODE, ("\n"));
   }
 
   DEBUGWAIT (DECODE);
@@ -1362,11 +1339,8 @@ IntelgbeUndiTransmit (
   IN GIG_DRIVER_DATA *GigAdapter
   )
 {
-  DEBUGPRINT (DECODE, ("IntelgbeUndiTransmit\n"));
-
   if (GigAdapter->DriverBusy) {
-    DEBUGPRINT (DECODE,
-      ("ERROR: IntelgbeUndiTransmit called when driver busy\n"));
+    INTELGBE_TRACE (GigAdapter, INTELGBE_TRACE_CMD_BUSY, CdbPtr->OpCode, 0, 0, 0);
     CdbPtr->StatFlags = PXE_STATFLAGS_COMMAND_FAILED;
     CdbPtr->StatCode = PXE_STATCODE_BUSY;
     return;
@@ -1408,11 +1382,8 @@ IntelgbeUndiReceive (
   IN GIG_DRIVER_DATA *GigAdapter
   )
 {
-  DEBUGPRINT (DECODE, ("IntelgbeUndiReceive\n"));
-
   if (GigAdapter->DriverBusy) {
-    DEBUGPRINT (DECODE,
-      ("ERROR: IntelgbeUndiReceive called while driver busy\n"));
+    INTELGBE_TRACE (GigAdapter, INTELGBE_TRACE_CMD_BUSY, CdbPtr->OpCode, 0, 0, 0);
     CdbPtr->StatFlags = PXE_STATFLAGS_COMMAND_FAILED;
     CdbPtr->StatCode = PXE_STATCODE_BUSY;
     return;
@@ -1455,8 +1426,6 @@ IntelgbeUndiApiEntry (
   GIG_DRIVER_DATA *GigAdapter;
   UNDI_CALL_TABLE *TabPtr;
 
-  DEBUGPRINT (DECODE, ("IntelgbeUndiApiEntry\n"));
-
   if (Cdb == (UINT64) 0) {
     return EFI_INVALID_PARAMETER;
   }
@@ -1482,15 +1451,13 @@ IntelgbeUndiApiEntry (
 
   GigAdapter->VersionFlag = 0x31; // entering from new entry point
 
-  DEBUGPRINT (DECODE, ("StatCode, OpCode, or StatFlags.: %x, %x, %x\n",
-    CdbPtr->StatCode, CdbPtr->OpCode, CdbPtr->StatFlags));
+  INTELGBE_TRACE (GigAdapter, INTELGBE_TRACE_CMD, CdbPtr->OpCode, CdbPtr->OpFlags,
+    CdbPtr->CPBsize, CdbPtr->DBsize);
 
   // Check the OPCODE range.
   if ((CdbPtr->OpCode > PXE_OPCODE_LAST_VALID) ||
     (CdbPtr->StatCode != PXE_STATCODE_INITIALIZE) ||
     (CdbPtr->StatFlags != PXE_STATFLAGS_INITIALIZE)) {
-    DEBUGPRINT (DECODE, ("Invalid StatCode, OpCode, or StatFlags.:%x, %x, %x\n",
-      CdbPtr->StatCode, CdbPtr->OpCode, CdbPtr->StatFlags));
     goto BadCdb;
   }
 
@@ -1561,7 +1528,8 @@ IntelgbeUndiApiEntry (
   return EFI_SUCCESS;
 
 BadCdb:
-  DEBUGPRINT (DECODE, ("BadCdb\n"));
+  INTELGBE_TRACE (GigAdapter, INTELGBE_TRACE_CMD_BAD_CDB, CdbPtr->OpCode,
+    CdbPtr->StatCode, CdbPtr->StatFlags, 0);
   CdbPtr->StatFlags = PXE_STATFLAGS_COMMAND_FAILED;
   CdbPtr->StatCode  = PXE_STATCODE_INVALID_CDB;
   return EFI_NOT_READY;
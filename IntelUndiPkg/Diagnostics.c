@@ -0,0 +1,502 @@
+/** @file
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "Intelgbe.h"
+#include "Diagnostics.h"
+
+EFI_GUID gIntelgbeDiagnosticsResultGuid = INTELGBE_DIAGNOSTICS_RESULT_GUID;
+
+/** Builds the self-test frame: addressed to our own MAC so the MAC address
+   filter accepts it on the way back, followed by a counting pattern.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+   @param[out]  Frame        Buffer of DIAG_FRAME_LEN bytes
+**/
+STATIC
+VOID
+IntelgbeDiagBuildFrame (
+  IN  GIG_DRIVER_DATA *GigAdapter,
+  OUT UINT8           *Frame
+  )
+{
+  ETHER_HEADER *EtherHeader;
+  UINTN         i;
+
+  EtherHeader = (ETHER_HEADER *) Frame;
+  INTELGBE_COPY_MAC (EtherHeader->DestAddr, GigAdapter->Hw.mac.addr);
+  INTELGBE_COPY_MAC (EtherHeader->SrcAddr, GigAdapter->Hw.mac.addr);
+  EtherHeader->Type = SwapBytes16 (DIAG_ETHER_TYPE);
+
+  for (i = sizeof (ETHER_HEADER); i < DIAG_FRAME_LEN; i++) {
+    Frame[i] = (UINT8) i;
+  }
+}
+
+/** Sends frames through the TX ring in loopback and checks them as they come
+   back on the RX ring.
+
+   The adapter is switched to internal (MAC) loopback unless a loopback mode
+   was already selected through the Initialize CPB. The run is timed with the
+   MAC system time counter; when timestamping is off it is started for the
+   duration of the test.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+   @param[in]   Frames       Number of frames to send
+   @param[out]  Result       Counters collected during the run
+
+   @retval   EFI_SUCCESS            Test ran, Result is valid
+   @retval   EFI_NOT_READY          Frames from the network stack are still in the TX ring
+   @retval   EFI_OUT_OF_RESOURCES   Could not allocate the test frames
+   @retval   EFI_DEVICE_ERROR       Loopback could not be enabled
+**/
+STATIC
+EFI_STATUS
+IntelgbeLoopbackSelfTest (
+  IN  GIG_DRIVER_DATA      *GigAdapter,
+  IN  UINT32               Frames,
+  OUT DIAG_LOOPBACK_RESULT *Result
+  )
+{
+  struct intelgbe_tx_queue *tx_q = &GigAdapter->tx_queue[INTELGBE_TXQ_BULK];
+  PXE_CPB_TRANSMIT          CpbTransmit;
+  PXE_CPB_RECEIVE           CpbReceive;
+  PXE_DB_RECEIVE            DbReceive;
+  EFI_STATUS                Status;
+  UINT64                    *TxDone;
+  UINT8                     *TxFrame;
+  UINT8                     *RxFrame;
+  UINT8                     SavedLoopBack;
+  BOOLEAN                   StartedTimer;
+  EFI_TPL                   OldTpl;
+  UINT64                    DropsBefore;
+  UINT64                    Start;
+  UINTN                     Idle;
+  UINTN                     StatCode;
+  UINT32                    i;
+
+  ZeroMem (Result, sizeof (DIAG_LOOPBACK_RESULT));
+
+  // Buffers handed to us by SNP must go back through GetStatus, not here.
+  // FreeTxBuffers reclaims every TX queue, so all of them have to be idle.
+  for (i = 0; i < GigAdapter->txqnum; i++) {
+    if (GigAdapter->tx_queue[i].cur_tx != GigAdapter->tx_queue[i].dirty_tx) {
+      return EFI_NOT_READY;
+    }
+  }
+
+  TxDone  = AllocatePool (sizeof (UINT64) * DEFAULT_TX_DESCRIPTORS);
+  TxFrame = AllocatePool (DIAG_FRAME_LEN);
+  RxFrame = AllocatePool (DIAG_FRAME_LEN);
+  if ((TxDone == NULL)
+    || (TxFrame == NULL)
+    || (RxFrame == NULL))
+  {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto ExitFree;
+  }
+  IntelgbeDiagBuildFrame (GigAdapter, TxFrame);
+
+  ZeroMem (&CpbTransmit, sizeof (CpbTransmit));
+  CpbTransmit.FrameAddr      = (UINT64) (UINTN) TxFrame;
+  CpbTransmit.DataLen        = DIAG_FRAME_LEN - PXE_MAC_HEADER_LEN_ETHER;
+  CpbTransmit.MediaheaderLen = PXE_MAC_HEADER_LEN_ETHER;
+
+  ZeroMem (&CpbReceive, sizeof (CpbReceive));
+  CpbReceive.BufferAddr = (UINT64) (UINTN) RxFrame;
+  CpbReceive.BufferLen  = DIAG_FRAME_LEN;
+
+  OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+  GigAdapter->DriverBusy = TRUE;
+
+  // Frames still waiting in the RX ring would be counted as bad.
+  while (IntelgbeReceive (GigAdapter, (UINT64) (UINTN) &CpbReceive,
+           (UINT64) (UINTN) &DbReceive) == PXE_STATCODE_SUCCESS)
+  {
+  }
+
+  SavedLoopBack = GigAdapter->LoopBack;
+  if (SavedLoopBack == LOOPBACK_NORMAL) {
+    if (IntelgbeSetLoopBack (GigAdapter, LOOPBACK_INTERNAL) != PXE_STATCODE_SUCCESS) {
+      GigAdapter->DriverBusy = FALSE;
+      gBS->RestoreTPL (OldTpl);
+      Status = EFI_DEVICE_ERROR;
+      goto ExitFree;
+    }
+  }
+
+  StartedTimer = FALSE;
+  if (GigAdapter->Hw.mac.tstamp && !GigAdapter->Hw.mac.tstamp_en) {
+    StartedTimer = (intelgbe_config_tstamp (&GigAdapter->Hw, TRUE) == INTELGBE_SUCCESS);
+  }
+
+  IntelgbeUpdateRxFifoDrops (GigAdapter);
+  DropsBefore = GigAdapter->RxFifoOverflows + GigAdapter->RxFifoMissed;
+
+  Start = intelgbe_get_systime (&GigAdapter->Hw);
+  Idle  = 0;
+  while (((Result->Received + Result->Bad) < Frames)
+    && (Idle < DIAG_DRAIN_TIMEOUT_US))
+  {
+    Idle++;
+
+    // Keep the RX ring from overflowing while we reap one frame per pass.
+    if ((Result->Sent < Frames)
+      && ((Result->Sent - Result->Received - Result->Bad) < DIAG_MAX_IN_FLIGHT))
+    {
+      if (IntelgbeTransmit (GigAdapter, (UINT64) (UINTN) &CpbTransmit, 0)
+          == PXE_STATCODE_SUCCESS)
+      {
+        Result->Sent++;
+        Idle = 0;
+      }
+    }
+
+    IntelgbeFreeTxBuffers (GigAdapter, DEFAULT_TX_DESCRIPTORS, TxDone);
+
+    // A frame dropped for errors is returned with no length.
+    DbReceive.FrameLen = 0;
+    StatCode = IntelgbeReceive (GigAdapter, (UINT64) (UINTN) &CpbReceive,
+                 (UINT64) (UINTN) &DbReceive);
+    if (StatCode == PXE_STATCODE_SUCCESS) {
+      if ((DbReceive.FrameLen == DIAG_FRAME_LEN)
+        && (CompareMem (RxFrame, TxFrame, DIAG_FRAME_LEN) == 0))
+      {
+        Result->Received++;
+      } else {
+        Result->Bad++;
+      }
+      Idle = 0;
+    }
+
+    if (Idle != 0) {
+      DelayInMicroseconds (GigAdapter, 1);
+    }
+  }
+  Result->ElapsedNs = intelgbe_get_systime (&GigAdapter->Hw) - Start;
+
+  IntelgbeUpdateRxFifoDrops (GigAdapter);
+  Result->FifoDrops = GigAdapter->RxFifoOverflows + GigAdapter->RxFifoMissed -
+                      DropsBefore;
+
+  // Wait out frames still in flight so no descriptor points at our buffer.
+  for (Idle = 0; (tx_q->cur_tx != tx_q->dirty_tx) && (Idle < DIAG_DRAIN_TIMEOUT_US); Idle++) {
+    IntelgbeFreeTxBuffers (GigAdapter, DEFAULT_TX_DESCRIPTORS, TxDone);
+    DelayInMicroseconds (GigAdapter, 1);
+  }
+
+  if (StartedTimer) {
+    intelgbe_config_tstamp (&GigAdapter->Hw, FALSE);
+  }
+  if (SavedLoopBack == LOOPBACK_NORMAL) {
+    IntelgbeSetLoopBack (GigAdapter, LOOPBACK_NORMAL);
+  }
+
+  GigAdapter->DriverBusy = FALSE;
+  gBS->RestoreTPL (OldTpl);
+
+  if (tx_q->cur_tx != tx_q->dirty_tx) {
+    // The hardware still owns descriptors pointing at TxFrame, leak it.
+    DEBUGPRINT (CRITICAL, ("Self-test frames stuck in TX ring\n"));
+    TxFrame = NULL;
+  }
+  Status = EFI_SUCCESS;
+
+ExitFree:
+  if (TxDone != NULL) {
+    FreePool (TxDone);
+  }
+  if (TxFrame != NULL) {
+    FreePool (TxFrame);
+  }
+  if (RxFrame != NULL) {
+    FreePool (RxFrame);
+  }
+  return Status;
+}
+
+/** Returns the throughput of a self-test run in Mb/s.
+
+   @param[in]   Result   Counters collected during the run
+
+   @return   Throughput of the frames received intact, 0 when the run was not timed
+**/
+STATIC
+UINT64
+IntelgbeDiagMbps (
+  IN DIAG_LOOPBACK_RESULT *Result
+  )
+{
+  if (Result->ElapsedNs == 0) {
+    return 0;
+  }
+  return DivU64x64Remainder (MultU64x32 (Result->Received, DIAG_FRAME_LEN * 8 * 1000),
+           Result->ElapsedNs, NULL);
+}
+
+/** Runs the loopback self-test under each named DMA profile.
+
+   One line per profile is written to Buffer followed by the profile that
+   moved the most data with no frame lost. The adapter goes back to the
+   profile it had before the sweep, the best one can then be selected
+   through the INTELGBE_ADAPTER_INFO_DMA_PROFILE Adapter Information type
+   or built in with INTELGBE_DMA_PROFILE.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+   @param[out]  Buffer       Report, DIAG_SWEEP_STRING_LEN characters
+   @param[in]   BufferSize   Size of Buffer in bytes
+
+   @retval   EFI_SUCCESS        Every profile ran without losing frames
+   @retval   EFI_DEVICE_ERROR   Frames were lost or corrupted under some profile
+   @retval   Others             A profile could not be applied or the self-test failed
+**/
+STATIC
+EFI_STATUS
+IntelgbeDiagDmaSweep (
+  IN  GIG_DRIVER_DATA *GigAdapter,
+  OUT CHAR16          *Buffer,
+  IN  UINTN           BufferSize
+  )
+{
+  struct intelgbe_dma_cfg SavedCfg;
+  DIAG_LOOPBACK_RESULT    Result;
+  EFI_STATUS              Status;
+  UINT32                  SavedProfile;
+  UINT32                  Profile;
+  UINT32                  Best;
+  UINT64                  BestMbps;
+  UINT64                  Mbps;
+  UINTN                   Len;
+  BOOLEAN                 Lost;
+
+  SavedProfile = GigAdapter->Hw.mac.dma_profile;
+  SavedCfg     = GigAdapter->Hw.mac.dma_cfg;
+  Best         = SavedProfile;
+  BestMbps     = 0;
+  Lost         = FALSE;
+  Len          = 0;
+  Status       = EFI_SUCCESS;
+
+  for (Profile = INTELGBE_DMA_PROFILE_DEFAULT; Profile < INTELGBE_DMA_PROFILE_CUSTOM; Profile++) {
+    Status = IntelgbeSetDmaProfile (GigAdapter, Profile, NULL);
+    if (!EFI_ERROR (Status)) {
+      Status = IntelgbeLoopbackSelfTest (GigAdapter, DIAG_FRAMES_STANDARD, &Result);
+    }
+    if (EFI_ERROR (Status)) {
+      DEBUGPRINT (CRITICAL, ("DMA profile %d returned %r\n", Profile, Status));
+      break;
+    }
+
+    Mbps = IntelgbeDiagMbps (&Result);
+    if ((Result.Received == 0)
+      || (Result.Received != Result.Sent)
+      || (Result.Bad != 0))
+    {
+      Lost = TRUE;
+    } else if (Mbps > BestMbps) {
+      BestMbps = Mbps;
+      Best     = Profile;
+    }
+
+    Len += UnicodeSPrint (
+             &Buffer[Len],
+             BufferSize - Len * sizeof (CHAR16),
+             L"DMA profile %d: %d/%d frames, %d bad, %ld FIFO drops, %ld.%03ld Gb/s\n",
+             Profile,
+             Result.Received,
+             Result.Sent,
+             Result.Bad,
+             Result.FifoDrops,
+             DivU64x32 (Mbps, 1000),
+             ModU64x32 (Mbps, 1000)
+           );
+  }
+
+  if (EFI_ERROR (IntelgbeSetDmaProfile (GigAdapter, SavedProfile, &SavedCfg))) {
+    DEBUGPRINT (CRITICAL, ("Could not restore DMA profile %d\n", SavedProfile));
+  }
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  UnicodeSPrint (
+    &Buffer[Len],
+    BufferSize - Len * sizeof (CHAR16),
+    L"Best DMA profile %d, %ld.%03ld Gb/s",
+    Best,
+    DivU64x32 (BestMbps, 1000),
+    ModU64x32 (BestMbps, 1000)
+  );
+
+  return Lost ? EFI_DEVICE_ERROR : EFI_SUCCESS;
+}
+
+/** Runs diagnostics on a controller.
+
+   Standard and extended diagnostics run the loopback self-test with
+   DIAG_FRAMES_STANDARD and DIAG_FRAMES_EXTENDED frames and report the frame
+   rate, throughput and drop counts in Buffer. Manufacturing diagnostics
+   repeat the standard test under every DMA profile and report the best one.
+
+   @param[in]   This               A pointer to the EFI_DRIVER_DIAGNOSTICS2_PROTOCOL or
+                                   EFI_DRIVER_DIAGNOSTICS_PROTOCOL instance.
+   @param[in]   ControllerHandle   The handle of the controller to run diagnostics on.
+   @param[in]   ChildHandle        The handle of the child controller, ignored.
+   @param[in]   DiagnosticType     Indicates the type of diagnostics to perform.
+   @param[in]   Language           Language in which Buffer is returned.
+   @param[out]  ErrorType          The GUID identifying the format of Buffer.
+   @param[out]  BufferSize         The size of Buffer in bytes.
+   @param[out]  Buffer             Results of the test, freed by the caller.
+
+   @retval   EFI_SUCCESS             All frames came back intact.
+   @retval   EFI_INVALID_PARAMETER   ControllerHandle, Language, ErrorType, BufferSize
+                                     or Buffer is NULL.
+   @retval   EFI_UNSUPPORTED         The driver is not managing ControllerHandle,
+                                     the diagnostic type or the language is not supported.
+   @retval   EFI_NOT_READY           The adapter is not initialized or is transmitting.
+   @retval   EFI_OUT_OF_RESOURCES    Could not allocate the test or result buffers.
+   @retval   EFI_DEVICE_ERROR        Frames were lost or corrupted.
+**/
+EFI_STATUS
+EFIAPI
+IntelgbeRunDiagnostics (
+  IN  EFI_DRIVER_DIAGNOSTICS2_PROTOCOL *This,
+  IN  EFI_HANDLE                       ControllerHandle,
+  IN  EFI_HANDLE                       ChildHandle  OPTIONAL,
+  IN  EFI_DRIVER_DIAGNOSTIC_TYPE       DiagnosticType,
+  IN  CHAR8                            *Language,
+  OUT EFI_GUID                         **ErrorType,
+  OUT UINTN                            *BufferSize,
+  OUT CHAR16                           **Buffer
+  )
+{
+  EFI_NII_POINTER_PROTOCOL *NiiPointerProtocol;
+  UNDI_PRIVATE_DATA        *UndiPrivateData;
+  GIG_DRIVER_DATA          *GigAdapter;
+  DIAG_LOOPBACK_RESULT     Result;
+  EFI_STATUS               Status;
+  UINT32                   Frames;
+  UINT64                   Pps;
+  UINT64                   Mbps;
+
+  if ((ControllerHandle == NULL)
+    || (Language == NULL)
+    || (ErrorType == NULL)
+    || (BufferSize == NULL)
+    || (Buffer == NULL))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+  *ErrorType  = NULL;
+  *BufferSize = 0;
+  *Buffer     = NULL;
+
+  if (AsciiStrCmp (Language, This->SupportedLanguages) != 0) {
+    return EFI_UNSUPPORTED;
+  }
+
+  switch (DiagnosticType) {
+  case EfiDriverDiagnosticTypeStandard:
+    Frames = DIAG_FRAMES_STANDARD;
+    break;
+  case EfiDriverDiagnosticTypeExtended:
+    Frames = DIAG_FRAMES_EXTENDED;
+    break;
+  case EfiDriverDiagnosticTypeManufacturing:
+    Frames = DIAG_FRAMES_STANDARD;
+    break;
+  default:
+    return EFI_UNSUPPORTED;
+  }
+
+  Status = gBS->OpenProtocol (
+                  ControllerHandle,
+                  &gEfiNiiPointerGuid,
+                  (VOID * *) &NiiPointerProtocol,
+                  gUndiDriverBinding.DriverBindingHandle,
+                  ControllerHandle,
+                  EFI_OPEN_PROTOCOL_GET_PROTOCOL
+                );
+  if (EFI_ERROR (Status)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  UndiPrivateData = UNDI_PRIVATE_DATA_FROM_THIS (NiiPointerProtocol->NiiProtocol31);
+  GigAdapter = &UndiPrivateData->NicInfo;
+
+  if ((GigAdapter->State != PXE_STATFLAGS_GET_STATE_INITIALIZED)
+    || GigAdapter->DriverBusy)
+  {
+    return EFI_NOT_READY;
+  }
+
+  if (DiagnosticType == EfiDriverDiagnosticTypeManufacturing) {
+    *BufferSize = DIAG_SWEEP_STRING_LEN * sizeof (CHAR16);
+    *Buffer = AllocateZeroPool (*BufferSize);
+    if (*Buffer == NULL) {
+      *BufferSize = 0;
+      return EFI_OUT_OF_RESOURCES;
+    }
+    Status = IntelgbeDiagDmaSweep (GigAdapter, *Buffer, *BufferSize);
+    *ErrorType = &gIntelgbeDiagnosticsResultGuid;
+    DEBUGPRINT (DIAG, ("%S\n", *Buffer));
+    return Status;
+  }
+
+  Status = IntelgbeLoopbackSelfTest (GigAdapter, Frames, &Result);
+  if (EFI_ERROR (Status)) {
+    DEBUGPRINT (CRITICAL, ("Loopback self-test returned %r\n", Status));
+    return Status;
+  }
+
+  Pps  = 0;
+  if (Result.ElapsedNs != 0) {
+    Pps  = DivU64x64Remainder (MultU64x32 (Result.Received, 1000000000),
+             Result.ElapsedNs, NULL);
+  }
+  Mbps = IntelgbeDiagMbps (&Result);
+
+  *BufferSize = DIAG_RESULT_STRING_LEN * sizeof (CHAR16);
+  *Buffer = AllocateZeroPool (*BufferSize);
+  if (*Buffer == NULL) {
+    *BufferSize = 0;
+    return EFI_OUT_OF_RESOURCES;
+  }
+  UnicodeSPrint (
+    *Buffer,
+    *BufferSize,
+    L"Loopback %d/%d frames, %d bad, %ld FIFO drops, %ld pps, %ld.%03ld Gb/s",
+    Result.Received,
+    Result.Sent,
+    Result.Bad,
+    Result.FifoDrops,
+    Pps,
+    DivU64x32 (Mbps, 1000),
+    ModU64x32 (Mbps, 1000)
+  );
+  *ErrorType = &gIntelgbeDiagnosticsResultGuid;
+
+  DEBUGPRINT (DIAG, ("%S\n", *Buffer));
+
+  if ((Result.Received == 0)
+    || (Result.Received != Result.Sent)
+    || (Result.Bad != 0))
+  {
+    return EFI_DEVICE_ERROR;
+  }
+  return EFI_SUCCESS;
+}
+
+/* Driver Diagnostics protocol instances */
+EFI_DRIVER_DIAGNOSTICS_PROTOCOL gUndiDriverDiagnostics = {
+  (EFI_DRIVER_DIAGNOSTICS_RUN_DIAGNOSTICS) IntelgbeRunDiagnostics,
+  "eng"
+};
+
+EFI_DRIVER_DIAGNOSTICS2_PROTOCOL gUndiDriverDiagnostics2 = {
+  IntelgbeRunDiagnostics,
+  "en-US"
+};
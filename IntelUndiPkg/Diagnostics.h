@@ -0,0 +1,50 @@
+/** @file
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef DIAGNOSTICS_H_
+#define DIAGNOSTICS_H_
+
+#include <Protocol/DriverDiagnostics.h>
+#include <Protocol/DriverDiagnostics2.h>
+
+/* Frames sent by the loopback self-test */
+#define DIAG_FRAMES_STANDARD      10000
+#define DIAG_FRAMES_EXTENDED      100000
+
+/* Self-test frame, addressed to ourselves with the IEEE local experimental EtherType */
+#define DIAG_FRAME_LEN            1514
+#define DIAG_ETHER_TYPE           0x88B5
+
+/* Frames sent ahead of the ones received back */
+#define DIAG_MAX_IN_FLIGHT        (DEFAULT_RX_DESCRIPTORS / 2)
+
+/* Time the ring may stay idle before the remaining frames count as dropped */
+#define DIAG_DRAIN_TIMEOUT_US     10000
+
+/* Characters in the result string returned through RunDiagnostics */
+#define DIAG_RESULT_STRING_LEN    160
+
+/* Characters in the DMA profile sweep report, one line per profile */
+#define DIAG_SWEEP_STRING_LEN     512
+
+/* ErrorType returned along with the self-test result string */
+#define INTELGBE_DIAGNOSTICS_RESULT_GUID \
+  { 0x2e531ecc, 0x359d, 0x4c11, { 0xb7, 0x78, 0x92, 0x40, 0xba, 0x48, 0x4e, 0x2d } }
+
+/* Outcome of one loopback self-test run */
+typedef struct {
+  UINT32 Sent;
+  UINT32 Received;
+  UINT32 Bad;        // frames received with errors or altered payload
+  UINT64 FifoDrops;  // RX FIFO overflows and missed frames during the run
+  UINT64 ElapsedNs;
+} DIAG_LOOPBACK_RESULT;
+
+extern EFI_DRIVER_DIAGNOSTICS_PROTOCOL  gUndiDriverDiagnostics;
+extern EFI_DRIVER_DIAGNOSTICS2_PROTOCOL gUndiDriverDiagnostics2;
+
+#endif /* DIAGNOSTICS_H_ */
@@ -20,6 +20,13 @@ UINT8              mActiveControllers = 0;
 UINT16             mActiveChildren    = 0;
 EFI_GUID gEfiNiiPointerGuid = EFI_NII_POINTER_PROTOCOL_GUID;
 
+/* Signalled when the OS loader calls ExitBootServices */
+STATIC EFI_EVENT   mExitBootServicesEvent = NULL;
+
+/* Private data by controller handle, chained through HashNext */
+#define CONTROLLER_HASH_SIZE 64
+STATIC UNDI_PRIVATE_DATA *mControllerHash[CONTROLLER_HASH_SIZE];
+
 /** Checks if remaining device path is NULL or end of device path
 
    @param[in]   RemainingDevicePath   Device Path
@@ -38,6 +45,65 @@ IsNullOrEndOfDevicePath (
   return FALSE;
 }
 
+/** Gets the controller hash bucket for a controller handle
+
+   @param[in]  ControllerHandle     Controller handle
+
+   @return     Index into mControllerHash
+**/
+STATIC
+UINTN
+ControllerHashIndex (
+  IN  EFI_HANDLE ControllerHandle
+  )
+{
+  UINTN Key;
+
+  // Handles are pool allocations, so the low bits carry no information.
+  Key = ((UINTN) ControllerHandle) >> 3;
+  return (Key ^ (Key >> 6) ^ (Key >> 12)) & (CONTROLLER_HASH_SIZE - 1);
+}
+
+/** Adds controller private data to the controller handle lookup
+
+   @param[in]  UndiPrivateData      Private data with ControllerHandle set
+**/
+STATIC
+VOID
+InsertControllerPrivateData (
+  IN  UNDI_PRIVATE_DATA *UndiPrivateData
+  )
+{
+  UINTN Index;
+
+  Index = ControllerHashIndex (UndiPrivateData->ControllerHandle);
+  UndiPrivateData->HashNext = mControllerHash[Index];
+  mControllerHash[Index] = UndiPrivateData;
+}
+
+/** Removes controller private data from the controller handle lookup
+
+   @param[in]  UndiPrivateData      Private data to remove
+**/
+STATIC
+VOID
+RemoveControllerPrivateData (
+  IN  UNDI_PRIVATE_DATA *UndiPrivateData
+  )
+{
+  UNDI_PRIVATE_DATA **Link;
+
+  Link = &mControllerHash[ControllerHashIndex (UndiPrivateData->ControllerHandle)];
+  while (*Link != NULL) {
+    if (*Link == UndiPrivateData) {
+      *Link = UndiPrivateData->HashNext;
+      break;
+    }
+    Link = &(*Link)->HashNext;
+  }
+  UndiPrivateData->HashNext = NULL;
+}
+
 /** Gets controller private data structure
 
    @param[in]  ControllerHandle     Controller handle
@@ -50,14 +116,14 @@ GetControllerPrivateData (
   IN  EFI_HANDLE ControllerHandle
   )
 {
-  UINT32 i = 0;
+  UNDI_PRIVATE_DATA *UndiPrivateData;
 
-  for (i = 0; i < mActiveControllers; i++) {
-    if (mIntelgbeUndi32DeviceList[i] != NULL) {
-      if (mIntelgbeUndi32DeviceList[i]->ControllerHandle == ControllerHandle) {
-        return mIntelgbeUndi32DeviceList[i];
-      }
+  UndiPrivateData = mControllerHash[ControllerHashIndex (ControllerHandle)];
+  while (UndiPrivateData != NULL) {
+    if (UndiPrivateData->ControllerHandle == ControllerHandle) {
+      return UndiPrivateData;
     }
+    UndiPrivateData = UndiPrivateData->HashNext;
   }
   return NULL;
 }
@@ -845,6 +911,22 @@ InitChildProtocols (
     return Status;
   }
 
+  if (UndiPrivateData->NicInfo.UndiEnabled) {
+    Status = InitVlanOffloadProtocol (UndiPrivateData);
+    if (EFI_ERROR (Status)) {
+      DEBUGPRINT (CRITICAL, ("InitVlanOffloadProtocol returned %r\n", Status));
+      DEBUGWAIT (CRITICAL);
+      return Status;
+    }
+
+    Status = InitDatapathProtocol (UndiPrivateData);
+    if (EFI_ERROR (Status)) {
+      DEBUGPRINT (CRITICAL, ("InitDatapathProtocol returned %r\n", Status));
+      DEBUGWAIT (CRITICAL);
+      return Status;
+    }
+  }
+
   return EFI_SUCCESS;
 }
 
@@ -897,15 +979,19 @@ InitUndiPrivateData (
 {
   UNDI_PRIVATE_DATA *PrivateData;
 
-  PrivateData = AllocateZeroPool (sizeof (UNDI_PRIVATE_DATA));
+  // Pool allocations are only 8-byte aligned. Use whole pages so the
+  // cache-line aligned datapath fields in NicInfo land on line boundaries.
+  PrivateData = AllocatePages (EFI_SIZE_TO_PAGES (sizeof (UNDI_PRIVATE_DATA)));
   if (PrivateData == NULL) {
-    DEBUGPRINT (CRITICAL, ("AllocateZeroPool returns %r\n", PrivateData));
+    DEBUGPRINT (CRITICAL, ("AllocatePages returns %r\n", PrivateData));
     DEBUGWAIT (CRITICAL);
     return EFI_OUT_OF_RESOURCES;
   }
+  ZeroMem (PrivateData, sizeof (UNDI_PRIVATE_DATA));
   PrivateData->Signature              = GIG_UNDI_DEV_SIGNATURE;
   PrivateData->DeviceHandle           = NULL;
   PrivateData->NicInfo.HwInitialized  = FALSE;
+  EfiInitializeLock (&PrivateData->NicInfo.Lock, TPL_NOTIFY);
 
   // Save off the controller handle so we can disconnect the driver later
   PrivateData->ControllerHandle = Controller;
@@ -916,6 +1002,7 @@ InitUndiPrivateData (
 
   mIntelgbeUndi32DeviceList[mActiveControllers] = PrivateData;
   mActiveControllers++;
+  InsertControllerPrivateData (PrivateData);
 
   *UndiPrivateData = PrivateData;
   return EFI_SUCCESS;
@@ -1175,7 +1262,11 @@ UndiError:
     Controller,
     This
   );
-  gBS->FreePool ((VOID **) UndiPrivateData);
+  if (UndiPrivateData != NULL) {
+    RemoveControllerPrivateData (UndiPrivateData);
+    mIntelgbeUndi32DeviceList[mActiveControllers] = NULL;
+    FreePages (UndiPrivateData, EFI_SIZE_TO_PAGES (sizeof (UNDI_PRIVATE_DATA)));
+  }
   return Status;
 }
 
@@ -1275,6 +1366,51 @@ InitializePxeStruct (
   return Status;
 }
 
+/** Quiesces every port before the OS takes over memory.
+
+   DMA is always stopped and bus mastering disabled. Ports handed off to the
+   OS keep PHY, SERDES and MAC link settings, every other port gets a MAC
+   reset so the OS driver starts from a clean controller.
+
+   @param[in]   Event     Event whose notification function is being invoked
+   @param[in]   Context   Not used
+**/
+STATIC
+VOID
+EFIAPI
+InitUndiNotifyExitBs (
+  IN EFI_EVENT Event,
+  IN VOID     *Context
+  )
+{
+  UNDI_PRIVATE_DATA *UndiPrivateData;
+  GIG_DRIVER_DATA   *GigAdapter;
+  UINTN              i;
+
+  for (i = 0; i < MAX_NIC_INTERFACES; i++) {
+    UndiPrivateData = mIntelgbeUndi32DeviceList[i];
+    if (UndiPrivateData == NULL) {
+      continue;
+    }
+    GigAdapter = &UndiPrivateData->NicInfo;
+
+    if (GigAdapter->State == PXE_STATFLAGS_GET_STATE_INITIALIZED) {
+      IntelgbeShutdown (GigAdapter);
+    }
+    if (!IntelgbeOsHandoffPublish (GigAdapter) && GigAdapter->HwInitialized) {
+      intelgbe_reset (&GigAdapter->Hw);
+    }
+
+    GigAdapter->PciIo->Attributes (
+                         GigAdapter->PciIo,
+                         EfiPciIoAttributeOperationDisable,
+                         EFI_PCI_IO_ATTRIBUTE_BUS_MASTER,
+                         NULL
+                         );
+    GigAdapter->ExitBootServicesTriggered = TRUE;
+  }
+}
+
 /** Register Driver Binding protocol for this driver.
    @param[in]   ImageHandle   Standard EFI Image entry - EFI_IMAGE_ENTRY_POINT
    @param[in]   SystemTable   EFI System Table structure pointer
@@ -1310,6 +1446,10 @@ InitializeIntelgbeUNDIDriver (
                   &gUndiComponentName,
                   &gEfiComponentName2ProtocolGuid,
                   &gUndiComponentName2,
+                  &gEfiDriverDiagnosticsProtocolGuid,
+                  &gUndiDriverDiagnostics,
+                  &gEfiDriverDiagnostics2ProtocolGuid,
+                  &gUndiDriverDiagnostics2,
                   &gEfiDriverConfigurationProtocolGuid,
                   &gGigUndiDriverConfiguration,
                   NULL
@@ -1337,6 +1477,21 @@ InitializeIntelgbeUNDIDriver (
   }
 
   Status = InitializePxeStruct ();
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = gBS->CreateEventEx (
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_NOTIFY,
+                  InitUndiNotifyExitBs,
+                  NULL,
+                  &gEfiEventExitBootServicesGuid,
+                  &mExitBootServicesEvent
+                );
+  if (EFI_ERROR (Status)) {
+    DEBUGPRINT (CRITICAL, ("CreateEventEx returns %r\n", Status));
+  }
 
   return Status;
 }
@@ -1359,6 +1514,7 @@ StopController (
   )
 {
   EFI_STATUS Status;
+  UINT32     i;
 
   if (This == NULL
     || UndiPrivateData == NULL)
@@ -1406,6 +1562,28 @@ StopController (
     &UndiPrivateData->NicInfo.RxBufferMapping
     );
 
+  if (UndiPrivateData->NicInfo.TxBufferMappings != NULL) {
+    FreePool (UndiPrivateData->NicInfo.TxBufferMappings);
+    UndiPrivateData->NicInfo.TxBufferMappings = NULL;
+  }
+
+  if (UndiPrivateData->NicInfo.TraceRing != NULL) {
+    UndiPrivateData->NicInfo.TraceMask = 0;
+    FreePool (UndiPrivateData->NicInfo.TraceRing);
+    UndiPrivateData->NicInfo.TraceRing = NULL;
+  }
+
+  UndiPrivateData->NicInfo.CaptureDirections = 0;
+  IntelgbeFreeCapture (UndiPrivateData->NicInfo.Capture);
+  UndiPrivateData->NicInfo.Capture = NULL;
+
+  for (i = 0; i < INTELGBE_MAX_TX_QUEUES; i++) {
+    if (UndiPrivateData->NicInfo.tx_queue[i].tx_tstamp != NULL) {
+      FreePool (UndiPrivateData->NicInfo.tx_queue[i].tx_tstamp);
+      UndiPrivateData->NicInfo.tx_queue[i].tx_tstamp = NULL;
+    }
+  }
+
   DEBUGPRINT (INIT, ("Attributes"));
   Status = UndiPrivateData->NicInfo.PciIo->Attributes (
                                              UndiPrivateData->NicInfo.PciIo,
@@ -1432,11 +1610,8 @@ StopController (
     return Status;
   }
 
-  Status = gBS->FreePool (UndiPrivateData);
-  if (EFI_ERROR (Status)) {
-    DEBUGPRINT (CRITICAL, ("FreePool(UndiPrivateData) returns %r\n", Status));
-    DEBUGWAIT (CRITICAL);
-  }
+  RemoveControllerPrivateData (UndiPrivateData);
+  FreePages (UndiPrivateData, EFI_SIZE_TO_PAGES (sizeof (UNDI_PRIVATE_DATA)));
   return EFI_SUCCESS;
 }
 
@@ -1483,6 +1658,21 @@ StopChild (
     return Status;
   }
 
+  if (UndiPrivateData->NicInfo.UndiEnabled) {
+    Status = UninstallDatapathProtocol (UndiPrivateData);
+    if (EFI_ERROR (Status)) {
+      DEBUGPRINT (CRITICAL, ("UninstallDatapathProtocol returns %r\n",
+        Status));
+      DEBUGWAIT (CRITICAL);
+    }
+
+    Status = UninstallVlanOffloadProtocol (UndiPrivateData);
+    if (EFI_ERROR (Status)) {
+      DEBUGPRINT (CRITICAL, ("UninstallVlanOffloadProtocol returns %r\n",
+        Status));
+      DEBUGWAIT (CRITICAL);
+    }
+  }
 
   Status = UninstallAdapterInformationProtocol (UndiPrivateData);
   if ((EFI_ERROR (Status)) && (Status != EFI_UNSUPPORTED)) {
@@ -1706,6 +1896,13 @@ IntelgbeUndiUnload (
       DEBUGPRINT (CRITICAL, ("FreePool returns %r\n", Status));
       return Status;
     }
+
+    if (mExitBootServicesEvent != NULL) {
+      gBS->CloseEvent (mExitBootServicesEvent);
+      mExitBootServicesEvent = NULL;
+    }
+    IntelgbeOsHandoffUninstall ();
+
     DEBUGPRINT (INIT,
       ("Uninstalling UEFI 1.10/2.10 Driver Diags and \
         Component Name protocols.\n"));
@@ -1717,6 +1914,10 @@ IntelgbeUndiUnload (
                     &gUndiComponentName,
                     &gEfiComponentName2ProtocolGuid,
                     &gUndiComponentName2,
+                    &gEfiDriverDiagnosticsProtocolGuid,
+                    &gUndiDriverDiagnostics,
+                    &gEfiDriverDiagnostics2ProtocolGuid,
+                    &gUndiDriverDiagnostics2,
                     &gEfiDriverConfigurationProtocolGuid,
                     &gGigUndiDriverConfiguration,
                     NULL
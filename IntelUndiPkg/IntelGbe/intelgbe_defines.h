@@ -19,12 +19,18 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
  * Those are available for 32 bits architectures:
  */
 #define POINTER_TO_UINT(x)                      ((u64) (x))
+#define lower_32_bits(x)                        ((u32) ((u64) (x)))
+#define upper_32_bits(x)                        ((u32) (((u64) (x)) >> 32))
 #define UINT_TO_POINTER(x)                      ((void *) (x))
 #define POINTER_TO_INT(x)                       ((s64) (x))
 #define INT_TO_POINTER(x)                       ((void *) (x))
 
 #define INTELGBE_MAX_RX_QUEUES                    1
-#define INTELGBE_MAX_TX_QUEUES                    1
+#define INTELGBE_MAX_TX_QUEUES                    2
+
+/* TX queues, a higher queue wins under strict priority */
+#define INTELGBE_TXQ_BULK                         0
+#define INTELGBE_TXQ_CONTROL                      1
 #define INTELGBE_ADDR_HIGH(reg)                   (0x300 + reg * 8)
 #define INTELGBE_ADDR_LOW(reg)                    (0x304 + reg * 8)
 
@@ -53,19 +59,39 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define DMA_SYSBUS_MD_EN_LPI                    BIT(31)
 #define INV_DMA_SYSBUS_MD_WR_OSR_LMT            0xF8FFFFFF
 #define INV_DMA_SYSBUS_MD_RD_OSR_LMT            0xFFF8FFFF
+#define DMA_SYSBUS_MD_WR_OSR_LMT_SHIFT          24
+#define DMA_SYSBUS_MD_RD_OSR_LMT_SHIFT          16
+#define DMA_SYSBUS_MD_OSR_LMT_MAX               7
 #define DMA_SYSBUS_MD_MB                        BIT(14)
 #define DMA_SYSBUS_MD_AAL                       BIT(12)
+#define DMA_SYSBUS_MD_EAME                      BIT(11)
 #define DMA_SYSBUS_MD_AALE                      BIT(10)
 #define DMA_SYSBUS_MD_BLEN32                    BIT(4)
 #define DMA_SYSBUS_MD_BLEN16                    BIT(3)
 #define DMA_SYSBUS_MD_BLEN8                     BIT(2)
 #define DMA_SYSBUS_MD_BLEN4                     BIT(1)
 #define DMA_SYSBUS_MD_FB                        BIT(0)
+#define DMA_SYSBUS_MD_BLEN_MASK                 (DMA_SYSBUS_MD_BLEN32 | DMA_SYSBUS_MD_BLEN16 | \
+                                                 DMA_SYSBUS_MD_BLEN8 | DMA_SYSBUS_MD_BLEN4)
 
 #define DMA_INTERRUPT_STATUS                    0x1008
 #define DMA_INTR_STS_CHNL_MAX                   8
 #define DMA_INTR_STS_DCIS(x)                    (BIT(0) << x)
 
+/* Receive and transmit process states, channels 0-2 from bit 8 of
+ * DMA_DEBUG_STATUS0, then four channels per register from bit 0
+ */
+#define DMA_DEBUG_STATUS0                       0x100C
+#define DMA_DEBUG_STATUS(x)                     ((x) < 3 ? DMA_DEBUG_STATUS0 : \
+                                                 (0x1010 + (((x) - 3) / 4) * 4))
+#define DMA_DEBUG_STATUS_RPS_SHIFT(x)           ((x) < 3 ? (8 + (x) * 8) : (((x) - 3) % 4) * 8)
+#define DMA_DEBUG_STATUS_TPS_SHIFT(x)           (DMA_DEBUG_STATUS_RPS_SHIFT(x) + 4)
+#define DMA_DEBUG_STATUS_PS_MASK                0xF
+#define DMA_DEBUG_RPS_STOPPED                   0
+#define DMA_DEBUG_RPS_SUSPENDED                 4
+#define DMA_DEBUG_TPS_STOPPED                   0
+#define DMA_DEBUG_TPS_SUSPENDED                 6
+
 #define DMA_CONTROL_CH(x)                       (0x1100 + (x * 0x80))
 #define DMA_CH_CTRL_DSL_MASK                    0x001C0000
 #define DMA_CH_CTRL_DSL_SHIFT                   18
@@ -85,6 +111,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define DMA_CH_RX_CTRL_RBSZ_SHIFT               1
 #define DMA_CH_RX_CTRL_SR                       BIT(0)
 
+#define DMA_TXDESC_LIST_HADDR_CH(x)             (0x1110 + (x * 0x80))
+#define DMA_RXDESC_LIST_HADDR_CH(x)             (0x1118 + (x * 0x80))
 #define DMA_TXDESC_LIST_ADDR_CH(x)              (0x1114 + (x * 0x80))
 #define DMA_RXDESC_LIST_ADDR_CH(x)              (0x111C + (x * 0x80))
 #define DMA_TXDESC_TAIL_PTR_CH(x)               (0x1120 + (x * 0x80))
@@ -99,6 +127,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define DMA_CH_INTR_EN_TIE                      BIT(0)
 #define DMA_INTR_STATUS_CH(x)                   (0x1160 + (x * 0x80))
 #define DMA_CH_INTR_STS_NIS                     BIT(15)
+#define DMA_CH_INTR_STS_AIS                     BIT(14)
 #define DMA_CH_INTR_STS_RWT                     BIT(9)
 #define DMA_CH_INTR_STS_RI                      BIT(6)
 #define DMA_CH_INTR_STS_TI                      BIT(0)
@@ -195,12 +224,32 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define INV_MTL_TXQ_OPR_TXQEN                   0xFFFFFFF3
 #define MTL_TXQ_OPR_TXQEN_EN                    0x00000008
 #define MTL_TXQ_OPR_TXQEN_EN_IF_AV              0x00000004
+#define MTL_TXQ_QUANTUM_WEIGHT(x)               (0x0D18 + (x * 0x40))
+#define MTL_TXQ_QW_ISCQW_MASK                   0x001FFFFF
+/* DWRR quantum per unit of queue weight, one full-size frame */
+#define MTL_TXQ_DWRR_QUANTUM                    1536
 
 #define MTL_RXQ_OPERATION_MODE(x)               (0x0D30 + (x * 0x40))
 #define MTL_RXQ_OPR_RQS_MASK                    0x07F00000
 #define MTL_RXQ_OPR_RQS_SHIFT                   20
 #define MTL_RXQSZ_BLOCK                         256
 #define MTL_RXQ_OPR_RSF                         BIT(5)
+#define MTL_RXQ_OPR_EHFC                        BIT(7)
+#define MTL_RXQ_OPR_RFA_SHIFT                   8
+#define MTL_RXQ_OPR_RFA_MASK                    0x00003F00
+#define MTL_RXQ_OPR_RFD_SHIFT                   14
+#define MTL_RXQ_OPR_RFD_MASK                    0x000FC000
+/* RFA/RFD encode the fill level as bytes below full, from 1K in 512 byte steps */
+#define MTL_RXQ_FC_THRESHOLD(bytes)             ((((bytes) - 1024) / 512))
+#define MTL_RXQ_FC_MIN_FIFO                     4096
+
+#define MTL_RXQ_MISSED_PKT_OVF_CNT(x)           (0x0D34 + (x * 0x40))
+#define MTL_RXQ_OVFPKTCNT_MASK                  0x000007FF
+#define MTL_RXQ_OVFCNTOVF                       BIT(11)
+#define MTL_RXQ_MISPKTCNT_MASK                  0x07FF0000
+#define MTL_RXQ_MISPKTCNT_SHIFT                 16
+#define MTL_RXQ_MISCNTOVF                       BIT(27)
+#define MTL_RXQ_CNT_WRAP                        0x800
 
 
 #define MAC_MDIO_ADDRESS_REG                    0x0200
@@ -282,17 +331,25 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define SERDES_PCLK_SHIFT       12
 
 #define MAC_HW_FEATURE0                         0x011C
+#define MAC_HW_FEAT0_VLHASH                     BIT(4)
 #define MAC_HW_FEAT0_TSSEL                      BIT(12)
+#define MAC_HW_FEAT0_EEESEL                     BIT(13)
 #define MAC_HW_FEAT0_TXCOESEL                   BIT(14)
 #define MAC_HW_FEAT0_RXCOESEL                   BIT(16)
 #define MAC_HW_FEAT0_ADDMACADRSEL_MASK          0x007C0000
 #define MAC_HW_FEAT0_ADDMACADRSEL_SHIFT         18
+#define MAC_HW_FEAT0_SAVLANINS                  BIT(27)
 #define MAC_HW_FEATURE1                         0x0120
 #define MAC_HW_FEAT1_HASHTBLSZ_MASK             0x03000000
 #define MAC_HW_FEAT1_HASHTBLSZ_SHIFT            24
 #define MAC_HW_FEAT1_HASHTBLSZ_64               0x01
 #define MAC_HW_FEAT1_HASHTBLSZ_128              0x02
 #define MAC_HW_FEAT1_HASHTBLSZ_256              0x03
+#define MAC_HW_FEAT1_ADDR64_MASK                0x0000C000
+#define MAC_HW_FEAT1_ADDR64_SHIFT               14
+#define MAC_HW_FEAT1_ADDR64_32                  0x00
+#define MAC_HW_FEAT1_ADDR64_40                  0x01
+#define MAC_HW_FEAT1_ADDR64_48                  0x02
 #define MAC_HW_FEAT1_TXFIFOSZ_MASK              0x000007C0
 #define MAC_HW_FEAT1_TXFIFOSZ_SHIFT             6
 #define MAC_HW_FEAT1_RXFIFOSZ_MASK              0x0000001F
@@ -329,6 +386,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #define MAC_CONFIGURATION                       0x0000
 #define MAC_PACKET_FILTER                       0x0008
+#define MAC_PACKET_FILTER_VTFE                  BIT(16)
 #define MAC_CONF_IPC                            BIT(27)
 #define MAC_CONF_CST                            BIT(21)
 #define MAC_CONF_ACS                            BIT(20)
@@ -343,6 +401,66 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define MAC_CONF_TE                             BIT(1)
 #define MAC_CONF_RE                             BIT(0)
 
+/* IEEE 802.3x flow control */
+#define INTELGBE_FC_RX                          BIT(0) /* honour received pause */
+#define INTELGBE_FC_TX                          BIT(1) /* send pause on RX fill */
+
+/* Loopback modes */
+#define INTELGBE_LOOPBACK_NONE                  0
+#define INTELGBE_LOOPBACK_MAC                   1 /* MAC TX looped to MAC RX */
+#define INTELGBE_LOOPBACK_PHY                   2 /* looped in the PHY PCS */
+#define MAC_QX_TX_FLOW_CTRL(x)                  (0x0070 + (x * 0x4))
+#define MAC_TX_FLOW_CTRL_TFE                    BIT(1)
+#define MAC_TX_FLOW_CTRL_PT_SHIFT               16
+#define MAC_TX_FLOW_CTRL_PT_MAX                 0xFFFF
+#define MAC_RX_FLOW_CTRL                        0x0090
+#define MAC_RX_FLOW_CTRL_RFE                    BIT(0)
+
+#define MAC_VLAN_TAG                            0x0050
+#define MAC_VLAN_TAG_ETV                        BIT(16)
+#define MAC_VLAN_TAG_EVLS_MASK                  0x00600000
+#define MAC_VLAN_TAG_EVLS_ALWAYS_STRIP          0x00600000
+#define MAC_VLAN_TAG_EVLRXS                     BIT(24)
+#define MAC_VLAN_TAG_VTHM                       BIT(25)
+#define MAC_VLAN_HASH_TABLE                     0x0058
+#define MAC_VLAN_INCL                           0x0060
+#define MAC_VLAN_INCL_VLC_MASK                  0x00030000
+#define MAC_VLAN_INCL_VLC_INSERT                0x00020000
+#define MAC_VLAN_INCL_VLTI                      BIT(20)
+
+/* IEEE 1588 timestamping, system time counter runs off the PTP clock */
+#define INTELGBE_PTP_CLK_RATE_HZ                200000000
+#define MAC_TIMESTAMP_CONTROL                   0x0B00
+#define MAC_TSCTRL_TSENA                        BIT(0)
+#define MAC_TSCTRL_TSINIT                       BIT(2)
+#define MAC_TSCTRL_TSENALL                      BIT(8)
+#define MAC_TSCTRL_TSCTRLSSR                    BIT(9)
+#define MAC_SUB_SECOND_INCREMENT                0x0B04
+#define MAC_SSINC_SHIFT                         16
+#define MAC_SYSTEM_TIME_SECONDS                 0x0B08
+#define MAC_SYSTEM_TIME_NANOSECONDS             0x0B0C
+#define MAC_SYSTEM_TIME_SECONDS_UPDATE          0x0B10
+#define MAC_SYSTEM_TIME_NANOSECONDS_UPDATE      0x0B14
+#define MAC_SYSTEM_TIME_NS_MASK                 0x7FFFFFFF
+
+/* Energy Efficient Ethernet, LPI timers count in CSR clock derived 1us tics */
+#define INTELGBE_CSR_CLK_RATE_HZ                200000000
+#define MAC_LPI_CONTROL_STATUS                  0x00D0
+#define MAC_LPI_CTRL_LPIEN                      BIT(16)
+#define MAC_LPI_CTRL_PLS                        BIT(17)
+#define MAC_LPI_CTRL_LPITXA                     BIT(19)
+#define MAC_LPI_CTRL_LPIATE                     BIT(20)
+#define MAC_LPI_TIMERS_CONTROL                  0x00D4
+#define MAC_LPI_TIMERS_LST_SHIFT                16
+#define MAC_LPI_TIMERS_LST_MASK                 0x03FF0000
+#define MAC_LPI_TIMERS_TWT_MASK                 0x0000FFFF
+#define MAC_LPI_ENTRY_TIMER                     0x00D8
+#define MAC_LPI_ENTRY_TIMER_MASK                0x000FFFF8
+#define MAC_1US_TIC_COUNTER                     0x00DC
+#define MAC_LPI_LS_TIMER_MS                     1000
+#define MAC_LPI_TW_TIMER_US                     30
+#define MAC_LPI_ENTRY_TIMER_US                  1000
+
 #define MAC_RXQ_CTRL0                           0x00A0
 #define MAC_RXQ_CTRL2                           0x00A8
 #define MAC_RXQ_CTRL3                           0x00AC
@@ -144,6 +144,253 @@ int mii_phy_soft_reset(struct intelgbe_hw *hw, bool wait)
   return retval;
 }
 
+/* MMD register access for both PHY kinds. Clause 22 PHYs reach the MMDs
+ * indirectly through registers 13 and 14 (IEEE 802.3 Annex 22D).
+ * refer to mmd_phy_indirect() in phy-core.c
+ */
+STATIC s32 mii_phy_read_mmd(struct intelgbe_hw *hw, u8 devad, u16 regnum,
+                            u32 *val)
+{
+  s32 retval;
+
+  if (hw->phy.c45)
+    return intelgbe_phy_read_c45(hw, devad, regnum, val);
+
+  retval = intelgbe_phy_write_c22(hw, MII_STD_MMD_CTRL,
+                                  devad & MII_STD_MMD_CTRL_DEVAD_MASK);
+  retval |= intelgbe_phy_write_c22(hw, MII_STD_MMD_DATA, regnum);
+  retval |= intelgbe_phy_write_c22(hw, MII_STD_MMD_CTRL,
+                                   (devad & MII_STD_MMD_CTRL_DEVAD_MASK) |
+                                   MII_STD_MMD_CTRL_DATA_NOINC);
+  if (retval < 0) return retval;
+
+  return intelgbe_phy_read_c22(hw, MII_STD_MMD_DATA, val);
+}
+
+STATIC s32 mii_phy_write_mmd(struct intelgbe_hw *hw, u8 devad, u16 regnum,
+                             u16 val)
+{
+  s32 retval;
+
+  if (hw->phy.c45)
+    return intelgbe_phy_write_c45(hw, devad, regnum, val);
+
+  retval = intelgbe_phy_write_c22(hw, MII_STD_MMD_CTRL,
+                                  devad & MII_STD_MMD_CTRL_DEVAD_MASK);
+  retval |= intelgbe_phy_write_c22(hw, MII_STD_MMD_DATA, regnum);
+  retval |= intelgbe_phy_write_c22(hw, MII_STD_MMD_CTRL,
+                                   (devad & MII_STD_MMD_CTRL_DEVAD_MASK) |
+                                   MII_STD_MMD_CTRL_DATA_NOINC);
+  if (retval < 0) return retval;
+
+  return intelgbe_phy_write_c22(hw, MII_STD_MMD_DATA, val);
+}
+
+/* Read the 10/100/1000 abilities and 2.5GBASE-T from the PMA/PMD, for PHYs
+ * with a multi-gigabit copper side.
+ * refer to genphy_c45_pma_read_abilities() in phy-c45.c
+ */
+int mii_phy_get_supported_c45(struct intelgbe_hw *hw)
+{
+  struct intelgbe_phy_info *phy = &hw->phy;
+  u32 val;
+  int retval;
+
+  retval = mii_phy_get_supported(hw);
+  if (retval < 0) return retval;
+
+  retval = mii_phy_read_mmd(hw, MMD_PMA_PMD, MMD_PMA_EXTABLE, &val);
+  if (retval < 0) return retval;
+  if (!(val & MMD_PMA_EXTABLE_NBT)) return INTELGBE_SUCCESS;
+
+  retval = mii_phy_read_mmd(hw, MMD_PMA_PMD, MMD_PMA_NG_EXTABLE, &val);
+  if (retval < 0) return retval;
+  if (val & MMD_PMA_NG_EXTABLE_2_5GBT) {
+    phy->support |= PHY_SUPPORT_2500_FULL;
+    DEBUGPRINT (CRITICAL, ("PHY Supported: 2500BASE-T, Full Duplex\n"));
+  }
+  return INTELGBE_SUCCESS;
+}
+
+/* Advertise EEE only in the power-save link profile. PHY firmware may
+ * enable it by default, so the advertisement is always rewritten.
+ * 2.5GBASE-T EEE lives in the second advertisement register, which is
+ * only touched on PHYs that support 2.5G.
+ * Returns negative errno, 0 if there was no change, and 1 in case of change
+ * refer to genphy_config_eee_advert() in phy_device.c
+ */
+STATIC int mii_phy_config_eee_advert(struct intelgbe_hw *hw)
+{
+  struct intelgbe_phy_info *phy = &hw->phy;
+  bool power_save = (hw->mac.link_profile == INTELGBE_LINK_PROFILE_POWER_SAVE);
+  int changed = 0;
+  int retval;
+  u32 oldval;
+  u16 advertise = 0;
+
+  if (power_save) {
+    if (phy->support & PHY_SUPPORT_100_FULL)
+      advertise |= MDIO_AN_EEE_100TX;
+    if (phy->support & PHY_SUPPORT_1000_FULL)
+      advertise |= MDIO_AN_EEE_1000T;
+  }
+
+  retval = mii_phy_read_mmd(hw, MMD_AN, MDIO_AN_EEE_ADV, &oldval);
+  if (retval < 0) return retval;
+  if ((oldval & MDIO_AN_EEE_ADV_SPEED) != advertise) {
+    DEBUGPRINT (PHYFUNC, ("EEE advertise %X -> %X\n", oldval, advertise));
+    retval = mii_phy_write_mmd(hw, MMD_AN, MDIO_AN_EEE_ADV,
+                               (oldval & ~MDIO_AN_EEE_ADV_SPEED) | advertise);
+    if (retval < 0) return retval;
+    changed = 1;
+  }
+
+  if (!(phy->support & PHY_SUPPORT_2500_FULL))
+    return changed;
+
+  advertise = power_save ? MDIO_AN_EEE_2_5GT : 0;
+  retval = mii_phy_read_mmd(hw, MMD_AN, MDIO_AN_EEE_ADV2, &oldval);
+  if (retval < 0) return retval;
+  if ((oldval & MDIO_AN_EEE_2_5GT) != advertise) {
+    DEBUGPRINT (PHYFUNC, ("EEE advertise 2 %X -> %X\n", oldval, advertise));
+    retval = mii_phy_write_mmd(hw, MMD_AN, MDIO_AN_EEE_ADV2,
+                               (oldval & ~MDIO_AN_EEE_2_5GT) | advertise);
+    if (retval < 0) return retval;
+    changed = 1;
+  }
+  return changed;
+}
+
+/* Check whether both link partners advertise EEE for the resolved speed
+ * refer to phy_init_eee() in phy.c
+ */
+int mii_phy_eee_active(struct intelgbe_hw *hw, s32 link_speed, bool *active)
+{
+  int retval;
+  u32 adv, lpa;
+
+  *active = false;
+
+  if (link_speed == 2500) {
+    retval = mii_phy_read_mmd(hw, MMD_AN, MDIO_AN_EEE_ADV2, &adv);
+    if (retval < 0) return retval;
+    retval = mii_phy_read_mmd(hw, MMD_AN, MDIO_AN_EEE_LPA2, &lpa);
+    if (retval < 0) return retval;
+    *active = (adv & lpa & MDIO_AN_EEE_2_5GT) ? true : false;
+    return INTELGBE_SUCCESS;
+  }
+
+  retval = mii_phy_read_mmd(hw, MMD_AN, MDIO_AN_EEE_ADV, &adv);
+  if (retval < 0) return retval;
+  retval = mii_phy_read_mmd(hw, MMD_AN, MDIO_AN_EEE_LPA, &lpa);
+  if (retval < 0) return retval;
+
+  adv &= lpa;
+  if (link_speed == 1000)
+    *active = (adv & MDIO_AN_EEE_1000T) ? true : false;
+  else if (link_speed == 100)
+    *active = (adv & MDIO_AN_EEE_100TX) ? true : false;
+
+  return INTELGBE_SUCCESS;
+}
+
+/* Resolve full duplex pause from both advertisements (IEEE 802.3 Table 28B-3)
+ * refer to mii_resolve_flowctrl_fdx() in mii.h
+ */
+int mii_phy_resolve_pause(struct intelgbe_hw *hw, u32 *fc)
+{
+  int retval;
+  u32 lcladv, rmtadv;
+
+  *fc = 0;
+
+  if (hw->phy.c45) {
+    retval = intelgbe_phy_read_c45(hw, MMD_AN, MMD_AN_ADV, &lcladv);
+    if (retval < 0) return retval;
+    retval = intelgbe_phy_read_c45(hw, MMD_AN, MMD_AN_LPA, &rmtadv);
+  } else {
+    retval = intelgbe_phy_read_c22(hw, MII_AN_ADV, &lcladv);
+    if (retval < 0) return retval;
+    retval = intelgbe_phy_read_c22(hw, MII_AN_LPA, &rmtadv);
+  }
+  if (retval < 0) return retval;
+
+  if (lcladv & rmtadv & MII_AN_ADV_TAF_PAUSE) {
+    *fc = INTELGBE_FC_RX | INTELGBE_FC_TX;
+  } else if (lcladv & rmtadv & MII_AN_ADV_TAF_ASYM_PAUSE) {
+    if (lcladv & MII_AN_ADV_TAF_PAUSE)
+      *fc = INTELGBE_FC_RX;
+    else if (rmtadv & MII_AN_ADV_TAF_PAUSE)
+      *fc = INTELGBE_FC_TX;
+  }
+
+  return INTELGBE_SUCCESS;
+}
+
+/* Map a forced speed and duplex to the matching PHY_SUPPORT_* mode,
+ * 0 if there is none
+ */
+u32 mii_phy_forced_mode(u32 speed, bool full_duplex)
+{
+  switch (speed) {
+  case 10:
+    return full_duplex ? PHY_SUPPORT_10_FULL : PHY_SUPPORT_10_HALF;
+  case 100:
+    return full_duplex ? PHY_SUPPORT_100_FULL : PHY_SUPPORT_100_HALF;
+  case 1000:
+    return full_duplex ? PHY_SUPPORT_1000_FULL : PHY_SUPPORT_1000_HALF;
+  case 2500:
+    return full_duplex ? PHY_SUPPORT_2500_FULL : 0;
+  default:
+    return 0;
+  }
+}
+
+/* refer to genphy_setup_forced() in phy_device.c */
+STATIC int mii_phy_setup_forced(struct intelgbe_hw *hw)
+{
+  struct intelgbe_phy_info *phy = &hw->phy;
+  u16 ctl;
+
+  DEBUGPRINT (CRITICAL, ("PHY forced to %dMbps %a duplex\n", phy->link_speed,
+                         phy->full_duplex ? "full" : "half"));
+
+  ctl = (phy->link_speed == 100) ? MII_STD_CTRL_SPEED_100 : MII_STD_CTRL_SPEED_10;
+  if (phy->full_duplex)
+    ctl |= MII_STD_CTRL_DUPLEX_MODE;
+
+  return intelgbe_phy_modify_c22(hw, MII_STD_CTRL,
+                                 (MII_STD_CTRL_SPEED_MASK | MII_STD_CTRL_DUPLEX_MODE |
+                                  MII_STD_CTRL_AUTONEG_ENABLE | MII_STD_CTRL_ISOLATE |
+                                  MII_STD_CTRL_POWERDOWN),
+                                 ctl);
+}
+
+/* Loop the PHY back at 1000 Mbps full duplex. Leaving loopback does not
+ * restore auto-negotiation, cfg_link has to run afterwards.
+ * refer to genphy_loopback() in phy_device.c and genphy_c45_loopback()
+ * in phy-c45.c
+ */
+int mii_phy_loopback(struct intelgbe_hw *hw, bool enable)
+{
+  u16 ctl = 0;
+
+  DEBUGPRINT (PHYFUNC, ("mii_phy_loopback %d\n", enable));
+
+  if (hw->phy.c45)
+    return intelgbe_phy_modify_c45(hw, MMD_PCS, MMD_PCS_CTRL1,
+                                   MMD_PCS_CTRL1_LOOPBACK,
+                                   enable ? MMD_PCS_CTRL1_LOOPBACK : 0);
+
+  if (enable)
+    ctl = MII_STD_CTRL_LOOPBACK | MII_STD_CTRL_SPEED_1000 | MII_STD_CTRL_DUPLEX_MODE;
+
+  return intelgbe_phy_modify_c22(hw, MII_STD_CTRL,
+                                 (MII_STD_CTRL_LOOPBACK | MII_STD_CTRL_SPEED_MASK |
+                                  MII_STD_CTRL_DUPLEX_MODE | MII_STD_CTRL_AUTONEG_ENABLE),
+                                 ctl);
+}
+
 /* To configure PHY link setting
  * refer to __genphy_config_aneg() in phy_device.c
  *
@@ -157,39 +404,60 @@ int mii_phy_config_link(struct intelgbe_hw *hw, bool changed)
   u16 mask = 0;
   u16 advertise = 0;
   u16 advertise_1000 = 0;
+  u32 support;
 
   DEBUGPRINT (PHYFUNC, ("mii_phy_config_link\n"));
 
-  /* Placeholder for genphy_config_eee_advert */
-
-  /* Placeholder for genphy_setup_forced() in phy_device.c */
-
-  /* refer to genphy_config_advert() in phy_device.c */
   if (!phy->support) {
     retval = mii_phy_get_supported(hw);
     if (retval < 0) return retval;
   }
+
+  /* refer to genphy_setup_forced() in phy_device.c. 1000BASE-T and faster
+   * need auto-negotiation for master/slave resolution, and the C45 PHY is only
+   * driven through its AN registers, so those are forced by advertising
+   * the one requested mode instead.
+   */
+  support = phy->support;
+  if (!phy->autoneg) {
+    support &= mii_phy_forced_mode(phy->link_speed, phy->full_duplex);
+    if (!support) return -INTELGBE_ERR_CONFIG;
+    if (!phy->c45 && phy->link_speed < 1000)
+      return mii_phy_setup_forced(hw);
+  }
+
+  /* refer to genphy_config_advert() in phy_device.c */
+  retval = mii_phy_config_eee_advert(hw);
+  if (retval < 0) return retval;
+  if (retval > 0) changed = true;
   /* Obtain PHY supported list and set advertise */
-  if (phy->support & PHY_SUPPORT_1000_FULL) {
+  if (support & PHY_SUPPORT_1000_FULL) {
     advertise_1000 |= MII_STD_GCTRL_1000_FULL;
   }
-  if (phy->support & PHY_SUPPORT_1000_HALF) {
+  if (support & PHY_SUPPORT_1000_HALF) {
     advertise_1000 |= MII_STD_GCTRL_1000_HALF;
   }
-  if (phy->support & PHY_SUPPORT_100_FULL) {
+  if (support & PHY_SUPPORT_100_FULL) {
     advertise |= MII_AN_ADV_TAF_100_FULL;
   }
-  if (phy->support & PHY_SUPPORT_100_HALF) {
+  if (support & PHY_SUPPORT_100_HALF) {
     advertise |= MII_AN_ADV_TAF_100_HALF;
   }
-  if (phy->support & PHY_SUPPORT_10_FULL) {
+  if (support & PHY_SUPPORT_10_FULL) {
     advertise |= MII_AN_ADV_TAF_10_FULL;
   }
-  if (phy->support & PHY_SUPPORT_10_HALF) {
+  if (support & PHY_SUPPORT_10_HALF) {
     advertise |= MII_AN_ADV_TAF_10_HALF;
   }
 
-  /* Do we need to advertise sym and asym pause? */
+  /* Advertise pause as requested, refer to linkmode_set_pause() in linkmode.c */
+  if (hw->mac.fc_requested & INTELGBE_FC_RX) {
+    advertise |= MII_AN_ADV_TAF_PAUSE;
+  }
+  if (!!(hw->mac.fc_requested & INTELGBE_FC_RX) !=
+      !!(hw->mac.fc_requested & INTELGBE_FC_TX)) {
+    advertise |= MII_AN_ADV_TAF_ASYM_PAUSE;
+  }
 
   /* Configure 10/100BASE-T advertise */
   mask = (MII_AN_ADV_TAF_10_HALF | MII_AN_ADV_TAF_10_FULL |
@@ -218,6 +486,19 @@ int mii_phy_config_link(struct intelgbe_hw *hw, bool changed)
     if (retval < 0) return retval;
     if (retval > 0) changed = true;
   }
+  /* Configure 2.5GBASE-T advertise, refer to genphy_c45_an_config_aneg() */
+  if (phy->support & PHY_SUPPORT_2500_FULL) {
+    retval = mii_phy_read_mmd(hw, MMD_AN, MMD_AN_MULTIG_CTRL, &readval);
+    if (retval < 0) return retval;
+    mask = (u16) readval & ~MMD_AN_MULTIG_CTRL_2_5G;
+    if (support & PHY_SUPPORT_2500_FULL)
+      mask |= MMD_AN_MULTIG_CTRL_2_5G;
+    if (mask != (u16) readval) {
+      retval = mii_phy_write_mmd(hw, MMD_AN, MMD_AN_MULTIG_CTRL, mask);
+      if (retval < 0) return retval;
+      changed = true;
+    }
+  }
 
   /* Advertisement hasn't changed, but maybe aneg was never on to
    * begin with?  Or maybe phy was isolated?
@@ -215,8 +215,8 @@ static void intelgbe_dma_rx_desc_init(struct intelgbe_rx_queue *rx_queue)
                             POINTER_TO_UINT(&rx_queue->dma_rx[i]),
                             POINTER_TO_UINT(&rx_queue->rx_buff[i]),
                             POINTER_TO_UINT(&rx_queue->dma_rx_buff[i])));
-    desc->des0 = (u32)(u64) &rx_queue->dma_rx_buff[i];
-    desc->des1 = 0;
+    desc->des0 = lower_32_bits(&rx_queue->dma_rx_buff[i]);
+    desc->des1 = upper_32_bits(&rx_queue->dma_rx_buff[i]);
     desc->des2 = 0;
     desc->des3 = (BIT(30) | BIT(24));
     MemoryFence();
@@ -272,6 +272,50 @@ static inline int intelgbe_mac_start_transaction(struct intelgbe_hw *hw)
   return 0;
 }
 
+/* Program MAC speed and duplex from mac->link_speed and mac->full_duplex */
+STATIC void intelgbe_config_mac_speed(struct intelgbe_hw *hw)
+{
+  struct intelgbe_mac_info *mac = &hw->mac;
+  u32 speed = mac->link_speed;
+  bool full_duplex = mac->full_duplex;
+  u32 reg_val;
+
+  /* The MAC runs at the host interface rate, which a rate matching PHY
+   * keeps at 2.5G full duplex
+   */
+  if (hw->phy.rate_matching) {
+    speed = 2500;
+    full_duplex = true;
+  }
+
+  DEBUGPRINT (CRITICAL, ("MAC configured for speed %dMbps ", speed));
+  reg_val = INTELGBE_READ_REG(hw, MAC_CONFIGURATION);
+  reg_val &= INV_MAC_CONF_SPD;
+  switch (speed) {
+  case 100:
+    reg_val |= MAC_CONF_SPD_100MHZ;
+    break;
+  case 1000:
+    reg_val |= MAC_CONF_SPD_1000MHZ;
+    break;
+  case 2500:
+    reg_val |= MAC_CONF_SPD_2500MHZ;
+    break;
+  default:
+    reg_val |= MAC_CONF_SPD_10MHZ;
+    break;
+  }
+
+  if (full_duplex) {
+    DEBUGPRINT (CRITICAL, ("full duplex\n"));
+    reg_val |= MAC_CONF_DM;
+  } else {
+    DEBUGPRINT (CRITICAL, ("half duplex\n"));
+    reg_val &= ~MAC_CONF_DM;
+  }
+  INTELGBE_WRITE_REG(hw, MAC_CONFIGURATION, reg_val);
+}
+
 static inline int intelgbe_mac_init(struct intelgbe_hw *hw)
 {
   struct intelgbe_mac_info *mac = &hw->mac;
@@ -296,38 +340,16 @@ static inline int intelgbe_mac_init(struct intelgbe_hw *hw)
     DEBUGPRINT (CRITICAL, ("PHY not initialized \n"));
   }
   if (link) {
+    if (intelgbe_serdes_follow_link(hw, link_speed) < 0) {
+      DEBUGPRINT (CRITICAL, ("SERDES reconfiguration failed\n"));
+    }
     mac->link_speed = link_speed;
     mac->full_duplex = duplex;
     phy->link_up = true;
   } else {
     phy->link_up = false;
   }
-  DEBUGPRINT (CRITICAL, ("MAC configured for speed %dMbps ", mac->link_speed));
-  reg_val = INTELGBE_READ_REG(hw, MAC_CONFIGURATION);
-  reg_val &= INV_MAC_CONF_SPD;
-  switch (mac->link_speed) {
-  case 100:
-    reg_val |= MAC_CONF_SPD_100MHZ;
-    break;
-  case 1000:
-    reg_val |= MAC_CONF_SPD_1000MHZ;
-    break;
-  case 2500:
-    reg_val |= MAC_CONF_SPD_2500MHZ;
-    break;
-  default:
-    reg_val |= MAC_CONF_SPD_10MHZ;
-    break;
-  }
-
-  if (mac->full_duplex) {
-    DEBUGPRINT (CRITICAL, ("full duplex\n"));
-    reg_val |= MAC_CONF_DM;
-  } else {
-    DEBUGPRINT (CRITICAL, ("half duplex\n"));
-    reg_val &= ~MAC_CONF_DM;
-  }
-  INTELGBE_WRITE_REG(hw, MAC_CONFIGURATION, reg_val);
+  intelgbe_config_mac_speed(hw);
 
   /* Enable MAC RX queues to DCB/General mode */
   reg_val = 0;
@@ -336,22 +358,110 @@ static inline int intelgbe_mac_init(struct intelgbe_hw *hw)
   }
   INTELGBE_WRITE_REG(hw, MAC_RXQ_CTRL0, reg_val);
 
+  /* Take the VLAN tag to insert from the TX context descriptor */
+  if (mac->vlan_insert) {
+    reg_val = INTELGBE_READ_REG(hw, MAC_VLAN_INCL);
+    reg_val &= ~MAC_VLAN_INCL_VLC_MASK;
+    reg_val |= MAC_VLAN_INCL_VLTI | MAC_VLAN_INCL_VLC_INSERT;
+    INTELGBE_WRITE_REG(hw, MAC_VLAN_INCL, reg_val);
+  }
+  /* Reset cleared the VLAN filter, put back what the upper layer asked for */
+  intelgbe_update_vlan_hash(hw, mac->vlan_hash);
+  if (mac->tstamp_en) {
+    intelgbe_config_tstamp(hw, true);
+  }
+  intelgbe_config_eee(hw);
+  intelgbe_config_flow_ctrl(hw);
+
   return 0;
 }
 
-static inline int intelgbe_mtl_init(struct intelgbe_hw *hw)
+/**
+ *  intelgbe_mtl_fifo_split - Share an MTL FIFO among the queues in use
+ *  @fifosz: FIFO size in bytes
+ *  @block: queue size granularity in bytes
+ *  @max_blocks: largest queue size the queue operation mode register holds
+ *  @weight: relative share of each queue, 0 counts as 1
+ *  @qnum: number of queues in use
+ *  @blocks: returns the size of each queue in blocks
+ *
+ *  Only the queues in use get FIFO space. Blocks left over by rounding go to
+ *  queue 0, which carries the UNDI datapath.
+ **/
+static void intelgbe_mtl_fifo_split(u32 fifosz, u32 block, u32 max_blocks,
+                                    const u32 *weight, int qnum, u32 *blocks)
+{
+  u32 total_blocks = fifosz / block;
+  u32 total_weight = 0;
+  u32 used = 0;
+  int i;
+
+  for (i = 0; i < qnum; i++) {
+    total_weight += weight[i] ? weight[i] : 1;
+  }
+  for (i = 0; i < qnum; i++) {
+    blocks[i] = (total_blocks * (weight[i] ? weight[i] : 1)) / total_weight;
+    used += blocks[i];
+  }
+  blocks[0] += total_blocks - used;
+
+  for (i = 0; i < qnum; i++) {
+    if (blocks[i] > max_blocks) {
+      blocks[i] = max_blocks;
+    }
+    if (blocks[i] == 0) {
+      blocks[i] = 1;
+    }
+  }
+}
+
+/**
+ *  intelgbe_config_tx_sched - Program the MTL scheduler between TX queues
+ *  @hw: pointer to the HW structure
+ *
+ *  Under WRR a queue weight counts frames, under DWRR each unit of weight is
+ *  a quantum of one full-size frame. Refer to dwmac4_prog_mtl_tx_algorithms()
+ *  and dwmac4_set_mtl_tx_queue_weight() in linux.
+ **/
+static void intelgbe_config_tx_sched(struct intelgbe_hw *hw)
 {
   struct intelgbe_mac_info *mac = &hw->mac;
   GIG_DRIVER_DATA *GigAdapterInfo = (GIG_DRIVER_DATA *)hw->back;
-  u32 reg_val, txqsz, rxqsz;
+  u32 reg_val;
+  u32 weight;
   int i;
 
-  /* Set MTL TX scheduling algo & RX arbitration algo to
-   * strict priority
-   */
-  reg_val = MTL_OPR_MD_SCHALG_SP;
+  reg_val = INTELGBE_READ_REG(hw, MTL_OPERATION_MODE);
+  reg_val &= INV_MTL_OPR_MD_SCHALG;
+  reg_val |= mac->tx_sched;
   INTELGBE_WRITE_REG(hw, MTL_OPERATION_MODE, reg_val);
 
+  if (mac->tx_sched == MTL_OPR_MD_SCHALG_SP) {
+    return;
+  }
+  for (i = 0; i < GigAdapterInfo->txqnum; i++) {
+    weight = mac->txq_weight[i] ? mac->txq_weight[i] : 1;
+    if (mac->tx_sched == MTL_OPR_MD_SCHALG_DWRR) {
+      weight *= MTL_TXQ_DWRR_QUANTUM;
+    }
+    INTELGBE_WRITE_REG(hw, MTL_TXQ_QUANTUM_WEIGHT(i),
+                       weight & MTL_TXQ_QW_ISCQW_MASK);
+  }
+}
+
+static inline int intelgbe_mtl_init(struct intelgbe_hw *hw)
+{
+  struct intelgbe_mac_info *mac = &hw->mac;
+  GIG_DRIVER_DATA *GigAdapterInfo = (GIG_DRIVER_DATA *)hw->back;
+  u32 txqblocks[INTELGBE_MAX_TX_QUEUES];
+  u32 rxqblocks[INTELGBE_MAX_RX_QUEUES];
+  u32 reg_val;
+  int i;
+
+  /* RX arbitration is strict priority, TX scheduling as configured */
+  INTELGBE_WRITE_REG(hw, MTL_OPERATION_MODE, 0);
+  intelgbe_config_tx_sched(hw);
+
   for (i = 0; i < GigAdapterInfo->rxqnum; i++) {
     struct intelgbe_rx_queue *rx_queue = &GigAdapterInfo->rx_queue[i];
     if (i < 4)
@@ -368,36 +478,110 @@ static inline int intelgbe_mtl_init(struct intelgbe_hw *hw)
     else
       INTELGBE_WRITE_REG(hw, MTL_RXQ_DMA_MAP1, reg_val);
   }
-  txqsz = (mac->txfifosz / (GigAdapterInfo->txqnum * MTL_TXQSZ_BLOCK)) - 1;
-  rxqsz = (mac->rxfifosz / (GigAdapterInfo->rxqnum * MTL_RXQSZ_BLOCK)) - 1;
+  intelgbe_mtl_fifo_split(mac->txfifosz, MTL_TXQSZ_BLOCK,
+                          (MTL_TXQ_OPR_TQS_MASK >> MTL_TXQ_OPR_TQS_SHIFT) + 1,
+                          mac->txq_fifo_weight, GigAdapterInfo->txqnum,
+                          txqblocks);
+  intelgbe_mtl_fifo_split(mac->rxfifosz, MTL_RXQSZ_BLOCK,
+                          (MTL_RXQ_OPR_RQS_MASK >> MTL_RXQ_OPR_RQS_SHIFT) + 1,
+                          mac->rxq_fifo_weight, GigAdapterInfo->rxqnum,
+                          rxqblocks);
 
   for (i = 0; i < GigAdapterInfo->txqnum; i++) {
     /* Enable TX store forward and configure TX queue size */
     reg_val = MTL_TXQ_OPR_TSF;
-    reg_val |= ((txqsz << MTL_TXQ_OPR_TQS_SHIFT) &
+    reg_val |= (((txqblocks[i] - 1) << MTL_TXQ_OPR_TQS_SHIFT) &
                             MTL_TXQ_OPR_TQS_MASK);
     INTELGBE_WRITE_REG(hw, MTL_TXQ_OPERATION_MODE(i), reg_val);
+    DEBUGPRINT (INTELGBE, ("TX queue %d FIFO %d bytes\n", i,
+                           txqblocks[i] * MTL_TXQSZ_BLOCK));
   }
   for (i = 0; i < GigAdapterInfo->rxqnum; i++) {
     /* Enable RX store forward and configure RX queue size */
     reg_val = MTL_RXQ_OPR_RSF;
-    reg_val |= ((rxqsz << MTL_RXQ_OPR_RQS_SHIFT) &
+    reg_val |= (((rxqblocks[i] - 1) << MTL_RXQ_OPR_RQS_SHIFT) &
                             MTL_RXQ_OPR_RQS_MASK);
+    DEBUGPRINT (INTELGBE, ("RX queue %d FIFO %d bytes\n", i,
+                           rxqblocks[i] * MTL_RXQSZ_BLOCK));
+    /* Pause thresholds, as bytes below a full queue. Once the fill level
+     * passes RFA, the frame the partner is already sending and one more
+     * can still land, so RFA leaves two 1536 byte frames of headroom.
+     * Pause is released at RFD, one more frame below, so that draining a
+     * single frame does not toggle pause. A FIFO under 8K cannot spare
+     * that: there RFA leaves one frame of headroom and RFD sits 1K lower,
+     * which still keeps a frame queued in a 4K FIFO when pause is released.
+     * Pause frames are only sent while MAC TX flow control is enabled.
+     */
+    if (rxqblocks[i] * MTL_RXQSZ_BLOCK >= MTL_RXQ_FC_MIN_FIFO) {
+      u32 rfa, rfd;
+
+      if (rxqblocks[i] * MTL_RXQSZ_BLOCK < 2 * MTL_RXQ_FC_MIN_FIFO) {
+        rfa = MTL_RXQ_FC_THRESHOLD(1536);
+        rfd = MTL_RXQ_FC_THRESHOLD(2560);
+      } else {
+        rfa = MTL_RXQ_FC_THRESHOLD(3072);
+        rfd = MTL_RXQ_FC_THRESHOLD(4608);
+      }
+      reg_val |= MTL_RXQ_OPR_EHFC;
+      reg_val |= (rfa << MTL_RXQ_OPR_RFA_SHIFT) & MTL_RXQ_OPR_RFA_MASK;
+      reg_val |= (rfd << MTL_RXQ_OPR_RFD_SHIFT) & MTL_RXQ_OPR_RFD_MASK;
+    }
     INTELGBE_WRITE_REG(hw, MTL_RXQ_OPERATION_MODE(i), reg_val);
   }
   return 0;
 }
 
+/* Bus settings of the named DMA profiles, in enum intelgbe_dma_profile order.
+ * Burst lengths and the outstanding request limits trade AXI efficiency
+ * against how long one channel can hold the fabric.
+ */
+static const struct intelgbe_dma_cfg intelgbe_dma_profiles[] = {
+  /* INTELGBE_DMA_PROFILE_DEFAULT */
+  { DMA_SYSBUS_MD_BLEN16 | DMA_SYSBUS_MD_BLEN8 | DMA_SYSBUS_MD_BLEN4,
+    0, 0, 32, true, false, false },
+  /* INTELGBE_DMA_PROFILE_BALANCED */
+  { DMA_SYSBUS_MD_BLEN16 | DMA_SYSBUS_MD_BLEN8 | DMA_SYSBUS_MD_BLEN4,
+    1, 1, 32, true, false, false },
+  /* INTELGBE_DMA_PROFILE_THROUGHPUT */
+  { DMA_SYSBUS_MD_BLEN_MASK, 3, 3, 32, true, true, false },
+  /* INTELGBE_DMA_PROFILE_LOW_LATENCY */
+  { DMA_SYSBUS_MD_BLEN8 | DMA_SYSBUS_MD_BLEN4, 0, 0, 8, false, false, false },
+};
+
+/* DMA_SYSBUS_MODE for the DMA profile, link profile and address width */
+static u32 intelgbe_dma_sysbus_mode(struct intelgbe_hw *hw)
+{
+  struct intelgbe_dma_cfg *cfg = &hw->mac.dma_cfg;
+  u32 reg_val;
+
+  reg_val = cfg->blen;
+  reg_val |= cfg->rd_osr << DMA_SYSBUS_MD_RD_OSR_LMT_SHIFT;
+  reg_val |= cfg->wr_osr << DMA_SYSBUS_MD_WR_OSR_LMT_SHIFT;
+  if (cfg->aal) {
+    reg_val |= DMA_SYSBUS_MD_AAL;
+  }
+  if (cfg->fb) {
+    reg_val |= DMA_SYSBUS_MD_FB;
+  }
+  /* Low Power Interface only in the power-save link profile */
+  if (hw->mac.link_profile == INTELGBE_LINK_PROFILE_POWER_SAVE) {
+    reg_val |= DMA_SYSBUS_MD_EN_LPI;
+  }
+  /* Descriptors carry the upper address bits in des1 */
+  if (hw->mac.dma_addr_width > 32) {
+    reg_val |= DMA_SYSBUS_MD_EAME;
+  }
+  return reg_val;
+}
+
 static inline int intelgbe_dma_init(struct intelgbe_hw *hw)
 {
   GIG_DRIVER_DATA *GigAdapterInfo = (GIG_DRIVER_DATA *)hw->back;
+  struct intelgbe_dma_cfg *cfg = &hw->mac.dma_cfg;
   u32 reg_val;
   int i;
 
-  /* Enable Low Power Interface and DMA AXI Burst Length 4, 8 & 16 mode */
-  reg_val = DMA_SYSBUS_MD_EN_LPI | DMA_SYSBUS_MD_BLEN16 |
-            DMA_SYSBUS_MD_BLEN8 | DMA_SYSBUS_MD_BLEN4;
-  INTELGBE_WRITE_REG(hw, DMA_SYSBUS_MODE, reg_val);
+  INTELGBE_WRITE_REG(hw, DMA_SYSBUS_MODE, intelgbe_dma_sysbus_mode(hw));
 
   for (i = 0; i < GigAdapterInfo->txqnum; i++) {
     struct intelgbe_tx_queue *tx_queue = &GigAdapterInfo->tx_queue[i];
@@ -423,8 +607,10 @@ static inline int intelgbe_dma_init(struct intelgbe_hw *hw)
                           DEFAULT_TX_DESCRIPTORS - 1);
 
     /* Initialize TX descriptor ring list address */
+    INTELGBE_WRITE_REG(hw, DMA_TXDESC_LIST_HADDR_CH(i),
+                           upper_32_bits(&tx_queue->dma_tx[0]));
     INTELGBE_WRITE_REG(hw, DMA_TXDESC_LIST_ADDR_CH(i),
-                           (u32)POINTER_TO_UINT(&tx_queue->tx_desc[0]));
+                           lower_32_bits(&tx_queue->dma_tx[0]));
     DEBUGPRINT (CRITICAL, ("TX descriptor address VA: 0x%16llx PA: 0x%16llx\n",
                             POINTER_TO_UINT(&tx_queue->tx_desc[0]),
                             POINTER_TO_UINT(&tx_queue->dma_tx[0])));
@@ -432,12 +618,14 @@ static inline int intelgbe_dma_init(struct intelgbe_hw *hw)
                             POINTER_TO_UINT(&tx_queue->tx_desc[0]),
                             POINTER_TO_UINT(&tx_queue->dma_tx[0])));
 
-    /* Initialize TX descriptor ring tail pointer */
+    /* Initialize TX descriptor ring tail pointer, the upper bits come from
+     * the list address so the ring must not cross a 4GB boundary
+     */
     INTELGBE_WRITE_REG(hw, DMA_TXDESC_TAIL_PTR_CH(i),
-                          (u32)POINTER_TO_UINT(&tx_queue->tx_desc[0]));
-    tx_queue->tx_tail_addr = (u32)POINTER_TO_UINT(&tx_queue->tx_desc[0]);
-    /* Set TX PBL to 32x8 */
-    reg_val = 32 << DMA_CH_TX_CTRL_TXPBL_SHIFT;
+                          lower_32_bits(&tx_queue->dma_tx[0]));
+    tx_queue->tx_tail_addr = lower_32_bits(&tx_queue->dma_tx[0]);
+    /* Set TX PBL from the DMA profile */
+    reg_val = cfg->pbl << DMA_CH_TX_CTRL_TXPBL_SHIFT;
     reg_val &= DMA_CH_TX_CTRL_TXPBL_MASK;
     INTELGBE_WRITE_REG(hw, DMA_TX_CONTROL_CH(i), reg_val);
 
@@ -477,33 +665,35 @@ static inline int intelgbe_dma_init(struct intelgbe_hw *hw)
     INTELGBE_WRITE_REG(hw, DMA_RXDESC_RING_LENGTH_CH(rx_queue->chan),
                           DEFAULT_RX_DESCRIPTORS - 1);
 
-    /* Set RX PBL to 32x8 */
-    reg_val = 32 << DMA_CH_RX_CTRL_RXPBL_SHIFT;
+    /* Set RX PBL from the DMA profile */
+    reg_val = cfg->pbl << DMA_CH_RX_CTRL_RXPBL_SHIFT;
     reg_val |= ((1536 << DMA_CH_RX_CTRL_RBSZ_SHIFT));
     reg_val &= DMA_CH_RX_CTRL_RXPBL_MASK | DMA_CH_RX_CTRL_RBSZ_MASK;
     INTELGBE_WRITE_REG(hw, DMA_RX_CONTROL_CH(rx_queue->chan), reg_val);
 
     /* Initialize RX descriptor ring list address */
+    INTELGBE_WRITE_REG(hw, DMA_RXDESC_LIST_HADDR_CH(rx_queue->chan),
+                           upper_32_bits(&rx_queue->dma_rx[0]));
     INTELGBE_WRITE_REG(hw, DMA_RXDESC_LIST_ADDR_CH(rx_queue->chan),
-                           (u32)POINTER_TO_UINT(&rx_queue->dma_rx[0]));
+                           lower_32_bits(&rx_queue->dma_rx[0]));
     DEBUGPRINT (CRITICAL, ("RX descriptor head address 0x%08llx\n",
                             POINTER_TO_UINT(&rx_queue->dma_rx[0])));
 
     /* Initialize RX descriptor ring tail pointer */
-    rx_queue->rx_tail_addr = (u32)(u64)rx_queue->dma_rx +
+    rx_queue->rx_tail_addr = lower_32_bits(rx_queue->dma_rx) +
     (sizeof(INTELGBE_RECEIVE_DESCRIPTOR) * DEFAULT_RX_DESCRIPTORS);
     DEBUGPRINT (CRITICAL, ("RX descriptor tail address 0x%08llx\n",
                             POINTER_TO_UINT(rx_queue->rx_tail_addr)));
     INTELGBE_WRITE_REG(hw, DMA_RXDESC_TAIL_PTR_CH(rx_queue->chan),
                                 rx_queue->rx_tail_addr);
-    /* Enable 8x Programmable Burst Length mode */
-    reg_val = DMA_CH_CTRL_PBLX8;
+    /* 8x Programmable Burst Length mode */
+    reg_val = cfg->pblx8 ? DMA_CH_CTRL_PBLX8 : 0;
     INTELGBE_WRITE_REG(hw, DMA_CONTROL_CH(rx_queue->chan), reg_val);
   }
 
   for (i = 0; i < GigAdapterInfo->txqnum; i++) {
-    /* Enable 8x Programmable Burst Length mode */
-    reg_val = DMA_CH_CTRL_PBLX8;
+    /* 8x Programmable Burst Length mode */
+    reg_val = cfg->pblx8 ? DMA_CH_CTRL_PBLX8 : 0;
     INTELGBE_WRITE_REG(hw, DMA_CONTROL_CH(i), reg_val);
   }
   return 0;
@@ -512,7 +702,6 @@ static inline int intelgbe_dma_init(struct intelgbe_hw *hw)
 s32 intelgbe_link_status (struct intelgbe_hw *hw, bool *link)
 {
   s32 retval;
-  u32 reg_val;
   struct intelgbe_mac_info *mac = &hw->mac;
   struct intelgbe_phy_info *phy = &hw->phy;
   bool link_sts_chg = false;
@@ -530,41 +719,20 @@ s32 intelgbe_link_status (struct intelgbe_hw *hw, bool *link)
   if (retval < 0)
     return retval;
   if (link_sts_chg) {
-    if (link) {
+    if (*link) {
+      if (intelgbe_serdes_follow_link(hw, link_speed) < 0) {
+        DEBUGPRINT (CRITICAL, ("SERDES reconfiguration failed\n"));
+      }
       mac->link_speed = link_speed;
       mac->full_duplex = duplex;
-      DEBUGPRINT (CRITICAL, ("MAC configured for speed %dMbps ",
-                              mac->link_speed));
-      reg_val = INTELGBE_READ_REG(hw, MAC_CONFIGURATION);
-
-      reg_val &= INV_MAC_CONF_SPD;
-      switch (mac->link_speed) {
-      case 100:
-        reg_val |= MAC_CONF_SPD_100MHZ;
-        break;
-      case 1000:
-        reg_val |= MAC_CONF_SPD_1000MHZ;
-        break;
-      case 2500:
-        reg_val |= MAC_CONF_SPD_2500MHZ;
-        break;
-      default:
-        reg_val |= MAC_CONF_SPD_10MHZ;
-        break;
-      }
-
-      if (mac->full_duplex) {
-        DEBUGPRINT (CRITICAL, ("full duplex\n"));
-        reg_val |= MAC_CONF_DM;
-      } else {
-        DEBUGPRINT (CRITICAL, ("half duplex\n"));
-        reg_val &= ~MAC_CONF_DM;
-      }
-      INTELGBE_WRITE_REG(hw, MAC_CONFIGURATION, reg_val);
+      intelgbe_config_mac_speed(hw);
       phy->link_up = true;
     } else {
       phy->link_up = false;
     }
+    /* EEE and pause are resolved per link, follow what was negotiated */
+    intelgbe_config_eee(hw);
+    intelgbe_config_flow_ctrl(hw);
   }
   return 0;
 }
@@ -676,22 +844,16 @@ s32 intelgbe_xpcs_init(struct intelgbe_hw *hw)
   return INTELGBE_SUCCESS;
 }
 
-s32 intelgbe_modphy_init(struct intelgbe_hw *hw)
+/* Power up the SERDES lane at the rate selected by speed_2500_en
+ * refer to intel_serdes_powerup() in dwmac-intel.c
+ */
+STATIC s32 intelgbe_serdes_powerup(struct intelgbe_hw *hw)
 {
   int retval = 0;
   u32 data_addr = 0;
   u16 data = 0;
   int retries = 10;
-  u8 link_mode = 0;
-
-  /* Determine link speed mode: 2.5Gbps or 1Gbps */
-  retval = intelgbe_mdio_read(hw, MODPHY_ADDR, 0, SERDES_GCR, &data_addr, 0);
-  if (retval < 0) {
-    return retval;
-  }
-  link_mode = (data_addr & SERDES_LINK_MODE_MASK) >> SERDES_LINK_MODE_SHIFT;
 
-  data_addr = 0;
   retval = intelgbe_mdio_read(hw, MODPHY_ADDR, 0, SERDES_GCR0, &data_addr, 0);
   if (retval < 0) {
     return retval;
@@ -701,15 +863,11 @@ s32 intelgbe_modphy_init(struct intelgbe_hw *hw)
   data &= ~SERDES_RATE_MASK;
   data &= ~SERDES_PCLK_MASK;
 
-  if (link_mode == SERDES_LINK_MODE_2G5) {
-    hw->mac.speed_2500_en = true;
-
+  if (hw->mac.speed_2500_en) {
     DEBUGPRINT(INTELGBE, ("SERDES: PCLK set to 37.5Mhz\n"));
     data |= SERDES_RATE_PCIE_GEN2 << SERDES_RATE_PCIE_SHIFT |
               SERDES_PCLK_37p5MHZ << SERDES_PCLK_SHIFT;
   } else {
-    hw->mac.speed_2500_en = false;
-
     data |= SERDES_RATE_PCIE_GEN1 << SERDES_RATE_PCIE_SHIFT |
               SERDES_PCLK_70MHZ << SERDES_PCLK_SHIFT;
   }
@@ -827,80 +985,842 @@ s32 intelgbe_modphy_init(struct intelgbe_hw *hw)
   return INTELGBE_SUCCESS;
 }
 
-s32 intelgbe_init_controller(struct intelgbe_hw *hw)
+s32 intelgbe_modphy_init(struct intelgbe_hw *hw)
 {
-  s32 retval;
+  int retval = 0;
+  u32 data_addr = 0;
+  u8 link_mode = 0;
 
-  retval = intelgbe_dma_init(hw);
-  if (retval < 0)
+  /* Determine the initial link speed mode from the strap: 2.5Gbps or 1Gbps.
+   * intelgbe_serdes_follow_link() changes it once the PHY has a link.
+   */
+  retval = intelgbe_mdio_read(hw, MODPHY_ADDR, 0, SERDES_GCR, &data_addr, 0);
+  if (retval < 0) {
     return retval;
-  retval = intelgbe_mtl_init(hw);
-  if (retval < 0)
+  }
+  link_mode = (data_addr & SERDES_LINK_MODE_MASK) >> SERDES_LINK_MODE_SHIFT;
+  hw->mac.speed_2500_en = (link_mode == SERDES_LINK_MODE_2G5);
+
+  return intelgbe_serdes_powerup(hw);
+}
+
+/* Wait until the SERDES status bits in @mask read back as @val */
+STATIC s32 intelgbe_serdes_poll(struct intelgbe_hw *hw, u16 mask, u16 val)
+{
+  int retval;
+  u32 data_addr = 0;
+  int retries = 10;
+
+  do {
+    retval = intelgbe_mdio_read(hw, MODPHY_ADDR, 0, SERDES_GSR0, &data_addr, 0);
+    if (retval < 0) {
+      return retval;
+    }
+    if ((data_addr & mask) == val) {
+      return INTELGBE_SUCCESS;
+    }
+    msec_delay(1);
+  } while (--retries);
+
+  DEBUGPRINT(INTELGBE, ("Serdes status %x timeout waiting %x\n", data_addr, val));
+  return -INTELGBE_ERR_TIMEOUT;
+}
+
+/* Move the SERDES lane to P3 and release PLL clock and lane reset
+ * refer to intel_serdes_powerdown() in dwmac-intel.c
+ */
+STATIC s32 intelgbe_serdes_powerdown(struct intelgbe_hw *hw)
+{
+  int retval;
+  u32 data_addr = 0;
+  u16 data;
+
+  retval = intelgbe_mdio_read(hw, MODPHY_ADDR, 0, SERDES_GCR0, &data_addr, 0);
+  if (retval < 0) {
     return retval;
-  retval = intelgbe_mac_init(hw);
-  if (retval < 0)
+  }
+  data = (u16) data_addr;
+
+  /* move power state to P3 */
+  data &= ~SERDES_PWR_ST_MASK;
+  data |= SERDES_PWR_ST_P3 << SERDES_PWR_ST_SHIFT;
+  retval = intelgbe_mdio_write(hw, MODPHY_ADDR, 0, SERDES_GCR0, data, 0);
+  if (retval < 0) {
     return retval;
-  retval = intelgbe_mac_enable_interrupts(hw);
-  if (retval < 0)
+  }
+  retval = intelgbe_serdes_poll(hw, SERDES_PWR_ST_MASK,
+                                SERDES_PWR_ST_P3 << SERDES_PWR_ST_SHIFT);
+  if (retval < 0) {
     return retval;
-  retval = intelgbe_mac_start_transaction(hw);
-  if (retval < 0)
+  }
+
+  /* de-assert clk_req */
+  data &= ~SERDES_PLL_CLK;
+  retval = intelgbe_mdio_write(hw, MODPHY_ADDR, 0, SERDES_GCR0, data, 0);
+  if (retval < 0) {
+    return retval;
+  }
+  retval = intelgbe_serdes_poll(hw, SERDES_PLL_CLK, 0);
+  if (retval < 0) {
     return retval;
+  }
 
-  return INTELGBE_SUCCESS;
+  /* de-assert lane reset */
+  data &= ~SERDES_RST;
+  retval = intelgbe_mdio_write(hw, MODPHY_ADDR, 0, SERDES_GCR0, data, 0);
+  if (retval < 0) {
+    return retval;
+  }
+  return intelgbe_serdes_poll(hw, SERDES_RST, 0);
 }
 
 /**
- *  Intelgbe_init_mac_ops- Init MAC func ptrs.
+ *  intelgbe_serdes_follow_link - Match SERDES rate and XPCS mode to the link
  *  @hw: pointer to the HW structure
+ *  @link_speed: speed resolved by the PHY in Mbps
+ *
+ *  The strap only picks the rate used until the first link. A 2.5GBASE-T
+ *  link needs the 2.5G SERDES rate with 2500BASE-X XPCS, every slower speed
+ *  needs the 1G rate with SGMII, so cycle the lane when the PHY resolves a
+ *  speed on the other side of that line. A rate matching PHY keeps its host
+ *  interface at 2.5G whatever the link speed.
  **/
-s32 intelgbe_init_mac_ops(struct intelgbe_hw *hw)
+s32 intelgbe_serdes_follow_link(struct intelgbe_hw *hw, s32 link_speed)
 {
-  struct intelgbe_mac_info *mac = &hw->mac;
-  u32 tx_queues, rx_queues;
+  bool speed_2500 = hw->phy.rate_matching || (link_speed == 2500);
+  s32 retval;
 
-  DEBUGPRINT (INTELGBE, ("entered init mac ops funcs\n"));
+  if (hw->phy.interface != PHY_INTERFACE_SGMII ||
+      hw->mac.speed_2500_en == speed_2500) {
+    return INTELGBE_SUCCESS;
+  }
 
-  /* read mac address */
-  mac->ops.read_mac_addr = intelgbe_read_mac_addr;
-  /* write mac address */
-  mac->ops.write_mac_addr = intelgbe_write_mac_addr;
-  /* read ID reg */
-  mac->ops.get_id = intelgbe_get_mac_version;
-  /* reset MAC controller */
-  mac->ops.reset_hw = intelgbe_reset_controller;
-  /* initialize MAC controller */
-  mac->ops.init_hw = intelgbe_init_controller;
-  /* deactivate MAC controller */
-  mac->ops.uninit_hw = intelgbe_uninit_controller;
-  /* Link status change */
-  mac->ops.check_for_link = intelgbe_link_status;
-  /* Obtain HW TX & RX fifo size */
-  mac->link_speed = 100;
-  mac->full_duplex = 1;
-  /*
-    Refer EHL sighting report EHL-84 1507102816
-    TXFIFOSIZE & RXFIFOSIZE Register Fields Incorrectly Report MTL TX & RX FIFO Sizes
-    for PSE GbE Controllers
+  DEBUGPRINT (CRITICAL, ("SERDES: switching to %a mode\n",
+                         speed_2500 ? "2.5Gbps" : "1Gbps"));
+  retval = intelgbe_serdes_powerdown(hw);
+  if (retval < 0) {
+    return retval;
+  }
+  hw->mac.speed_2500_en = speed_2500;
+  retval = intelgbe_serdes_powerup(hw);
+  if (retval < 0) {
+    return retval;
+  }
+  return intelgbe_xpcs_init(hw);
+}
 
-    Software must implement workaround below.
+/**
+ *  intelgbe_dma_addr_width - Decode the DMA address width
+ *  @hw_feature1: MAC_HW_FEATURE1 register value
+ *
+ *  Returns the number of address bits the DMA drives on the bus, which
+ *  bounds the buffers and rings that can be handed to it.
+ **/
+u32 intelgbe_dma_addr_width(u32 hw_feature1)
+{
+  switch ((hw_feature1 & MAC_HW_FEAT1_ADDR64_MASK) >>
+          MAC_HW_FEAT1_ADDR64_SHIFT) {
+  case MAC_HW_FEAT1_ADDR64_40:
+    return 40;
+  case MAC_HW_FEAT1_ADDR64_48:
+    return 48;
+  default:
+    return 32;
+  }
+}
 
-    A workaround for this sighting is available in the Beta Yocto Project* and
-    PSE Beta firmware. Other operating systems should hardcode the MTL TX &
-    RX FIFO size to 32kB, instead of reading from the
-    MAC_HW_FEATURE1.TXFIFOSIZE & MAC_HW_FEATURE1.RXFIFOSIZE registers
-  */
+/**
+ *  intelgbe_vlan_hash_bit - Get the VLAN hash table bit for a VLAN ID
+ *  @vid: 12-bit VLAN identifier
+ *
+ *  The MAC indexes the 16-bit VLAN hash table with the upper four bits of
+ *  the bit-reversed, inverted CRC-32 of the VLAN ID.
+ **/
+u32 intelgbe_vlan_hash_bit(u16 vid)
+{
+  u32 crc = ~0x0;
+  u32 temp;
+  int i;
 
-  switch (hw->device_id) {
-    case EHL_PSE0_STMMAC_RGMII1G_DID:
-    case EHL_PSE1_STMMAC_RGMII1G_DID:
-    case EHL_PCH_STMMAC_SGMII_DID:
-    case EHL_PSE0_STMMAC_SGMII1G_DID:
-    case EHL_PSE1_STMMAC_SGMII1G_DID:
-    case EHL_PSE0_STMMAC_SGMII2G5_DID:
-    case EHL_PSE1_STMMAC_SGMII2G5_DID:
-      tx_queues = 8;
-      rx_queues = 8;
+  for (i = 0; i < 12; i++) {
+    temp = (crc ^ vid) & 1;
+    crc >>= 1;
+    vid >>= 1;
+    if (temp) {
+      crc ^= 0xEDB88320;
+    }
+  }
+  /* bitrev32(~crc) >> 28 is the bit reversal of the low nibble of ~crc */
+  crc = ~crc;
+  return ((crc & 0x1) << 3) | ((crc & 0x2) << 1) |
+         ((crc & 0x4) >> 1) | ((crc & 0x8) >> 3);
+}
+
+/**
+ *  intelgbe_update_vlan_hash - Program VLAN stripping and hash filter
+ *  @hw: pointer to the HW structure
+ *  @hash: VLAN hash table, 0 when no VLAN is in use
+ *
+ *  While at least one VLAN is in use the outer tag is stripped from every
+ *  received frame and reported in the descriptor, and tagged frames that
+ *  miss the hash table are dropped when the hash filter is present.
+ **/
+s32 intelgbe_update_vlan_hash(struct intelgbe_hw *hw, u16 hash)
+{
+  struct intelgbe_mac_info *mac = &hw->mac;
+  u32 filter;
+  u32 tag;
+
+  mac->vlan_hash = hash;
+
+  filter = INTELGBE_READ_REG(hw, MAC_PACKET_FILTER);
+  tag = INTELGBE_READ_REG(hw, MAC_VLAN_TAG);
+  tag &= ~(MAC_VLAN_TAG_EVLS_MASK | MAC_VLAN_TAG_EVLRXS |
+           MAC_VLAN_TAG_VTHM | MAC_VLAN_TAG_ETV);
+  filter &= ~MAC_PACKET_FILTER_VTFE;
+
+  if (hash) {
+    tag |= MAC_VLAN_TAG_EVLS_ALWAYS_STRIP | MAC_VLAN_TAG_EVLRXS;
+    if (mac->vlan_hash_filter) {
+      tag |= MAC_VLAN_TAG_VTHM | MAC_VLAN_TAG_ETV;
+      filter |= MAC_PACKET_FILTER_VTFE;
+    }
+  }
+
+  if (mac->vlan_hash_filter) {
+    INTELGBE_WRITE_REG(hw, MAC_VLAN_HASH_TABLE, hash);
+  }
+  INTELGBE_WRITE_REG(hw, MAC_VLAN_TAG, tag);
+  INTELGBE_WRITE_REG(hw, MAC_PACKET_FILTER, filter);
+
+  return INTELGBE_SUCCESS;
+}
+
+/**
+ *  intelgbe_config_tstamp - Start or stop RX/TX timestamping
+ *  @hw: pointer to the HW structure
+ *  @enable: true to timestamp every frame
+ *
+ *  The system time counter is started from zero with a fixed increment and
+ *  digital rollover, so timestamps read back directly as seconds and
+ *  nanoseconds. Only differences are used, no PTP synchronization is done.
+ **/
+s32 intelgbe_config_tstamp(struct intelgbe_hw *hw, bool enable)
+{
+  struct intelgbe_mac_info *mac = &hw->mac;
+  s32 limit = 10;
+  u32 val;
+
+  if (!mac->tstamp) {
+    return -INTELGBE_NOT_IMPLEMENTED;
+  }
+  mac->tstamp_en = enable;
+
+  if (!enable) {
+    INTELGBE_WRITE_REG(hw, MAC_TIMESTAMP_CONTROL, 0);
+    return INTELGBE_SUCCESS;
+  }
+
+  val = MAC_TSCTRL_TSENA | MAC_TSCTRL_TSENALL | MAC_TSCTRL_TSCTRLSSR;
+  INTELGBE_WRITE_REG(hw, MAC_TIMESTAMP_CONTROL, val);
+  INTELGBE_WRITE_REG(hw, MAC_SUB_SECOND_INCREMENT,
+                     (1000000000 / INTELGBE_PTP_CLK_RATE_HZ) << MAC_SSINC_SHIFT);
+  INTELGBE_WRITE_REG(hw, MAC_SYSTEM_TIME_SECONDS_UPDATE, 0);
+  INTELGBE_WRITE_REG(hw, MAC_SYSTEM_TIME_NANOSECONDS_UPDATE, 0);
+  INTELGBE_WRITE_REG(hw, MAC_TIMESTAMP_CONTROL, val | MAC_TSCTRL_TSINIT);
+  while (limit--) {
+    if (!(INTELGBE_READ_REG(hw, MAC_TIMESTAMP_CONTROL) & MAC_TSCTRL_TSINIT)) {
+      break;
+    }
+    usec_delay(10);
+  }
+  if (limit < 0) {
+    DEBUGPRINT (CRITICAL, ("System time init timed out\n"));
+    return -INTELGBE_ERR_TIMEOUT;
+  }
+
+  return INTELGBE_SUCCESS;
+}
+
+/**
+ *  intelgbe_get_systime - Read the system time counter in nanoseconds
+ *  @hw: pointer to the HW structure
+ **/
+u64 intelgbe_get_systime(struct intelgbe_hw *hw)
+{
+  u32 sec, nsec;
+
+  /* Re-read the seconds if the nanoseconds rolled over in between */
+  do {
+    sec = INTELGBE_READ_REG(hw, MAC_SYSTEM_TIME_SECONDS);
+    nsec = INTELGBE_READ_REG(hw, MAC_SYSTEM_TIME_NANOSECONDS) &
+           MAC_SYSTEM_TIME_NS_MASK;
+  } while (sec != INTELGBE_READ_REG(hw, MAC_SYSTEM_TIME_SECONDS));
+
+  return MultU64x32(sec, 1000000000) + nsec;
+}
+
+/**
+ *  intelgbe_config_eee - Program MAC LPI for the current link
+ *  @hw: pointer to the HW structure
+ *
+ *  LPI is entered by the MAC's own entry timer once the TX path has been idle,
+ *  and only when the power-save profile is selected and the link partner
+ *  negotiated EEE at the current speed. Otherwise LPI is kept off.
+ **/
+s32 intelgbe_config_eee(struct intelgbe_hw *hw)
+{
+  struct intelgbe_mac_info *mac = &hw->mac;
+  struct intelgbe_phy_info *phy = &hw->phy;
+  bool active = false;
+  u32 reg_val;
+  s32 retval;
+
+  if (!mac->eee) {
+    return INTELGBE_SUCCESS;
+  }
+
+  if ((mac->link_profile == INTELGBE_LINK_PROFILE_POWER_SAVE) &&
+      phy->link_up && mac->full_duplex) {
+    retval = mii_phy_eee_active(hw, mac->link_speed, &active);
+    if (retval < 0) {
+      active = false;
+    }
+  }
+  mac->eee_active = active;
+
+  reg_val = INTELGBE_READ_REG(hw, MAC_LPI_CONTROL_STATUS);
+  reg_val &= ~(MAC_LPI_CTRL_LPIEN | MAC_LPI_CTRL_PLS |
+               MAC_LPI_CTRL_LPITXA | MAC_LPI_CTRL_LPIATE);
+  if (!active) {
+    INTELGBE_WRITE_REG(hw, MAC_LPI_CONTROL_STATUS, reg_val);
+    return INTELGBE_SUCCESS;
+  }
+
+  INTELGBE_WRITE_REG(hw, MAC_1US_TIC_COUNTER,
+                     (INTELGBE_CSR_CLK_RATE_HZ / 1000000) - 1);
+  INTELGBE_WRITE_REG(hw, MAC_LPI_TIMERS_CONTROL,
+                     ((MAC_LPI_LS_TIMER_MS << MAC_LPI_TIMERS_LST_SHIFT) &
+                      MAC_LPI_TIMERS_LST_MASK) |
+                     (MAC_LPI_TW_TIMER_US & MAC_LPI_TIMERS_TWT_MASK));
+  INTELGBE_WRITE_REG(hw, MAC_LPI_ENTRY_TIMER,
+                     MAC_LPI_ENTRY_TIMER_US & MAC_LPI_ENTRY_TIMER_MASK);
+
+  reg_val |= MAC_LPI_CTRL_LPIEN | MAC_LPI_CTRL_PLS |
+             MAC_LPI_CTRL_LPITXA | MAC_LPI_CTRL_LPIATE;
+  INTELGBE_WRITE_REG(hw, MAC_LPI_CONTROL_STATUS, reg_val);
+
+  DEBUGPRINT (INTELGBE, ("EEE active at %dMbps\n", mac->link_speed));
+  return INTELGBE_SUCCESS;
+}
+
+/**
+ *  intelgbe_set_link_profile - Switch between low-latency and power-save
+ *  @hw: pointer to the HW structure
+ *  @profile: link profile to apply
+ *
+ *  Rewrites the PHY EEE advertisement, which restarts auto-negotiation when
+ *  it changes, then updates the DMA Low Power Interface and MAC LPI.
+ **/
+s32 intelgbe_set_link_profile(struct intelgbe_hw *hw, u32 profile)
+{
+  struct intelgbe_mac_info *mac = &hw->mac;
+  u32 reg_val;
+  s32 retval = INTELGBE_SUCCESS;
+
+  if (mac->link_profile == profile) {
+    return INTELGBE_SUCCESS;
+  }
+  mac->link_profile = profile;
+
+  if (hw->phy.ops.cfg_link) {
+    retval = hw->phy.ops.cfg_link(hw);
+    if (retval < 0) {
+      return retval;
+    }
+  }
+
+  reg_val = INTELGBE_READ_REG(hw, DMA_SYSBUS_MODE);
+  if (profile == INTELGBE_LINK_PROFILE_POWER_SAVE) {
+    reg_val |= DMA_SYSBUS_MD_EN_LPI;
+  } else {
+    reg_val &= ~DMA_SYSBUS_MD_EN_LPI;
+  }
+  INTELGBE_WRITE_REG(hw, DMA_SYSBUS_MODE, reg_val);
+
+  return intelgbe_config_eee(hw);
+}
+
+/**
+ *  intelgbe_set_dma_profile - Select the AXI and DMA burst settings
+ *  @hw: pointer to the HW structure
+ *  @profile: INTELGBE_DMA_PROFILE_* value
+ *  @cfg: settings for INTELGBE_DMA_PROFILE_CUSTOM, ignored otherwise
+ *
+ *  Only records the settings, dma_init or intelgbe_config_dma applies them.
+ **/
+s32 intelgbe_set_dma_profile(struct intelgbe_hw *hw, u32 profile,
+                             const struct intelgbe_dma_cfg *cfg)
+{
+  struct intelgbe_mac_info *mac = &hw->mac;
+
+  if (profile > INTELGBE_DMA_PROFILE_CUSTOM) {
+    return -INTELGBE_ERR_CONFIG;
+  }
+  if (profile != INTELGBE_DMA_PROFILE_CUSTOM) {
+    cfg = &intelgbe_dma_profiles[profile];
+  } else if (!cfg ||
+             !cfg->blen || (cfg->blen & ~DMA_SYSBUS_MD_BLEN_MASK) ||
+             (cfg->rd_osr > DMA_SYSBUS_MD_OSR_LMT_MAX) ||
+             (cfg->wr_osr > DMA_SYSBUS_MD_OSR_LMT_MAX) ||
+             !cfg->pbl || (cfg->pbl > 32) || (cfg->pbl & (cfg->pbl - 1))) {
+    return -INTELGBE_ERR_CONFIG;
+  }
+  mac->dma_profile = profile;
+  mac->dma_cfg = *cfg;
+
+  return INTELGBE_SUCCESS;
+}
+
+/**
+ *  intelgbe_dma_stopped - Check that the stopped channels have gone idle
+ *  @hw: pointer to the HW structure
+ *
+ *  A channel keeps running until the transfer in flight completes after
+ *  ST or SR is cleared. A process that is suspended waiting for
+ *  descriptors is idle as well.
+ **/
+static bool intelgbe_dma_stopped(struct intelgbe_hw *hw)
+{
+  GIG_DRIVER_DATA *GigAdapterInfo = (GIG_DRIVER_DATA *)hw->back;
+  u32 state;
+  int i;
+
+  for (i = 0; i < GigAdapterInfo->txqnum; i++) {
+    state = (INTELGBE_READ_REG(hw, DMA_DEBUG_STATUS(i)) >>
+             DMA_DEBUG_STATUS_TPS_SHIFT(i)) & DMA_DEBUG_STATUS_PS_MASK;
+    if ((state != DMA_DEBUG_TPS_STOPPED) &&
+        (state != DMA_DEBUG_TPS_SUSPENDED)) {
+      return false;
+    }
+  }
+  for (i = 0; i < GigAdapterInfo->rxqnum; i++) {
+    u32 chan = GigAdapterInfo->rx_queue[i].chan;
+
+    state = (INTELGBE_READ_REG(hw, DMA_DEBUG_STATUS(chan)) >>
+             DMA_DEBUG_STATUS_RPS_SHIFT(chan)) & DMA_DEBUG_STATUS_PS_MASK;
+    if ((state != DMA_DEBUG_RPS_STOPPED) &&
+        (state != DMA_DEBUG_RPS_SUSPENDED)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ *  intelgbe_config_dma - Apply the DMA profile to a running controller
+ *  @hw: pointer to the HW structure
+ *
+ *  The burst settings may only change while the DMA is stopped, so the
+ *  channels are stopped around the update and restarted as they were.
+ *  The caller makes sure no transmit is in progress. If the channels do
+ *  not go idle they are restarted with the old settings.
+ **/
+s32 intelgbe_config_dma(struct intelgbe_hw *hw)
+{
+  GIG_DRIVER_DATA *GigAdapterInfo = (GIG_DRIVER_DATA *)hw->back;
+  struct intelgbe_dma_cfg *cfg = &hw->mac.dma_cfg;
+  u32 tx_ctrl[INTELGBE_MAX_TX_QUEUES];
+  u32 rx_ctrl[INTELGBE_MAX_RX_QUEUES];
+  u32 reg_val;
+  s32 limit = 100;
+  int i;
+
+  for (i = 0; i < GigAdapterInfo->txqnum; i++) {
+    tx_ctrl[i] = INTELGBE_READ_REG(hw, DMA_TX_CONTROL_CH(i));
+    INTELGBE_WRITE_REG(hw, DMA_TX_CONTROL_CH(i),
+                       tx_ctrl[i] & ~DMA_CH_TX_CTRL_ST);
+  }
+  for (i = 0; i < GigAdapterInfo->rxqnum; i++) {
+    u32 chan = GigAdapterInfo->rx_queue[i].chan;
+
+    rx_ctrl[i] = INTELGBE_READ_REG(hw, DMA_RX_CONTROL_CH(chan));
+    INTELGBE_WRITE_REG(hw, DMA_RX_CONTROL_CH(chan),
+                       rx_ctrl[i] & ~DMA_CH_RX_CTRL_SR);
+  }
+
+  while (limit--) {
+    if (intelgbe_dma_stopped(hw)) {
+      break;
+    }
+    usec_delay(10);
+  }
+  if (limit < 0) {
+    DEBUGPRINT (CRITICAL, ("DMA channels did not stop\n"));
+    for (i = 0; i < GigAdapterInfo->txqnum; i++) {
+      INTELGBE_WRITE_REG(hw, DMA_TX_CONTROL_CH(i), tx_ctrl[i]);
+    }
+    for (i = 0; i < GigAdapterInfo->rxqnum; i++) {
+      INTELGBE_WRITE_REG(hw, DMA_RX_CONTROL_CH(GigAdapterInfo->rx_queue[i].chan),
+                         rx_ctrl[i]);
+    }
+    return -INTELGBE_ERR_TIMEOUT;
+  }
+
+  INTELGBE_WRITE_REG(hw, DMA_SYSBUS_MODE, intelgbe_dma_sysbus_mode(hw));
+
+  for (i = 0; i < GigAdapterInfo->txqnum; i++) {
+    reg_val = INTELGBE_READ_REG(hw, DMA_CONTROL_CH(i));
+    reg_val &= ~DMA_CH_CTRL_PBLX8;
+    reg_val |= cfg->pblx8 ? DMA_CH_CTRL_PBLX8 : 0;
+    INTELGBE_WRITE_REG(hw, DMA_CONTROL_CH(i), reg_val);
+
+    reg_val = tx_ctrl[i] & ~DMA_CH_TX_CTRL_TXPBL_MASK;
+    reg_val |= (cfg->pbl << DMA_CH_TX_CTRL_TXPBL_SHIFT) &
+               DMA_CH_TX_CTRL_TXPBL_MASK;
+    INTELGBE_WRITE_REG(hw, DMA_TX_CONTROL_CH(i), reg_val);
+  }
+  for (i = 0; i < GigAdapterInfo->rxqnum; i++) {
+    u32 chan = GigAdapterInfo->rx_queue[i].chan;
+
+    reg_val = INTELGBE_READ_REG(hw, DMA_CONTROL_CH(chan));
+    reg_val &= ~DMA_CH_CTRL_PBLX8;
+    reg_val |= cfg->pblx8 ? DMA_CH_CTRL_PBLX8 : 0;
+    INTELGBE_WRITE_REG(hw, DMA_CONTROL_CH(chan), reg_val);
+
+    reg_val = rx_ctrl[i] & ~DMA_CH_RX_CTRL_RXPBL_MASK;
+    reg_val |= (cfg->pbl << DMA_CH_RX_CTRL_RXPBL_SHIFT) &
+               DMA_CH_RX_CTRL_RXPBL_MASK;
+    INTELGBE_WRITE_REG(hw, DMA_RX_CONTROL_CH(chan), reg_val);
+  }
+
+  return INTELGBE_SUCCESS;
+}
+
+/**
+ *  intelgbe_config_flow_ctrl - Program IEEE 802.3x flow control for the link
+ *  @hw: pointer to the HW structure
+ *
+ *  Pause is only used on full duplex links, in the directions resolved from
+ *  the auto-negotiated pause advertisements.
+ **/
+s32 intelgbe_config_flow_ctrl(struct intelgbe_hw *hw)
+{
+  struct intelgbe_mac_info *mac = &hw->mac;
+  struct intelgbe_phy_info *phy = &hw->phy;
+  GIG_DRIVER_DATA *GigAdapterInfo = (GIG_DRIVER_DATA *)hw->back;
+  u32 fc = 0;
+  u32 reg_val;
+  int i;
+
+  if (phy->link_up && mac->full_duplex && mac->fc_requested) {
+    if (mii_phy_resolve_pause(hw, &fc) < 0) {
+      fc = 0;
+    }
+  }
+  mac->fc_active = fc;
+
+  for (i = 0; i < GigAdapterInfo->txqnum; i++) {
+    reg_val = 0;
+    if (fc & INTELGBE_FC_TX) {
+      reg_val = (MAC_TX_FLOW_CTRL_PT_MAX << MAC_TX_FLOW_CTRL_PT_SHIFT) |
+                MAC_TX_FLOW_CTRL_TFE;
+    }
+    INTELGBE_WRITE_REG(hw, MAC_QX_TX_FLOW_CTRL(i), reg_val);
+  }
+
+  reg_val = INTELGBE_READ_REG(hw, MAC_RX_FLOW_CTRL);
+  if (fc & INTELGBE_FC_RX) {
+    reg_val |= MAC_RX_FLOW_CTRL_RFE;
+  } else {
+    reg_val &= ~MAC_RX_FLOW_CTRL_RFE;
+  }
+  INTELGBE_WRITE_REG(hw, MAC_RX_FLOW_CTRL, reg_val);
+
+  DEBUGPRINT (INTELGBE, ("Flow control rx %d tx %d\n",
+                         !!(fc & INTELGBE_FC_RX), !!(fc & INTELGBE_FC_TX)));
+  return INTELGBE_SUCCESS;
+}
+
+/**
+ *  intelgbe_set_flow_ctrl - Change the requested pause directions
+ *  @hw: pointer to the HW structure
+ *  @fc: INTELGBE_FC_* directions to advertise
+ *
+ *  Rewrites the PHY pause advertisement, which restarts auto-negotiation when
+ *  it changes, then applies the newly resolved flow control.
+ **/
+s32 intelgbe_set_flow_ctrl(struct intelgbe_hw *hw, u32 fc)
+{
+  struct intelgbe_mac_info *mac = &hw->mac;
+  s32 retval;
+
+  fc &= INTELGBE_FC_RX | INTELGBE_FC_TX;
+  if (mac->fc_requested == fc) {
+    return INTELGBE_SUCCESS;
+  }
+  mac->fc_requested = fc;
+
+  if (hw->phy.ops.cfg_link) {
+    retval = hw->phy.ops.cfg_link(hw);
+    if (retval < 0) {
+      return retval;
+    }
+  }
+
+  return intelgbe_config_flow_ctrl(hw);
+}
+
+/**
+ *  intelgbe_set_tx_sched - Change the scheduling between TX queues
+ *  @hw: pointer to the HW structure
+ *  @sched: MTL_OPR_MD_SCHALG_SP, _WRR or _DWRR
+ *  @weight: INTELGBE_MAX_TX_QUEUES weights, ignored under strict priority
+ **/
+s32 intelgbe_set_tx_sched(struct intelgbe_hw *hw, u32 sched, const u32 *weight)
+{
+  struct intelgbe_mac_info *mac = &hw->mac;
+  int i;
+
+  if ((sched != MTL_OPR_MD_SCHALG_SP) &&
+      (sched != MTL_OPR_MD_SCHALG_WRR) &&
+      (sched != MTL_OPR_MD_SCHALG_DWRR)) {
+    return -INTELGBE_ERR_CONFIG;
+  }
+  mac->tx_sched = sched;
+  for (i = 0; i < INTELGBE_MAX_TX_QUEUES; i++) {
+    mac->txq_weight[i] = weight[i];
+  }
+  intelgbe_config_tx_sched(hw);
+
+  return INTELGBE_SUCCESS;
+}
+
+/**
+ *  intelgbe_set_loopback - Select MAC, PHY or no loopback
+ *  @hw: pointer to the HW structure
+ *  @mode: INTELGBE_LOOPBACK_* mode
+ *
+ *  PHY loopback runs at 1000 Mbps full duplex, so the SERDES and MAC are
+ *  moved to that speed. Leaving PHY loopback re-runs cfg_link, which
+ *  restarts auto-negotiation.
+ **/
+s32 intelgbe_set_loopback(struct intelgbe_hw *hw, u32 mode)
+{
+  struct intelgbe_mac_info *mac = &hw->mac;
+  struct intelgbe_phy_info *phy = &hw->phy;
+  u32 reg_val;
+  s32 retval;
+
+  if (mode == INTELGBE_LOOPBACK_PHY && !phy->ops.set_loopback) {
+    return -INTELGBE_NOT_IMPLEMENTED;
+  }
+
+  if (mac->loopback == INTELGBE_LOOPBACK_PHY && mode != INTELGBE_LOOPBACK_PHY) {
+    retval = phy->ops.set_loopback(hw, false);
+    if (retval < 0) {
+      return retval;
+    }
+    if (phy->ops.cfg_link) {
+      retval = phy->ops.cfg_link(hw);
+      if (retval < 0) {
+        return retval;
+      }
+    }
+  }
+
+  if (mode == INTELGBE_LOOPBACK_PHY && mac->loopback != INTELGBE_LOOPBACK_PHY) {
+    retval = phy->ops.set_loopback(hw, true);
+    if (retval < 0) {
+      return retval;
+    }
+    retval = intelgbe_serdes_follow_link(hw, 1000);
+    if (retval < 0) {
+      return retval;
+    }
+    mac->link_speed = 1000;
+    mac->full_duplex = 1;
+    intelgbe_config_mac_speed(hw);
+  }
+
+  /* Init clears MAC_CONFIGURATION, so LM is written on every call */
+  reg_val = INTELGBE_READ_REG(hw, MAC_CONFIGURATION);
+  if (mode == INTELGBE_LOOPBACK_MAC) {
+    reg_val |= MAC_CONF_LM;
+  } else {
+    reg_val &= ~MAC_CONF_LM;
+  }
+  INTELGBE_WRITE_REG(hw, MAC_CONFIGURATION, reg_val);
+
+  mac->loopback = mode;
+  DEBUGPRINT (CRITICAL, ("Loopback mode %d\n", mode));
+  return INTELGBE_SUCCESS;
+}
+
+/**
+ *  intelgbe_set_link_mode - Change between auto-negotiation and a forced link
+ *  @hw: pointer to the HW structure
+ *  @autoneg: true to auto-negotiate, false to force @speed and @full_duplex
+ *  @speed: forced speed in Mbps
+ *  @full_duplex: forced duplex
+ *
+ *  Reprograms the PHY through cfg_link, the MAC follows the new speed and
+ *  duplex on the next link status change.
+ **/
+s32 intelgbe_set_link_mode(struct intelgbe_hw *hw, bool autoneg, u32 speed,
+                           bool full_duplex)
+{
+  struct intelgbe_phy_info *phy = &hw->phy;
+
+  if (autoneg && phy->autoneg) {
+    return INTELGBE_SUCCESS;
+  }
+  if (!autoneg && !phy->autoneg && phy->link_speed == speed &&
+      phy->full_duplex == full_duplex) {
+    return INTELGBE_SUCCESS;
+  }
+  phy->autoneg = autoneg;
+  phy->link_speed = speed;
+  phy->full_duplex = full_duplex;
+
+  if (hw->phy.ops.cfg_link) {
+    return hw->phy.ops.cfg_link(hw);
+  }
+  return INTELGBE_SUCCESS;
+}
+
+/**
+ *  intelgbe_get_rx_fifo_drops - Collect RX FIFO drop counters
+ *  @hw: pointer to the HW structure
+ *  @overflow: frames dropped because an MTL RX queue was full
+ *  @missed: frames dropped because the DMA had no free descriptor
+ *
+ *  The counters clear on read and are summed over all RX queues. A counter
+ *  that wrapped since the last read is reported as one full wrap.
+ **/
+void intelgbe_get_rx_fifo_drops(struct intelgbe_hw *hw, u32 *overflow,
+                                u32 *missed)
+{
+  GIG_DRIVER_DATA *GigAdapterInfo = (GIG_DRIVER_DATA *)hw->back;
+  u32 reg_val;
+  int i;
+
+  *overflow = 0;
+  *missed = 0;
+  for (i = 0; i < GigAdapterInfo->rxqnum; i++) {
+    reg_val = INTELGBE_READ_REG(hw, MTL_RXQ_MISSED_PKT_OVF_CNT(i));
+    *overflow += reg_val & MTL_RXQ_OVFPKTCNT_MASK;
+    if (reg_val & MTL_RXQ_OVFCNTOVF) {
+      *overflow += MTL_RXQ_CNT_WRAP;
+    }
+    *missed += (reg_val & MTL_RXQ_MISPKTCNT_MASK) >> MTL_RXQ_MISPKTCNT_SHIFT;
+    if (reg_val & MTL_RXQ_MISCNTOVF) {
+      *missed += MTL_RXQ_CNT_WRAP;
+    }
+  }
+}
+
+s32 intelgbe_init_controller(struct intelgbe_hw *hw)
+{
+  s32 retval;
+
+  retval = intelgbe_dma_init(hw);
+  if (retval < 0)
+    return retval;
+  retval = intelgbe_mtl_init(hw);
+  if (retval < 0)
+    return retval;
+  retval = intelgbe_mac_init(hw);
+  if (retval < 0)
+    return retval;
+  retval = intelgbe_mac_enable_interrupts(hw);
+  if (retval < 0)
+    return retval;
+  retval = intelgbe_mac_start_transaction(hw);
+  if (retval < 0)
+    return retval;
+
+  return INTELGBE_SUCCESS;
+}
+
+/**
+ *  Intelgbe_init_mac_ops- Init MAC func ptrs.
+ *  @hw: pointer to the HW structure
+ **/
+s32 intelgbe_init_mac_ops(struct intelgbe_hw *hw)
+{
+  struct intelgbe_mac_info *mac = &hw->mac;
+  u32 tx_queues, rx_queues;
+  u32 hw_feature;
+  u32 dma_profile;
+  int i;
+
+  DEBUGPRINT (INTELGBE, ("entered init mac ops funcs\n"));
+
+  /* read mac address */
+  mac->ops.read_mac_addr = intelgbe_read_mac_addr;
+  /* write mac address */
+  mac->ops.write_mac_addr = intelgbe_write_mac_addr;
+  /* read ID reg */
+  mac->ops.get_id = intelgbe_get_mac_version;
+  /* reset MAC controller */
+  mac->ops.reset_hw = intelgbe_reset_controller;
+  /* initialize MAC controller */
+  mac->ops.init_hw = intelgbe_init_controller;
+  /* deactivate MAC controller */
+  mac->ops.uninit_hw = intelgbe_uninit_controller;
+  /* Link status change */
+  mac->ops.check_for_link = intelgbe_link_status;
+  /* Obtain HW TX & RX fifo size */
+  mac->link_speed = 100;
+  mac->full_duplex = 1;
+  /* VLAN offloads are optional in the IP configuration */
+  hw_feature = INTELGBE_READ_REG(hw, MAC_HW_FEATURE0);
+  mac->vlan_insert = !!(hw_feature & MAC_HW_FEAT0_SAVLANINS);
+  mac->vlan_hash_filter = !!(hw_feature & MAC_HW_FEAT0_VLHASH);
+  mac->vlan_hash = 0;
+  mac->tstamp = !!(hw_feature & MAC_HW_FEAT0_TSSEL);
+  hw_feature = INTELGBE_READ_REG(hw, MAC_HW_FEATURE1);
+  mac->dma_addr_width = intelgbe_dma_addr_width(hw_feature);
+  mac->tstamp_en = false;
+  /* LPI wake-up adds jitter to every frame after an idle gap, so keep EEE
+   * off unless power-save is asked for
+   */
+  mac->eee = !!(hw_feature & MAC_HW_FEAT0_EEESEL);
+  mac->eee_active = false;
+  mac->link_profile = INTELGBE_LINK_PROFILE_LOW_LATENCY;
+  /* Symmetric pause, so a slow poller stalls the sender instead of dropping */
+  mac->fc_requested = INTELGBE_FC_RX | INTELGBE_FC_TX;
+  mac->fc_active = 0;
+  mac->loopback = INTELGBE_LOOPBACK_NONE;
+  /* Control frames go out ahead of bulk data until WRR/DWRR is asked for */
+  mac->tx_sched = MTL_OPR_MD_SCHALG_SP;
+  /* Auto-negotiate until a forced speed is requested */
+  hw->phy.autoneg = true;
+  /*
+    Refer EHL sighting report EHL-84 1507102816
+    TXFIFOSIZE & RXFIFOSIZE Register Fields Incorrectly Report MTL TX & RX FIFO Sizes
+    for PSE GbE Controllers
+
+    Software must implement workaround below.
+
+    A workaround for this sighting is available in the Beta Yocto Project* and
+    PSE Beta firmware. Other operating systems should hardcode the MTL TX &
+    RX FIFO size to 32kB, instead of reading from the
+    MAC_HW_FEATURE1.TXFIFOSIZE & MAC_HW_FEATURE1.RXFIFOSIZE registers
+  */
+
+  switch (hw->device_id) {
+    case EHL_PSE0_STMMAC_RGMII1G_DID:
+    case EHL_PSE1_STMMAC_RGMII1G_DID:
+    case EHL_PCH_STMMAC_SGMII_DID:
+    case EHL_PSE0_STMMAC_SGMII1G_DID:
+    case EHL_PSE1_STMMAC_SGMII1G_DID:
+    case EHL_PSE0_STMMAC_SGMII2G5_DID:
+    case EHL_PSE1_STMMAC_SGMII2G5_DID:
+      tx_queues = 8;
+      rx_queues = 8;
       break;
     case TGLH_PCH1_STMMAC_SGMII_DID:
     case TGLH_PCH2_STMMAC_SGMII_DID:
@@ -925,6 +1845,48 @@ s32 intelgbe_init_mac_ops(struct intelgbe_hw *hw)
   */
   mac->txfifosz = tx_queues * INTELGBE_FIFO_SZ_PER_QUEUE;
   mac->rxfifosz = rx_queues * INTELGBE_FIFO_SZ_PER_QUEUE;
+  /* The whole FIFO is shared among the queues in use, equally by default */
+  for (i = 0; i < INTELGBE_MAX_TX_QUEUES; i++) {
+    mac->txq_fifo_weight[i] = 1;
+    mac->txq_weight[i] = 1;
+  }
+  /* The control queue only carries small frames, keep most of the TX FIFO
+   * for line rate bursts on the bulk queue
+   */
+  mac->txq_fifo_weight[INTELGBE_TXQ_BULK] = 7;
+  for (i = 0; i < INTELGBE_MAX_RX_QUEUES; i++) {
+    mac->rxq_fifo_weight[i] = 1;
+  }
+  /* The PSE controllers reach memory through the PSE fabric, where a
+   * second outstanding request hides its extra latency
+   */
+  switch (hw->device_id) {
+    case EHL_PSE0_STMMAC_RGMII1G_DID:
+    case EHL_PSE1_STMMAC_RGMII1G_DID:
+    case EHL_PSE0_STMMAC_SGMII1G_DID:
+    case EHL_PSE1_STMMAC_SGMII1G_DID:
+    case EHL_PSE0_STMMAC_SGMII2G5_DID:
+    case EHL_PSE1_STMMAC_SGMII2G5_DID:
+      dma_profile = INTELGBE_DMA_PROFILE_BALANCED;
+      break;
+    default:
+      dma_profile = INTELGBE_DMA_PROFILE_DEFAULT;
+      break;
+  }
+#ifdef INTELGBE_DMA_PROFILE
+  /* Only the named profiles, INTELGBE_DMA_PROFILE_DEFAULT (0) up to
+   * INTELGBE_DMA_PROFILE_LOW_LATENCY (3), can be built in, custom settings
+   * need the Adapter Information protocol
+   */
+#if (INTELGBE_DMA_PROFILE < 0) || (INTELGBE_DMA_PROFILE > 3)
+#error INTELGBE_DMA_PROFILE must be a named INTELGBE_DMA_PROFILE_* value, not CUSTOM
+#endif
+  dma_profile = INTELGBE_DMA_PROFILE;
+#endif
+  if (intelgbe_set_dma_profile(hw, dma_profile, NULL) != INTELGBE_SUCCESS) {
+    DEBUGPRINT(CRITICAL, ("DMA profile %d rejected, using default\n", dma_profile));
+    intelgbe_set_dma_profile(hw, INTELGBE_DMA_PROFILE_DEFAULT, NULL);
+  }
 
   return INTELGBE_SUCCESS;
 }
@@ -34,8 +34,42 @@ struct intelgbe_rx_desc {
   __le32 des3;
 };
 
+/* Transmit Descriptor read format fields */
+#define TDES2_VLAN_TAG_INSERT        (0x2 << 14)
+#define TDES2_TIMESTAMP_ENABLE       BIT(30)
+#define TDES2_INTERRUPT_ON_COMPLETION BIT(31)
+
+#define TDES3_VLAN_TAG_MASK          0xFFFF
+#define TDES3_VLAN_TAG_VALID         BIT(16)
+#define TDES3_TIMESTAMP_STATUS       BIT(17)
+#define TDES3_ERROR_SUMMARY          BIT(15)
+#define TDES3_LAST_DESCRIPTOR        BIT(28)
+#define TDES3_FIRST_DESCRIPTOR       BIT(29)
+#define TDES3_CONTEXT_TYPE           BIT(30)
+#define TDES3_OWN                    BIT(31)
+
+/* Receive Descriptor write-back fields */
+#define RDES0_OUTER_VLAN_TAG_MASK    0xFFFF
+#define RDES1_TIMESTAMP_AVAILABLE    BIT(14)
+
+#define RDES2_SA_FILTER_FAIL         BIT(16)
+#define RDES2_DA_FILTER_FAIL         BIT(17)
+#define RDES2_HASH_FILTER_STATUS     BIT(18)
+#define RDES2_MAC_ADDR_MATCH_MASK    (0xFF << 19)
+#define RDES2_MAC_ADDR_MATCH_SHIFT   19
+
+#define RDES3_PACKET_SIZE_MASK       0x7FFF
+#define RDES3_GIANT_PACKET           BIT(23)
+#define RDES3_CRC_ERROR              BIT(24)
+#define RDES3_RDES0_VALID            BIT(25)
+#define RDES3_RDES2_VALID            BIT(27)
+#define RDES3_LAST_DESCRIPTOR        BIT(28)
+#define RDES3_CONTEXT_TYPE           BIT(30)
+#define RDES3_OWN                    BIT(31)
+
 struct intelgbe_hw;
 struct intelgbe_phy_info;
+struct intelgbe_dma_cfg;
 
 /**
  *  Intelgbe_init_mac_ops_generic- Init MAC func ptrs.
@@ -54,10 +88,34 @@ s32 intelgbe_init_phy_params_stmmac(struct intelgbe_hw *hw);
 void intelgbe_init_function_pointers_stmmac(struct intelgbe_hw *hw);
 s32 intelgbe_xpcs_init(struct intelgbe_hw *hw);
 s32 intelgbe_modphy_init(struct intelgbe_hw *hw);
+s32 intelgbe_serdes_follow_link(struct intelgbe_hw *hw, s32 link_speed);
+u32 intelgbe_dma_addr_width(u32 hw_feature1);
+u32 intelgbe_vlan_hash_bit(u16 vid);
+s32 intelgbe_update_vlan_hash(struct intelgbe_hw *hw, u16 hash);
+s32 intelgbe_config_tstamp(struct intelgbe_hw *hw, bool enable);
+u64 intelgbe_get_systime(struct intelgbe_hw *hw);
+s32 intelgbe_config_eee(struct intelgbe_hw *hw);
+s32 intelgbe_set_link_profile(struct intelgbe_hw *hw, u32 profile);
+s32 intelgbe_set_dma_profile(struct intelgbe_hw *hw, u32 profile,
+                             const struct intelgbe_dma_cfg *cfg);
+s32 intelgbe_config_dma(struct intelgbe_hw *hw);
+s32 intelgbe_config_flow_ctrl(struct intelgbe_hw *hw);
+s32 intelgbe_set_flow_ctrl(struct intelgbe_hw *hw, u32 fc);
+s32 intelgbe_set_loopback(struct intelgbe_hw *hw, u32 mode);
+s32 intelgbe_set_tx_sched(struct intelgbe_hw *hw, u32 sched, const u32 *weight);
+s32 intelgbe_set_link_mode(struct intelgbe_hw *hw, bool autoneg, u32 speed,
+                           bool full_duplex);
+void intelgbe_get_rx_fifo_drops(struct intelgbe_hw *hw, u32 *overflow,
+                                u32 *missed);
 
 s32 mii_phy_id_get(struct intelgbe_hw *hw);
 int mii_phy_soft_reset(struct intelgbe_hw *hw, bool wait);
 int mii_phy_config_link(struct intelgbe_hw *hw, bool changed);
+int mii_phy_loopback(struct intelgbe_hw *hw, bool enable);
+int mii_phy_eee_active(struct intelgbe_hw *hw, s32 link_speed, bool *active);
+int mii_phy_resolve_pause(struct intelgbe_hw *hw, u32 *fc);
+u32 mii_phy_forced_mode(u32 speed, bool full_duplex);
 int mii_phy_get_supported(struct intelgbe_hw *hw);
+int mii_phy_get_supported_c45(struct intelgbe_hw *hw);
 
 #endif
@@ -162,6 +162,8 @@ s32 intelgbe_init_phy_ops_marvell_88e1512(struct intelgbe_hw *hw)
   phy->ops.link_status_change = marvell_88e1512_link_status_change;
   /* PHY status */
   phy->ops.status = marvell_88e1512_read_status;
+  /* PHY loopback */
+  phy->ops.set_loopback = mii_phy_loopback;
   phy->type = PHY_MARVELL_88E1512;
 
   return INTELGBE_SUCCESS;
@@ -67,11 +67,6 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 /* MDIO Manageable Device (MMD) Auto-Negotiation */
 #define MDIO_AN_DEVICE                          7
 
-/* PHY EEE Advertisement Register - Device 7, Reg 60 */
-#define MDIO_AN_EEE_ADV                         60
-/* 100M & 1000M link speed */
-#define MDIO_AN_EEE_ADV_SPEED                   (BIT(1) | BIT(2))
-
 #define PHY_AUTONEG_TIMEOUT_MS                  5500
 #define PHY_AUTONEG_POLL_MS                     100
 
@@ -68,6 +68,13 @@ STATIC s32 m88e2110_read_status (struct intelgbe_hw *hw, bool *link,
         case MMD_PCS_CSTATUS1_SPEED_100M:
             *link_speed = 100;
             break;
+        case MMD_PCS_CSTATUS1_SPEED_SPD2:
+            if ((phyreg & MMD_PCS_CSTATUS1_SPD2) == MMD_PCS_CSTATUS1_SPD2_2500) {
+                *link_speed = 2500;
+                break;
+            }
+            *link_speed = 10;
+            break;
         default:
             *link_speed = 10;
             break;
@@ -79,9 +86,12 @@ STATIC s32 m88e2110_phy_cfg_link (struct intelgbe_hw *hw)
 {
     s32 retval;
 
-    retval = intelgbe_phy_write_c45 (hw, MMD_AN, MMD_AN_MULTIG_CTRL, MMD_AN_MULTIG_CTRL_1G);
+    /* 5G/10G stay off, 2.5G is left to mii_phy_config_link() */
+    retval = intelgbe_phy_modify_c45_if_changed (hw, MMD_AN, MMD_AN_MULTIG_CTRL,
+                                                 (u16) ~MMD_AN_MULTIG_CTRL_2_5G,
+                                                 MMD_AN_MULTIG_CTRL_1G);
     if (retval < 0) return retval;
-    return mii_phy_config_link (hw, false);
+    return mii_phy_config_link (hw, retval > 0);
 }
 
 STATIC s32 m88e2110_phy_initialize (struct intelgbe_hw *hw)
@@ -102,6 +112,17 @@ STATIC s32 m88e2110_phy_initialize (struct intelgbe_hw *hw)
     fwver |= phyreg & BIT_MASK(16);
     DEBUGPRINT (PHYFUNC, ("M88E2110 FW Ver %X\n", fwver));
 
+    /* Only the 5GBASE-R MACTYPEs switch the host interface with the link
+     * speed, the others keep one host rate and match the copper rate
+     */
+    retval |= intelgbe_phy_read_c45 (hw, MMD_PMA_PMD, MMD_PMA_PORT_CTRL, &phyreg);
+    phyreg &= MMD_PMA_PORT_CTRL_MACTYPE_MASK;
+    hw->phy.rate_matching = (phyreg != MMD_PMA_MACTYPE_5GBASER) &&
+                            (phyreg != MMD_PMA_MACTYPE_5GBASER_NO_SGMII_AN);
+    DEBUGPRINT (PHYFUNC, ("M88E2110 MACTYPE %d, %a\n", phyreg,
+                          hw->phy.rate_matching ? "rate matching" : "rate switching"));
+
+    retval |= mii_phy_get_supported_c45 (hw);
     return retval;
 }
 
@@ -117,6 +138,8 @@ s32 intelgbe_init_phy_ops_marvell_88e2110 (struct intelgbe_hw *hw)
     phy->ops.link_status_change = m88e2110_link_status_change;
     /* PHY status */
     phy->ops.status = m88e2110_read_status;
+    /* PHY loopback */
+    phy->ops.set_loopback = mii_phy_loopback;
     phy->type = PHY_MARVELL_88E2110;
 
     return INTELGBE_SUCCESS;
@@ -69,6 +69,21 @@ STATIC s32 intelgbe_phy_cfg_link(struct intelgbe_hw *hw)
   return mii_phy_config_link(hw, false);
 }
 
+/* Ported from gpy_loopback in mxl-gpy.c */
+STATIC s32 maxlinear_gpyxxx_loopback(struct intelgbe_hw *hw, bool enable)
+{
+  int retval;
+
+  retval = mii_phy_loopback(hw, enable);
+  if (retval < 0) {
+    return retval;
+  }
+
+  /* It takes some time for PHY device to switch into/out-of loopback mode */
+  msec_delay(100);
+  return INTELGBE_SUCCESS;
+}
+
 /* Ported from gpy_config_init in intel-gpy.c */
 STATIC s32 intelgbe_phy_initialize(struct intelgbe_hw *hw)
 {
@@ -76,10 +91,17 @@ STATIC s32 intelgbe_phy_initialize(struct intelgbe_hw *hw)
 
   /* TODO: Show GPY PHY FW version in log */
 
-  /* TODO: In GPY PHY FW, by default EEE mode is enabled. So, disable EEE mode
-   * during power up. See Linux implementation.
+  /* In GPY PHY FW, by default EEE mode is enabled. The EEE advertisement is
+   * rewritten from the link profile by mii_phy_config_link() in cfg_link.
    */
 
+  /* GPY2xx copper side can run 2.5GBASE-T, the host side follows through
+   * intelgbe_serdes_follow_link()
+   */
+  if (mii_phy_get_supported_c45(hw) < 0) {
+    return -INTELGBE_ERR_PHY;
+  }
+
   /* TODO: Keep LED settings to default after discussing with CK. Revisit LED later.
    * Not debug printing LED settings to reduce log file entries. To enable, you can refer to previous commits.
    */
@@ -101,6 +123,8 @@ s32 intelgbe_init_phy_ops_maxlinear_gpyxxx(struct intelgbe_hw *hw)
   phy->ops.link_status_change = maxlinear_gpyxxx_link_status_change;
   /* PHY status */
   phy->ops.status = maxlinear_gpyxxx_read_status;
+  /* PHY loopback */
+  phy->ops.set_loopback = maxlinear_gpyxxx_loopback;
   phy->type = PHY_MAXLINEAR_GPY211;
 
   return INTELGBE_SUCCESS;
@@ -73,14 +73,26 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define MII_STD_XSTATUS_1000BASE_T_FULL   BIT(13)
 #define MII_STD_XSTATUS_1000BASE_T_HALF   BIT(12)
 
+/* MMD access through Clause 22 registers 13 and 14 */
+#define MII_STD_MMD_CTRL_DEVAD_MASK       0x1F
+#define MII_STD_MMD_CTRL_DATA_NOINC       BIT(14)
+
 /* Clause 45 MMD Registers */
 #define MMD_PMA_PMD                       0x01
 #define MMD_PMA_PHYID1                    0x02    /* PHY ID 1 */
 #define MMD_PMA_PHYID2                    0x03    /* PHY ID 2 */
 #define MMD_PMA_FW_VER0                   0xC011
 #define MMD_PMA_FW_VER1                   0xC012
+#define MMD_PMA_PORT_CTRL                 0xC04A  /* 88E21x0 port control */
+#define MMD_PMA_PORT_CTRL_MACTYPE_MASK    0x7     /* host interface mode */
+#define MMD_PMA_MACTYPE_5GBASER           0x4     /* 5GBASE-R/2500BASE-X/SGMII by link speed */
+#define MMD_PMA_MACTYPE_5GBASER_NO_SGMII_AN 0x5   /* as above, no SGMII auto-negotiation */
 #define MMD_PMA_BOOT                      0xC050
 #define MMD_PMA_BOOT_FATAL                BIT(0)
+#define MMD_PMA_EXTABLE                   0x0B    /* Extended abilities */
+#define MMD_PMA_EXTABLE_NBT               BIT(14) /* 2.5G/5GBASE-T abilities present */
+#define MMD_PMA_NG_EXTABLE                0x15    /* 2.5G/5G extended abilities */
+#define MMD_PMA_NG_EXTABLE_2_5GBT         BIT(0)
 
 #define MMD_AN                            0x07
 #define MMD_AN_CTRL                       0x00
@@ -93,11 +105,25 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define MMD_AN_LPA                        0x13
 #define MMD_AN_MULTIG_CTRL                0x20
 #define MMD_AN_MULTIG_CTRL_1G             BIT(0)
+#define MMD_AN_MULTIG_CTRL_2_5G           BIT(7)
 #define MMD_AN_1G_ABILITY                 0x8002
 #define MMD_AN_1G_STATUS                  0x8001
 #define MMD_AN_1G_CTRL                    0x8000
+/* PHY EEE Advertisement Register - Device 7, Reg 60 */
+#define MDIO_AN_EEE_ADV                   60
+#define MDIO_AN_EEE_LPA                   61
+#define MDIO_AN_EEE_100TX                 BIT(1)
+#define MDIO_AN_EEE_1000T                 BIT(2)
+/* 100M & 1000M link speed */
+#define MDIO_AN_EEE_ADV_SPEED             (MDIO_AN_EEE_100TX | MDIO_AN_EEE_1000T)
+/* PHY EEE Advertisement 2 Register - Device 7, Reg 62 */
+#define MDIO_AN_EEE_ADV2                  62
+#define MDIO_AN_EEE_LPA2                  63
+#define MDIO_AN_EEE_2_5GT                 BIT(0)
 
 #define MMD_PCS                           0x03
+#define MMD_PCS_CTRL1                     0x00
+#define MMD_PCS_CTRL1_LOOPBACK            BIT(14)
 #define MMD_PCS_CSTATUS1                  0x8008
 #define MMD_PCS_CSTATUS1_LINK             BIT(10)
 #define MMD_PCS_CSTATUS1_SPDDONE          BIT(11)
@@ -105,6 +131,9 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define MMD_PCS_CSTATUS1_SPEED            (BIT(15) | BIT(14))
 #define MMD_PCS_CSTATUS1_SPEED_1G         0x2
 #define MMD_PCS_CSTATUS1_SPEED_100M       0x1
+#define MMD_PCS_CSTATUS1_SPEED_SPD2       0x3     /* speed is in SPD2 */
+#define MMD_PCS_CSTATUS1_SPD2             (BIT(3) | BIT(2))
+#define MMD_PCS_CSTATUS1_SPD2_2500        BIT(2)
 
 // TODO: don't belong here
 #define PHY_SOFT_RESET_TIMEOUT_MS               600
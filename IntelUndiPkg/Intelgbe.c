@@ -8,10 +8,6 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include "Init.h"
 #include "Intelgbe.h"
 
-/* Global variables for blocking IO */
-STATIC BOOLEAN  mInitializeLock = TRUE;
-STATIC EFI_LOCK mLock;
-
 VOID IntelgbeRegsDump(GIG_DRIVER_DATA *GigAdapter)
 {
 #if DBG_LVL
@@ -26,7 +22,7 @@ VOID IntelgbeRegsDump(GIG_DRIVER_DATA *GigAdapter)
     DEBUGPRINT (CRITICAL, ("TX descriptor ring: %d\n", k));
     DEBUGPRINT (CRITICAL, ("curr=%d \n", tx_q->cur_tx));
     for (i = 0; i < DEFAULT_TX_DESCRIPTORS; i++) {
-      UNDI_DMA_MAPPING *TxBufMapping = &GigAdapter->TxBufferMappings[i];
+      UNDI_DMA_MAPPING *TxBufMapping = &tx_q->buf_map[i];
       DEBUGPRINT (CRITICAL, ("%03d [0x%x]: 0x%x 0x%x 0x%x 0x%x 0x%x 0x%x\n",
                         i, (UINT64)p,
                         (p->des0), (p->des1),
@@ -139,15 +135,11 @@ IntelgbeBlockIt (
   if (GigAdapter->Block != NULL) {
     (*GigAdapter->Block) (GigAdapter->UniqueId, Flag);
   } else {
-    if (mInitializeLock) {
-      EfiInitializeLock (&mLock, TPL_NOTIFY);
-      mInitializeLock = FALSE;
-    }
-
+    // Each port has its own lock so traffic on one adapter never waits on another.
     if (Flag != 0) {
-      EfiAcquireLock (&mLock);
+      EfiAcquireLock (&GigAdapter->Lock);
     } else {
-      EfiReleaseLock (&mLock);
+      EfiReleaseLock (&GigAdapter->Lock);
     }
   }
 }
@@ -169,6 +161,29 @@ DelayInMicroseconds (
   gBS->Stall (MicroSeconds);
 }
 
+/** Checks that the DMA can reach a buffer.
+
+   Once dual address cycles are enabled PciIo may place buffers anywhere in
+   the 64-bit space, but the MAC only drives dma_addr_width address bits.
+
+   @param[in]   Address        Device address of the buffer
+   @param[in]   Size           Length of the buffer, not zero
+   @param[in]   DmaAddrWidth   Address bits the DMA drives
+
+   @retval   TRUE    The whole buffer is below the DMA address limit
+   @retval   FALSE   The DMA would truncate the address
+**/
+STATIC
+BOOLEAN
+IntelgbeDmaReachable (
+  IN UINT64 Address,
+  IN UINTN  Size,
+  IN UINT32 DmaAddrWidth
+  )
+{
+  return RShiftU64 (Address + Size - 1, DmaAddrWidth) == 0;
+}
+
 /** Detects surprise removal device status in PCI controller register
 
    @param[in]   Adapter   Pointer to the device instance
@@ -220,42 +235,104 @@ IntelgbeMapMem (
   }
 }
 
-/** Free TX buffers that have been transmitted by the hardware.
+/** Adds one latency sample to a latency profile.
+
+   @param[in,out]   Stats   Profile to update
+   @param[in]       Ns      Latency in nanoseconds
+**/
+STATIC
+VOID
+IntelgbeLatencyAdd (
+  INTELGBE_LATENCY_STATS *Stats,
+  UINT64                  Ns
+  )
+{
+  Stats->Count++;
+  Stats->TotalNs += Ns;
+  if (Ns < Stats->MinNs) {
+    Stats->MinNs = Ns;
+  }
+  if (Ns > Stats->MaxNs) {
+    Stats->MaxNs = Ns;
+  }
+}
+
+/** Records the submit time of the frame just queued, while timestamping.
+
+   The time is kept against the last descriptor of the frame, which is the one
+   the MAC writes the TX timestamp back to.
+
+   @param[in]   GigAdapter   Pointer to the driver data
+   @param[in]   tx_q         Queue the frame was placed on, cur_tx past the frame
+**/
+STATIC
+VOID
+IntelgbeTxSubmitTime (
+  GIG_DRIVER_DATA          *GigAdapter,
+  struct intelgbe_tx_queue *tx_q
+  )
+{
+  UINT32 Last;
+
+  if (tx_q->tx_tstamp == NULL) {
+    return;
+  }
+
+  Last = (tx_q->cur_tx + DEFAULT_TX_DESCRIPTORS - 1) % DEFAULT_TX_DESCRIPTORS;
+  tx_q->tx_tstamp[Last] = intelgbe_get_systime (&GigAdapter->Hw);
+}
+
+/** Free TX buffers of one queue that have been transmitted by the hardware.
 
    @param[in]   GigAdapter   Pointer to the NIC data structure information
                              which the UNDI driver is layering on.
+   @param[in]   tx_q         Queue to reclaim
    @param[in]   NumEntries   Number of entries in the array which can be freed.
    @param[out]  TxBuffer     Array to pass back free TX buffer
 
    @return   Number of TX buffers written.
 **/
+STATIC
 UINT16
-IntelgbeFreeTxBuffers (
-  IN GIG_DRIVER_DATA *GigAdapter,
-  IN UINT16           NumEntries,
-  OUT UINT64 *        TxBuffer
+IntelgbeFreeTxQueue (
+  IN GIG_DRIVER_DATA          *GigAdapter,
+  IN struct intelgbe_tx_queue *tx_q,
+  IN UINT16                    NumEntries,
+  OUT UINT64 *                 TxBuffer
   )
 {
-  struct intelgbe_tx_queue  *tx_q = &GigAdapter->tx_queue[0];
   UINT32                     entry;
   UINT16                     count = 0;
   UNDI_DMA_MAPPING          *TxBufMapping;
+  UINT64                     WireTime;
 
-  DEBUGPRINT (DECODE, ("INTELGBEFreeTxBuffers cur %d dirty %d NumEntries %d\n",
-    tx_q->cur_tx, tx_q->dirty_tx, NumEntries));
+  INTELGBE_TRACE (GigAdapter, INTELGBE_TRACE_TX_RECLAIM, tx_q->queue_index,
+    tx_q->cur_tx, tx_q->dirty_tx, NumEntries);
 
   entry = tx_q->dirty_tx;
   while ((entry != tx_q->cur_tx) && (count < NumEntries)) {
     INTELGBE_TRANSMIT_DESCRIPTOR *p = &tx_q->tx_desc[entry];
-    TxBufMapping = &GigAdapter->TxBufferMappings[entry];
+    TxBufMapping = &tx_q->buf_map[entry];
     UINT32 tdes3 = p->des3;
     if (tdes3 & BIT(31)) {
-      DEBUGPRINT (INTELGBE, ("TX desc busy\n"));
       break;
     }
-    if (tdes3 & BIT(28)) {
-      if (tdes3 & BIT(15)) {
-        DEBUGPRINT (CRITICAL, ("TX Error\n"));
+    if (tdes3 & TDES3_CONTEXT_TYPE) {
+      // VLAN context descriptors carry no buffer to hand back.
+      p->des3 = 0;
+      entry = (entry +1) & (DEFAULT_TX_DESCRIPTORS -1);
+      continue;
+    }
+    if ((tdes3 & BIT(28)) && (tdes3 & BIT(15))) {
+      INTELGBE_TRACE (GigAdapter, INTELGBE_TRACE_TX_ERROR, tx_q->queue_index,
+        entry, tdes3, 0);
+    }
+    if ((tdes3 & TDES3_TIMESTAMP_STATUS) && (tx_q->tx_tstamp != NULL)) {
+      // Write-back replaced the buffer address with the wire timestamp.
+      WireTime = MultU64x32 (p->des1, 1000000000) + p->des0;
+      if (WireTime >= tx_q->tx_tstamp[entry]) {
+        IntelgbeLatencyAdd (&GigAdapter->TransmitToWire,
+          WireTime - tx_q->tx_tstamp[entry]);
       }
     }
     if (TxBufMapping->UnmappedAddress == 0) {
@@ -264,6 +341,8 @@ IntelgbeFreeTxBuffers (
       break;
     }
     UndiDmaUnmapMemory (GigAdapter->PciIo, TxBufMapping);
+    INTELGBE_TRACE (GigAdapter, INTELGBE_TRACE_TX_DONE, tx_q->queue_index,
+      entry, tdes3, 0);
 
     TxBuffer[count] = TxBufMapping->UnmappedAddress;
     count++;
@@ -281,6 +360,227 @@ IntelgbeFreeTxBuffers (
   return count;
 }
 
+/** Free TX buffers that have been transmitted by the hardware.
+
+   @param[in]   GigAdapter   Pointer to the NIC data structure information
+                             which the UNDI driver is layering on.
+   @param[in]   NumEntries   Number of entries in the array which can be freed.
+   @param[out]  TxBuffer     Array to pass back free TX buffer
+
+   @return   Number of TX buffers written.
+**/
+UINT16
+IntelgbeFreeTxBuffers (
+  IN GIG_DRIVER_DATA *GigAdapter,
+  IN UINT16           NumEntries,
+  OUT UINT64 *        TxBuffer
+  )
+{
+  UINT16 count = 0;
+  UINT32 i;
+
+  for (i = 0; (i < GigAdapter->txqnum) && (count < NumEntries); i++) {
+    count += IntelgbeFreeTxQueue (GigAdapter, &GigAdapter->tx_queue[i],
+               NumEntries - count, &TxBuffer[count]);
+  }
+
+  return count;
+}
+
+/** Reads and clears the transmit and receive interrupt status of all DMA channels.
+
+   DMA_INTERRUPT_STATUS has a bit per channel with an enabled interrupt
+   pending, so an idle poll costs that one read. Only flagged channels have
+   their status read and cleared. Frames already completed in the rings are
+   reported too, they may still be waiting after an earlier poll cleared
+   the interrupt.
+
+   @param[in]   GigAdapter   Pointer to the NIC data structure information
+                             which the UNDI driver is layering on.
+
+   @return   PXE_STATFLAGS_GET_STATUS_TRANSMIT and PXE_STATFLAGS_GET_STATUS_RECEIVE
+             for the interrupts that were pending
+**/
+UINT16
+IntelgbeGetInterruptStatus (
+  IN GIG_DRIVER_DATA *GigAdapter
+  )
+{
+  struct intelgbe_tx_queue *tx_q;
+  struct intelgbe_rx_queue *rx_q;
+  UINT16 StatFlags = 0;
+  UINT32 Pending;
+  UINT32 IntStatus;
+  UINT32 Clear;
+  UINT32 entry;
+  u32 chan;
+  u32 i;
+
+  Pending = INTELGBE_READ_REG(&GigAdapter->Hw, DMA_INTERRUPT_STATUS) &
+            (DMA_INTR_STS_DCIS(DMA_INTR_STS_CHNL_MAX) - 1);
+
+  for (chan = 0; Pending != 0; chan++, Pending >>= 1) {
+    if (!(Pending & 1)) {
+      continue;
+    }
+
+    // TX queue i runs on DMA channel i, RX queues carry their own channel.
+    IntStatus = INTELGBE_READ_REG(&GigAdapter->Hw, DMA_INTR_STATUS_CH(chan));
+    Clear = 0;
+    if ((IntStatus & DMA_CH_INTR_STS_TI) && (chan < GigAdapter->txqnum)) {
+      StatFlags |= PXE_STATFLAGS_GET_STATUS_TRANSMIT;
+      Clear |= DMA_CH_INTR_STS_TI;
+    }
+    for (i = 0; i < GigAdapter->rxqnum; i++) {
+      if ((IntStatus & DMA_CH_INTR_STS_RI) && (GigAdapter->rx_queue[i].chan == chan)) {
+        StatFlags |= PXE_STATFLAGS_GET_STATUS_RECEIVE;
+        Clear |= DMA_CH_INTR_STS_RI;
+      }
+    }
+
+    if (IntStatus & DMA_CH_INTR_STS_AIS) {
+      INTELGBE_TRACE (GigAdapter, INTELGBE_TRACE_STATUS_ABNORM, chan, IntStatus, 0, 0);
+      Clear = IntStatus;
+    } else {
+      INTELGBE_TRACE (GigAdapter, INTELGBE_TRACE_STATUS_INT, chan, IntStatus, 0, 0);
+      // NIS is sticky, left set it would keep the channel flagged in DMA_INTERRUPT_STATUS.
+      Clear |= IntStatus & DMA_CH_INTR_STS_NIS;
+    }
+    if (Clear != 0) {
+      INTELGBE_WRITE_REG(&GigAdapter->Hw, DMA_INTR_STATUS_CH(chan), Clear);
+    }
+  }
+
+  // The rings are in memory, checking them costs no MMIO.
+  if (!(StatFlags & PXE_STATFLAGS_GET_STATUS_TRANSMIT)) {
+    for (i = 0; i < GigAdapter->txqnum; i++) {
+      tx_q = &GigAdapter->tx_queue[i];
+      if ((tx_q->dirty_tx != tx_q->cur_tx)
+        && !(tx_q->tx_desc[tx_q->dirty_tx].des3 & TDES3_OWN))
+      {
+        StatFlags |= PXE_STATFLAGS_GET_STATUS_TRANSMIT;
+        break;
+      }
+    }
+  }
+  if (!(StatFlags & PXE_STATFLAGS_GET_STATUS_RECEIVE)) {
+    for (i = 0; i < GigAdapter->rxqnum; i++) {
+      rx_q  = &GigAdapter->rx_queue[i];
+      entry = rx_q->cur_rx;
+      // A context descriptor left behind by a consumed frame, look past it.
+      if ((rx_q->rx_desc[entry].des3 & (RDES3_OWN | RDES3_CONTEXT_TYPE)) == RDES3_CONTEXT_TYPE) {
+        entry = (entry + 1) % DEFAULT_RX_DESCRIPTORS;
+      }
+      // Only a written back last descriptor holds a complete frame.
+      if ((rx_q->rx_desc[entry].des3 & (RDES3_OWN | RDES3_CONTEXT_TYPE | RDES3_LAST_DESCRIPTOR))
+        == RDES3_LAST_DESCRIPTOR)
+      {
+        StatFlags |= PXE_STATFLAGS_GET_STATUS_RECEIVE;
+        break;
+      }
+    }
+  }
+
+  return StatFlags;
+}
+
+/** Picks the TX queue for a frame.
+
+   ARP, DHCP, ICMPv6 (neighbor discovery) and TCP segments without payload,
+   which covers ACKs for a download, go to the control queue so they are
+   not stuck behind bulk data. A SYN has no earlier data to overtake and
+   stays in the control queue, a FIN or RST goes to the bulk queue so it
+   cannot pass the data it ends. Only the first IPv4 fragment carries the
+   transport header, later fragments go to the bulk queue. Everything else
+   goes to the bulk queue.
+
+   @param[in]   GigAdapter   Pointer to the driver data
+   @param[in]   Frame        Start of the frame, media header included
+   @param[in]   Len          Bytes readable at Frame
+
+   @return   INTELGBE_TXQ_CONTROL or INTELGBE_TXQ_BULK
+**/
+STATIC
+UINT32
+IntelgbeTxClassify (
+  GIG_DRIVER_DATA *GigAdapter,
+  UINT8           *Frame,
+  UINT32           Len
+  )
+{
+  UINT32 Off;
+  UINT16 Type;
+  UINT32 IpHdrLen;
+  UINT32 IpLen;
+  UINT8  Proto;
+  UINT16 DstPort;
+
+  if (GigAdapter->txqnum <= INTELGBE_TXQ_CONTROL) {
+    return INTELGBE_TXQ_BULK;
+  }
+
+  Off = sizeof (ETHER_HEADER);
+  if (Len < Off) {
+    return INTELGBE_TXQ_BULK;
+  }
+  Type = (UINT16) ((Frame[12] << 8) | Frame[13]);
+  if ((Type == 0x8100) && (Len >= Off + 4)) {
+    Type = (UINT16) ((Frame[16] << 8) | Frame[17]);
+    Off += 4;
+  }
+
+  switch (Type) {
+  case 0x0806: // ARP
+    return INTELGBE_TXQ_CONTROL;
+  case 0x0800: // IPv4
+    if (Len < Off + 20) {
+      return INTELGBE_TXQ_BULK;
+    }
+    if ((((Frame[Off + 6] & 0x1F) << 8) | Frame[Off + 7]) != 0) { // fragment offset
+      return INTELGBE_TXQ_BULK;
+    }
+    IpHdrLen = (Frame[Off] & 0x0F) * 4;
+    IpLen    = (Frame[Off + 2] << 8) | Frame[Off + 3];
+    Proto    = Frame[Off + 9];
+    break;
+  case 0x86DD: // IPv6, extension headers are not followed
+    if (Len < Off + 40) {
+      return INTELGBE_TXQ_BULK;
+    }
+    IpHdrLen = 40;
+    IpLen    = 40 + ((Frame[Off + 4] << 8) | Frame[Off + 5]);
+    Proto    = Frame[Off + 6];
+    if (Proto == 58) { // ICMPv6
+      return INTELGBE_TXQ_CONTROL;
+    }
+    break;
+  default:
+    return INTELGBE_TXQ_BULK;
+  }
+
+  Off += IpHdrLen;
+  if (Proto == 17) { // UDP
+    if (Len < Off + 4) {
+      return INTELGBE_TXQ_BULK;
+    }
+    DstPort = (UINT16) ((Frame[Off + 2] << 8) | Frame[Off + 3]);
+    if ((DstPort == 67) || (DstPort == 68) || (DstPort == 546) || (DstPort == 547)) {
+      return INTELGBE_TXQ_CONTROL;
+    }
+  } else if (Proto == 6) { // TCP
+    if (Len < Off + 14) {
+      return INTELGBE_TXQ_BULK;
+    }
+    if ((IpLen == IpHdrLen + (Frame[Off + 12] >> 4) * 4)
+      && !(Frame[Off + 13] & 0x05)) // FIN, RST
+    {
+      return INTELGBE_TXQ_CONTROL;
+    }
+  }
+
+  return INTELGBE_TXQ_BULK;
+}
+
 /** Takes a command Block pointer (cpb) and sends the frame.  Takes either one fragment or many
    and places them onto the wire.  Cleanup of the send happens in the function UNDI_Status in DECODE.C
 
@@ -291,7 +591,8 @@ IntelgbeFreeTxBuffers (
 
    @retval   PXE_STATCODE_SUCCESS        If the frame goes out
    @retval   PXE_STATCODE_QUEUE_FULL     Transmit buffers aren't freed by upper layer
-   @retval   PXE_STATCODE_DEVICE_FAILURE Frame failed to go out
+   @retval   PXE_STATCODE_DEVICE_FAILURE Frame failed to go out, or the DMA cannot reach it
+   @retval   PXE_STATCODE_INVALID_CPB    More fragments than the CPB can describe
    @retval   PXE_STATCODE_BUSY           If they need to call again later
 **/
 UINTN
@@ -301,7 +602,7 @@ IntelgbeTransmit (
   UINT16           OpFlags
   )
 {
-  struct intelgbe_tx_queue       *tx_q = &GigAdapter->tx_queue[0];
+  struct intelgbe_tx_queue       *tx_q;
   PXE_CPB_TRANSMIT_FRAGMENTS *TxFrags;
   PXE_CPB_TRANSMIT *          TxBuffer;
   INTELGBE_TRANSMIT_DESCRIPTOR *desc, *first;
@@ -309,29 +610,92 @@ IntelgbeTransmit (
   UNDI_DMA_MAPPING            *TxBufMapping;
   UINT32 entry, avail, needed_descs;
   UINT32 i;
+  UINT32 start_tx;
+  UINT16 VlanTci;
+  UINT64 FragAddr[MAX_XMIT_FRAGMENTS];
 
-  TxBufMapping = &GigAdapter->TxBufferMappings[tx_q->cur_tx];
+  // A tag set through the VLAN offload protocol applies to this frame only.
+  VlanTci = GigAdapter->TxVlanTci;
+  GigAdapter->TxVlanTci = 0;
+
+  // Make some short cut pointers so we don't have to worry about typecasting later.
+  // If the TX has fragments we will use the
+  // tx_tpr_f pointer, otherwise the tx_ptr_l (l is for linear)
+  TxBuffer  = (PXE_CPB_TRANSMIT *) (UINTN) Cpb;
+  TxFrags   = (PXE_CPB_TRANSMIT_FRAGMENTS *) (UINTN) Cpb;
+
+  // The media header is at the start of the frame or of its first fragment.
+  if (OpFlags & PXE_OPFLAGS_TRANSMIT_FRAGMENTED) {
+    tx_q = &GigAdapter->tx_queue[IntelgbeTxClassify (GigAdapter,
+             (UINT8 *) (UINTN) TxFrags->FragDesc[0].FragAddr,
+             TxFrags->FragDesc[0].FragLen)];
+  } else {
+    tx_q = &GigAdapter->tx_queue[IntelgbeTxClassify (GigAdapter,
+             (UINT8 *) (UINTN) TxBuffer->FrameAddr,
+             TxBuffer->DataLen + TxBuffer->MediaheaderLen)];
+  }
 
   if (tx_q->dirty_tx > tx_q->cur_tx)
     avail = tx_q->dirty_tx - tx_q->cur_tx - 1;
   else
     avail = DEFAULT_TX_DESCRIPTORS - tx_q->cur_tx +
                  tx_q->dirty_tx - 1;
- // Make some short cut pointers so we don't have to worry about typecasting later.
-  // If the TX has fragments we will use the
-  // tx_tpr_f pointer, otherwise the tx_ptr_l (l is for linear)
-  TxBuffer  = (PXE_CPB_TRANSMIT *) (UINTN) Cpb;
-  TxFrags   = (PXE_CPB_TRANSMIT_FRAGMENTS *) (UINTN) Cpb;
   needed_descs = (TxFrags->FragCnt == 0)? 1 : TxFrags->FragCnt;
+  if (VlanTci != 0) {
+    needed_descs++;
+  }
   // Transmit buffers must be freed by the upper layer before we can transmit any more.
   if (avail < needed_descs) {
+    INTELGBE_TRACE (GigAdapter, INTELGBE_TRACE_TX_RING_FULL, tx_q->queue_index,
+      tx_q->cur_tx, tx_q->dirty_tx, needed_descs);
     DEBUGWAIT (CRITICAL);
     // According to UEFI spec we should return PXE_STATCODE_BUFFER_FULL,
     // but SNP is not implemented to recognize this callback.
     return PXE_STATCODE_QUEUE_FULL;
   }
 
+  // Fragments are mapped before any descriptor is claimed, so a fragment the
+  // DMA cannot reach fails the frame without touching the ring.
+  if (OpFlags & PXE_OPFLAGS_TRANSMIT_FRAGMENTED) {
+    if (TxFrags->FragCnt > MAX_XMIT_FRAGMENTS) {
+      return PXE_STATCODE_INVALID_CPB;
+    }
+    for (i = 0; (i == 0) || (i < TxFrags->FragCnt); i++) {
+      FragAddr[i] = 0;
+      IntelgbeMapMem (
+        GigAdapter,
+        TxFrags->FragDesc[i].FragAddr,
+        TxFrags->FragDesc[i].FragLen,
+        (UINTN *) &FragAddr[i]
+      );
+      if ((TxFrags->FragDesc[i].FragLen != 0) &&
+          !IntelgbeDmaReachable (FragAddr[i], TxFrags->FragDesc[i].FragLen,
+             GigAdapter->Hw.mac.dma_addr_width)) {
+        INTELGBE_TRACE (GigAdapter, INTELGBE_TRACE_TX_MAP_FAIL, tx_q->queue_index,
+          tx_q->cur_tx, TxFrags->FragDesc[i].FragLen, 0);
+        return PXE_STATCODE_DEVICE_FAILURE;
+      }
+    }
+  }
+
+  start_tx = tx_q->cur_tx;
+
+  // The tag goes in a context descriptor ahead of the first data descriptor.
+  if (VlanTci != 0) {
+    desc = &tx_q->tx_desc[tx_q->cur_tx];
+    desc->des0 = 0;
+    desc->des1 = 0;
+    desc->des2 = 0;
+    desc->des3 = (VlanTci & TDES3_VLAN_TAG_MASK) | TDES3_VLAN_TAG_VALID |
+                 TDES3_CONTEXT_TYPE | TDES3_OWN;
+    tx_q->cur_tx++;
+    if (tx_q->cur_tx >= DEFAULT_TX_DESCRIPTORS) {
+      tx_q->cur_tx = 0;
+    }
+  }
+
   entry = tx_q->cur_tx;
+  TxBufMapping = &tx_q->buf_map[entry];
   // quicker pointer to the next available Tx descriptor to use.
   desc = &tx_q->tx_desc[entry];
   tx_q->cur_tx++;
@@ -344,7 +708,6 @@ IntelgbeTransmit (
   // of all frames sent.
   if (OpFlags & PXE_OPFLAGS_TRANSMIT_FRAGMENTED) {
       // this count cannot be more than 8;
-      DEBUGPRINT (CRITICAL, ("Fragments %x\n", TxFrags->FragCnt));
       first = desc;
     // for each fragment, give it a descriptor, being sure to keep track of the number used.
     for (i = 1; i < TxFrags->FragCnt; i++) {
@@ -354,13 +717,8 @@ IntelgbeTransmit (
         tx_q->cur_tx = 0;
       }
       // Put the size of the fragment in the descriptor
-      IntelgbeMapMem (
-        GigAdapter,
-        TxFrags->FragDesc[i].FragAddr,
-        TxFrags->FragDesc[i].FragLen,
-        (UINTN *) &desc->des0
-      );
-      desc->des1 = 0;
+      desc->des0 = lower_32_bits (FragAddr[i]);
+      desc->des1 = upper_32_bits (FragAddr[i]);
       desc->des2 = TxFrags->FragDesc[i].FragLen;
 
       UINT32 tdes3 = desc->des3;
@@ -377,14 +735,15 @@ IntelgbeTransmit (
     }
     desc = first;
     // Put the size of the fragment in the descriptor
-    IntelgbeMapMem (
-        GigAdapter,
-        TxFrags->FragDesc[0].FragAddr,
-        TxFrags->FragDesc[0].FragLen,
-        (UINTN *) &desc->des0
-    );
-    desc->des1 = 0;
+    desc->des0 = lower_32_bits (FragAddr[0]);
+    desc->des1 = upper_32_bits (FragAddr[0]);
     desc->des2 = TxFrags->FragDesc[0].FragLen;
+    if (VlanTci != 0) {
+      desc->des2 |= TDES2_VLAN_TAG_INSERT;
+    }
+    if (tx_q->tx_tstamp != NULL) {
+      desc->des2 |= TDES2_TIMESTAMP_ENABLE;
+    }
 
     UINT32 tdes3 = desc->des3;
     tdes3 = TxFrags->FrameLen + TxFrags->MediaheaderLen;
@@ -395,9 +754,10 @@ IntelgbeTransmit (
     tdes3 |= BIT(31);
     desc->des3 = tdes3;
 
-    tx_q->tx_tail_addr = (UINT32)(UINT64)tx_q->dma_tx +
+    IntelgbeTxSubmitTime (GigAdapter, tx_q);
+    tx_q->tx_tail_addr = lower_32_bits (tx_q->dma_tx) +
                          (tx_q->cur_tx * sizeof(INTELGBE_TRANSMIT_DESCRIPTOR));
-    INTELGBE_WRITE_REG (&GigAdapter->Hw, DMA_TXDESC_TAIL_PTR_CH(0),
+    INTELGBE_WRITE_REG (&GigAdapter->Hw, DMA_TXDESC_TAIL_PTR_CH(tx_q->queue_index),
       tx_q->tx_tail_addr);
   } else {
     TxBufMapping->UnmappedAddress = TxBuffer->FrameAddr;
@@ -407,20 +767,32 @@ IntelgbeTransmit (
                GigAdapter->PciIo,
                TxBufMapping
                );
-    if (Status != EFI_SUCCESS) {
-      DEBUGPRINT (INTELGBE, ("TX DMA mapping failed\n"));
-    }
-
-    if (TxBufMapping->Size != RequestedSize) {
-      DEBUGPRINT (CRITICAL, ("Failed to map whole DMA area. \
-        Requested: %d, Obtained: %d\n", RequestedSize, TxBufMapping->Size));
+    if ((Status != EFI_SUCCESS) || (TxBufMapping->Size != RequestedSize)) {
+      INTELGBE_TRACE (GigAdapter, INTELGBE_TRACE_TX_MAP_FAIL, tx_q->queue_index,
+        entry, RequestedSize, TxBufMapping->Size);
       DEBUGWAIT (CRITICAL);
     }
+    if ((Status == EFI_SUCCESS) &&
+        !IntelgbeDmaReachable (TxBufMapping->PhysicalAddress, TxBufMapping->Size,
+           GigAdapter->Hw.mac.dma_addr_width)) {
+      // Give the descriptors back, the tail pointer has not moved past them.
+      INTELGBE_TRACE (GigAdapter, INTELGBE_TRACE_TX_MAP_FAIL, tx_q->queue_index,
+        entry, RequestedSize, 0);
+      UndiDmaUnmapMemory (GigAdapter->PciIo, TxBufMapping);
+      tx_q->cur_tx = start_tx;
+      return PXE_STATCODE_DEVICE_FAILURE;
+    }
 
-    desc->des0 = (UINT32)TxBufMapping->PhysicalAddress;
-    desc->des1 = 0;
+    desc->des0 = lower_32_bits (TxBufMapping->PhysicalAddress);
+    desc->des1 = upper_32_bits (TxBufMapping->PhysicalAddress);
     desc->des2 = (UINT32)TxBufMapping->Size;
     desc->des2 |= (BIT(31));
+    if (VlanTci != 0) {
+      desc->des2 |= TDES2_VLAN_TAG_INSERT;
+    }
+    if (tx_q->tx_tstamp != NULL) {
+      desc->des2 |= TDES2_TIMESTAMP_ENABLE;
+    }
 
     UINT32 tdes3 = desc->des3;
     tdes3 = (UINT32)TxBufMapping->Size;
@@ -431,15 +803,66 @@ IntelgbeTransmit (
     tdes3 = desc->des3;
     tdes3 |= BIT(31);
     desc->des3 = tdes3;
-    tx_q->tx_tail_addr = (UINT32)(UINT64)tx_q->dma_tx +
+    IntelgbeTxSubmitTime (GigAdapter, tx_q);
+    tx_q->tx_tail_addr = lower_32_bits (tx_q->dma_tx) +
                           (tx_q->cur_tx * sizeof(INTELGBE_TRANSMIT_DESCRIPTOR));
-    INTELGBE_WRITE_REG (&GigAdapter->Hw, DMA_TXDESC_TAIL_PTR_CH(0),
+    INTELGBE_WRITE_REG (&GigAdapter->Hw, DMA_TXDESC_TAIL_PTR_CH(tx_q->queue_index),
       tx_q->tx_tail_addr);
   }
- // If the OpFlags tells us to wait for the packet to hit the wire, we will wait.
-  if ((OpFlags & PXE_OPFLAGS_TRANSMIT_BLOCK) != 0) {
-      DEBUGPRINT (INTELGBE, ("Wait for Transmit to complete\n"));
+  if (OpFlags & PXE_OPFLAGS_TRANSMIT_FRAGMENTED) {
+    INTELGBE_CAPTURE_FRAGMENTS (GigAdapter, TxFrags);
+  } else {
+    INTELGBE_CAPTURE_FRAME (GigAdapter, INTELGBE_CAPTURE_TX,
+      (UINT8 *) (UINTN) TxBuffer->FrameAddr,
+      TxBuffer->DataLen + TxBuffer->MediaheaderLen);
   }
+  INTELGBE_TRACE (GigAdapter, INTELGBE_TRACE_TX_SUBMIT, tx_q->queue_index, entry,
+    (OpFlags & PXE_OPFLAGS_TRANSMIT_FRAGMENTED) ?
+      (TxFrags->FrameLen + TxFrags->MediaheaderLen) :
+      (TxBuffer->DataLen + TxBuffer->MediaheaderLen),
+    needed_descs);
+  return PXE_STATCODE_SUCCESS;
+}
+
+/** Applies the link speed and duplex requested through the Initialize CPB.
+
+   A LinkSpeed of 0 selects auto-negotiation.
+
+   @param[in]   GigAdapter   Pointer to adapter structure
+
+   @retval   PXE_STATCODE_SUCCESS         Link mode applied
+   @retval   PXE_STATCODE_INVALID_CPB     Speed or duplex not supported
+   @retval   PXE_STATCODE_DEVICE_FAILURE  PHY could not be reconfigured
+**/
+STATIC
+PXE_STATCODE
+IntelgbeSetSpeedDuplex (
+  GIG_DRIVER_DATA *GigAdapter
+  )
+{
+  struct intelgbe_hw *Hw;
+  BOOLEAN            AutoNeg;
+  BOOLEAN            FullDuplex;
+  UINT32             Mode;
+
+  Hw         = &GigAdapter->Hw;
+  AutoNeg    = (GigAdapter->LinkSpeed == 0);
+  FullDuplex = ((GigAdapter->DuplexMode & PXE_FORCE_HALF_DUPLEX) == 0);
+
+  if (!AutoNeg) {
+    Mode = mii_phy_forced_mode (GigAdapter->LinkSpeed, FullDuplex);
+    if ((Hw->phy.support & Mode) == 0) {
+      DEBUGPRINT (CRITICAL, ("Unsupported forced link %d Mbps, duplex %x\n",
+        GigAdapter->LinkSpeed, GigAdapter->DuplexMode));
+      return PXE_STATCODE_INVALID_CPB;
+    }
+  }
+
+  if (intelgbe_set_link_mode (Hw, AutoNeg, GigAdapter->LinkSpeed, FullDuplex) != INTELGBE_SUCCESS) {
+    DEBUGPRINT (CRITICAL, ("intelgbe_set_link_mode failed\n"));
+    return PXE_STATCODE_DEVICE_FAILURE;
+  }
+
   return PXE_STATCODE_SUCCESS;
 }
 
@@ -448,8 +871,11 @@ IntelgbeTransmit (
 
    @param[in]   GigAdapter   Pointer to adapter structure
 
-   @retval   PXE_STATCODE_SUCCESS       Initialization succeeded
-   @retval   PXE_STATCODE_NOT_STARTED   Hardware Init failed
+   @retval   PXE_STATCODE_SUCCESS         Initialization succeeded
+   @retval   PXE_STATCODE_NOT_STARTED     Hardware Init failed
+   @retval   PXE_STATCODE_INVALID_CPB     Requested link speed/duplex or loopback
+                                          not supported
+   @retval   PXE_STATCODE_DEVICE_FAILURE  PHY could not be reconfigured
 **/
 PXE_STATCODE
 IntelgbeInititialize (
@@ -463,7 +889,11 @@ IntelgbeInititialize (
   PxeStatcode = PXE_STATCODE_SUCCESS;
   DEBUGWAIT (INTELGBE);
 
-  //IntelgbeSetSpeedDuplex (GigAdapter);
+  PxeStatcode = IntelgbeSetSpeedDuplex (GigAdapter);
+  if (PxeStatcode != PXE_STATCODE_SUCCESS) {
+    return PxeStatcode;
+  }
+
  // If the hardware has already been initialized then don't bother with a reset
   // We want to make sure we do not have to restart autonegotiation and two-pair
   // downshift.
@@ -489,6 +919,10 @@ IntelgbeInititialize (
     DEBUGPRINT (CRITICAL, ("Could not read MAC address.\n"));
   }
 
+  if (PxeStatcode == PXE_STATCODE_SUCCESS) {
+    PxeStatcode = IntelgbeSetLoopBack (GigAdapter, GigAdapter->LoopBack);
+  }
+
   DEBUGWAIT (INTELGBE);
 
   return PxeStatcode;
@@ -512,6 +946,9 @@ IntelgbePciInit (
   EFI_STATUS Status;
   UINT64     Result = 0;
   BOOLEAN    PciAttributesSaved = FALSE;
+  UINT32     HwFeature1 = 0;
+  UINT32     DmaAddrWidth = 32;
+  UINT32     i;
 
   // Save original PCI attributes
   Status = GigAdapter->PciIo->Attributes (
@@ -543,8 +980,7 @@ IntelgbePciInit (
     Status = GigAdapter->PciIo->Attributes (
                                   GigAdapter->PciIo,
                                   EfiPciIoAttributeOperationEnable,
-                                  Result & (EFI_PCI_DEVICE_ENABLE |
-                                  EFI_PCI_IO_ATTRIBUTE_DUAL_ADDRESS_CYCLE),
+                                  Result & EFI_PCI_DEVICE_ENABLE,
                                   NULL
                                 );
   }
@@ -554,6 +990,32 @@ IntelgbePciInit (
     goto PciIoError;
   }
 
+  // Let PciIo hand out buffers above 4GB only when the DMA can reach them,
+  // otherwise they would be bounced through low memory on every map.
+  if ((Result & EFI_PCI_IO_ATTRIBUTE_DUAL_ADDRESS_CYCLE) != 0) {
+    Status = GigAdapter->PciIo->Mem.Read (
+                                  GigAdapter->PciIo,
+                                  EfiPciIoWidthUint32,
+                                  0,
+                                  MAC_HW_FEATURE1,
+                                  1,
+                                  &HwFeature1
+                                );
+    if (!EFI_ERROR (Status) && (intelgbe_dma_addr_width (HwFeature1) > 32)) {
+      Status = GigAdapter->PciIo->Attributes (
+                                    GigAdapter->PciIo,
+                                    EfiPciIoAttributeOperationEnable,
+                                    EFI_PCI_IO_ATTRIBUTE_DUAL_ADDRESS_CYCLE,
+                                    NULL
+                                  );
+      if (!EFI_ERROR (Status)) {
+        DmaAddrWidth = intelgbe_dma_addr_width (HwFeature1);
+      }
+    }
+    DEBUGPRINT (INIT, ("DMA address width %d, dual address cycle %r\n",
+      intelgbe_dma_addr_width (HwFeature1), Status));
+  }
+
   // Allocate common DMA buffer for Tx descriptors
   GigAdapter->TxRing.Size = TX_RING_SIZE;
 
@@ -578,6 +1040,17 @@ IntelgbePciInit (
     goto OnAllocError;
   }
 
+  // Tail pointers take their upper address bits from the ring base, so no
+  // ring may straddle a 4GB boundary.
+  if ((upper_32_bits (GigAdapter->TxRing.PhysicalAddress) !=
+       upper_32_bits (GigAdapter->TxRing.PhysicalAddress + TX_RING_SIZE - 1)) ||
+      (upper_32_bits (GigAdapter->RxRing.PhysicalAddress) !=
+       upper_32_bits (GigAdapter->RxRing.PhysicalAddress + RX_RING_SIZE - 1))) {
+    DEBUGPRINT (CRITICAL, ("Descriptor ring crosses a 4GB boundary\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto OnAllocError;
+  }
+
   // Allocate common DMA buffer for Rx buffers
   GigAdapter->RxBufferMapping.Size = RX_BUFFERS_SIZE;
 
@@ -590,6 +1063,31 @@ IntelgbePciInit (
     goto OnAllocError;
   }
 
+  // Dual address cycles let PciIo place the rings above what the DMA drives.
+  if (!IntelgbeDmaReachable (GigAdapter->TxRing.PhysicalAddress, TX_RING_SIZE, DmaAddrWidth) ||
+      !IntelgbeDmaReachable (GigAdapter->RxRing.PhysicalAddress, RX_RING_SIZE, DmaAddrWidth) ||
+      !IntelgbeDmaReachable (GigAdapter->RxBufferMapping.PhysicalAddress, RX_BUFFERS_SIZE,
+         DmaAddrWidth)) {
+    DEBUGPRINT (CRITICAL, ("DMA buffers above the %d-bit DMA address limit\n", DmaAddrWidth));
+    Status = EFI_UNSUPPORTED;
+    goto OnAllocError;
+  }
+
+  // TX buffer mappings are only touched one entry per frame, keep them out
+  // of the adapter structure so they do not push the hot fields apart.
+  GigAdapter->TxBufferMappings = AllocateZeroPool (
+                                   sizeof (UNDI_DMA_MAPPING) * DEFAULT_TX_DESCRIPTORS *
+                                   INTELGBE_MAX_TX_QUEUES
+                                   );
+  if (GigAdapter->TxBufferMappings == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto OnAllocError;
+  }
+  for (i = 0; i < INTELGBE_MAX_TX_QUEUES; i++) {
+    GigAdapter->tx_queue[i].buf_map =
+      &GigAdapter->TxBufferMappings[i * DEFAULT_TX_DESCRIPTORS];
+  }
+
   ZeroMem (
     (VOID *) GigAdapter->RxRing.UnmappedAddress,
     RX_RING_SIZE
@@ -621,6 +1119,11 @@ OnAllocError:
           &GigAdapter->RxBufferMapping);
       }
 
+      if (GigAdapter->TxBufferMappings != NULL) {
+        FreePool (GigAdapter->TxBufferMappings);
+        GigAdapter->TxBufferMappings = NULL;
+      }
+
 PciIoError:
   if (PciAttributesSaved) {
 
@@ -655,9 +1158,11 @@ IntelgbeFirstTimeInit (
   GIG_DRIVER_DATA *GigAdapter
   )
 {
+  UINT32             PciConfig[MAX_PCI_CONFIG_LEN];
   PCI_CONFIG_HEADER *PciConfigHeader;
   UINT32 *           TempBar;
   UINT8              BarIndex;
+  UINT32             i;
   struct intelgbe_hw *hw = &GigAdapter->Hw;
   struct intelgbe_phy_info *phy = &hw->phy;
 
@@ -669,10 +1174,10 @@ IntelgbeFirstTimeInit (
                            EfiPciIoWidthUint32,
                            0,
                            MAX_PCI_CONFIG_LEN,
-                           GigAdapter->PciConfig
+                           PciConfig
                          );
 
-  PciConfigHeader = (PCI_CONFIG_HEADER *) GigAdapter->PciConfig;
+  PciConfigHeader = (PCI_CONFIG_HEADER *) PciConfig;
 
   // Enumerate through the PCI BARs for the device to determine which one is
   // the IO BAR.  Save the index of the BAR into the adapter info structure.
@@ -821,7 +1326,10 @@ IntelgbeFirstTimeInit (
     DEBUGPRINT (INTELGBE, ("intelgbe_init_hw success\n"));
     GigAdapter->HwInitialized = TRUE;
   }
-  GigAdapter->tx_queue[0].cur_tx = 0;
+  for (i = 0; i < GigAdapter->txqnum; i++) {
+    GigAdapter->tx_queue[i].cur_tx   = 0;
+    GigAdapter->tx_queue[i].dirty_tx = 0;
+  }
   GigAdapter->rx_queue[0].cur_rx = 0;
 
   return EFI_SUCCESS;
@@ -874,70 +1382,155 @@ IntelgbeWaitForAutoNeg (
     return TRUE;
   }
 
+  if (GigAdapter->LoopBack != LOOPBACK_NORMAL) {
+    // Frames never leave the adapter, there is no partner to wait for.
+    DEBUGPRINT (INIT, ("Loopback, no link needed.\n"));
+    return TRUE;
+  }
+
   DEBUGPRINT (INIT, ("Return %d\n", AutoNegComplete));
   DEBUGWAIT (INIT);
   return AutoNegComplete;
 }
 
-/** This is the drivers copy function so it does not need to rely on the BootServices
-   copy which goes away at runtime.
+/** Compares two MAC addresses without byte-wise branching.
+
+   @param[in]   a   Pointer to first MAC address
+   @param[in]   b   Pointer to second MAC address
+
+   @retval   TRUE    Addresses are equal
+   @retval   FALSE   Addresses differ
+**/
+STATIC
+BOOLEAN
+IntelgbeMacEqual (
+  IN CONST UINT8 *a,
+  IN CONST UINT8 *b
+  )
+{
+  return ((ReadUnaligned32 ((CONST UINT32 *) a) ^ ReadUnaligned32 ((CONST UINT32 *) b)) |
+          (ReadUnaligned16 ((CONST UINT16 *) (a + 4)) ^
+           ReadUnaligned16 ((CONST UINT16 *) (b + 4)))) == 0;
+}
+
+/** Determines the PXE frame type of a received frame.
 
-   This copy function allows 64-bit or 32-bit copies
-   depending on platform architecture.  On Itanium we must check that both addresses
-   are naturally aligned before attempting a 64-bit copy.
+   The MAC has already run the frame through its DA filters and reports the
+   result in the RX write-back descriptor. Unicast frames only get past the
+   filter by matching the station address, and multicast frames matched via
+   the hash table are flagged as such, so in the common case only the group
+   bit of the destination is looked at. When RDES2 is not valid the station
+   address is compared directly.
 
-   @param[in]   Dest     Destination memory pointer to copy data to.
-   @param[in]   Source   Source memory pointer.
-   @param[in]   Count    Number of bytes to copy
+   @param[in]   GigAdapter   Pointer to the NIC data structure information
+                             which the UNDI driver is layering on.
+   @param[in]   Rdes2        Write-back RDES2 of the last descriptor
+   @param[in]   Rdes3        Write-back RDES3 of the last descriptor
+   @param[in]   DestAddr     Destination MAC address of the frame
 
-   @return    Memory copied from source to destination
+   @return   PXE_FRAME_TYPE of the frame
 **/
-VOID
-IntelgbeMemCopy (
-  IN UINT8* Dest,
-  IN UINT8* Source,
-  IN UINT32 Count
+STATIC
+PXE_FRAME_TYPE
+IntelgbeClassifyFrame (
+  IN GIG_DRIVER_DATA *GigAdapter,
+  IN UINT32           Rdes2,
+  IN UINT32           Rdes3,
+  IN CONST UINT8 *    DestAddr
   )
 {
-  UINT32 BytesToCopy;
-  UINT32 IntsToCopy;
-  UINTN* SourcePtr;
-  UINTN* DestPtr;
-  UINT8* SourceBytePtr;
-  UINT8* DestBytePtr;
-
-  IntsToCopy = Count / sizeof (UINTN);
-  BytesToCopy = Count % sizeof (UINTN);
-#ifdef EFI64
-
-  // Itanium cannot handle memory accesses that are not naturally aligned.  Determine
-  // if 64-bit copy is even possible with these start addresses.
-  if (((((UINTN) Source) & 0x0007) != 0)
-    || (( ((UINTN) Dest) & 0x0007) != 0))
-  {
-    IntsToCopy = 0;
-    BytesToCopy = Count;
+  BOOLEAN FilterValid;
+
+  FilterValid = (Rdes3 & RDES3_RDES2_VALID) != 0;
+
+  if ((DestAddr[0] & 1) == 0) {
+    if ((FilterValid && ((Rdes2 & RDES2_DA_FILTER_FAIL) == 0))
+      || IntelgbeMacEqual (DestAddr, GigAdapter->Hw.mac.addr))
+    {
+      return PXE_FRAME_TYPE_UNICAST;
+    }
+    return PXE_FRAME_TYPE_PROMISCUOUS;
   }
-#endif /* EFI64 */
 
-  SourcePtr = (UINTN *) Source;
-  DestPtr = (UINTN *) Dest;
+  if (FilterValid && ((Rdes2 & RDES2_HASH_FILTER_STATUS) != 0)) {
+    return PXE_FRAME_TYPE_MULTICAST;
+  }
 
-  while (IntsToCopy > 0) {
-    *DestPtr = *SourcePtr;
-    SourcePtr++;
-    DestPtr++;
-    IntsToCopy--;
+  if (IntelgbeMacEqual (DestAddr, GigAdapter->BroadcastNodeAddress)) {
+    return PXE_FRAME_TYPE_BROADCAST;
   }
 
-  // Copy the leftover bytes.
-  SourceBytePtr = (UINT8 *) SourcePtr;
-  DestBytePtr = (UINT8 *) DestPtr;
-  while (BytesToCopy > 0) {
-    *DestBytePtr = *SourceBytePtr;
-    SourceBytePtr++;
-    DestBytePtr++;
-    BytesToCopy--;
+  return PXE_FRAME_TYPE_MULTICAST;
+}
+
+/** Gives an RX descriptor back to the hardware and moves the tail pointer past it.
+
+   @param[in]   GigAdapter   Pointer to the driver data
+   @param[in]   rx_q         RX queue owning the descriptor
+   @param[in]   entry        Index of the descriptor to re-arm
+**/
+STATIC
+VOID
+IntelgbeRxRefill (
+  GIG_DRIVER_DATA          *GigAdapter,
+  struct intelgbe_rx_queue *rx_q,
+  UINT32                    entry
+  )
+{
+  INTELGBE_RECEIVE_DESCRIPTOR *desc = &rx_q->rx_desc[entry];
+
+  desc->des0 = lower_32_bits(&rx_q->dma_rx_buff[entry]);
+  desc->des1 = upper_32_bits(&rx_q->dma_rx_buff[entry]);
+  desc->des2 = 0;
+  desc->des3 = (BIT(31) | BIT(30) | BIT(24));
+  /* Initialize RX descriptor ring tail pointer */
+  rx_q->rx_tail_addr = lower_32_bits(&rx_q->dma_rx[entry]);
+  INTELGBE_WRITE_REG(&GigAdapter->Hw, DMA_RXDESC_TAIL_PTR_CH(0),
+    rx_q->rx_tail_addr);
+}
+
+/** Consumes the timestamp context descriptor that follows a received frame.
+
+   If the MAC has not written the context descriptor back yet it is left in place
+   and IntelgbeReceive drops it on a later call.
+
+   @param[in]   GigAdapter   Pointer to the driver data
+   @param[in]   rx_q         RX queue, cur_rx at the context descriptor
+   @param[in]   Now          System time IntelgbeReceive was entered, 0 to only
+                             consume the descriptor
+**/
+STATIC
+VOID
+IntelgbeRxTimestamp (
+  GIG_DRIVER_DATA          *GigAdapter,
+  struct intelgbe_rx_queue *rx_q,
+  UINT64                    Now
+  )
+{
+  INTELGBE_RECEIVE_DESCRIPTOR *ctx;
+  UINT32                       entry;
+  UINT64                       WireTime;
+
+  entry = rx_q->cur_rx;
+  ctx   = &rx_q->rx_desc[entry];
+  if ((ctx->des3 & (RDES3_OWN | RDES3_CONTEXT_TYPE)) != RDES3_CONTEXT_TYPE) {
+    return;
+  }
+
+  // All ones marks a timestamp the MAC could not capture.
+  if ((Now != 0)
+    && ((ctx->des0 != 0xFFFFFFFF) || (ctx->des1 != 0xFFFFFFFF)))
+  {
+    WireTime = MultU64x32 (ctx->des1, 1000000000) + ctx->des0;
+    if (Now >= WireTime) {
+      IntelgbeLatencyAdd (&GigAdapter->WireToReceive, Now - WireTime);
+    }
+  }
+
+  IntelgbeRxRefill (GigAdapter, rx_q, entry);
+  rx_q->cur_rx++;
+  if (rx_q->cur_rx >= DEFAULT_RX_DESCRIPTORS) {
+    rx_q->cur_rx = 0;
   }
 }
 
@@ -980,6 +1573,7 @@ IntelgbeReceive (
   struct intelgbe_rx_queue   *rx_q = &GigAdapter->rx_queue[0];
   UINT32 entry;
   int frame_len;
+  UINT64 Now;
 
 
   PacketType  = PXE_FRAME_TYPE_NONE;
@@ -993,31 +1587,43 @@ IntelgbeReceive (
   //ReceiveDescriptor = INTELGBE_RX_DESC (&GigAdapter->RxRing, GigAdapter->CurRxInd); // AR check unmapped
   entry = rx_q->cur_rx;
   desc  = &rx_q->rx_desc[entry];
-  if(!(desc->des3 & BIT(31))) {
+  Now   = 0;
+  if (rx_q->tstamp) {
+    Now = intelgbe_get_systime (&GigAdapter->Hw);
+  }
+
+  // A context descriptor written back after its frame was consumed.
+  if ((desc->des3 & (RDES3_OWN | RDES3_CONTEXT_TYPE)) == RDES3_CONTEXT_TYPE) {
+    IntelgbeRxTimestamp (GigAdapter, rx_q, 0);
+    entry = rx_q->cur_rx;
+    desc  = &rx_q->rx_desc[entry];
+  }
+
+  if(!(desc->des3 & RDES3_OWN)) {
+    UINT32 rdes1 = desc->des1;
     UINT32 rdes2 = desc->des2;
     UINT32 rdes3 = desc->des3;
     s32 ret = 0;
 
-    if (!(rdes3 & BIT(28))) {
-      DEBUGPRINT (CRITICAL, ("Not Last descriptor\n"));
+    if (!(rdes3 & RDES3_LAST_DESCRIPTOR)) {
       ret = -1;
     }
-    if (rdes3 & (BIT(23) | BIT(24))) {
-      DEBUGPRINT (CRITICAL, ("rdes3 status Error"));
-      DEBUGPRINT (CRITICAL, (" desc->des3 %x, entry %d\n", desc->des3, entry));
+    if (rdes3 & (RDES3_GIANT_PACKET | RDES3_CRC_ERROR)) {
       ret = -1;
     }
-    if (rdes2 & (BIT(16) | BIT(17))) {
-      DEBUGPRINT (CRITICAL, ("rdes2 status Error\n"));
+    if (rdes2 & (RDES2_SA_FILTER_FAIL | RDES2_DA_FILTER_FAIL)) {
       ret = -1;
     }
+    if (ret) {
+      INTELGBE_TRACE (GigAdapter, INTELGBE_TRACE_RX_ERROR, entry, rdes2, rdes3, 0);
+    }
     rx_q->cur_rx++;
     if (rx_q->cur_rx >= DEFAULT_RX_DESCRIPTORS) {
       rx_q->cur_rx = 0;
     }
 
     if (!ret) {
-      frame_len = rdes3 & 0x7FFF;
+      frame_len = rdes3 & RDES3_PACKET_SIZE_MASK;
       if (frame_len > (INT16) CpbReceive->BufferLen) {
         frame_len = (UINT16) CpbReceive->BufferLen;
       }
@@ -1027,26 +1633,28 @@ IntelgbeReceive (
            (UINT8 *) (UINTN) &rx_q->rx_buff[entry],
            frame_len
       );
+      // Capture the frame as received, not as cut to the caller's buffer.
+      INTELGBE_CAPTURE_FRAME (GigAdapter, INTELGBE_CAPTURE_RX,
+        (UINT8 *) (UINTN) &rx_q->rx_buff[entry],
+        rdes3 & RDES3_PACKET_SIZE_MASK);
       DbReceive->FrameLen       = frame_len;  // includes header
       DbReceive->MediaHeaderLen = PXE_MAC_HEADER_LEN_ETHER;
-      EtherHeader = (ETHER_HEADER *) (UINTN) &rx_q->rx_buff[entry];
 
-      // Obtain packet type from MAC address
-      if (CompareMem(EtherHeader->DestAddr, GigAdapter->Hw.mac.perm_addr, PXE_HWADDR_LEN_ETHER) == 0) {
-        DEBUGPRINT(DECODE, ("Unicast packet\n"));
-        PacketType = PXE_FRAME_TYPE_UNICAST;
-      }
-      else if (CompareMem(EtherHeader->DestAddr, GigAdapter->BroadcastNodeAddress, PXE_HWADDR_LEN_ETHER) == 0) {
-        DEBUGPRINT(DECODE, ("Broadcast packet\n"));
-        PacketType = PXE_FRAME_TYPE_BROADCAST;
+      // Parse the header out of the copy we just made, it is still in cache.
+      // Fall back to the ring buffer only when the caller's buffer is too short.
+      if (frame_len >= PXE_MAC_HEADER_LEN_ETHER) {
+        EtherHeader = (ETHER_HEADER *) (UINTN) CpbReceive->BufferAddr;
+      } else {
+        EtherHeader = (ETHER_HEADER *) (UINTN) &rx_q->rx_buff[entry];
       }
-      else if (BIT_TEST(EtherHeader->DestAddr[0], 1)) {
-        DEBUGPRINT(DECODE, ("Multicast packet\n"));
-        PacketType = PXE_FRAME_TYPE_MULTICAST;
-      }
-      else {
-        DEBUGPRINT(DECODE, ("Promiscuous packet\n"));
-        PacketType = PXE_FRAME_TYPE_PROMISCUOUS;
+
+      PacketType = IntelgbeClassifyFrame (GigAdapter, rdes2, rdes3, EtherHeader->DestAddr);
+
+      // While VLANs are enabled the MAC strips the outer tag and reports it in RDES0.
+      if (rdes3 & RDES3_RDES0_VALID) {
+        GigAdapter->RxVlanTci = (UINT16) (desc->des0 & RDES0_OUTER_VLAN_TAG_MASK);
+      } else {
+        GigAdapter->RxVlanTci = 0;
       }
 
       DbReceive->Type = PacketType;
@@ -1056,20 +1664,346 @@ IntelgbeReceive (
 
       INTELGBE_COPY_MAC (DbReceive->SrcAddr, EtherHeader->SrcAddr);
       INTELGBE_COPY_MAC (DbReceive->DestAddr, EtherHeader->DestAddr);
+      INTELGBE_TRACE (GigAdapter, INTELGBE_TRACE_RX_FRAME, entry, frame_len,
+        PacketType, rdes3);
+    }
+    IntelgbeRxRefill (GigAdapter, rx_q, entry);
+
+    // The frame's RX timestamp follows in a context descriptor.
+    if (rdes1 & RDES1_TIMESTAMP_AVAILABLE) {
+      IntelgbeRxTimestamp (GigAdapter, rx_q, (ret == 0) ? Now : 0);
     }
-    desc->des0 = (u32)(u64)&rx_q->dma_rx_buff[entry];
-    desc->des1 = 0;
-    desc->des2 = 0;
-    desc->des3 = (BIT(31) | BIT(30) | BIT(24));
-    /* Initialize RX descriptor ring tail pointer */
-    rx_q->rx_tail_addr = (u32)(u64)desc;
-    INTELGBE_WRITE_REG(&GigAdapter->Hw, DMA_RXDESC_TAIL_PTR_CH(0),
-      rx_q->rx_tail_addr);
     StatCode = PXE_STATCODE_SUCCESS;
   }
   return StatCode;
 }
 
+/** Starts or stops RX/TX timestamping for the latency profile.
+
+   Starting clears the profile collected so far.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+   @param[in]   Enable       TRUE to timestamp every frame
+
+   @retval   EFI_SUCCESS            Timestamping state changed
+   @retval   EFI_UNSUPPORTED        MAC has no timestamping unit
+   @retval   EFI_OUT_OF_RESOURCES   Could not allocate TX submit times
+   @retval   EFI_DEVICE_ERROR       System time counter failed to start
+**/
+EFI_STATUS
+IntelgbeSetTimestamping (
+  GIG_DRIVER_DATA *GigAdapter,
+  BOOLEAN          Enable
+  )
+{
+  struct intelgbe_tx_queue *tx_q;
+  struct intelgbe_rx_queue *rx_q = &GigAdapter->rx_queue[0];
+  UINT32                    i;
+
+  if (!GigAdapter->Hw.mac.tstamp) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (Enable) {
+    for (i = 0; i < GigAdapter->txqnum; i++) {
+      tx_q = &GigAdapter->tx_queue[i];
+      if (tx_q->tx_tstamp == NULL) {
+        tx_q->tx_tstamp = AllocateZeroPool (sizeof (UINT64) * DEFAULT_TX_DESCRIPTORS);
+        if (tx_q->tx_tstamp == NULL) {
+          return EFI_OUT_OF_RESOURCES;
+        }
+      }
+    }
+    ZeroMem (&GigAdapter->WireToReceive, sizeof (INTELGBE_LATENCY_STATS));
+    ZeroMem (&GigAdapter->TransmitToWire, sizeof (INTELGBE_LATENCY_STATS));
+    GigAdapter->WireToReceive.MinNs  = MAX_UINT64;
+    GigAdapter->TransmitToWire.MinNs = MAX_UINT64;
+  }
+
+  // Before Initialize the setting is only recorded, init_hw applies it.
+  if (GigAdapter->State == PXE_STATFLAGS_GET_STATE_INITIALIZED) {
+    if (intelgbe_config_tstamp (&GigAdapter->Hw, Enable) != INTELGBE_SUCCESS) {
+      DEBUGPRINT (CRITICAL, ("intelgbe_config_tstamp failed\n"));
+      return EFI_DEVICE_ERROR;
+    }
+  } else {
+    GigAdapter->Hw.mac.tstamp_en = Enable;
+  }
+  rx_q->tstamp = Enable;
+
+  for (i = 0; !Enable && (i < GigAdapter->txqnum); i++) {
+    tx_q = &GigAdapter->tx_queue[i];
+    if (tx_q->tx_tstamp != NULL) {
+      FreePool (tx_q->tx_tstamp);
+      tx_q->tx_tstamp = NULL;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/** Selects the low-latency or power-save link profile.
+
+   Switching an initialized adapter restarts auto-negotiation when the EEE
+   advertisement changes.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+   @param[in]   Profile      INTELGBE_ADAPTER_INFO_LINK_PROFILE_* value
+
+   @retval   EFI_SUCCESS             Profile applied
+   @retval   EFI_INVALID_PARAMETER   Unknown profile
+   @retval   EFI_UNSUPPORTED         MAC has no EEE support
+   @retval   EFI_DEVICE_ERROR        PHY could not be reconfigured
+**/
+EFI_STATUS
+IntelgbeSetLinkProfile (
+  GIG_DRIVER_DATA *GigAdapter,
+  UINT32           Profile
+  )
+{
+  if ((Profile != INTELGBE_LINK_PROFILE_LOW_LATENCY)
+    && (Profile != INTELGBE_LINK_PROFILE_POWER_SAVE))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if ((Profile == INTELGBE_LINK_PROFILE_POWER_SAVE)
+    && !GigAdapter->Hw.mac.eee)
+  {
+    return EFI_UNSUPPORTED;
+  }
+
+  // Before Initialize the profile is only recorded, PHY and MAC init apply it.
+  if (GigAdapter->State == PXE_STATFLAGS_GET_STATE_INITIALIZED) {
+    if (intelgbe_set_link_profile (&GigAdapter->Hw, Profile) != INTELGBE_SUCCESS) {
+      DEBUGPRINT (CRITICAL, ("intelgbe_set_link_profile failed\n"));
+      return EFI_DEVICE_ERROR;
+    }
+  } else {
+    GigAdapter->Hw.mac.link_profile = (enum intelgbe_link_profile) Profile;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/** Selects which 802.3x pause directions are advertised.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+   @param[in]   FlowControl  INTELGBE_ADAPTER_INFO_FC_* bits
+
+   @retval   EFI_SUCCESS             Flow control applied
+   @retval   EFI_INVALID_PARAMETER   Unknown bits set
+   @retval   EFI_DEVICE_ERROR        PHY could not be reconfigured
+**/
+EFI_STATUS
+IntelgbeSetFlowControl (
+  GIG_DRIVER_DATA *GigAdapter,
+  UINT32           FlowControl
+  )
+{
+  UINT32 Fc;
+
+  if ((FlowControl & ~(INTELGBE_ADAPTER_INFO_FC_RX | INTELGBE_ADAPTER_INFO_FC_TX)) != 0) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Fc = 0;
+  if ((FlowControl & INTELGBE_ADAPTER_INFO_FC_RX) != 0) {
+    Fc |= INTELGBE_FC_RX;
+  }
+  if ((FlowControl & INTELGBE_ADAPTER_INFO_FC_TX) != 0) {
+    Fc |= INTELGBE_FC_TX;
+  }
+
+  // Before Initialize the setting is only recorded, PHY and MAC init apply it.
+  if (GigAdapter->State == PXE_STATFLAGS_GET_STATE_INITIALIZED) {
+    if (intelgbe_set_flow_ctrl (&GigAdapter->Hw, Fc) != INTELGBE_SUCCESS) {
+      DEBUGPRINT (CRITICAL, ("intelgbe_set_flow_ctrl failed\n"));
+      return EFI_DEVICE_ERROR;
+    }
+  } else {
+    GigAdapter->Hw.mac.fc_requested = Fc;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/** Selects the MTL scheduling algorithm between the TX queues.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+   @param[in]   Algorithm    INTELGBE_ADAPTER_INFO_TX_SCHED_* value
+   @param[in]   Weight       Per queue weights, txqnum entries, ignored for
+                             strict priority
+
+   @retval   EFI_SUCCESS             Scheduling applied
+   @retval   EFI_INVALID_PARAMETER   Unknown algorithm or a zero weight
+   @retval   EFI_DEVICE_ERROR        MTL could not be reconfigured
+**/
+EFI_STATUS
+IntelgbeSetTxScheduling (
+  GIG_DRIVER_DATA *GigAdapter,
+  UINT32           Algorithm,
+  UINT32          *Weight
+  )
+{
+  UINT32 Sched;
+  UINT32 i;
+
+  switch (Algorithm) {
+  case INTELGBE_ADAPTER_INFO_TX_SCHED_SP:
+    Sched = MTL_OPR_MD_SCHALG_SP;
+    break;
+  case INTELGBE_ADAPTER_INFO_TX_SCHED_WRR:
+    Sched = MTL_OPR_MD_SCHALG_WRR;
+    break;
+  case INTELGBE_ADAPTER_INFO_TX_SCHED_DWRR:
+    Sched = MTL_OPR_MD_SCHALG_DWRR;
+    break;
+  default:
+    return EFI_INVALID_PARAMETER;
+  }
+
+  for (i = 0; (Sched != MTL_OPR_MD_SCHALG_SP) && (i < GigAdapter->txqnum); i++) {
+    if (Weight[i] == 0) {
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+
+  // Before Initialize the setting is only recorded, MTL init applies it.
+  if (GigAdapter->State == PXE_STATFLAGS_GET_STATE_INITIALIZED) {
+    if (intelgbe_set_tx_sched (&GigAdapter->Hw, Sched, Weight) != INTELGBE_SUCCESS) {
+      DEBUGPRINT (CRITICAL, ("intelgbe_set_tx_sched failed\n"));
+      return EFI_DEVICE_ERROR;
+    }
+  } else {
+    GigAdapter->Hw.mac.tx_sched = Sched;
+    for (i = 0; (Sched != MTL_OPR_MD_SCHALG_SP) && (i < GigAdapter->txqnum); i++) {
+      GigAdapter->Hw.mac.txq_weight[i] = Weight[i];
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/** Selects the AXI burst, outstanding request and DMA burst settings.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+   @param[in]   Profile      INTELGBE_ADAPTER_INFO_DMA_PROFILE_* value
+   @param[in]   Cfg          Settings for INTELGBE_ADAPTER_INFO_DMA_PROFILE_CUSTOM,
+                             ignored for the named profiles
+
+   @retval   EFI_SUCCESS             Profile applied
+   @retval   EFI_INVALID_PARAMETER   Unknown profile or bad custom settings
+   @retval   EFI_NOT_READY           Frames are still in the TX rings
+   @retval   EFI_DEVICE_ERROR        DMA could not be reconfigured
+**/
+EFI_STATUS
+IntelgbeSetDmaProfile (
+  GIG_DRIVER_DATA         *GigAdapter,
+  UINT32                   Profile,
+  struct intelgbe_dma_cfg *Cfg
+  )
+{
+  UINT32                  SavedProfile;
+  struct intelgbe_dma_cfg SavedCfg;
+  UINT32                  i;
+
+  // The channels are stopped while the settings change.
+  if (GigAdapter->State == PXE_STATFLAGS_GET_STATE_INITIALIZED) {
+    for (i = 0; i < GigAdapter->txqnum; i++) {
+      if (GigAdapter->tx_queue[i].cur_tx != GigAdapter->tx_queue[i].dirty_tx) {
+        return EFI_NOT_READY;
+      }
+    }
+  }
+
+  SavedProfile = GigAdapter->Hw.mac.dma_profile;
+  SavedCfg     = GigAdapter->Hw.mac.dma_cfg;
+  if (intelgbe_set_dma_profile (&GigAdapter->Hw, Profile, Cfg) != INTELGBE_SUCCESS) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  // Before Initialize the profile is only recorded, DMA init applies it.
+  if (GigAdapter->State == PXE_STATFLAGS_GET_STATE_INITIALIZED) {
+    if (intelgbe_config_dma (&GigAdapter->Hw) != INTELGBE_SUCCESS) {
+      DEBUGPRINT (CRITICAL, ("intelgbe_config_dma failed\n"));
+      // The channels were restarted with the settings they had.
+      GigAdapter->Hw.mac.dma_profile = SavedProfile;
+      GigAdapter->Hw.mac.dma_cfg     = SavedCfg;
+      return EFI_DEVICE_ERROR;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/** Selects the loopback mode of the UNDI Initialize CPB.
+
+   LOOPBACK_INTERNAL loops frames inside the MAC, LOOPBACK_EXTERNAL loops
+   them in the PHY so the SERDES and PHY PCS are exercised as well.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+   @param[in]   LoopBack     LOOPBACK_NORMAL, LOOPBACK_INTERNAL or LOOPBACK_EXTERNAL
+
+   @retval   PXE_STATCODE_SUCCESS          Loopback mode applied
+   @retval   PXE_STATCODE_INVALID_CPB      Mode unknown or not supported by the PHY
+   @retval   PXE_STATCODE_DEVICE_FAILURE   MAC or PHY could not be reconfigured
+**/
+PXE_STATCODE
+IntelgbeSetLoopBack (
+  GIG_DRIVER_DATA *GigAdapter,
+  UINT8            LoopBack
+  )
+{
+  UINT32 Mode;
+
+  switch (LoopBack) {
+  case LOOPBACK_NORMAL:
+    Mode = INTELGBE_LOOPBACK_NONE;
+    break;
+  case LOOPBACK_INTERNAL:
+    Mode = INTELGBE_LOOPBACK_MAC;
+    break;
+  case LOOPBACK_EXTERNAL:
+    if (GigAdapter->Hw.phy.ops.set_loopback == NULL) {
+      return PXE_STATCODE_INVALID_CPB;
+    }
+    Mode = INTELGBE_LOOPBACK_PHY;
+    break;
+  default:
+    return PXE_STATCODE_INVALID_CPB;
+  }
+
+  if (intelgbe_set_loopback (&GigAdapter->Hw, Mode) != INTELGBE_SUCCESS) {
+    DEBUGPRINT (CRITICAL, ("intelgbe_set_loopback failed\n"));
+    return PXE_STATCODE_DEVICE_FAILURE;
+  }
+  GigAdapter->LoopBack = LoopBack;
+
+  return PXE_STATCODE_SUCCESS;
+}
+
+/** Adds the hardware RX FIFO drop counters to the running totals.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+**/
+VOID
+IntelgbeUpdateRxFifoDrops (
+  GIG_DRIVER_DATA *GigAdapter
+  )
+{
+  UINT32 Overflow;
+  UINT32 Missed;
+
+  if (GigAdapter->State != PXE_STATFLAGS_GET_STATE_INITIALIZED) {
+    return;
+  }
+
+  intelgbe_get_rx_fifo_drops (&GigAdapter->Hw, &Overflow, &Missed);
+  GigAdapter->RxFifoOverflows += Overflow;
+  GigAdapter->RxFifoMissed    += Missed;
+}
+
 /** Stop the hardware and put it all (including the PHY) into a known good state.
 
    @param[in]   GigAdapter   Pointer to the driver structure
@@ -1083,6 +2017,9 @@ IntelgbeShutdown (
 {
   DEBUGPRINT (INTELGBE, ("IntelgbeShutdown - adapter stop\n"));
 
+  // Reset clears the drop counters, keep what was counted so far.
+  IntelgbeUpdateRxFifoDrops (GigAdapter);
+
   // Disable the transmit and receive DMA
   intelgbe_uninit_hw(&GigAdapter->Hw);
   GigAdapter->ReceiveStarted = FALSE;
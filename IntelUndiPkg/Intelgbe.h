@@ -45,6 +45,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <IndustryStandard/Pci.h>
 
 #include "AdapterInformation.h"
+#include "VlanOffload.h"
+#include "Datapath.h"
 #include "Dma.h"
 #include "Intelgbe_osdep.h"
 #include "intelgbe_api.h"
@@ -52,6 +54,11 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include "intelgbe_defines.h"
 #include "Version.h"
 #include "ComponentName.h"
+#include "Diagnostics.h"
+#include "OsHandoff.h"
+#include "Trace.h"
+#include "Capture.h"
+#include "MemCopy.h"
 #include "StartStop.h"
 
 // Debug levels for driver DEBUG_PRINT statements
@@ -190,6 +197,24 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define UNDI_PRIVATE_DATA_FROM_AIP(a) \
   CR (a, UNDI_PRIVATE_DATA, AdapterInformation, GIG_UNDI_DEV_SIGNATURE)
 
+/** Retrieves UNDI_PRIVATE_DATA structure using VLAN Offload protocol instance
+
+   @param[in]   a   Current protocol instance
+
+   @return    UNDI_PRIVATE_DATA structure instance
+**/
+#define UNDI_PRIVATE_DATA_FROM_VLAN_OFFLOAD(a) \
+  CR (a, UNDI_PRIVATE_DATA, VlanOffload, GIG_UNDI_DEV_SIGNATURE)
+
+/** Retrieves UNDI_PRIVATE_DATA structure using NIC Datapath protocol instance
+
+   @param[in]   a   Current protocol instance
+
+   @return    UNDI_PRIVATE_DATA structure instance
+**/
+#define UNDI_PRIVATE_DATA_FROM_DATAPATH(a) \
+  CR (a, UNDI_PRIVATE_DATA, Datapath, GIG_UNDI_DEV_SIGNATURE)
+
 /** Retrieves UNDI_PRIVATE_DATA structure using NII Protocol 3.1 instance
 
    @param[in]   a   Current protocol instance
@@ -286,6 +311,30 @@ enum intelgbe_mac_type {
   intelgbe_stmmac_sgmii,
 };
 
+enum intelgbe_link_profile {
+  INTELGBE_LINK_PROFILE_LOW_LATENCY,  /* EEE off in PHY and MAC */
+  INTELGBE_LINK_PROFILE_POWER_SAVE,   /* EEE advertised, LPI entered on idle */
+};
+
+enum intelgbe_dma_profile {
+  INTELGBE_DMA_PROFILE_DEFAULT,      /* 4/8/16 beat bursts, one request in flight */
+  INTELGBE_DMA_PROFILE_BALANCED,     /* as default with two reads and writes in flight */
+  INTELGBE_DMA_PROFILE_THROUGHPUT,   /* aligned bursts up to 32 beats, four in flight */
+  INTELGBE_DMA_PROFILE_LOW_LATENCY,  /* short bursts that do not hold the bus */
+  INTELGBE_DMA_PROFILE_CUSTOM,       /* dma_cfg set field by field */
+};
+
+/* AXI master and DMA channel burst settings */
+struct intelgbe_dma_cfg {
+  u32 blen;    /* DMA_SYSBUS_MD_BLEN* burst lengths the AXI master may use */
+  u32 rd_osr;  /* outstanding read requests minus one */
+  u32 wr_osr;  /* outstanding write requests minus one */
+  u32 pbl;     /* TX and RX programmable burst length, 1 to 32 beats */
+  bool pblx8;  /* pbl counts units of 8 beats */
+  bool aal;    /* address-aligned beats */
+  bool fb;     /* fixed length bursts only */
+};
+
 struct intelgbe_mac_info {
   struct intelgbe_mac_operations ops;
   u8 addr[ETH_ADDR_LEN];
@@ -295,10 +344,28 @@ struct intelgbe_mac_info {
 
   u32 txfifosz;
   u32 rxfifosz;
+  u32 dma_addr_width;    /* address bits the DMA drives, 32, 40 or 48 */
   u32 link_speed;
   u32 full_duplex;
   bool speed_2500_en;
   bool pse_gbe;
+  bool vlan_insert;      /* TX VLAN insertion from context descriptor */
+  bool vlan_hash_filter; /* RX VLAN hash filter present */
+  u16 vlan_hash;         /* VLAN hash table, restored on init */
+  bool tstamp;           /* IEEE 1588 timestamping unit present */
+  bool tstamp_en;        /* timestamping requested, restored on init */
+  bool eee;              /* EEE/LPI supported by MAC */
+  bool eee_active;       /* LPI enabled for the current link */
+  enum intelgbe_link_profile link_profile;
+  u32 dma_profile;       /* INTELGBE_DMA_PROFILE_* */
+  struct intelgbe_dma_cfg dma_cfg;
+  u32 fc_requested;      /* INTELGBE_FC_* advertised to the link partner */
+  u32 fc_active;         /* INTELGBE_FC_* resolved for the current link */
+  u32 loopback;          /* INTELGBE_LOOPBACK_* */
+  u32 txq_fifo_weight[INTELGBE_MAX_TX_QUEUES]; /* MTL FIFO share per queue */
+  u32 tx_sched;          /* MTL_OPR_MD_SCHALG_* between the TX queues */
+  u32 txq_weight[INTELGBE_MAX_TX_QUEUES];      /* WRR/DWRR share per queue */
+  u32 rxq_fifo_weight[INTELGBE_MAX_RX_QUEUES];
 };
 
 struct intelgbe_phy_operations {
@@ -309,6 +376,7 @@ struct intelgbe_phy_operations {
   s32  (*cfg_link)(struct intelgbe_hw *);
   s32  (*link_status_change)(struct intelgbe_hw *, bool *);
   s32  (*status)(struct intelgbe_hw *, bool *, s32 *, s8 *);
+  s32  (*set_loopback)(struct intelgbe_hw *, bool);
 };
 
 enum phy_type {
@@ -331,6 +399,7 @@ enum phy_support {
   PHY_SUPPORT_100_FULL   = BIT(3),
   PHY_SUPPORT_1000_HALF  = BIT(4),
   PHY_SUPPORT_1000_FULL  = BIT(5),
+  PHY_SUPPORT_2500_FULL  = BIT(6),
 };
 
 struct intelgbe_phy_info {
@@ -348,6 +417,7 @@ struct intelgbe_phy_info {
   u32 reset_delay_us; /* in usec */
   u32 revision;
   bool c45;
+  bool rate_matching;  /* host interface stays at 2.5G, the PHY matches the link rate */
 };
 
 struct intelgbe_hw {
@@ -497,30 +567,73 @@ VOID
   UINT64  MappedAddr
   );
 
-struct intelgbe_tx_queue {
-  u32 queue_index;
-  INTELGBE_TRANSMIT_DESCRIPTOR *tx_desc;
-  INTELGBE_TRANSMIT_DESCRIPTOR *dma_tx;
+/* Ring bookkeeping is touched on every frame; the indices and tail come
+   first so a queue's per-packet state fits in a single cache line. */
+struct INTELGBE_CACHE_ALIGNED intelgbe_tx_queue {
   unsigned int cur_tx;
   unsigned int dirty_tx;
   u32 tx_tail_addr;
+  u32 queue_index;
+  INTELGBE_TRANSMIT_DESCRIPTOR *tx_desc;
+  INTELGBE_TRANSMIT_DESCRIPTOR *dma_tx;
+  UNDI_DMA_MAPPING *buf_map; /* DEFAULT_TX_DESCRIPTORS entries */
+  u64 *tx_tstamp; /* submit time per descriptor, NULL unless timestamping */
 };
 
-struct intelgbe_rx_queue {
-  u32 queue_index;
+struct INTELGBE_CACHE_ALIGNED intelgbe_rx_queue {
+  unsigned int cur_rx;
+  unsigned int dirty_rx;
+  u32 rx_tail_addr;
   u32 chan;
   INTELGBE_RECEIVE_DESCRIPTOR *rx_desc;
   INTELGBE_RECEIVE_DESCRIPTOR *dma_rx;
   LOCAL_RX_BUFFER           *rx_buff;
   LOCAL_RX_BUFFER           *dma_rx_buff;
-  unsigned int cur_rx;
-  unsigned int dirty_rx;
-  u32 rx_tail_addr;
+  u32 queue_index;
+  bool tstamp;
 };
 
 typedef struct DRIVER_DATA_S {
-  UINT16                State; // stopped, started or initialized
-  struct intelgbe_hw      Hw;
+  /* Hot: read or written by every transmit, receive and status call.
+     Keep these together at the head of the structure so the per-packet
+     path stays within a few cache lines. */
+  INTELGBE_CACHE_ALIGNED
+  UINTN                DriverBusy;
+  UINT8                ReceiveStarted;
+  UINT8                IntMask;
+  UINT16               RxFilter;
+  UINT16               XmitDoneHead;
+  UINT16               State; // stopped, started or initialized
+  UINT8                txqnum;
+  UINT8                rxqnum;
+  BOOLEAN              SurpriseRemoval;
+  BOOLEAN              ExitBootServicesTriggered;
+  UINT16               TxVlanTci; // tag for the next transmit, 0 for none
+  UINT16               RxVlanTci; // tag stripped from the last receive
+  UINT32               TraceMask; // bit per INTELGBE_TRACE_CLASS_* being recorded
+  UINT64               TraceWritten; // records written since the trace was started
+  INTELGBE_TRACE_RECORD *TraceRing; // INTELGBE_TRACE_RECORDS entries, NULL until traced
+  UINT8                CaptureDirections; // INTELGBE_CAPTURE_TX/RX being captured
+  INTELGBE_CAPTURE    *Capture; // NULL until a capture was armed
+  EFI_PCI_IO_PROTOCOL *PciIo;
+  UNDI_DMA_MAPPING    *TxBufferMappings; // DEFAULT_TX_DESCRIPTORS entries per TX queue
+  UINT64               UniqueId;
+  BLOCK                Block;
+  MAP_MEM              MapMem;
+
+  /* TX Queue, active queue first */
+  struct intelgbe_tx_queue tx_queue[INTELGBE_MAX_TX_QUEUES];
+  /* RX Queue, active queue first */
+  struct intelgbe_rx_queue rx_queue[INTELGBE_MAX_RX_QUEUES];
+
+  /* Warm: register access goes through Hw.hw_addr */
+  INTELGBE_CACHE_ALIGNED
+  struct intelgbe_hw     Hw;
+
+  /* Cold: configuration and bookkeeping used at init/shutdown only */
+  UNDI_DMA_MAPPING     TxRing;
+  UNDI_DMA_MAPPING     RxRing;
+  UNDI_DMA_MAPPING     RxBufferMapping;
   UINTN                 Segment;
   UINTN                 Bus;
   UINTN                 Device;
@@ -528,9 +641,8 @@ typedef struct DRIVER_DATA_S {
   UINT8                 PciClass;
   UINT8                 PciSubClass;
   UINTN                 LanFunction;
-  UINT32                PciConfig[MAX_PCI_CONFIG_LEN];
   UINTN                 HwInitialized;
-  UINTN                 DriverBusy;
+  BOOLEAN               OsHandoff; // leave the link up for the OS at ExitBootServices
   UINT16                LinkSpeed; // requested (forced) link speed
   UINT8                 DuplexMode; // requested duplex
   UINT8                 CableDetect; // 1 to detect and 0 not to detect the cable
@@ -539,39 +651,26 @@ typedef struct DRIVER_DATA_S {
                                      // NII is not installed on ControllerHandle
                                      // (e.g. in case iSCSI driver loaded on port)
 
-  UINT64               UniqueId;
-  EFI_PCI_IO_PROTOCOL *PciIo;
   UINT64               OriginalPciAttributes;
   // UNDI callbacks
   BS_PTR               Delay;
   VIRT_PHYS            Virt2Phys;
-  BLOCK                Block;
   MEM_IO               MemIo;
-  MAP_MEM              MapMem;
   UNMAP_MEM            UnMapMem;
   SYNC_MEM             SyncMem;
   UINT8                IoBarIndex;
-  UINT16               RxFilter;
-  UINT8                IntMask;
-  UINT8                txqnum;
-  UINT8                rxqnum;
-  UINT8                ReceiveStarted;
-  UINT16               XmitDoneHead;
-  UNDI_DMA_MAPPING     TxRing;
-  UNDI_DMA_MAPPING     RxRing;
-  UNDI_DMA_MAPPING     RxBufferMapping;
-  UNDI_DMA_MAPPING     TxBufferMappings[DEFAULT_TX_DESCRIPTORS];
-  /* RX Queue */
-  struct intelgbe_rx_queue rx_queue[INTELGBE_MAX_RX_QUEUES];
-  /* TX Queue */
-  struct intelgbe_tx_queue tx_queue[INTELGBE_MAX_TX_QUEUES];
+  EFI_LOCK             Lock; // used by IntelgbeBlockIt when Block is not provided
 
   UINT8                BroadcastNodeAddress[PXE_MAC_LENGTH];
   UINT8                DeviceId;
   BOOLEAN              MacAddrOverride;
-  BOOLEAN              SurpriseRemoval;
-  BOOLEAN              ExitBootServicesTriggered;
   UINTN                VersionFlag; // Indicates UNDI version 3.0 or 3.1
+  UINT8                ActiveVlans[UNDI_VLAN_ID_COUNT / 8]; // VLAN offload filter set
+  INTELGBE_LATENCY_STATS WireToReceive;
+  INTELGBE_LATENCY_STATS TransmitToWire;
+  UINT64               RxFifoOverflows;
+  UINT64               RxFifoMissed;
+  UINT64               TraceTscHz; // time stamp counter frequency for decoding trace and capture
 } GIG_DRIVER_DATA, *PADAPTER_STRUCT;
 
 typedef struct {
@@ -588,12 +687,15 @@ typedef struct UNDI_PRIVATE_DATA_S {
   EFI_DEVICE_PATH_PROTOCOL *                Undi32BaseDevPath;
   EFI_DEVICE_PATH_PROTOCOL *                Undi32DevPath;
   EFI_ADAPTER_INFORMATION_PROTOCOL          AdapterInformation;
+  EDKII_NIC_VLAN_OFFLOAD_PROTOCOL           VlanOffload;
+  EDKII_NIC_DATAPATH_PROTOCOL               Datapath;
   GIG_DRIVER_DATA                           NicInfo;
   UINT8 AltMacAddrSupported;
   BOOLEAN                                   IsChildInitialized;
   EFI_DRIVER_STOP_PROTOCOL                  DriverStop;
   EFI_UNICODE_STRING_TABLE *                ControllerNameTable;
   CHAR16 *                                  Brand;
+  struct UNDI_PRIVATE_DATA_S *              HashNext; // controller handle lookup chain
 } UNDI_PRIVATE_DATA;
 
 typedef struct {
@@ -772,6 +874,19 @@ IntelgbeFreeTxBuffers (
   OUT UINT64 *        TxBuffer
   );
 
+/** Reads and clears the transmit and receive interrupt status of all DMA channels.
+
+   @param[in]   GigAdapter   Pointer to the NIC data structure information
+                             which the UNDI driver is layering on.
+
+   @return   PXE_STATFLAGS_GET_STATUS_TRANSMIT and PXE_STATFLAGS_GET_STATUS_RECEIVE
+             for the interrupts that were pending
+**/
+UINT16
+IntelgbeGetInterruptStatus (
+  IN GIG_DRIVER_DATA *GigAdapter
+  );
+
 /** Copies the frame from our internal storage ring (As pointed to by GigAdapter->rx_ring)
    to the command Block passed in as part of the cpb parameter.
 
@@ -802,34 +917,297 @@ IntelgbeReceive (
   UINT64           Db
   );
 
-/** This is the drivers copy function so it does not need to rely on the BootServices
-   copy which goes away at runtime.
+/** Stop the hardware and put it all (including the PHY) into a known good state.
 
-   This copy function allows 64-bit or 32-bit copies
-   depending on platform architecture.  On Itanium we must check that both addresses
-   are naturally aligned before attempting a 64-bit copy.
+   @param[in]   GigAdapter   Pointer to the driver structure
 
-   @param[in]   Dest     Destination memory pointer to copy data to.
-   @param[in]   Source   Source memory pointer.
-   @param[in]   Count    Number of bytes to copy
+   @retval   PXE_STATCODE_SUCCESS    Hardware stopped
+**/
+UINTN
+IntelgbeShutdown (
+  GIG_DRIVER_DATA *GigAdapter
+  );
+
+/** Starts or stops RX/TX timestamping for the latency profile.
+
+   Starting clears the profile collected so far.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+   @param[in]   Enable       TRUE to timestamp every frame
 
-   @return    Memory copied from source to destination
+   @retval   EFI_SUCCESS            Timestamping state changed
+   @retval   EFI_UNSUPPORTED        MAC has no timestamping unit
+   @retval   EFI_OUT_OF_RESOURCES   Could not allocate TX submit times
+   @retval   EFI_DEVICE_ERROR       System time counter failed to start
+**/
+EFI_STATUS
+IntelgbeSetTimestamping (
+  GIG_DRIVER_DATA *GigAdapter,
+  BOOLEAN          Enable
+  );
+
+/** Selects the low-latency or power-save link profile.
+
+   Switching an initialized adapter restarts auto-negotiation when the EEE
+   advertisement changes.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+   @param[in]   Profile      INTELGBE_ADAPTER_INFO_LINK_PROFILE_* value
+
+   @retval   EFI_SUCCESS             Profile applied
+   @retval   EFI_INVALID_PARAMETER   Unknown profile
+   @retval   EFI_UNSUPPORTED         MAC has no EEE support
+   @retval   EFI_DEVICE_ERROR        PHY could not be reconfigured
+**/
+EFI_STATUS
+IntelgbeSetLinkProfile (
+  GIG_DRIVER_DATA *GigAdapter,
+  UINT32           Profile
+  );
+
+/** Selects which 802.3x pause directions are advertised.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+   @param[in]   FlowControl  INTELGBE_ADAPTER_INFO_FC_* bits
+
+   @retval   EFI_SUCCESS             Flow control applied
+   @retval   EFI_INVALID_PARAMETER   Unknown bits set
+   @retval   EFI_DEVICE_ERROR        PHY could not be reconfigured
+**/
+EFI_STATUS
+IntelgbeSetFlowControl (
+  GIG_DRIVER_DATA *GigAdapter,
+  UINT32           FlowControl
+  );
+
+/** Selects the MTL scheduling algorithm between the TX queues.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+   @param[in]   Algorithm    INTELGBE_ADAPTER_INFO_TX_SCHED_* value
+   @param[in]   Weight       Per queue weights, txqnum entries, ignored for
+                             strict priority
+
+   @retval   EFI_SUCCESS             Scheduling applied
+   @retval   EFI_INVALID_PARAMETER   Unknown algorithm or a zero weight
+   @retval   EFI_DEVICE_ERROR        MTL could not be reconfigured
+**/
+EFI_STATUS
+IntelgbeSetTxScheduling (
+  GIG_DRIVER_DATA *GigAdapter,
+  UINT32           Algorithm,
+  UINT32          *Weight
+  );
+
+/** Selects the AXI burst, outstanding request and DMA burst settings.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+   @param[in]   Profile      INTELGBE_ADAPTER_INFO_DMA_PROFILE_* value
+   @param[in]   Cfg          Settings for INTELGBE_ADAPTER_INFO_DMA_PROFILE_CUSTOM,
+                             ignored for the named profiles
+
+   @retval   EFI_SUCCESS             Profile applied
+   @retval   EFI_INVALID_PARAMETER   Unknown profile or bad custom settings
+   @retval   EFI_NOT_READY           Frames are still in the TX rings
+   @retval   EFI_DEVICE_ERROR        DMA could not be reconfigured
+**/
+EFI_STATUS
+IntelgbeSetDmaProfile (
+  GIG_DRIVER_DATA         *GigAdapter,
+  UINT32                   Profile,
+  struct intelgbe_dma_cfg *Cfg
+  );
+
+/** Selects the loopback mode of the UNDI Initialize CPB.
+
+   LOOPBACK_INTERNAL loops frames inside the MAC, LOOPBACK_EXTERNAL loops
+   them in the PHY so the SERDES and PHY PCS are exercised as well.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+   @param[in]   LoopBack     LOOPBACK_NORMAL, LOOPBACK_INTERNAL or LOOPBACK_EXTERNAL
+
+   @retval   PXE_STATCODE_SUCCESS          Loopback mode applied
+   @retval   PXE_STATCODE_INVALID_CPB      Mode unknown or not supported by the PHY
+   @retval   PXE_STATCODE_DEVICE_FAILURE   MAC or PHY could not be reconfigured
+**/
+PXE_STATCODE
+IntelgbeSetLoopBack (
+  GIG_DRIVER_DATA *GigAdapter,
+  UINT8            LoopBack
+  );
+
+/** Selects whether the link is left up for the OS at ExitBootServices.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+   @param[in]   Enable       TRUE to hand the link off to the OS driver
+
+   @retval   EFI_SUCCESS            Setting recorded
+   @retval   EFI_OUT_OF_RESOURCES   Could not allocate the configuration table
+   @retval   !EFI_SUCCESS           Configuration table could not be installed
+**/
+EFI_STATUS
+IntelgbeSetOsHandoff (
+  GIG_DRIVER_DATA *GigAdapter,
+  BOOLEAN          Enable
+  );
+
+/** Describes the port in the handoff table from the ExitBootServices notification.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+
+   @retval   TRUE    Link is up and was published, leave PHY, SERDES and MAC as they are
+   @retval   FALSE   Port is not handed off, shut it down completely
+**/
+BOOLEAN
+IntelgbeOsHandoffPublish (
+  GIG_DRIVER_DATA *GigAdapter
+  );
+
+/** Removes the handoff table when the driver is unloaded.
 **/
 VOID
-IntelgbeMemCopy (
-  IN UINT8* Dest,
-  IN UINT8* Source,
-  IN UINT32 Count
+IntelgbeOsHandoffUninstall (
+  VOID
   );
 
-/** Stop the hardware and put it all (including the PHY) into a known good state.
+/** Writes one record into the adapter's trace ring, overwriting the oldest.
 
    @param[in]   GigAdapter   Pointer to the driver structure
+   @param[in]   Event        INTELGBE_TRACE_* event
+   @param[in]   Arg0         Event argument
+   @param[in]   Arg1         Event argument
+   @param[in]   Arg2         Event argument
+   @param[in]   Arg3         Event argument
+**/
+VOID
+IntelgbeTraceRecord (
+  GIG_DRIVER_DATA *GigAdapter,
+  UINT16           Event,
+  UINT32           Arg0,
+  UINT32           Arg1,
+  UINT32           Arg2,
+  UINT32           Arg3
+  );
 
-   @retval   PXE_STATCODE_SUCCESS    Hardware stopped
+/** Measures the time stamp counter frequency once per adapter.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
 **/
-UINTN
-IntelgbeShutdown (
+VOID
+IntelgbeCalibrateTsc (
+  GIG_DRIVER_DATA *GigAdapter
+  );
+
+/** Selects the event classes recorded in the trace ring.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+   @param[in]   Mask         Bit per INTELGBE_TRACE_CLASS_*
+
+   @retval   EFI_SUCCESS             Trace mask applied
+   @retval   EFI_INVALID_PARAMETER   Unknown class in Mask
+   @retval   EFI_OUT_OF_RESOURCES    Could not allocate the trace ring
+**/
+EFI_STATUS
+IntelgbeSetTrace (
+  GIG_DRIVER_DATA *GigAdapter,
+  UINT32           Mask
+  );
+
+/** Copies the newest records out of the trace ring, oldest first.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+   @param[out]  Records      Buffer for Count records
+   @param[in]   Count        Records to copy, at most INTELGBE_TRACE_RECORDS
+
+   @return   Records written since the trace was started
+**/
+UINT64
+IntelgbeTraceCopy (
+  GIG_DRIVER_DATA       *GigAdapter,
+  INTELGBE_TRACE_RECORD *Records,
+  UINT32                 Count
+  );
+
+/** Records a frame in the capture ring.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+   @param[in]   Direction    INTELGBE_CAPTURE_TX or INTELGBE_CAPTURE_RX
+   @param[in]   Frame        Frame, starting with the media header
+   @param[in]   FrameLen     Length of the frame
+**/
+VOID
+IntelgbeCaptureFrame (
+  GIG_DRIVER_DATA *GigAdapter,
+  UINT8            Direction,
+  UINT8           *Frame,
+  UINT32           FrameLen
+  );
+
+/** Records a fragmented transmit frame in the capture ring.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+   @param[in]   TxFrags      Fragment list of the frame
+**/
+VOID
+IntelgbeCaptureFragments (
+  GIG_DRIVER_DATA            *GigAdapter,
+  PXE_CPB_TRANSMIT_FRAGMENTS *TxFrags
+  );
+
+/** Arms or stops the packet capture.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+   @param[in]   Directions   INTELGBE_CAPTURE_TX and/or INTELGBE_CAPTURE_RX, 0 to stop
+   @param[in]   Flags        INTELGBE_CAPTURE_FLAG_*
+   @param[in]   SnapLen      Bytes kept per frame, 0 for the default
+   @param[in]   EtherType    Only capture frames of this EtherType, 0 for all
+   @param[in]   RingSize     Ring size in bytes, 0 for the default
+
+   @retval   EFI_SUCCESS             Capture armed or stopped
+   @retval   EFI_INVALID_PARAMETER   Unknown direction or flag, or sizes out of range
+   @retval   EFI_OUT_OF_RESOURCES    Could not allocate the ring
+**/
+EFI_STATUS
+IntelgbeSetCapture (
+  GIG_DRIVER_DATA *GigAdapter,
+  UINT32           Directions,
+  UINT32           Flags,
+  UINT32           SnapLen,
+  UINT16           EtherType,
+  UINT32           RingSize
+  );
+
+/** Copies the captured frames out of the ring, oldest first.
+
+   @param[in]      GigAdapter   Pointer to the driver structure
+   @param[out]     State        Returns the capture settings and counters, Ring is NULL
+   @param[out]     Buffer       Buffer for the records, each INTELGBE_CAPTURE_RECORD_SIZE bytes
+   @param[in,out]  BufferSize   On entry the size of Buffer, on exit the bytes written
+
+   @return   Records written to Buffer
+**/
+UINT32
+IntelgbeCaptureCopy (
+  GIG_DRIVER_DATA  *GigAdapter,
+  INTELGBE_CAPTURE *State,
+  UINT8            *Buffer,
+  UINTN            *BufferSize
+  );
+
+/** Releases a capture and its ring.
+
+   @param[in]   Capture   Capture to free, may be NULL
+**/
+VOID
+IntelgbeFreeCapture (
+  INTELGBE_CAPTURE *Capture
+  );
+
+/** Adds the hardware RX FIFO drop counters to the running totals.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+**/
+VOID
+IntelgbeUpdateRxFifoDrops (
   GIG_DRIVER_DATA *GigAdapter
   );
 
@@ -59,6 +59,18 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define true 1
 #define false 0
 
+/* Cache line size assumed when laying out per-packet adapter state */
+#define INTELGBE_CACHE_LINE_SIZE  64
+
+/** Aligns a structure type or member to the start of a cache line.
+   Place it between the struct keyword and the tag, or in front of a member.
+**/
+#if defined (_MSC_VER)
+#define INTELGBE_CACHE_ALIGNED    __declspec (align (64))
+#else /* NOT _MSC_VER */
+#define INTELGBE_CACHE_ALIGNED    __attribute__ ((aligned (INTELGBE_CACHE_LINE_SIZE)))
+#endif /* _MSC_VER */
+
 struct intelgbe_hw;
 
 /** This function calls the MemIo callback to read a dword from the device's
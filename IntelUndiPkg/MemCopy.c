@@ -0,0 +1,83 @@
+/** @file
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include "MemCopy.h"
+
+#ifdef EFIX64
+/* X64/MemCopy.nasm. There are no AVX kernels, the firmware interrupt
+   handlers only save the FXSAVE state and would clobber the YMM registers. */
+VOID EFIAPI IntelgbeCopySse2 (OUT VOID *Dest, IN CONST VOID *Source, IN UINTN Count);
+VOID EFIAPI IntelgbeCopyStream (OUT VOID *Dest, IN CONST VOID *Source, IN UINTN Count);
+#else /* EFIX64 */
+
+/** Copies one UINTN at a time, then the tail byte by byte. Used where no
+   vector copy is available.
+
+   @param[out]  Dest     Destination memory pointer to copy data to.
+   @param[in]   Source   Source memory pointer.
+   @param[in]   Count    Number of bytes to copy
+**/
+STATIC
+VOID
+EFIAPI
+IntelgbeCopyPortable (
+  OUT VOID       *Dest,
+  IN  CONST VOID *Source,
+  IN  UINTN       Count
+  )
+{
+  UINTN       *DestPtr;
+  CONST UINTN *SourcePtr;
+  UINT8       *DestBytePtr;
+  CONST UINT8 *SourceBytePtr;
+  UINTN        IntsToCopy;
+
+  DestPtr   = (UINTN *) Dest;
+  SourcePtr = (CONST UINTN *) Source;
+  for (IntsToCopy = Count / sizeof (UINTN); IntsToCopy > 0; IntsToCopy--) {
+    *DestPtr++ = *SourcePtr++;
+  }
+
+  DestBytePtr   = (UINT8 *) DestPtr;
+  SourceBytePtr = (CONST UINT8 *) SourcePtr;
+  for (Count %= sizeof (UINTN); Count > 0; Count--) {
+    *DestBytePtr++ = *SourceBytePtr++;
+  }
+}
+
+#endif /* EFIX64 */
+
+/** Copies a frame between two buffers that do not overlap.
+
+   This is the drivers copy function so it does not need to rely on the
+   BootServices copy which goes away at runtime.
+
+   @param[in]   Dest     Destination memory pointer to copy data to.
+   @param[in]   Source   Source memory pointer.
+   @param[in]   Count    Number of bytes to copy
+
+   @return    Memory copied from source to destination
+**/
+VOID
+IntelgbeMemCopy (
+  IN UINT8* Dest,
+  IN UINT8* Source,
+  IN UINT32 Count
+  )
+{
+#ifdef EFIX64
+  if (Count >= INTELGBE_COPY_STREAM_MIN) {
+    IntelgbeCopyStream (Dest, Source, Count);
+  } else {
+    IntelgbeCopySse2 (Dest, Source, Count);
+  }
+#else /* EFIX64 */
+  IntelgbeCopyPortable (Dest, Source, Count);
+#endif /* EFIX64 */
+}
@@ -0,0 +1,30 @@
+/** @file
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef MEM_COPY_H_
+#define MEM_COPY_H_
+
+/* Frames at least this long are copied with non-temporal stores where the
+   CPU has them, so a jumbo frame does not push the rings out of the cache. */
+#define INTELGBE_COPY_STREAM_MIN   4096
+
+/** Copies a frame between two buffers that do not overlap.
+
+   @param[in]   Dest     Destination memory pointer to copy data to.
+   @param[in]   Source   Source memory pointer.
+   @param[in]   Count    Number of bytes to copy
+
+   @return    Memory copied from source to destination
+**/
+VOID
+IntelgbeMemCopy (
+  IN UINT8* Dest,
+  IN UINT8* Source,
+  IN UINT32 Count
+  );
+
+#endif /* MEM_COPY_H_ */
@@ -0,0 +1,136 @@
+/** @file
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "Intelgbe.h"
+#include "OsHandoff.h"
+
+EFI_GUID gIntelgbeOsHandoffTableGuid = INTELGBE_OS_HANDOFF_TABLE_GUID;
+
+/* Runtime memory so the table is still there when the OS driver looks */
+STATIC INTELGBE_OS_HANDOFF_TABLE *mOsHandoffTable = NULL;
+
+/** Selects whether the link is left up for the OS at ExitBootServices.
+
+   The configuration table is installed with the first port that opts in,
+   because allocating and installing are not allowed once ExitBootServices
+   has started. Its entries are only filled in from the ExitBootServices
+   notification.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+   @param[in]   Enable       TRUE to hand the link off to the OS driver
+
+   @retval   EFI_SUCCESS            Setting recorded
+   @retval   EFI_OUT_OF_RESOURCES   Could not allocate the configuration table
+   @retval   !EFI_SUCCESS           Configuration table could not be installed
+**/
+EFI_STATUS
+IntelgbeSetOsHandoff (
+  GIG_DRIVER_DATA *GigAdapter,
+  BOOLEAN          Enable
+  )
+{
+  INTELGBE_OS_HANDOFF_TABLE *Table;
+  EFI_STATUS                 Status;
+
+  if (Enable && (mOsHandoffTable == NULL)) {
+    Table = AllocateRuntimeZeroPool (sizeof (INTELGBE_OS_HANDOFF_TABLE));
+    if (Table == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    Table->Signature = INTELGBE_OS_HANDOFF_SIGNATURE;
+    Table->Revision  = INTELGBE_OS_HANDOFF_REVISION;
+
+    Status = gBS->InstallConfigurationTable (&gIntelgbeOsHandoffTableGuid, Table);
+    if (EFI_ERROR (Status)) {
+      DEBUGPRINT (CRITICAL, ("InstallConfigurationTable returns %r\n", Status));
+      FreePool (Table);
+      return Status;
+    }
+    mOsHandoffTable = Table;
+  }
+  GigAdapter->OsHandoff = Enable;
+
+  return EFI_SUCCESS;
+}
+
+/** Describes the port in the handoff table from the ExitBootServices notification.
+
+   Runs after DMA was stopped and must neither allocate nor install anything.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+
+   @retval   TRUE    Link is up and was published, leave PHY, SERDES and MAC as they are
+   @retval   FALSE   Port is not handed off, shut it down completely
+**/
+BOOLEAN
+IntelgbeOsHandoffPublish (
+  GIG_DRIVER_DATA *GigAdapter
+  )
+{
+  struct intelgbe_hw        *hw = &GigAdapter->Hw;
+  INTELGBE_OS_HANDOFF_ENTRY *Entry;
+
+  if (!GigAdapter->OsHandoff
+    || (mOsHandoffTable == NULL)
+    || (mOsHandoffTable->EntryCount >= INTELGBE_OS_HANDOFF_MAX_ENTRIES))
+  {
+    return FALSE;
+  }
+
+  Entry = &mOsHandoffTable->Entry[mOsHandoffTable->EntryCount];
+  mOsHandoffTable->EntryCount++;
+
+  ZeroMem (Entry, sizeof (INTELGBE_OS_HANDOFF_ENTRY));
+  Entry->Segment  = (UINT16) GigAdapter->Segment;
+  Entry->Bus      = (UINT8) GigAdapter->Bus;
+  Entry->Device   = (UINT8) GigAdapter->Device;
+  Entry->Function = (UINT8) GigAdapter->Function;
+  INTELGBE_COPY_MAC (Entry->MacAddr, hw->mac.addr);
+  Entry->PhyAddr  = (UINT8) hw->phy.addr;
+  Entry->PhyC45   = hw->phy.c45 ? 1 : 0;
+  Entry->PhyId    = hw->phy.id;
+
+  // A port in loopback has no link the OS driver could reuse.
+  if (!GigAdapter->HwInitialized
+    || (GigAdapter->LoopBack != LOOPBACK_NORMAL)
+    || !IsLinkUp (GigAdapter))
+  {
+    return FALSE;
+  }
+
+  Entry->LinkUp     = 1;
+  Entry->LinkSpeed  = hw->mac.link_speed;
+  Entry->FullDuplex = hw->mac.full_duplex ? 1 : 0;
+  if (hw->phy.interface != PHY_INTERFACE_SGMII) {
+    Entry->SerdesMode = INTELGBE_OS_HANDOFF_SERDES_NONE;
+  } else if (hw->mac.speed_2500_en) {
+    Entry->SerdesMode = INTELGBE_OS_HANDOFF_SERDES_2500BASEX;
+  } else {
+    Entry->SerdesMode = INTELGBE_OS_HANDOFF_SERDES_SGMII;
+  }
+
+  DEBUGPRINT (INIT, ("OS handoff %d Mbps %a duplex\n",
+    Entry->LinkSpeed, Entry->FullDuplex ? "full" : "half"));
+
+  return TRUE;
+}
+
+/** Removes the handoff table when the driver is unloaded.
+**/
+VOID
+IntelgbeOsHandoffUninstall (
+  VOID
+  )
+{
+  if (mOsHandoffTable == NULL) {
+    return;
+  }
+
+  gBS->InstallConfigurationTable (&gIntelgbeOsHandoffTableGuid, NULL);
+  FreePool (mOsHandoffTable);
+  mOsHandoffTable = NULL;
+}
@@ -0,0 +1,52 @@
+/** @file
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef OS_HANDOFF_H_
+#define OS_HANDOFF_H_
+
+/* UEFI configuration table listing the ports whose link was left up at
+   ExitBootServices. A cooperating OS driver that finds its port here with
+   LinkUp set may take the PHY, SERDES and MAC speed setting as they are and
+   skip the reset and auto-negotiation sequence. DMA is always stopped. */
+#define INTELGBE_OS_HANDOFF_TABLE_GUID \
+  { 0x1aab1622, 0x9720, 0x4200, { 0xb4, 0x50, 0xac, 0xc3, 0xa7, 0x87, 0x3f, 0x46 }}
+
+#define INTELGBE_OS_HANDOFF_SIGNATURE     SIGNATURE_32 ('I', 'G', 'H', 'O')
+#define INTELGBE_OS_HANDOFF_REVISION      1
+
+/* Ports beyond this count fall back to the full shutdown */
+#define INTELGBE_OS_HANDOFF_MAX_ENTRIES   8
+
+#define INTELGBE_OS_HANDOFF_SERDES_NONE       0  // No SERDES lane (RGMII)
+#define INTELGBE_OS_HANDOFF_SERDES_SGMII      1  // 1G lane rate, SGMII XPCS
+#define INTELGBE_OS_HANDOFF_SERDES_2500BASEX  2  // 2.5G lane rate, 2500BASE-X XPCS
+
+#pragma pack(1)
+typedef struct {
+  UINT16  Segment;
+  UINT8   Bus;
+  UINT8   Device;
+  UINT8   Function;
+  UINT8   LinkUp;       // 0 when the port was shut down and needs a full init
+  UINT8   MacAddr[6];   // Address programmed in MAC_ADDRESS0
+  UINT8   PhyAddr;      // MDIO address of the PHY
+  UINT8   PhyC45;       // 1 when the PHY is accessed with clause 45 frames
+  UINT8   FullDuplex;
+  UINT8   SerdesMode;   // INTELGBE_OS_HANDOFF_SERDES_*
+  UINT32  PhyId;        // PHY identifier registers 2 and 3
+  UINT32  LinkSpeed;    // Negotiated speed in Mbps
+} INTELGBE_OS_HANDOFF_ENTRY;
+
+typedef struct {
+  UINT32                     Signature;   // INTELGBE_OS_HANDOFF_SIGNATURE
+  UINT16                     Revision;    // INTELGBE_OS_HANDOFF_REVISION
+  UINT16                     EntryCount;  // Entries filled in at ExitBootServices
+  INTELGBE_OS_HANDOFF_ENTRY  Entry[INTELGBE_OS_HANDOFF_MAX_ENTRIES];
+} INTELGBE_OS_HANDOFF_TABLE;
+#pragma pack()
+
+#endif /* OS_HANDOFF_H_ */
@@ -0,0 +1,154 @@
+/** @file
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "Intelgbe.h"
+#include "Trace.h"
+
+/* Stall used to measure the time stamp counter frequency */
+#define TRACE_CALIBRATE_US  1000
+
+/** Writes one record into the adapter's trace ring, overwriting the oldest.
+
+   Only called through INTELGBE_TRACE once the class was found enabled.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+   @param[in]   Event        INTELGBE_TRACE_* event
+   @param[in]   Arg0         Event argument
+   @param[in]   Arg1         Event argument
+   @param[in]   Arg2         Event argument
+   @param[in]   Arg3         Event argument
+**/
+VOID
+IntelgbeTraceRecord (
+  GIG_DRIVER_DATA *GigAdapter,
+  UINT16           Event,
+  UINT32           Arg0,
+  UINT32           Arg1,
+  UINT32           Arg2,
+  UINT32           Arg3
+  )
+{
+  INTELGBE_TRACE_RECORD *Record;
+  UINT64                 Written;
+
+  Written = GigAdapter->TraceWritten;
+  Record  = &GigAdapter->TraceRing[Written & (INTELGBE_TRACE_RECORDS - 1)];
+  GigAdapter->TraceWritten = Written + 1;
+
+  Record->Tsc      = INTELGBE_TRACE_TIMESTAMP ();
+  Record->Event    = Event;
+  Record->Reserved = 0;
+  Record->Sequence = (UINT32) Written;
+  Record->Arg[0]   = Arg0;
+  Record->Arg[1]   = Arg1;
+  Record->Arg[2]   = Arg2;
+  Record->Arg[3]   = Arg3;
+}
+
+/** Measures the time stamp counter frequency once per adapter.
+
+   The frequency decodes both the trace and the capture timestamps.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+**/
+VOID
+IntelgbeCalibrateTsc (
+  GIG_DRIVER_DATA *GigAdapter
+  )
+{
+  UINT64 Start;
+
+  if (GigAdapter->TraceTscHz == 0) {
+    Start = INTELGBE_TRACE_TIMESTAMP ();
+    gBS->Stall (TRACE_CALIBRATE_US);
+    GigAdapter->TraceTscHz = MultU64x32 (INTELGBE_TRACE_TIMESTAMP () - Start,
+                               1000000 / TRACE_CALIBRATE_US);
+  }
+}
+
+/** Selects the event classes recorded in the trace ring.
+
+   A non-zero mask starts a new trace, a zero mask stops tracing and keeps
+   the records so they can still be read out.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+   @param[in]   Mask         Bit per INTELGBE_TRACE_CLASS_*
+
+   @retval   EFI_SUCCESS             Trace mask applied
+   @retval   EFI_INVALID_PARAMETER   Unknown class in Mask
+   @retval   EFI_OUT_OF_RESOURCES    Could not allocate the trace ring
+**/
+EFI_STATUS
+IntelgbeSetTrace (
+  GIG_DRIVER_DATA *GigAdapter,
+  UINT32           Mask
+  )
+{
+  if ((Mask & ~((1U << (INTELGBE_TRACE_CLASS_CMD + 1)) - 1)) != 0) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (Mask == 0) {
+    GigAdapter->TraceMask = 0;
+    return EFI_SUCCESS;
+  }
+
+  if (GigAdapter->TraceRing == NULL) {
+    GigAdapter->TraceRing = AllocateZeroPool (
+                              sizeof (INTELGBE_TRACE_RECORD) * INTELGBE_TRACE_RECORDS
+                              );
+    if (GigAdapter->TraceRing == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+
+  IntelgbeCalibrateTsc (GigAdapter);
+
+  GigAdapter->TraceWritten = 0;
+  GigAdapter->TraceMask    = Mask;
+
+  return EFI_SUCCESS;
+}
+
+/** Copies the newest records out of the trace ring, oldest first.
+
+   @param[in]   GigAdapter   Pointer to the driver structure
+   @param[out]  Records      Buffer for Count records
+   @param[in]   Count        Records to copy, at most INTELGBE_TRACE_RECORDS
+
+   @return   Records written since the trace was started
+**/
+UINT64
+IntelgbeTraceCopy (
+  GIG_DRIVER_DATA       *GigAdapter,
+  INTELGBE_TRACE_RECORD *Records,
+  UINT32                 Count
+  )
+{
+  EFI_TPL OldTpl;
+  UINT64  Written;
+  UINT32  First;
+  UINT32  Tail;
+
+  // The datapath runs at TPL_CALLBACK, keep it from writing while we copy.
+  OldTpl  = gBS->RaiseTPL (TPL_NOTIFY);
+  Written = GigAdapter->TraceWritten;
+  if (Count > Written) {
+    Count = (UINT32) Written;
+  }
+  if ((GigAdapter->TraceRing != NULL) && (Count != 0)) {
+    First = (UINT32) ((Written - Count) & (INTELGBE_TRACE_RECORDS - 1));
+    Tail  = MIN (Count, INTELGBE_TRACE_RECORDS - First);
+    CopyMem (Records, &GigAdapter->TraceRing[First],
+      Tail * sizeof (INTELGBE_TRACE_RECORD));
+    CopyMem (&Records[Tail], GigAdapter->TraceRing,
+      (Count - Tail) * sizeof (INTELGBE_TRACE_RECORD));
+  }
+  gBS->RestoreTPL (OldTpl);
+
+  return Written;
+}
@@ -0,0 +1,88 @@
+/** @file
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+/* Binary trace of the transmit, receive and status paths.
+
+   Every event is a fixed size record in a per-adapter ring. Recording costs
+   a mask test when the event's class is off and a handful of stores when it
+   is on, so tracing can stay enabled under load where DEBUGPRINT cannot.
+   The ring is read out through the INTELGBE_ADAPTER_INFO_TRACE Adapter
+   Information type and decoded offline with the definitions below. */
+
+/* Records kept per adapter, a power of two */
+#define INTELGBE_TRACE_RECORDS        4096
+
+/* Event classes, selected through the trace mask */
+#define INTELGBE_TRACE_CLASS_TX       0
+#define INTELGBE_TRACE_CLASS_RX       1
+#define INTELGBE_TRACE_CLASS_STATUS   2
+#define INTELGBE_TRACE_CLASS_CMD      3
+
+#define INTELGBE_TRACE_EVENT(Class, Id)   ((UINT16) (((Class) << 8) | (Id)))
+#define INTELGBE_TRACE_MASK(Event)        (1U << ((Event) >> 8))
+
+/* Transmit:    Arg0          Arg1        Arg2          Arg3 */
+#define INTELGBE_TRACE_TX_SUBMIT      INTELGBE_TRACE_EVENT (INTELGBE_TRACE_CLASS_TX, 1)  // queue, entry, length, descriptors
+#define INTELGBE_TRACE_TX_RING_FULL   INTELGBE_TRACE_EVENT (INTELGBE_TRACE_CLASS_TX, 2)  // queue, cur, dirty, descriptors needed
+#define INTELGBE_TRACE_TX_MAP_FAIL    INTELGBE_TRACE_EVENT (INTELGBE_TRACE_CLASS_TX, 3)  // queue, entry, requested, mapped
+#define INTELGBE_TRACE_TX_RECLAIM     INTELGBE_TRACE_EVENT (INTELGBE_TRACE_CLASS_TX, 4)  // queue, cur, dirty, free slots
+#define INTELGBE_TRACE_TX_DONE        INTELGBE_TRACE_EVENT (INTELGBE_TRACE_CLASS_TX, 5)  // queue, entry, TDES3
+#define INTELGBE_TRACE_TX_ERROR       INTELGBE_TRACE_EVENT (INTELGBE_TRACE_CLASS_TX, 6)  // queue, entry, TDES3
+
+/* Receive */
+#define INTELGBE_TRACE_RX_FRAME       INTELGBE_TRACE_EVENT (INTELGBE_TRACE_CLASS_RX, 1)  // entry, length, PXE_FRAME_TYPE, RDES3
+#define INTELGBE_TRACE_RX_ERROR       INTELGBE_TRACE_EVENT (INTELGBE_TRACE_CLASS_RX, 2)  // entry, RDES2, RDES3
+
+/* GetStatus */
+#define INTELGBE_TRACE_STATUS         INTELGBE_TRACE_EVENT (INTELGBE_TRACE_CLASS_STATUS, 1)  // OpFlags, TX buffers returned, StatFlags
+#define INTELGBE_TRACE_STATUS_INT     INTELGBE_TRACE_EVENT (INTELGBE_TRACE_CLASS_STATUS, 2)  // DMA channel, DMA_INTR_STATUS
+#define INTELGBE_TRACE_STATUS_ABNORM  INTELGBE_TRACE_EVENT (INTELGBE_TRACE_CLASS_STATUS, 3)  // DMA channel, DMA_INTR_STATUS
+#define INTELGBE_TRACE_LINK_DOWN      INTELGBE_TRACE_EVENT (INTELGBE_TRACE_CLASS_STATUS, 4)
+
+/* UNDI commands */
+#define INTELGBE_TRACE_CMD            INTELGBE_TRACE_EVENT (INTELGBE_TRACE_CLASS_CMD, 1)  // OpCode, OpFlags, CPBsize, DBsize
+#define INTELGBE_TRACE_CMD_BUSY       INTELGBE_TRACE_EVENT (INTELGBE_TRACE_CLASS_CMD, 2)  // OpCode
+#define INTELGBE_TRACE_CMD_BAD_CDB    INTELGBE_TRACE_EVENT (INTELGBE_TRACE_CLASS_CMD, 3)  // OpCode, StatCode, StatFlags
+
+#pragma pack(1)
+typedef struct {
+  UINT64  Tsc;       // Time stamp counter, 0 where the CPU has none
+  UINT16  Event;     // INTELGBE_TRACE_*
+  UINT16  Reserved;
+  UINT32  Sequence;  // Low bits of the record number, shows where the ring wrapped
+  UINT32  Arg[4];
+} INTELGBE_TRACE_RECORD;
+#pragma pack()
+
+#if defined (MDE_CPU_IA32) || defined (MDE_CPU_X64)
+#define INTELGBE_TRACE_TIMESTAMP()  AsmReadTsc ()
+#else
+#define INTELGBE_TRACE_TIMESTAMP()  0
+#endif
+
+#ifndef INTELGBE_NO_TRACE
+/** Records an event when its class is enabled on the adapter.
+
+   @param[in]   Adapter   GIG_DRIVER_DATA pointer
+   @param[in]   Event     INTELGBE_TRACE_* event
+   @param[in]   A0..A3    Event arguments
+**/
+#define INTELGBE_TRACE(Adapter, Event, A0, A1, A2, A3) \
+  do { \
+    if (((Adapter)->TraceMask & INTELGBE_TRACE_MASK (Event)) != 0) { \
+      IntelgbeTraceRecord ((Adapter), (Event), (UINT32) (A0), (UINT32) (A1), \
+        (UINT32) (A2), (UINT32) (A3)); \
+    } \
+  } while (FALSE)
+#else
+#define INTELGBE_TRACE(Adapter, Event, A0, A1, A2, A3)
+#endif /* INTELGBE_NO_TRACE */
+
+#endif /* TRACE_H_ */
@@ -0,0 +1,216 @@
+/** @file
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+#include "Intelgbe.h"
+#include "VlanOffload.h"
+
+/* Global variables */
+
+EFI_GUID gEdkiiNicVlanOffloadProtocolGuid = EDKII_NIC_VLAN_OFFLOAD_PROTOCOL_GUID;
+
+/** Adds or removes a VLAN from the set of VLANs received by the adapter
+
+   @param[in]   This     Current EDKII_NIC_VLAN_OFFLOAD_PROTOCOL instance
+   @param[in]   VlanId   VLAN ID, 1-4094
+   @param[in]   Enable   TRUE to receive frames of VlanId, FALSE to stop
+
+   @retval      EFI_SUCCESS             VLAN set updated
+   @retval      EFI_INVALID_PARAMETER   This is NULL or VlanId is out of range
+**/
+EFI_STATUS
+EFIAPI
+UndiVlanSetFilter (
+  IN EDKII_NIC_VLAN_OFFLOAD_PROTOCOL  *This,
+  IN UINT16                           VlanId,
+  IN BOOLEAN                          Enable
+  )
+{
+  UNDI_PRIVATE_DATA *UndiPrivateData;
+  GIG_DRIVER_DATA   *GigAdapter;
+  UINT16            Hash;
+  UINTN             Vid;
+
+  if ((This == NULL)
+    || (VlanId == 0)
+    || (VlanId > 4094))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  UndiPrivateData = UNDI_PRIVATE_DATA_FROM_VLAN_OFFLOAD (This);
+  GigAdapter = &UndiPrivateData->NicInfo;
+
+  DEBUGPRINT (VLAN, ("VLAN %d %a\n", VlanId, Enable ? "enabled" : "disabled"));
+
+  if (Enable) {
+    GigAdapter->ActiveVlans[VlanId / 8] |= (UINT8) (1 << (VlanId % 8));
+  } else {
+    GigAdapter->ActiveVlans[VlanId / 8] &= (UINT8) ~(1 << (VlanId % 8));
+  }
+
+  // Several VLAN IDs share a hash bit, so rebuild the table from the full set.
+  Hash = 0;
+  for (Vid = 1; Vid < UNDI_VLAN_ID_COUNT; Vid++) {
+    if ((GigAdapter->ActiveVlans[Vid / 8] & (1 << (Vid % 8))) != 0) {
+      Hash |= (UINT16) (1 << intelgbe_vlan_hash_bit ((UINT16) Vid));
+    }
+  }
+
+  // Before Initialize the table is only recorded, init_hw programs it.
+  if (GigAdapter->State == PXE_STATFLAGS_GET_STATE_INITIALIZED) {
+    intelgbe_update_vlan_hash (&GigAdapter->Hw, Hash);
+  } else {
+    GigAdapter->Hw.mac.vlan_hash = Hash;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/** Sets the VLAN tag inserted into the next transmitted frame
+
+   @param[in]   This     Current EDKII_NIC_VLAN_OFFLOAD_PROTOCOL instance
+   @param[in]   Tci      Tag control information, 0 to send untagged
+
+   @retval      EFI_SUCCESS             Tag will be used for the next frame
+   @retval      EFI_INVALID_PARAMETER   This is NULL
+   @retval      EFI_UNSUPPORTED         Adapter cannot insert tags
+**/
+EFI_STATUS
+EFIAPI
+UndiVlanSetTxTag (
+  IN EDKII_NIC_VLAN_OFFLOAD_PROTOCOL  *This,
+  IN UINT16                           Tci
+  )
+{
+  UNDI_PRIVATE_DATA *UndiPrivateData;
+
+  if (This == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  UndiPrivateData = UNDI_PRIVATE_DATA_FROM_VLAN_OFFLOAD (This);
+
+  if (!UndiPrivateData->NicInfo.Hw.mac.vlan_insert) {
+    return EFI_UNSUPPORTED;
+  }
+
+  UndiPrivateData->NicInfo.TxVlanTci = Tci;
+  return EFI_SUCCESS;
+}
+
+/** Gets the VLAN tag stripped from the last received frame
+
+   @param[in]   This     Current EDKII_NIC_VLAN_OFFLOAD_PROTOCOL instance
+   @param[out]  Tci      Tag control information
+
+   @retval      EFI_SUCCESS             Tci holds the stripped tag
+   @retval      EFI_NOT_FOUND           Frame was received untagged
+   @retval      EFI_INVALID_PARAMETER   This or Tci is NULL
+**/
+EFI_STATUS
+EFIAPI
+UndiVlanGetRxTag (
+  IN  EDKII_NIC_VLAN_OFFLOAD_PROTOCOL  *This,
+  OUT UINT16                           *Tci
+  )
+{
+  UNDI_PRIVATE_DATA *UndiPrivateData;
+
+  if ((This == NULL)
+    || (Tci == NULL))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  UndiPrivateData = UNDI_PRIVATE_DATA_FROM_VLAN_OFFLOAD (This);
+
+  if (UndiPrivateData->NicInfo.RxVlanTci == 0) {
+    return EFI_NOT_FOUND;
+  }
+
+  *Tci = UndiPrivateData->NicInfo.RxVlanTci;
+  return EFI_SUCCESS;
+}
+
+/** Initializes and installs VLAN Offload Protocol on adapter
+
+   @param[in]   UndiPrivateData   Driver private data structure
+
+   @retval    EFI_SUCCESS   Protocol installed successfully
+   @retval    !EFI_SUCCESS  Failed to install and initialize protocol
+**/
+EFI_STATUS
+InitVlanOffloadProtocol (
+  IN UNDI_PRIVATE_DATA *UndiPrivateData
+  )
+{
+  EFI_STATUS                      Status;
+  EDKII_NIC_VLAN_OFFLOAD_PROTOCOL *VlanOffload;
+  struct intelgbe_mac_info        *Mac;
+
+  DEBUGPRINT (VLAN, ("%a, %d\n", __FUNCTION__, __LINE__));
+
+  VlanOffload = &UndiPrivateData->VlanOffload;
+  Mac = &UndiPrivateData->NicInfo.Hw.mac;
+
+  VlanOffload->Revision     = EDKII_NIC_VLAN_OFFLOAD_PROTOCOL_REVISION;
+  VlanOffload->Capabilities = EDKII_NIC_VLAN_OFFLOAD_RX_STRIP;
+  if (Mac->vlan_insert) {
+    VlanOffload->Capabilities |= EDKII_NIC_VLAN_OFFLOAD_TX_INSERT;
+  }
+  if (Mac->vlan_hash_filter) {
+    VlanOffload->Capabilities |= EDKII_NIC_VLAN_OFFLOAD_FILTER;
+  }
+  VlanOffload->SetFilter = UndiVlanSetFilter;
+  VlanOffload->SetTxTag  = UndiVlanSetTxTag;
+  VlanOffload->GetRxTag  = UndiVlanGetRxTag;
+
+  Status = gBS->InstallProtocolInterface (
+                  &UndiPrivateData->DeviceHandle,
+                  &gEdkiiNicVlanOffloadProtocolGuid,
+                  EFI_NATIVE_INTERFACE,
+                  VlanOffload
+                );
+  if (EFI_ERROR (Status)) {
+    DEBUGPRINT (VLAN,
+      ("InstallProtocolInterface returned %r\n", Status));
+    return Status;
+  }
+
+  return Status;
+}
+
+/** Uninstalls VLAN Offload Protocol
+
+   @param[in]   UndiPrivateData   Driver private data structure
+
+   @retval     EFI_SUCCESS    Protocol uninstalled successfully
+   @retval     !EFI_SUCCESS   Failed to uninstall protocol
+**/
+EFI_STATUS
+UninstallVlanOffloadProtocol (
+  IN UNDI_PRIVATE_DATA *UndiPrivateData
+  )
+{
+  EFI_STATUS Status;
+
+  DEBUGPRINT (VLAN, ("%a, %d\n", __FUNCTION__, __LINE__));
+
+  Status = gBS->UninstallProtocolInterface (
+                  UndiPrivateData->DeviceHandle,
+                  &gEdkiiNicVlanOffloadProtocolGuid,
+                  &UndiPrivateData->VlanOffload
+                );
+  if (EFI_ERROR (Status)) {
+    DEBUGPRINT (VLAN,
+      ("UnInstallProtocolInterface returned %r\n", Status));
+    return Status;
+  }
+
+  return Status;
+}
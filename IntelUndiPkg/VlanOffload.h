@@ -0,0 +1,42 @@
+/** @file
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef VLAN_OFFLOAD_H_
+#define VLAN_OFFLOAD_H_
+
+#include <Protocol/NicVlanOffload.h>
+
+typedef struct UNDI_PRIVATE_DATA_S UNDI_PRIVATE_DATA;
+
+/* Number of VLAN IDs tracked by the VLAN offload protocol */
+#define UNDI_VLAN_ID_COUNT 4096
+
+/** Initializes and installs VLAN Offload Protocol on adapter
+
+   @param[in]   UndiPrivateData   Driver private data structure
+
+   @retval    EFI_SUCCESS   Protocol installed successfully
+   @retval    !EFI_SUCCESS  Failed to install and initialize protocol
+**/
+EFI_STATUS
+InitVlanOffloadProtocol (
+  IN UNDI_PRIVATE_DATA *UndiPrivateData
+  );
+
+/** Uninstalls VLAN Offload Protocol
+
+   @param[in]   UndiPrivateData   Driver private data structure
+
+   @retval     EFI_SUCCESS    Protocol uninstalled successfully
+   @retval     !EFI_SUCCESS   Failed to uninstall protocol
+**/
+EFI_STATUS
+UninstallVlanOffloadProtocol (
+  IN UNDI_PRIVATE_DATA *UndiPrivateData
+  );
+
+#endif /* VLAN_OFFLOAD_H_ */
@@ -72,6 +72,9 @@ ArpOnFrameRcvdDpc (
   EFI_MANAGED_NETWORK_COMPLETION_TOKEN  *RxToken;
   EFI_MANAGED_NETWORK_RECEIVE_DATA      *RxData;
   ARP_HEAD                              *Head;
+  UINT16                                HwType;
+  UINT16                                ProtoType;
+  UINT16                                OpCode;
   ARP_ADDRESS                           ArpAddress;
   ARP_CACHE_ENTRY                       *CacheEntry;
   LIST_ENTRY                            *Entry;
@@ -117,18 +120,19 @@ ArpOnFrameRcvdDpc (
   }
 
   //
-  // Convert the byte order of the multi-byte fields.
+  // Convert the byte order of the multi-byte fields into locals, the frame
+  // may be shared with other MNP instances and must not be written.
   //
-  Head   = (ARP_HEAD *) RxData->PacketData;
-  Head->HwType    = NTOHS (Head->HwType);
-  Head->ProtoType = NTOHS (Head->ProtoType);
-  Head->OpCode    = NTOHS (Head->OpCode);
+  Head      = (ARP_HEAD *) RxData->PacketData;
+  HwType    = NTOHS (Head->HwType);
+  ProtoType = NTOHS (Head->ProtoType);
+  OpCode    = NTOHS (Head->OpCode);
 
   if (RxData->DataLength < (sizeof (ARP_HEAD) + 2 * Head->HwAddrLen + 2 * Head->ProtoAddrLen)) {
     goto RECYCLE_RXDATA;
   }
 
-  if ((Head->HwType != ArpService->SnpMode.IfType) ||
+  if ((HwType != ArpService->SnpMode.IfType) ||
     (Head->HwAddrLen != ArpService->SnpMode.HwAddressSize) ||
     (RxData->ProtocolType != ARP_ETHER_PROTO_TYPE)) {
     //
@@ -146,11 +150,11 @@ ArpOnFrameRcvdDpc (
   ArpAddress.TargetHwAddr    = ArpAddress.SenderProtoAddr + Head->ProtoAddrLen;
   ArpAddress.TargetProtoAddr = ArpAddress.TargetHwAddr + Head->HwAddrLen;
 
-  SenderAddress[Hardware].Type       = Head->HwType;
+  SenderAddress[Hardware].Type       = HwType;
   SenderAddress[Hardware].Length     = Head->HwAddrLen;
   SenderAddress[Hardware].AddressPtr = ArpAddress.SenderHwAddr;
 
-  SenderAddress[Protocol].Type       = Head->ProtoType;
+  SenderAddress[Protocol].Type       = ProtoType;
   SenderAddress[Protocol].Length     = Head->ProtoAddrLen;
   SenderAddress[Protocol].AddressPtr = ArpAddress.SenderProtoAddr;
 
@@ -182,7 +186,7 @@ ArpOnFrameRcvdDpc (
     ConfigData = &Instance->ConfigData;
 
     if ((Instance->Configured) &&
-      (Head->ProtoType == ConfigData->SwAddressType) &&
+      (ProtoType == ConfigData->SwAddressType) &&
       (Head->ProtoAddrLen == ConfigData->SwAddressLength)) {
       //
       // The protocol type is matched for the received arp packet.
@@ -282,7 +286,7 @@ ArpOnFrameRcvdDpc (
     InsertHeadList (&ArpService->ResolvedCacheTable, &CacheEntry->List);
   }
 
-  if (Head->OpCode == ARP_OPCODE_REQUEST) {
+  if (OpCode == ARP_OPCODE_REQUEST) {
     //
     // Send back the ARP Reply. If we reach here, Instance is not NULL and CacheEntry
     // is not NULL.
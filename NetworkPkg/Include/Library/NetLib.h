@@ -1929,6 +1929,38 @@ NetbufFromExt (
   IN VOID                   *Arg          OPTIONAL
   );
 
+/**
+  Build a NET_BUF from an external block that other readers share.
+
+  Unlike NetbufFromExt, the HeadLen bytes of header are always copied into a
+  block owned by the net buffer, even when the external block alone would hold
+  them linearly. The caller may then rewrite the header in place, for example
+  to convert it to host byte order, while the rest of the data stays shared.
+  This is the copy-on-write counterpart of NetbufFromExt for receive buffers
+  that the Managed Network Protocol hands to several instances at once.
+
+  @param[in]  ExtFragment           The pointer to the data block.
+  @param[in]  HeadSpace             The head space to be reserved.
+  @param[in]  HeadLen               The length of the protocol header to copy.
+  @param[in]  ExtFree               The pointer to the caller-provided free function.
+  @param[in]  Arg                   The argument passed to ExtFree when ExtFree is
+                                    called.
+
+  @return                  The pointer to the net buffer built from the data block,
+                           or NULL if the allocation failed due to resource
+                           limit.
+
+**/
+NET_BUF  *
+EFIAPI
+NetbufFromSharedExt (
+  IN NET_FRAGMENT           *ExtFragment,
+  IN UINT32                 HeadSpace,
+  IN UINT32                 HeadLen,
+  IN NET_VECTOR_EXT_FREE    ExtFree,
+  IN VOID                   *Arg          OPTIONAL
+  );
+
 /**
   Build a fragment table to contain the fragments in the net buffer. This is the
   opposite operation of the NetbufFromExt.
@@ -0,0 +1,86 @@
+/** @file
+
+  EDK II MNP Poll Info Protocol.
+
+  Installed by the MNP driver on each controller it manages to report how
+  often the background poll ran, how many frames it received and what
+  handing them to the MNP instances cost. The poll period adapts to the
+  traffic: it shortens while frames are flowing and backs off while the link
+  is idle, so benchmarks read the effective rate here rather than assuming a
+  fixed period.
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __MNP_POLL_INFO_H__
+#define __MNP_POLL_INFO_H__
+
+//
+// MNP Poll Info Protocol GUID value
+//
+#define EDKII_MNP_POLL_INFO_PROTOCOL_GUID \
+    { \
+      0x826db6d5, 0x65fc, 0x43ea, { 0x8c, 0x5f, 0xc7, 0x73, 0x2d, 0x8d, 0x94, 0x2e } \
+    }
+
+#define EDKII_MNP_POLL_INFO_PROTOCOL_REVISION  0x00010001
+
+//
+// Forward reference for pure ANSI compatibility
+//
+typedef struct _EDKII_MNP_POLL_INFO_PROTOCOL  EDKII_MNP_POLL_INFO_PROTOCOL;
+
+///
+/// Background poll counters. The effective poll rate in polls per second is
+/// Polls * 10,000,000 / PolledTime.
+///
+typedef struct {
+  UINT64  Interval;     ///< Current poll period in 100ns units, 0 while the background poll is off.
+  UINT64  MinInterval;  ///< Period used while frames are flowing.
+  UINT64  MaxInterval;  ///< Period the poll backs off to while the link is idle.
+  UINT32  Budget;       ///< Frames received per poll at most.
+  UINT32  Reserved;
+  UINT64  Polls;        ///< Polls run.
+  UINT64  PolledTime;   ///< Sum of the periods the polls ran at, in 100ns units.
+  UINT64  Frames;       ///< Frames received by the polls.
+  UINT64  BudgetHits;   ///< Polls that stopped at Budget with frames likely left.
+  //
+  // Added in revision 0x00010001.
+  //
+  UINT64  RxWraps;            ///< Received frames handed to an instance, once per matching instance.
+  UINT64  RxWrapAllocations;  ///< Pool allocations and events created to hand them over.
+} EDKII_MNP_POLL_INFO;
+
+/**
+  Read the background poll counters.
+
+  @param  This  The protocol instance pointer.
+  @param  Info  Returns the counters.
+
+  @retval EFI_SUCCESS            The counters were returned.
+  @retval EFI_INVALID_PARAMETER  Info is NULL.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_MNP_GET_POLL_INFO)(
+  IN  EDKII_MNP_POLL_INFO_PROTOCOL  *This,
+  OUT EDKII_MNP_POLL_INFO           *Info
+  );
+
+///
+/// MNP Poll Info Protocol structure.
+///
+struct _EDKII_MNP_POLL_INFO_PROTOCOL {
+  UINT64                   Revision;
+  EDKII_MNP_GET_POLL_INFO  GetPollInfo;
+};
+
+///
+/// MNP Poll Info Protocol GUID variable.
+///
+extern EFI_GUID gEdkiiMnpPollInfoProtocolGuid;
+
+#endif
@@ -0,0 +1,141 @@
+/** @file
+
+  EDK II NIC Datapath Protocol.
+
+  Installed by a network controller driver next to its NII instance to offer
+  typed transmit, receive and status entry points bound to one interface.
+  SNP may use them in place of issuing UNDI commands, which saves building
+  and validating a CDB for every frame. The UNDI command interface remains
+  the reference behavior and stays fully usable.
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __NIC_DATAPATH_H__
+#define __NIC_DATAPATH_H__
+
+#include <Uefi/UefiPxe.h>
+
+//
+// NIC Datapath Protocol GUID value
+//
+#define EDKII_NIC_DATAPATH_PROTOCOL_GUID \
+    { \
+      0xbc25f50f, 0xefd9, 0x458c, { 0x82, 0x1c, 0x23, 0x0d, 0x83, 0x7b, 0x92, 0x47 } \
+    }
+
+#define EDKII_NIC_DATAPATH_PROTOCOL_REVISION  0x00010000
+
+//
+// Forward reference for pure ANSI compatibility
+//
+typedef struct _EDKII_NIC_DATAPATH_PROTOCOL  EDKII_NIC_DATAPATH_PROTOCOL;
+
+/**
+  Place one frame, media header included, on the transmit queue.
+
+  Same semantics as the UNDI Transmit command with a whole frame: the buffer
+  belongs to the controller until ReclaimTx() returns its address.
+
+  @param  This        The protocol instance pointer.
+  @param  FrameAddr   Address of the frame.
+  @param  FrameLen    Length of the frame in bytes.
+
+  @retval EFI_SUCCESS       The frame was queued.
+  @retval EFI_NOT_READY     The transmit queue is full or the controller is busy.
+  @retval EFI_NOT_STARTED   The interface is not initialized.
+  @retval EFI_DEVICE_ERROR  The frame could not be queued.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_NIC_DATAPATH_TRANSMIT)(
+  IN EDKII_NIC_DATAPATH_PROTOCOL  *This,
+  IN UINT64                       FrameAddr,
+  IN UINT32                       FrameLen
+  );
+
+/**
+  Copy the next received frame into a buffer.
+
+  Same semantics as the UNDI Receive command. When the buffer is too short
+  the frame is truncated and Db->FrameLen still holds its full length.
+
+  @param  This        The protocol instance pointer.
+  @param  BufferAddr  Address of the receive buffer.
+  @param  BufferLen   Length of the receive buffer in bytes.
+  @param  Db          Returns the frame length, header and addresses.
+
+  @retval EFI_SUCCESS       A frame was received.
+  @retval EFI_NOT_READY     No frame is waiting.
+  @retval EFI_NOT_STARTED   The interface is not initialized.
+  @retval EFI_DEVICE_ERROR  The frame could not be received.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_NIC_DATAPATH_RECEIVE)(
+  IN  EDKII_NIC_DATAPATH_PROTOCOL  *This,
+  IN  UINT64                       BufferAddr,
+  IN  UINT32                       BufferLen,
+  OUT PXE_DB_RECEIVE               *Db
+  );
+
+/**
+  Return the addresses of frames whose transmission has completed.
+
+  @param  This      The protocol instance pointer.
+  @param  Buffers   Returns up to *Count frame addresses.
+  @param  Count     On entry the size of Buffers, on exit the number written.
+
+  @retval EFI_SUCCESS       *Count addresses were written, possibly none.
+  @retval EFI_NOT_STARTED   The interface is not initialized.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_NIC_DATAPATH_RECLAIM_TX)(
+  IN     EDKII_NIC_DATAPATH_PROTOCOL  *This,
+  OUT    UINT64                       *Buffers,
+  IN OUT UINT32                       *Count
+  );
+
+/**
+  Read and clear the interrupt status, and optionally read the media state.
+
+  @param  This              The protocol instance pointer.
+  @param  InterruptStatus   Returns EFI_SIMPLE_NETWORK_*_INTERRUPT bits. Optional,
+                            the interrupt status is left pending when NULL.
+  @param  MediaPresent      Returns the link state. Optional.
+
+  @retval EFI_SUCCESS       The status was read.
+  @retval EFI_NOT_STARTED   The interface is not initialized.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_NIC_DATAPATH_POLL_STATUS)(
+  IN  EDKII_NIC_DATAPATH_PROTOCOL  *This,
+  OUT UINT32                       *InterruptStatus  OPTIONAL,
+  OUT BOOLEAN                      *MediaPresent     OPTIONAL
+  );
+
+///
+/// NIC Datapath Protocol structure.
+///
+struct _EDKII_NIC_DATAPATH_PROTOCOL {
+  UINT64                          Revision;
+  EDKII_NIC_DATAPATH_TRANSMIT     Transmit;
+  EDKII_NIC_DATAPATH_RECEIVE      Receive;
+  EDKII_NIC_DATAPATH_RECLAIM_TX   ReclaimTx;
+  EDKII_NIC_DATAPATH_POLL_STATUS  PollStatus;
+};
+
+///
+/// NIC Datapath Protocol GUID variable.
+///
+extern EFI_GUID gEdkiiNicDatapathProtocolGuid;
+
+#endif
@@ -0,0 +1,118 @@
+/** @file
+
+  EDK II NIC VLAN Offload Protocol.
+
+  Installed by a network controller driver next to its NII/SNP instance when
+  the controller can insert, strip and filter 802.1Q tags in hardware. MNP
+  uses it instead of editing the frame in software.
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __NIC_VLAN_OFFLOAD_H__
+#define __NIC_VLAN_OFFLOAD_H__
+
+//
+// NIC VLAN Offload Protocol GUID value
+//
+#define EDKII_NIC_VLAN_OFFLOAD_PROTOCOL_GUID \
+    { \
+      0xa24314a2, 0x5e90, 0x4d7d, { 0xbd, 0x04, 0x42, 0x3d, 0xc1, 0x6a, 0x68, 0x98 } \
+    }
+
+#define EDKII_NIC_VLAN_OFFLOAD_PROTOCOL_REVISION  0x00010000
+
+//
+// Capabilities
+//
+#define EDKII_NIC_VLAN_OFFLOAD_TX_INSERT  BIT0  ///< SetTxTag() is supported.
+#define EDKII_NIC_VLAN_OFFLOAD_RX_STRIP   BIT1  ///< Tags are stripped and returned by GetRxTag().
+#define EDKII_NIC_VLAN_OFFLOAD_FILTER     BIT2  ///< Frames of unknown VLANs are dropped by the NIC.
+
+//
+// Forward reference for pure ANSI compatibility
+//
+typedef struct _EDKII_NIC_VLAN_OFFLOAD_PROTOCOL  EDKII_NIC_VLAN_OFFLOAD_PROTOCOL;
+
+/**
+  Add or remove a VLAN from the set of VLANs received by the controller.
+
+  Stripping is active while at least one VLAN is enabled; with no VLAN
+  enabled frames are received unmodified.
+
+  @param  This     The protocol instance pointer.
+  @param  VlanId   The VLAN ID, 1-4094.
+  @param  Enable   TRUE to receive frames of VlanId, FALSE to stop.
+
+  @retval EFI_SUCCESS            The VLAN set was updated.
+  @retval EFI_INVALID_PARAMETER  This is NULL or VlanId is out of range.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_NIC_VLAN_OFFLOAD_SET_FILTER)(
+  IN EDKII_NIC_VLAN_OFFLOAD_PROTOCOL  *This,
+  IN UINT16                           VlanId,
+  IN BOOLEAN                          Enable
+  );
+
+/**
+  Set the 802.1Q tag control information the controller inserts into the
+  next frame passed to the Transmit() function of the SNP on this handle.
+
+  The tag is consumed by that one transmit attempt, so it must be set again
+  before retrying a transmit.
+
+  @param  This     The protocol instance pointer.
+  @param  Tci      The tag control information, 0 to send untagged.
+
+  @retval EFI_SUCCESS            The tag will be used for the next frame.
+  @retval EFI_INVALID_PARAMETER  This is NULL.
+  @retval EFI_UNSUPPORTED        The controller cannot insert tags.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_NIC_VLAN_OFFLOAD_SET_TX_TAG)(
+  IN EDKII_NIC_VLAN_OFFLOAD_PROTOCOL  *This,
+  IN UINT16                           Tci
+  );
+
+/**
+  Get the 802.1Q tag control information stripped from the frame most
+  recently returned by the Receive() function of the SNP on this handle.
+
+  @param  This     The protocol instance pointer.
+  @param  Tci      Returns the tag control information.
+
+  @retval EFI_SUCCESS            Tci holds the stripped tag.
+  @retval EFI_NOT_FOUND          The frame was received untagged.
+  @retval EFI_INVALID_PARAMETER  This or Tci is NULL.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_NIC_VLAN_OFFLOAD_GET_RX_TAG)(
+  IN  EDKII_NIC_VLAN_OFFLOAD_PROTOCOL  *This,
+  OUT UINT16                           *Tci
+  );
+
+///
+/// NIC VLAN Offload Protocol structure.
+///
+struct _EDKII_NIC_VLAN_OFFLOAD_PROTOCOL {
+  UINT64                             Revision;
+  UINT32                             Capabilities;
+  EDKII_NIC_VLAN_OFFLOAD_SET_FILTER  SetFilter;
+  EDKII_NIC_VLAN_OFFLOAD_SET_TX_TAG  SetTxTag;
+  EDKII_NIC_VLAN_OFFLOAD_GET_RX_TAG  GetRxTag;
+};
+
+///
+/// NIC VLAN Offload Protocol GUID variable.
+///
+extern EFI_GUID gEdkiiNicVlanOffloadProtocolGuid;
+
+#endif
@@ -1256,12 +1256,18 @@ Ip4OnFrameReceivedDpc (
 
   //
   // Wrap the frame in a net buffer then deliver it to IP input.
-  // IP will reassemble the packet, and deliver it to upper layer
+  // IP will reassemble the packet, and deliver it to upper layer.
+  // When MNP shares the frame with other instances, take a private
+  // copy of the headers that IP converts in place.
   //
   Netfrag.Len  = MnpRxData->DataLength;
   Netfrag.Bulk = MnpRxData->PacketData;
 
-  Packet = NetbufFromExt (&Netfrag, 1, 0, IP4_MAX_HEADLEN, Ip4RecycleFrame, Token);
+  if (PcdGetBool (PcdMnpShareRxBuffers)) {
+    Packet = NetbufFromSharedExt (&Netfrag, 0, IP4_MAX_SHARED_HEADLEN, Ip4RecycleFrame, Token);
+  } else {
+    Packet = NetbufFromExt (&Netfrag, 1, 0, IP4_MAX_HEADLEN, Ip4RecycleFrame, Token);
+  }
 
   if (Packet == NULL) {
     gBS->SignalEvent (MnpRxData->RecycleEvent);
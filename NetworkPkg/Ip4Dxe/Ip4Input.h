@@ -11,6 +11,12 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define IP4_MIN_HEADLEN        20
 #define IP4_MAX_HEADLEN        60
 ///
+/// Header bytes copied out of a receive buffer MNP shares between instances:
+/// the IP header and the largest transport header (TCP, 60 bytes), which the
+/// upper layers expect linear.
+///
+#define IP4_MAX_SHARED_HEADLEN (IP4_MAX_HEADLEN + 60)
+///
 /// 8(ESP header) + 16(max IV) + 16(max padding) + 2(ESP tail) + 12(max ICV) = 54
 ///
 #define IP4_MAX_IPSEC_HEADLEN  54
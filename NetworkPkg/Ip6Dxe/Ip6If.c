@@ -498,12 +498,18 @@ Ip6OnFrameReceivedDpc (
 
   //
   // Wrap the frame in a net buffer then deliver it to IP input.
-  // IP will reassemble the packet, and deliver it to upper layer
+  // IP will reassemble the packet, and deliver it to upper layer.
+  // When MNP shares the frame with other instances, take a private
+  // copy of the headers that IP converts in place.
   //
   Netfrag.Len  = MnpRxData->DataLength;
   Netfrag.Bulk = MnpRxData->PacketData;
 
-  Packet = NetbufFromExt (&Netfrag, 1, IP6_MAX_HEADLEN, 0, Ip6RecycleFrame, Token->MnpToken.Packet.RxData);
+  if (PcdGetBool (PcdMnpShareRxBuffers)) {
+    Packet = NetbufFromSharedExt (&Netfrag, IP6_MAX_HEADLEN, IP6_MAX_SHARED_HEADLEN, Ip6RecycleFrame, Token->MnpToken.Packet.RxData);
+  } else {
+    Packet = NetbufFromExt (&Netfrag, 1, IP6_MAX_HEADLEN, 0, Ip6RecycleFrame, Token->MnpToken.Packet.RxData);
+  }
 
   if (Packet == NULL) {
     gBS->SignalEvent (MnpRxData->RecycleEvent);
@@ -13,6 +13,12 @@
 #define IP6_MIN_HEADLEN       40
 #define IP6_MAX_HEADLEN       120
 ///
+/// Header bytes copied out of a receive buffer MNP shares between instances:
+/// the IP headers and the largest transport header (TCP, 60 bytes), which the
+/// upper layers expect linear.
+///
+#define IP6_MAX_SHARED_HEADLEN (IP6_MAX_HEADLEN + 60)
+///
 /// 8(ESP header) + 16(max IV) + 16(max padding) + 2(ESP tail) + 12(max ICV) = 54
 ///
 #define IP6_MAX_IPSEC_HEADLEN 54
@@ -14,6 +14,33 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/MemoryAllocationLib.h>
 
+#if defined (MDE_CPU_X64)
+//
+// Blocks of data summed by the SSE2 checksum kernel, and the data length
+// from which calling it pays off. Wider AVX kernels are not used, the
+// firmware interrupt handlers only save the FXSAVE state and would clobber
+// the upper halves of the YMM registers.
+//
+#define NET_CHECKSUM_SIMD_BLOCK    64
+#define NET_CHECKSUM_SIMD_MIN_LEN  128
+
+/**
+  Sum Blocks 64-byte blocks of data as 32-bit words.
+
+  @param[in]   Bulk                  Pointer to the data.
+  @param[in]   Blocks                Number of 64-byte blocks, not zero.
+
+  @return    The sum, to be folded by NetChecksumFold.
+
+**/
+UINT64
+EFIAPI
+InternalNetChecksumSse2 (
+  IN UINT8                  *Bulk,
+  IN UINTN                  Blocks
+  );
+#endif
+
 
 /**
   Allocate and build up the sketch for a NET_BUF.
@@ -868,6 +895,53 @@ FreeFirstBlock:
 }
 
 
+/**
+  Build a NET_BUF from an external block that other readers share.
+
+  Unlike NetbufFromExt, the HeadLen bytes of header are always copied into a
+  block owned by the net buffer, even when the external block alone would hold
+  them linearly. The caller may then rewrite the header in place while the rest
+  of the data stays shared.
+
+  @param[in]  ExtFragment           Pointer to the data block.
+  @param[in]  HeadSpace             The head space to be reserved.
+  @param[in]  HeadLen               The length of the protocol header to copy.
+  @param[in]  ExtFree               Pointer to the caller provided free function.
+  @param[in]  Arg                   The argument passed to ExtFree when ExtFree is
+                                    called.
+
+  @return                  Pointer to the net buffer built from the data block,
+                           or NULL if the allocation failed due to resource
+                           limit.
+
+**/
+NET_BUF  *
+EFIAPI
+NetbufFromSharedExt (
+  IN NET_FRAGMENT           *ExtFragment,
+  IN UINT32                 HeadSpace,
+  IN UINT32                 HeadLen,
+  IN NET_VECTOR_EXT_FREE    ExtFree,
+  IN VOID                   *Arg          OPTIONAL
+  )
+{
+  NET_FRAGMENT              Fragment[2];
+
+  ASSERT (ExtFragment != NULL);
+
+  //
+  // NetbufFromExt only aggregates the header when it spans blocks. An empty
+  // leading block makes it span two, so the header is always pulled into the
+  // first block, which the net buffer owns.
+  //
+  Fragment[0].Bulk = ExtFragment->Bulk;
+  Fragment[0].Len  = 0;
+  Fragment[1]      = *ExtFragment;
+
+  return NetbufFromExt (Fragment, 2, HeadSpace, HeadLen, ExtFree, Arg);
+}
+
+
 /**
   Build a fragment table to contain the fragments in the net buffer. This is the
   opposite operation of the NetbufFromExt.
@@ -1640,47 +1714,139 @@ NetbufQueFlush (
 
 
 /**
-  Compute the checksum for a bulk of data.
+  Sum a bulk of data as 32-bit words into a 64-bit accumulator.
+
+  A 32-bit word folds to the same one's complement sum as its two 16-bit
+  halves, so the result folds to the checksum of the 16-bit words. Like the
+  16-bit words, a left-over byte is added as the low-order byte.
 
   @param[in]   Bulk                  Pointer to the data.
   @param[in]   Len                   Length of the data, in bytes.
 
-  @return    The computed checksum.
+  @return    The sum, to be folded by NetChecksumFold.
 
 **/
-UINT16
-EFIAPI
-NetblockChecksum (
+STATIC
+UINT64
+NetblockSum (
   IN UINT8                  *Bulk,
   IN UINT32                 Len
   )
 {
-  register UINT32           Sum;
+  UINT64                    Sum;
 
   Sum = 0;
 
-  //
-  // Add left-over byte, if any
-  //
-  if (Len % 2 != 0) {
-    Sum += *(Bulk + Len - 1);
+  while (Len >= 32) {
+    Sum += *(UINT32 *) Bulk;
+    Sum += *(UINT32 *) (Bulk + 4);
+    Sum += *(UINT32 *) (Bulk + 8);
+    Sum += *(UINT32 *) (Bulk + 12);
+    Sum += *(UINT32 *) (Bulk + 16);
+    Sum += *(UINT32 *) (Bulk + 20);
+    Sum += *(UINT32 *) (Bulk + 24);
+    Sum += *(UINT32 *) (Bulk + 28);
+    Bulk += 32;
+    Len  -= 32;
   }
 
-  while (Len > 1) {
+  while (Len >= 4) {
+    Sum += *(UINT32 *) Bulk;
+    Bulk += 4;
+    Len  -= 4;
+  }
+
+  if (Len >= 2) {
     Sum += *(UINT16 *) Bulk;
     Bulk += 2;
-    Len -= 2;
+    Len  -= 2;
+  }
+
+  //
+  // Add left-over byte, if any
+  //
+  if (Len != 0) {
+    Sum += *Bulk;
   }
 
+  return Sum;
+}
+
+
+/**
+  Fold a 64-bit sum to a 16-bit one's complement sum.
+
+  @param[in]   Sum                   The sum returned by NetblockSum or a
+                                     checksum kernel.
+
+  @return    The folded checksum.
+
+**/
+STATIC
+UINT16
+NetChecksumFold (
+  IN UINT64                 Sum
+  )
+{
+  UINT32                    Sum32;
+
+  Sum   = (Sum & 0xffffffff) + RShiftU64 (Sum, 32);
+  Sum   = (Sum & 0xffffffff) + RShiftU64 (Sum, 32);
+  Sum32 = (UINT32) Sum;
+
   //
   // Fold 32-bit sum to 16 bits
   //
-  while ((Sum >> 16) != 0) {
-    Sum = (Sum & 0xffff) + (Sum >> 16);
+  while ((Sum32 >> 16) != 0) {
+    Sum32 = (Sum32 & 0xffff) + (Sum32 >> 16);
+  }
+
+  return (UINT16) Sum32;
+}
+
 
+/**
+  Compute the checksum for a bulk of data.
+
+  On X64 the data is summed 64 bytes at a time with SSE2, and the rest with
+  a 64-bit accumulator.
+
+  @param[in]   Bulk                  Pointer to the data.
+  @param[in]   Len                   Length of the data, in bytes.
+
+  @return    The computed checksum.
+
+**/
+UINT16
+EFIAPI
+NetblockChecksum (
+  IN UINT8                  *Bulk,
+  IN UINT32                 Len
+  )
+{
+  UINT64                    Sum;
+#if defined (MDE_CPU_X64)
+  UINT32                    Blocks;
+#endif
+
+  Sum = 0;
+
+#if defined (MDE_CPU_X64)
+  if (Len >= NET_CHECKSUM_SIMD_MIN_LEN) {
+    //
+    // The blocks have an even length, the rest of the data keeps its
+    // byte order.
+    //
+    Blocks = Len / NET_CHECKSUM_SIMD_BLOCK;
+    Sum    = InternalNetChecksumSse2 (Bulk, Blocks);
+    Bulk  += Blocks * NET_CHECKSUM_SIMD_BLOCK;
+    Len   -= Blocks * NET_CHECKSUM_SIMD_BLOCK;
   }
+#endif
 
-  return (UINT16) Sum;
+  Sum += NetblockSum (Bulk, Len);
+
+  return NetChecksumFold (Sum);
 }
 
 
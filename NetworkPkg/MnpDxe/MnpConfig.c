@@ -25,6 +25,11 @@ EFI_MANAGED_NETWORK_PROTOCOL    mMnpProtocolTemplate = {
   MnpPoll
 };
 
+EDKII_MNP_POLL_INFO_PROTOCOL    mMnpPollInfoProtocolTemplate = {
+  EDKII_MNP_POLL_INFO_PROTOCOL_REVISION,
+  MnpGetPollInfo
+};
+
 EFI_MANAGED_NETWORK_CONFIG_DATA mMnpDefaultConfigData = {
   10000000,
   10000000,
@@ -405,6 +410,174 @@ MnpRecycleTxBuf (
   return EFI_SUCCESS;
 }
 
+/**
+  Add Count of RX data wraps, with their recycle events, to
+  MnpDeviceData->FreeRxDataWrapList.
+
+  @param[in, out]  MnpDeviceData         Pointer to the MNP_DEVICE_DATA.
+  @param[in]       Count                 Number of RX data wraps to add.
+
+  @retval EFI_SUCCESS           The specified amount of wraps are allocated
+                                and added into FreeRxDataWrapList.
+  @retval EFI_OUT_OF_RESOURCES  Failed to allocate a wrap or its event.
+
+**/
+EFI_STATUS
+MnpAddFreeRxDataWrap (
+  IN OUT MNP_DEVICE_DATA   *MnpDeviceData,
+  IN     UINTN             Count
+  )
+{
+  EFI_STATUS        Status;
+  UINT32            Index;
+  MNP_RXDATA_WRAP   *RxDataWrap;
+
+  NET_CHECK_SIGNATURE (MnpDeviceData, MNP_DEVICE_DATA_SIGNATURE);
+  ASSERT (Count > 0);
+
+  Status = EFI_SUCCESS;
+  for (Index = 0; Index < Count; Index++) {
+    RxDataWrap = AllocateZeroPool (sizeof (MNP_RXDATA_WRAP));
+    if (RxDataWrap == NULL) {
+      DEBUG ((EFI_D_ERROR, "MnpAddFreeRxDataWrap: RxDataWrap Alloc failed.\n"));
+
+      Status = EFI_OUT_OF_RESOURCES;
+      break;
+    }
+
+    Status = gBS->CreateEvent (
+                    EVT_NOTIFY_SIGNAL,
+                    TPL_NOTIFY,
+                    MnpRecycleRxData,
+                    RxDataWrap,
+                    &RxDataWrap->RecycleEvent
+                    );
+    if (EFI_ERROR (Status)) {
+      DEBUG ((EFI_D_ERROR, "MnpAddFreeRxDataWrap: gBS->CreateEvent failed, %r.\n", Status));
+
+      FreePool (RxDataWrap);
+      break;
+    }
+
+    InsertTailList (&MnpDeviceData->FreeRxDataWrapList, &RxDataWrap->WrapEntry);
+  }
+
+  MnpDeviceData->FreeRxDataWrapCount         += Index;
+  MnpDeviceData->RxDataWrapCount             += Index;
+  MnpDeviceData->PollStats.RxWrapAllocations += 2 * Index;
+  return Status;
+}
+
+/**
+  Take a RX data wrap from MnpDeviceData->FreeRxDataWrapList, growing the list
+  when it is empty.
+
+  @param[in, out]  MnpDeviceData         Pointer to the MNP_DEVICE_DATA.
+
+  @return Pointer to the wrap, NULL if none could be allocated.
+
+**/
+MNP_RXDATA_WRAP *
+MnpAllocRxDataWrap (
+  IN OUT MNP_DEVICE_DATA   *MnpDeviceData
+  )
+{
+  EFI_TPL           OldTpl;
+  LIST_ENTRY        *Entry;
+  MNP_RXDATA_WRAP   *RxDataWrap;
+
+  NET_CHECK_SIGNATURE (MnpDeviceData, MNP_DEVICE_DATA_SIGNATURE);
+
+  //
+  // The recycle events run at TPL_NOTIFY and return wraps to the list.
+  //
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+  if (IsListEmpty (&MnpDeviceData->FreeRxDataWrapList)) {
+    MnpAddFreeRxDataWrap (MnpDeviceData, MNP_RXDATA_WRAP_INCREASEMENT);
+    if (IsListEmpty (&MnpDeviceData->FreeRxDataWrapList)) {
+      DEBUG ((EFI_D_ERROR, "MnpAllocRxDataWrap: Failed to add RxDataWrap into the FreeRxDataWrapList.\n"));
+
+      RxDataWrap = NULL;
+      goto ON_EXIT;
+    }
+  }
+
+  Entry = MnpDeviceData->FreeRxDataWrapList.ForwardLink;
+  RemoveEntryList (Entry);
+  MnpDeviceData->FreeRxDataWrapCount--;
+  MnpDeviceData->PollStats.RxWraps++;
+  RxDataWrap = NET_LIST_USER_STRUCT (Entry, MNP_RXDATA_WRAP, WrapEntry);
+
+ON_EXIT:
+  gBS->RestoreTPL (OldTpl);
+
+  return RxDataWrap;
+}
+
+/**
+  Return a RX data wrap to MnpDeviceData->FreeRxDataWrapList, or release it
+  when enough wraps are idle already.
+
+  @param[in, out]  MnpDeviceData         Pointer to the MNP_DEVICE_DATA.
+  @param[in, out]  RxDataWrap            Pointer to the wrap to free.
+
+**/
+VOID
+MnpFreeRxDataWrap (
+  IN OUT MNP_DEVICE_DATA   *MnpDeviceData,
+  IN OUT MNP_RXDATA_WRAP   *RxDataWrap
+  )
+{
+  EFI_TPL  OldTpl;
+
+  NET_CHECK_SIGNATURE (MnpDeviceData, MNP_DEVICE_DATA_SIGNATURE);
+
+  RxDataWrap->Instance = NULL;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+  if (MnpDeviceData->FreeRxDataWrapCount >= MNP_MAX_RCVD_PACKET_QUE_SIZE) {
+    //
+    // A burst is over, keep no more idle wraps than one full receive queue.
+    //
+    gBS->CloseEvent (RxDataWrap->RecycleEvent);
+    FreePool (RxDataWrap);
+    MnpDeviceData->RxDataWrapCount--;
+  } else {
+    InsertHeadList (&MnpDeviceData->FreeRxDataWrapList, &RxDataWrap->WrapEntry);
+    MnpDeviceData->FreeRxDataWrapCount++;
+  }
+
+  gBS->RestoreTPL (OldTpl);
+}
+
+/**
+  Release all the RX data wraps in MnpDeviceData->FreeRxDataWrapList.
+
+  @param[in, out]  MnpDeviceData         Pointer to the MNP_DEVICE_DATA.
+
+**/
+STATIC
+VOID
+MnpFlushFreeRxDataWrap (
+  IN OUT MNP_DEVICE_DATA   *MnpDeviceData
+  )
+{
+  LIST_ENTRY        *Entry;
+  LIST_ENTRY        *NextEntry;
+  MNP_RXDATA_WRAP   *RxDataWrap;
+
+  NET_LIST_FOR_EACH_SAFE (Entry, NextEntry, &MnpDeviceData->FreeRxDataWrapList) {
+    RxDataWrap = NET_LIST_USER_STRUCT (Entry, MNP_RXDATA_WRAP, WrapEntry);
+    RemoveEntryList (Entry);
+    gBS->CloseEvent (RxDataWrap->RecycleEvent);
+    FreePool (RxDataWrap);
+    MnpDeviceData->FreeRxDataWrapCount--;
+    MnpDeviceData->RxDataWrapCount--;
+  }
+}
+
 /**
   Initialize the mnp device context data.
 
@@ -436,6 +609,10 @@ MnpInitializeDeviceData (
   // Copy the MNP Protocol interfaces from the template.
   //
   CopyMem (&MnpDeviceData->VlanConfig, &mVlanConfigProtocolTemplate, sizeof (EFI_VLAN_CONFIG_PROTOCOL));
+  CopyMem (&MnpDeviceData->PollInfo, &mMnpPollInfoProtocolTemplate, sizeof (EDKII_MNP_POLL_INFO_PROTOCOL));
+  MnpDeviceData->PollStats.MinInterval = MNP_SYS_POLL_INTERVAL_MIN;
+  MnpDeviceData->PollStats.MaxInterval = MNP_SYS_POLL_INTERVAL_MAX;
+  MnpDeviceData->PollStats.Budget      = MNP_SYS_POLL_BUDGET;
 
   //
   // Open the Simple Network protocol.
@@ -458,6 +635,20 @@ MnpInitializeDeviceData (
   SnpMode            = Snp->Mode;
   MnpDeviceData->Snp = Snp;
 
+  //
+  // The NIC VLAN offload is optional, fall back to software tagging without it.
+  //
+  if (EFI_ERROR (gBS->OpenProtocol (
+                        ControllerHandle,
+                        &gEdkiiNicVlanOffloadProtocolGuid,
+                        (VOID **) &MnpDeviceData->VlanOffload,
+                        ImageHandle,
+                        ControllerHandle,
+                        EFI_OPEN_PROTOCOL_GET_PROTOCOL
+                        ))) {
+    MnpDeviceData->VlanOffload = NULL;
+  }
+
   //
   // Initialize the lists.
   //
@@ -513,6 +704,17 @@ MnpInitializeDeviceData (
   InitializeListHead (&MnpDeviceData->AllTxBufList);
   MnpDeviceData->TxBufCount = 0;
 
+  //
+  // Pre-allocate the wraps used to hand received packets to the instances.
+  //
+  InitializeListHead (&MnpDeviceData->FreeRxDataWrapList);
+  Status = MnpAddFreeRxDataWrap (MnpDeviceData, MNP_INIT_RXDATA_WRAP_NUM);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((EFI_D_ERROR, "MnpInitializeDeviceData: MnpAddFreeRxDataWrap failed, %r.\n", Status));
+
+    goto ERROR;
+  }
+
   //
   // Create the system poll timer.
   //
@@ -561,6 +763,21 @@ MnpInitializeDeviceData (
     goto ERROR;
   }
 
+  //
+  // Report the background poll rate.
+  //
+  Status = gBS->InstallMultipleProtocolInterfaces (
+                  &ControllerHandle,
+                  &gEdkiiMnpPollInfoProtocolGuid,
+                  &MnpDeviceData->PollInfo,
+                  NULL
+                  );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((EFI_D_ERROR, "MnpInitializeDeviceData: Install poll info protocol failed, %r.\n", Status));
+
+    goto ERROR;
+  }
+
 ERROR:
   if (EFI_ERROR (Status)) {
     //
@@ -590,6 +807,10 @@ ERROR:
       NetbufQueFlush (&MnpDeviceData->FreeNbufQue);
     }
 
+    if (MnpDeviceData->FreeRxDataWrapList.ForwardLink != NULL) {
+      MnpFlushFreeRxDataWrap (MnpDeviceData);
+    }
+
     //
     // Close the Simple Network Protocol.
     //
@@ -636,6 +857,13 @@ MnpDestroyDeviceData (
   //
   ASSERT (IsListEmpty (&MnpDeviceData->GroupAddressList));
 
+  gBS->UninstallMultipleProtocolInterfaces (
+         MnpDeviceData->ControllerHandle,
+         &gEdkiiMnpPollInfoProtocolGuid,
+         &MnpDeviceData->PollInfo,
+         NULL
+         );
+
   //
   // Close the event.
   //
@@ -655,6 +883,12 @@ MnpDestroyDeviceData (
   ASSERT (IsListEmpty (&MnpDeviceData->AllTxBufList));
   ASSERT (MnpDeviceData->TxBufCount == 0);
 
+  //
+  // Free the RX data wrap pool, all the wraps must have been recycled.
+  //
+  MnpFlushFreeRxDataWrap (MnpDeviceData);
+  ASSERT (MnpDeviceData->RxDataWrapCount == 0);
+
   //
   // Free the RxNbufCache.
   //
@@ -762,6 +996,13 @@ MnpCreateServiceData (
       goto Exit;
     }
 
+    //
+    // Let the NIC receive this VLAN
+    //
+    if (MnpDeviceData->VlanOffload != NULL) {
+      MnpDeviceData->VlanOffload->SetFilter (MnpDeviceData->VlanOffload, VlanId, TRUE);
+    }
+
     //
     // Reduce MTU for VLAN device
     //
@@ -827,6 +1068,14 @@ MnpDestroyServiceData (
   }
 
   if (MnpServiceData->VlanId != 0) {
+    if (MnpServiceData->MnpDeviceData->VlanOffload != NULL) {
+      MnpServiceData->MnpDeviceData->VlanOffload->SetFilter (
+                                                    MnpServiceData->MnpDeviceData->VlanOffload,
+                                                    MnpServiceData->VlanId,
+                                                    FALSE
+                                                    );
+    }
+
     //
     // Close VlanConfig Protocol opened by VLAN child handle
     //
@@ -1280,6 +1529,8 @@ MnpStart (
     }
 
     MnpDeviceData->EnableSystemPoll = EnableSystemPoll;
+    MnpDeviceData->PollStats.Interval = EnableSystemPoll ? MNP_SYS_POLL_INTERVAL : 0;
+    MnpDeviceData->PollIdleCount      = 0;
   }
 
   //
@@ -1339,7 +1590,8 @@ MnpStop (
     //  The system poll in on, cancel the poll timer.
     //
     Status  = gBS->SetTimer (MnpDeviceData->PollTimer, TimerCancel, 0);
-    MnpDeviceData->EnableSystemPoll = FALSE;
+    MnpDeviceData->EnableSystemPoll   = FALSE;
+    MnpDeviceData->PollStats.Interval = 0;
   }
 
   //
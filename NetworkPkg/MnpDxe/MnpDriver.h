@@ -15,6 +15,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Protocol/SimpleNetwork.h>
 #include <Protocol/ServiceBinding.h>
 #include <Protocol/VlanConfig.h>
+#include <Protocol/NicVlanOffload.h>
+#include <Protocol/MnpPollInfo.h>
 
 #include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
@@ -24,6 +26,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/UefiLib.h>
 #include <Library/NetLib.h>
 #include <Library/DpcLib.h>
+#include <Library/PcdLib.h>
 #include <Library/UefiRuntimeServicesTableLib.h>
 #include <Library/DevicePathLib.h>
 #include <Library/PrintLib.h>
@@ -47,6 +50,10 @@ typedef struct {
   UINTN                         NumberOfVlan;
   CHAR16                        *MacString;
   EFI_SIMPLE_NETWORK_PROTOCOL   *Snp;
+  //
+  // VLAN offload of the NIC behind Snp, NULL if tags are handled in software
+  //
+  EDKII_NIC_VLAN_OFFLOAD_PROTOCOL  *VlanOffload;
 
   //
   // List of MNP_SERVICE_DATA
@@ -67,8 +74,18 @@ typedef struct {
   NET_BUF_QUEUE                 FreeNbufQue;
   INTN                          NbufCnt;
 
+  LIST_ENTRY                    FreeRxDataWrapList;
+  UINT32                        FreeRxDataWrapCount;
+  UINT32                        RxDataWrapCount;
+
   EFI_EVENT                     PollTimer;
   BOOLEAN                       EnableSystemPoll;
+  //
+  // Adaptive system poll, PollStats.Interval is the period PollTimer runs at
+  //
+  EDKII_MNP_POLL_INFO_PROTOCOL  PollInfo;
+  EDKII_MNP_POLL_INFO           PollStats;
+  UINT32                        PollIdleCount;
 
   EFI_EVENT                     TimeoutCheckTimer;
   EFI_EVENT                     MediaDetectTimer;
@@ -95,6 +112,14 @@ typedef struct {
   MNP_DEVICE_DATA_SIGNATURE \
   )
 
+#define MNP_DEVICE_DATA_FROM_POLL_INFO(a) \
+  CR ( \
+  (a), \
+  MNP_DEVICE_DATA, \
+  PollInfo, \
+  MNP_DEVICE_DATA_SIGNATURE \
+  )
+
 #define MNP_SERVICE_DATA_SIGNATURE  SIGNATURE_32 ('M', 'n', 'p', 'S')
 
 typedef struct {
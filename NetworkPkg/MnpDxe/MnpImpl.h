@@ -13,7 +13,11 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #define NET_ETHER_FCS_SIZE            4
 
-#define MNP_SYS_POLL_INTERVAL         (10 * TICKS_PER_MS)   // 10 milliseconds
+#define MNP_SYS_POLL_INTERVAL         (10 * TICKS_PER_MS)   // 10 milliseconds, period the system poll starts at
+#define MNP_SYS_POLL_INTERVAL_MIN     (1 * TICKS_PER_MS)    // 1 millisecond, while frames are flowing
+#define MNP_SYS_POLL_INTERVAL_MAX     (40 * TICKS_PER_MS)   // 40 milliseconds, once the link is idle
+#define MNP_SYS_POLL_BUDGET           32    // Frames received per system poll at most
+#define MNP_SYS_POLL_IDLE_COUNT       8     // Empty polls before the poll period doubles
 #define MNP_TIMEOUT_CHECK_INTERVAL    (50 * TICKS_PER_MS)   // 50 milliseconds
 #define MNP_MEDIA_DETECT_INTERVAL     (500 * TICKS_PER_MS)  // 500 milliseconds
 #define MNP_TX_TIMEOUT_TIME           (500 * TICKS_PER_MS)  // 500 milliseconds
@@ -24,6 +28,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define MNP_MAX_TX_BUFFER_NUM         65536
 
 #define MNP_MAX_RCVD_PACKET_QUE_SIZE  256
+#define MNP_INIT_RXDATA_WRAP_NUM      32
+#define MNP_RXDATA_WRAP_INCREASEMENT  32    // Idle wraps kept are bounded by MNP_MAX_RCVD_PACKET_QUE_SIZE.
 
 #define MNP_RECEIVE_UNICAST           0x01
 #define MNP_RECEIVE_BROADCAST         0x02
@@ -80,11 +86,12 @@ typedef struct {
 } MNP_GROUP_CONTROL_BLOCK;
 
 typedef struct {
-  LIST_ENTRY                        WrapEntry;
+  LIST_ENTRY                        WrapEntry;  // Link to FreeRxDataWrapList or an instance queue
   MNP_INSTANCE_DATA                 *Instance;
   EFI_MANAGED_NETWORK_RECEIVE_DATA  RxData;
   NET_BUF                           *Nbuf;
   UINT64                            TimeoutTick;
+  EFI_EVENT                         RecycleEvent;  // Created once, reused for every packet
 } MNP_RXDATA_WRAP;
 
 #define MNP_TX_BUF_WRAP_SIGNATURE   SIGNATURE_32 ('M', 'T', 'B', 'W')
@@ -97,6 +104,52 @@ typedef struct {
   UINT8                   TxBuf[1];
 } MNP_TX_BUF_WRAP;
 
+/**
+  Add Count of RX data wraps, with their recycle events, to
+  MnpDeviceData->FreeRxDataWrapList.
+
+  @param[in, out]  MnpDeviceData         Pointer to the MNP_DEVICE_DATA.
+  @param[in]       Count                 Number of RX data wraps to add.
+
+  @retval EFI_SUCCESS           The specified amount of wraps are allocated
+                                and added into FreeRxDataWrapList.
+  @retval EFI_OUT_OF_RESOURCES  Failed to allocate a wrap or its event.
+
+**/
+EFI_STATUS
+MnpAddFreeRxDataWrap (
+  IN OUT MNP_DEVICE_DATA   *MnpDeviceData,
+  IN     UINTN             Count
+  );
+
+/**
+  Take a RX data wrap from MnpDeviceData->FreeRxDataWrapList, growing the list
+  when it is empty.
+
+  @param[in, out]  MnpDeviceData         Pointer to the MNP_DEVICE_DATA.
+
+  @return Pointer to the wrap, NULL if none could be allocated.
+
+**/
+MNP_RXDATA_WRAP *
+MnpAllocRxDataWrap (
+  IN OUT MNP_DEVICE_DATA   *MnpDeviceData
+  );
+
+/**
+  Return a RX data wrap to MnpDeviceData->FreeRxDataWrapList, or release it
+  when enough wraps are idle already.
+
+  @param[in, out]  MnpDeviceData         Pointer to the MNP_DEVICE_DATA.
+  @param[in, out]  RxDataWrap            Pointer to the wrap to free.
+
+**/
+VOID
+MnpFreeRxDataWrap (
+  IN OUT MNP_DEVICE_DATA   *MnpDeviceData,
+  IN OUT MNP_RXDATA_WRAP   *RxDataWrap
+  );
+
 /**
   Initialize the mnp device context data.
 
@@ -517,6 +570,47 @@ MnpCheckMediaStatus (
   IN VOID          *Context
   );
 
+/**
+  Change the period of the system poll timer, if the system poll is on.
+
+  @param[in, out]  MnpDeviceData   Pointer to the mnp device context data.
+  @param[in]       Interval        The new period in 100ns units.
+
+**/
+VOID
+MnpSetPollInterval (
+  IN OUT MNP_DEVICE_DATA   *MnpDeviceData,
+  IN     UINT64            Interval
+  );
+
+/**
+  Poll at the shortest period, traffic is flowing or frames are pending.
+
+  @param[in, out]  MnpDeviceData   Pointer to the mnp device context data.
+
+**/
+VOID
+MnpBoostPoll (
+  IN OUT MNP_DEVICE_DATA   *MnpDeviceData
+  );
+
+/**
+  Read the background poll counters.
+
+  @param[in]   This   The protocol instance pointer.
+  @param[out]  Info   Returns the counters.
+
+  @retval EFI_SUCCESS            The counters were returned.
+  @retval EFI_INVALID_PARAMETER  Info is NULL.
+
+**/
+EFI_STATUS
+EFIAPI
+MnpGetPollInfo (
+  IN  EDKII_MNP_POLL_INFO_PROTOCOL  *This,
+  OUT EDKII_MNP_POLL_INFO           *Info
+  );
+
 /**
   Poll to receive the packets from Snp. This function is either called by upperlayer
   protocols/applications or the system poll timer notify mechanism.
@@ -218,6 +218,7 @@ MnpSyncSendPacket (
   UINT32                            HeaderSize;
   MNP_DEVICE_DATA                   *MnpDeviceData;
   UINT16                            ProtocolType;
+  UINT16                            VlanTci;
 
   MnpDeviceData = MnpServiceData->MnpDeviceData;
   Snp           = MnpDeviceData->Snp;
@@ -239,7 +240,15 @@ MnpSyncSendPacket (
   }
 
 
-  if (MnpServiceData->VlanId != 0) {
+  VlanTci = 0;
+  if ((MnpServiceData->VlanId != 0) &&
+      MNP_VLAN_OFFLOAD (MnpDeviceData, EDKII_NIC_VLAN_OFFLOAD_TX_INSERT)) {
+    //
+    // The NIC inserts the VLAN tag, leave the packet untouched
+    //
+    VlanTci      = MnpGetVlanTci (MnpServiceData);
+    ProtocolType = TxData->ProtocolType;
+  } else if (MnpServiceData->VlanId != 0) {
     //
     // Insert VLAN tag
     //
@@ -248,6 +257,14 @@ MnpSyncSendPacket (
     ProtocolType = TxData->ProtocolType;
   }
 
+  //
+  // The offload tag only covers the next transmit attempt, set it on every
+  // attempt (0 for untagged) so no stale tag is left behind.
+  //
+  if (MNP_VLAN_OFFLOAD (MnpDeviceData, EDKII_NIC_VLAN_OFFLOAD_TX_INSERT)) {
+    MnpDeviceData->VlanOffload->SetTxTag (MnpDeviceData->VlanOffload, VlanTci);
+  }
+
   //
   // Transmit the packet through SNP.
   //
@@ -267,6 +284,10 @@ MnpSyncSendPacket (
       goto SIGNAL_TOKEN;
     }
 
+    if (MNP_VLAN_OFFLOAD (MnpDeviceData, EDKII_NIC_VLAN_OFFLOAD_TX_INSERT)) {
+      MnpDeviceData->VlanOffload->SetTxTag (MnpDeviceData->VlanOffload, VlanTci);
+    }
+
     Status = Snp->Transmit (
                     Snp,
                     HeaderSize,
@@ -280,6 +301,11 @@ MnpSyncSendPacket (
 
   if (EFI_ERROR (Status)) {
     Token->Status = EFI_DEVICE_ERROR;
+  } else {
+    //
+    // Replies are likely to follow, poll for them promptly.
+    //
+    MnpBoostPoll (MnpDeviceData);
   }
 
 SIGNAL_TOKEN:
@@ -331,10 +357,12 @@ MnpInstanceDeliverPacket (
   ASSERT (Instance->RcvdPacketQueueSize != 0);
 
   RxDataWrap = NET_LIST_HEAD (&Instance->RcvdPacketQueue, MNP_RXDATA_WRAP, WrapEntry);
-  if (RxDataWrap->Nbuf->RefCnt > 2) {
+  if (!PcdGetBool (PcdMnpShareRxBuffers) && (RxDataWrap->Nbuf->RefCnt > 2)) {
     //
     // There are other instances share this Nbuf, duplicate to get a
-    // copy to allow the instance to do R/W operations.
+    // copy to allow the instance to do R/W operations. When the buffers
+    // are shared, each instance holds a reference to the same Nbuf and
+    // only reads it, the Nbuf returns to the pool with the last recycle.
     //
     DupNbuf = MnpAllocNbuf (MnpDeviceData);
     if (DupNbuf == NULL) {
@@ -452,16 +480,12 @@ MnpRecycleRxData (
   RxDataWrap->Nbuf = NULL;
 
   //
-  // Close the recycle event.
-  //
-  gBS->CloseEvent (RxDataWrap->RxData.RecycleEvent);
-
-  //
-  // Remove this Wrap entry from the list.
+  // Remove this Wrap entry from the list and return it, with its recycle
+  // event, to the pool.
   //
   RemoveEntryList (&RxDataWrap->WrapEntry);
 
-  FreePool (RxDataWrap);
+  MnpFreeRxDataWrap (MnpDeviceData, RxDataWrap);
 }
 
 
@@ -716,13 +740,12 @@ MnpWrapRxData (
   IN EFI_MANAGED_NETWORK_RECEIVE_DATA    *RxData
   )
 {
-  EFI_STATUS      Status;
   MNP_RXDATA_WRAP *RxDataWrap;
 
   //
-  // Allocate memory.
+  // Take a wrap from the pool, its recycle event is already created.
   //
-  RxDataWrap = AllocatePool (sizeof (MNP_RXDATA_WRAP));
+  RxDataWrap = MnpAllocRxDataWrap (Instance->MnpServiceData->MnpDeviceData);
   if (RxDataWrap == NULL) {
     DEBUG ((EFI_D_ERROR, "MnpDispatchPacket: Failed to allocate a MNP_RXDATA_WRAP.\n"));
     return NULL;
@@ -734,23 +757,7 @@ MnpWrapRxData (
   // Fill the RxData in RxDataWrap,
   //
   CopyMem (&RxDataWrap->RxData, RxData, sizeof (RxDataWrap->RxData));
-
-  //
-  // Create the recycle event.
-  //
-  Status = gBS->CreateEvent (
-                  EVT_NOTIFY_SIGNAL,
-                  TPL_NOTIFY,
-                  MnpRecycleRxData,
-                  RxDataWrap,
-                  &RxDataWrap->RxData.RecycleEvent
-                  );
-  if (EFI_ERROR (Status)) {
-    DEBUG ((EFI_D_ERROR, "MnpDispatchPacket: gBS->CreateEvent failed, %r.\n", Status));
-
-    FreePool (RxDataWrap);
-    return NULL;
-  }
+  RxDataWrap->RxData.RecycleEvent = RxDataWrap->RecycleEvent;
 
   return RxDataWrap;
 }
@@ -930,7 +937,14 @@ MnpReceivePacket (
   }
 
   VlanId = 0;
-  if (MnpDeviceData->NumberOfVlan != 0) {
+  if ((MnpDeviceData->NumberOfVlan != 0) &&
+      MNP_VLAN_OFFLOAD (MnpDeviceData, EDKII_NIC_VLAN_OFFLOAD_RX_STRIP)) {
+    //
+    // VLAN is configured and the NIC has stripped the tag if any
+    //
+    MnpGetOffloadedVlanId (MnpDeviceData, &VlanId);
+    IsVlanPacket = FALSE;
+  } else if (MnpDeviceData->NumberOfVlan != 0) {
     //
     // VLAN is configured, remove the VLAN tag if any
     //
@@ -1097,10 +1111,90 @@ MnpCheckMediaStatus (
     // Upon successful return of GetStatus(), the MediaPresent field of
     // EFI_SIMPLE_NETWORK_MODE will be updated to reflect any change of media status
     //
+    InterruptStatus = 0;
     Snp->GetStatus (Snp, &InterruptStatus, NULL);
+
+    //
+    // The driver reports frames waiting in its receive ring, drain them promptly.
+    //
+    if ((InterruptStatus & EFI_SIMPLE_NETWORK_RECEIVE_INTERRUPT) != 0) {
+      MnpBoostPoll (MnpDeviceData);
+    }
+  }
+}
+
+/**
+  Change the period of the system poll timer, if the system poll is on.
+
+  @param[in, out]  MnpDeviceData   Pointer to the mnp device context data.
+  @param[in]       Interval        The new period in 100ns units.
+
+**/
+VOID
+MnpSetPollInterval (
+  IN OUT MNP_DEVICE_DATA   *MnpDeviceData,
+  IN     UINT64            Interval
+  )
+{
+  MnpDeviceData->PollIdleCount = 0;
+
+  if ((MnpDeviceData->PollStats.Interval == 0) ||
+      (MnpDeviceData->PollStats.Interval == Interval)) {
+    return;
+  }
+
+  if (!EFI_ERROR (gBS->SetTimer (MnpDeviceData->PollTimer, TimerPeriodic, Interval))) {
+    MnpDeviceData->PollStats.Interval = Interval;
   }
 }
 
+/**
+  Poll at the shortest period, traffic is flowing or frames are pending.
+
+  @param[in, out]  MnpDeviceData   Pointer to the mnp device context data.
+
+**/
+VOID
+MnpBoostPoll (
+  IN OUT MNP_DEVICE_DATA   *MnpDeviceData
+  )
+{
+  MnpSetPollInterval (MnpDeviceData, MNP_SYS_POLL_INTERVAL_MIN);
+}
+
+/**
+  Read the background poll counters.
+
+  @param[in]   This   The protocol instance pointer.
+  @param[out]  Info   Returns the counters.
+
+  @retval EFI_SUCCESS            The counters were returned.
+  @retval EFI_INVALID_PARAMETER  Info is NULL.
+
+**/
+EFI_STATUS
+EFIAPI
+MnpGetPollInfo (
+  IN  EDKII_MNP_POLL_INFO_PROTOCOL  *This,
+  OUT EDKII_MNP_POLL_INFO           *Info
+  )
+{
+  MNP_DEVICE_DATA  *MnpDeviceData;
+  EFI_TPL          OldTpl;
+
+  if ((This == NULL) || (Info == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  MnpDeviceData = MNP_DEVICE_DATA_FROM_POLL_INFO (This);
+
+  OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+  CopyMem (Info, &MnpDeviceData->PollStats, sizeof (EDKII_MNP_POLL_INFO));
+  gBS->RestoreTPL (OldTpl);
+
+  return EFI_SUCCESS;
+}
+
 /**
   Poll to receive the packets from Snp. This function is either called by upperlayer
   protocols/applications or the system poll timer notify mechanism.
@@ -1116,18 +1210,52 @@ MnpSystemPoll (
   IN VOID          *Context
   )
 {
-  MNP_DEVICE_DATA  *MnpDeviceData;
+  MNP_DEVICE_DATA      *MnpDeviceData;
+  EDKII_MNP_POLL_INFO  *Stats;
+  UINT32               Frames;
 
   MnpDeviceData = (MNP_DEVICE_DATA *) Context;
   NET_CHECK_SIGNATURE (MnpDeviceData, MNP_DEVICE_DATA_SIGNATURE);
 
   //
-  // Try to receive packets from Snp.
+  // Drain the frames the NIC holds, up to the budget so one busy link
+  // does not hold the TPL_CALLBACK level for too long.
   //
-  MnpReceivePacket (MnpDeviceData);
+  for (Frames = 0; Frames < MNP_SYS_POLL_BUDGET; Frames++) {
+    if (EFI_ERROR (MnpReceivePacket (MnpDeviceData))) {
+      break;
+    }
+
+    //
+    // Let the receivers queue new rx tokens before the next packet.
+    //
+    DispatchDpc ();
+  }
 
   //
   // Dispatch the DPC queued by the NotifyFunction of rx token's events.
   //
   DispatchDpc ();
+
+  Stats = &MnpDeviceData->PollStats;
+  Stats->Polls++;
+  Stats->PolledTime += Stats->Interval;
+  Stats->Frames     += Frames;
+
+  if (Frames != 0) {
+    //
+    // Traffic is flowing, a full budget means frames are likely left behind.
+    //
+    if (Frames == MNP_SYS_POLL_BUDGET) {
+      Stats->BudgetHits++;
+    }
+
+    MnpBoostPoll (MnpDeviceData);
+  } else if ((++MnpDeviceData->PollIdleCount >= MNP_SYS_POLL_IDLE_COUNT) &&
+             (Stats->Interval < MNP_SYS_POLL_INTERVAL_MAX)) {
+    //
+    // Idle, back off.
+    //
+    MnpSetPollInterval (MnpDeviceData, MIN (Stats->Interval * 2, MNP_SYS_POLL_INTERVAL_MAX));
+  }
 }
@@ -776,6 +776,12 @@ MnpPoll (
   // Try to receive packets.
   //
   Status = MnpReceivePacket (Instance->MnpServiceData->MnpDeviceData);
+  if (!EFI_ERROR (Status)) {
+    //
+    // Frames are flowing, keep the background poll up with them.
+    //
+    MnpBoostPoll (Instance->MnpServiceData->MnpDeviceData);
+  }
 
   //
   // Dispatch the DPC queued by the NotifyFunction of rx token's events.
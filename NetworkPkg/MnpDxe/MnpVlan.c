@@ -162,6 +162,59 @@ MnpRemoveVlanTag (
   return TRUE;
 }
 
+/**
+  Get the VLAN ID of the last received packet from the NIC VLAN offload.
+
+  The NIC has already removed the tag, so unlike MnpRemoveVlanTag() the
+  packet buffer is left untouched.
+
+  @param[in]       MnpDeviceData      Pointer to the mnp device context data.
+  @param[out]      VlanId             Pointer to the returned VLAN ID, 0 if
+                                      the packet was untagged.
+
+**/
+VOID
+MnpGetOffloadedVlanId (
+  IN     MNP_DEVICE_DATA   *MnpDeviceData,
+     OUT UINT16            *VlanId
+  )
+{
+  EFI_STATUS  Status;
+  VLAN_TCI    VlanTag;
+
+  *VlanId = 0;
+  Status  = MnpDeviceData->VlanOffload->GetRxTag (
+                                          MnpDeviceData->VlanOffload,
+                                          &VlanTag.Uint16
+                                          );
+  if (!EFI_ERROR (Status)) {
+    *VlanId = VlanTag.Bits.Vid;
+  }
+}
+
+/**
+  Get the VLAN tag control information of the mnp service, in host byte order.
+
+  @param[in]       MnpServiceData     Pointer to the mnp service context data.
+
+  @return The VLAN TCI to insert into packets sent by this service.
+
+**/
+UINT16
+MnpGetVlanTci (
+  IN MNP_SERVICE_DATA      *MnpServiceData
+  )
+{
+  VLAN_TCI  VlanTci;
+
+  VlanTci.Uint16        = 0;
+  VlanTci.Bits.Vid      = MnpServiceData->VlanId;
+  VlanTci.Bits.Cfi      = VLAN_TCI_CFI_CANONICAL_MAC;
+  VlanTci.Bits.Priority = MnpServiceData->Priority;
+
+  return VlanTci.Uint16;
+}
+
 
 /**
   Build the vlan packet to transmit from the TxData passed in.
@@ -217,10 +270,7 @@ MnpInsertVlanTag (
     *EtherType = HTONS (TxData->ProtocolType);
   }
 
-  VlanTci->Bits.Vid      = MnpServiceData->VlanId;
-  VlanTci->Bits.Cfi      = VLAN_TCI_CFI_CANONICAL_MAC;
-  VlanTci->Bits.Priority = MnpServiceData->Priority;
-  VlanTci->Uint16        = HTONS (VlanTci->Uint16);
+  VlanTci->Uint16 = HTONS (MnpGetVlanTci (MnpServiceData));
 }
 
 /**
@@ -13,6 +13,13 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 extern EFI_VLAN_CONFIG_PROTOCOL mVlanConfigProtocolTemplate;
 
+//
+// Check whether the NIC provides one of the EDKII_NIC_VLAN_OFFLOAD capabilities
+//
+#define MNP_VLAN_OFFLOAD(MnpDeviceData, Capability) \
+  (((MnpDeviceData)->VlanOffload != NULL) && \
+   (((MnpDeviceData)->VlanOffload->Capabilities & (Capability)) != 0))
+
 
 /**
   Create a child handle for the VLAN ID.
@@ -51,6 +58,36 @@ MnpRemoveVlanTag (
      OUT UINT16            *VlanId
   );
 
+/**
+  Get the VLAN ID of the last received packet from the NIC VLAN offload.
+
+  The NIC has already removed the tag, so unlike MnpRemoveVlanTag() the
+  packet buffer is left untouched.
+
+  @param[in]       MnpDeviceData      Pointer to the mnp device context data.
+  @param[out]      VlanId             Pointer to the returned VLAN ID, 0 if
+                                      the packet was untagged.
+
+**/
+VOID
+MnpGetOffloadedVlanId (
+  IN     MNP_DEVICE_DATA   *MnpDeviceData,
+     OUT UINT16            *VlanId
+  );
+
+/**
+  Get the VLAN tag control information of the mnp service, in host byte order.
+
+  @param[in]       MnpServiceData     Pointer to the mnp service context data.
+
+  @return The VLAN TCI to insert into packets sent by this service.
+
+**/
+UINT16
+MnpGetVlanTci (
+  IN MNP_SERVICE_DATA      *MnpServiceData
+  );
+
 /**
   Build the vlan packet to transmit from the TxData passed in.
 
@@ -9,6 +9,105 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include "Snp.h"
 
+/**
+  Append a transmitted buffer address to Snp->RecycledTxBuf, growing it as needed.
+
+  @param[in]   Snp                     Pointer to snp driver structure.
+  @param[in]   TxBuf                   Address of the transmitted buffer.
+
+  @retval      EFI_SUCCESS             The address was stored.
+  @retval      EFI_DEVICE_ERROR        Snp->RecycledTxBuf could not be grown.
+
+**/
+STATIC
+EFI_STATUS
+SnpAddRecycledTxBuf (
+  IN SNP_DRIVER *Snp,
+  IN UINT64     TxBuf
+  )
+{
+  UINT64  *Tmp;
+
+  if (Snp->RecycledTxBufCount == Snp->MaxRecycledTxBuf) {
+    //
+    // Snp->RecycledTxBuf is full, reallocate a new one.
+    //
+    if ((Snp->MaxRecycledTxBuf + SNP_TX_BUFFER_INCREASEMENT) >= SNP_MAX_TX_BUFFER_NUM) {
+      return EFI_DEVICE_ERROR;
+    }
+    Tmp = AllocatePool (sizeof (UINT64) * (Snp->MaxRecycledTxBuf + SNP_TX_BUFFER_INCREASEMENT));
+    if (Tmp == NULL) {
+      return EFI_DEVICE_ERROR;
+    }
+    CopyMem (Tmp, Snp->RecycledTxBuf, sizeof (UINT64) * Snp->RecycledTxBufCount);
+    FreePool (Snp->RecycledTxBuf);
+    Snp->RecycledTxBuf    =  Tmp;
+    Snp->MaxRecycledTxBuf += SNP_TX_BUFFER_INCREASEMENT;
+  }
+  Snp->RecycledTxBuf[Snp->RecycledTxBufCount] = TxBuf;
+  Snp->RecycledTxBufCount++;
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Same as PxeGetStatus, through the direct entry points of the NIC driver
+  instead of an UNDI GET_STATUS command.
+
+  @param[in]   Snp                     Pointer to snp driver structure.
+  @param[out]  InterruptStatusPtr      A pointer to contain the interrupt status,
+                                       NULL to leave the interrupt status alone.
+  @param[in]   GetTransmittedBuf       Set to TRUE to retrieve the recycled transmit
+                                       buffer address.
+
+  @retval      EFI_SUCCESS             The status of the network interface was retrieved.
+  @retval      EFI_DEVICE_ERROR        The NIC driver could not return the status.
+
+**/
+STATIC
+EFI_STATUS
+PxeGetStatusDatapath (
+  IN     SNP_DRIVER *Snp,
+     OUT UINT32     *InterruptStatusPtr,
+  IN     BOOLEAN    GetTransmittedBuf
+  )
+{
+  UINT64      TxBuffer[MAX_XMIT_BUFFERS];
+  UINT32      Count;
+  UINT32      Index;
+  BOOLEAN     MediaPresent;
+  EFI_STATUS  Status;
+
+  if ((InterruptStatusPtr != NULL) || Snp->MediaStatusSupported) {
+    Status = Snp->Datapath->PollStatus (
+                              Snp->Datapath,
+                              InterruptStatusPtr,
+                              Snp->MediaStatusSupported ? &MediaPresent : NULL
+                              );
+    if (EFI_ERROR (Status)) {
+      return EFI_DEVICE_ERROR;
+    }
+    if (Snp->MediaStatusSupported) {
+      Snp->Snp.Mode->MediaPresent = MediaPresent;
+    }
+  }
+
+  if (GetTransmittedBuf) {
+    Count  = MAX_XMIT_BUFFERS;
+    Status = Snp->Datapath->ReclaimTx (Snp->Datapath, TxBuffer, &Count);
+    if (EFI_ERROR (Status)) {
+      return EFI_DEVICE_ERROR;
+    }
+    for (Index = 0; Index < Count; Index++) {
+      if (EFI_ERROR (SnpAddRecycledTxBuf (Snp, TxBuffer[Index]))) {
+        return EFI_DEVICE_ERROR;
+      }
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
 /**
   Call undi to get the status of the interrupts, get the list of recycled transmit
   buffers that completed transmitting. The recycled transmit buffer address will
@@ -36,9 +135,11 @@ PxeGetStatus (
   PXE_DB_GET_STATUS *Db;
   UINT16            InterruptFlags;
   UINT32            Index;
-  UINT64            *Tmp;
 
-  Tmp               = NULL;
+  if (Snp->Datapath != NULL) {
+    return PxeGetStatusDatapath (Snp, InterruptStatusPtr, GetTransmittedBuf);
+  }
+
   Db                = Snp->Db;
   Snp->Cdb.OpCode   = PXE_OPCODE_GET_STATUS;
 
@@ -118,24 +219,9 @@ PxeGetStatus (
       //
       for (Index = 0; Index < MAX_XMIT_BUFFERS; Index++) {
         if (Db->TxBuffer[Index] != 0) {
-          if (Snp->RecycledTxBufCount == Snp->MaxRecycledTxBuf) {
-            //
-            // Snp->RecycledTxBuf is full, reallocate a new one.
-            //
-            if ((Snp->MaxRecycledTxBuf + SNP_TX_BUFFER_INCREASEMENT) >= SNP_MAX_TX_BUFFER_NUM) {
-              return EFI_DEVICE_ERROR;
-            }
-            Tmp = AllocatePool (sizeof (UINT64) * (Snp->MaxRecycledTxBuf + SNP_TX_BUFFER_INCREASEMENT));
-            if (Tmp == NULL) {
-              return EFI_DEVICE_ERROR;
-            }
-            CopyMem (Tmp, Snp->RecycledTxBuf, sizeof (UINT64) * Snp->RecycledTxBufCount);
-            FreePool (Snp->RecycledTxBuf);
-            Snp->RecycledTxBuf    =  Tmp;
-            Snp->MaxRecycledTxBuf += SNP_TX_BUFFER_INCREASEMENT;
+          if (EFI_ERROR (SnpAddRecycledTxBuf (Snp, Db->TxBuffer[Index]))) {
+            return EFI_DEVICE_ERROR;
           }
-          Snp->RecycledTxBuf[Snp->RecycledTxBufCount] = Db->TxBuffer[Index];
-          Snp->RecycledTxBufCount++;
         }
       }
     }
@@ -49,11 +49,20 @@ PxeReceive (
   PXE_CPB_RECEIVE *Cpb;
   PXE_DB_RECEIVE  *Db;
   UINTN           BuffSize;
+  EFI_STATUS      Status;
 
   Cpb       = Snp->Cpb;
   Db        = Snp->Db;
   BuffSize  = *BufferSize;
 
+  if (Snp->Datapath != NULL) {
+    Status = Snp->Datapath->Receive (Snp->Datapath, (UINT64)(UINTN) Buffer, (UINT32) *BufferSize, Db);
+    if (EFI_ERROR (Status)) {
+      return (Status == EFI_NOT_READY) ? EFI_NOT_READY : EFI_DEVICE_ERROR;
+    }
+    goto ON_RECEIVED;
+  }
+
   Cpb->BufferAddr = (UINT64)(UINTN) Buffer;
   Cpb->BufferLen  = (UINT32) *BufferSize;
 
@@ -105,6 +114,7 @@ PxeReceive (
     return EFI_DEVICE_ERROR;
   }
 
+ON_RECEIVED:
   *BufferSize = Db->FrameLen;
 
   if (HeaderSize != NULL) {
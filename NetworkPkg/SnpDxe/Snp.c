@@ -425,6 +425,34 @@ SimpleNetworkDriverStart (
     } else {
       Snp->IssueUndi32Command = (ISSUE_UNDI32_COMMAND) (UINTN) ((UINT8) (UINTN) Pxe + Pxe->sw.EntryPoint);
     }
+
+    //
+    // The NIC driver may offer direct datapath calls next to its UNDI entry point.
+    // The revision is checked once here so the datapath calls need no checks.
+    // It is opened by driver so that SNP is stopped before the NIC driver can
+    // uninstall it.
+    //
+    if (PcdGetBool (PcdSnpUseNicDatapath)) {
+      Status = gBS->OpenProtocol (
+                      Controller,
+                      &gEdkiiNicDatapathProtocolGuid,
+                      (VOID **) &Snp->Datapath,
+                      This->DriverBindingHandle,
+                      Controller,
+                      EFI_OPEN_PROTOCOL_BY_DRIVER
+                      );
+      if (EFI_ERROR (Status)) {
+        Snp->Datapath = NULL;
+      } else if (Snp->Datapath->Revision < EDKII_NIC_DATAPATH_PROTOCOL_REVISION) {
+        gBS->CloseProtocol (
+              Controller,
+              &gEdkiiNicDatapathProtocolGuid,
+              This->DriverBindingHandle,
+              Controller
+              );
+        Snp->Datapath = NULL;
+      }
+    }
   }
   //
   // Allocate a global CPB and DB buffer for this UNDI interface.
@@ -687,6 +715,15 @@ SimpleNetworkDriverStart (
 
 Error_DeleteSNP:
 
+  if (Snp->Datapath != NULL) {
+    gBS->CloseProtocol (
+          Controller,
+          &gEdkiiNicDatapathProtocolGuid,
+          This->DriverBindingHandle,
+          Controller
+          );
+  }
+
   if (Snp->RecycledTxBuf != NULL) {
     FreePool (Snp->RecycledTxBuf);
   }
@@ -788,6 +825,15 @@ SimpleNetworkDriverStop (
     gBS->CloseEvent (Snp->ExitBootServicesEvent);
   }
 
+  if (Snp->Datapath != NULL) {
+    gBS->CloseProtocol (
+          Controller,
+          &gEdkiiNicDatapathProtocolGuid,
+          This->DriverBindingHandle,
+          Controller
+          );
+  }
+
   Status = gBS->CloseProtocol (
                   Controller,
                   &gEfiNetworkInterfaceIdentifierProtocolGuid_31,
@@ -15,6 +15,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Protocol/PciIo.h>
 #include <Protocol/NetworkInterfaceIdentifier.h>
 #include <Protocol/DevicePath.h>
+#include <Protocol/NicDatapath.h>
 
 #include <Guid/EventGroup.h>
 
@@ -149,6 +150,12 @@ typedef struct {
   // Current number of recycled buffer pointers in RecycledTxBuf.
   //
   UINT32                 RecycledTxBufCount;
+
+  //
+  // Direct entry points of the NIC driver for Transmit, Receive and GetStatus,
+  // NULL when every call goes through IssueUndi32Command.
+  //
+  EDKII_NIC_DATAPATH_PROTOCOL  *Datapath;
 } SNP_DRIVER;
 
 #define EFI_SIMPLE_NETWORK_DEV_FROM_THIS(a) CR (a, SNP_DRIVER, Snp, SNP_DRIVER_SIGNATURE)
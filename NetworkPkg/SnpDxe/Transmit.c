@@ -147,6 +147,10 @@ PxeTransmit (
   PXE_CPB_TRANSMIT  *Cpb;
   EFI_STATUS        Status;
 
+  if (Snp->Datapath != NULL) {
+    return Snp->Datapath->Transmit (Snp->Datapath, (UINT64) (UINTN) Buffer, (UINT32) BufferSize);
+  }
+
   Cpb             = Snp->Cpb;
   Cpb->FrameAddr  = (UINT64) (UINTN) Buffer;
   Cpb->DataLen    = (UINT32) BufferSize;